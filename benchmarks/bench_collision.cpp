@@ -0,0 +1,690 @@
+// benchmarks/bench_collision.cpp
+// 碰撞微基準測試：不依賴 OpenGL/SDL2，純 CPU
+// 用法：./bench_collision（建議 Release 編譯，Debug 的 assert 會扭曲結果）
+//
+// 場景：和壓測場景同樣的組成比例
+//   40% 靜態 AABB 石頭（無 RigidBody，永遠不動）
+//   60% 動態圓（半徑 19，每 tick 移動幾個像素，撞到邊界反彈）
+// 每個量級先跑 1 個暖身 tick，再量 N 個 tick 的平均。
+// broad phase 的每種實作（四叉樹 / 雜湊網格 / sweep-and-prune / LBVH）都跑同一組場景。
+
+#include "ecs/Components.h"
+#include "ecs/Registry.h"
+#include "physics/CollisionWorld.h"
+#include "physics/ContactCache.h"
+#include "physics/LinearBvh.h"
+#include "physics/ProjectileManager.h"
+#include "physics/SpatialIndex.h"
+#include "systems/CollisionSystem.h"
+#include "systems/EnemySystem.h"
+#include "systems/PickupSystem.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point begin, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+// 固定種子的 LCG：每次跑出來的場景都一樣，結果可重現
+struct Lcg {
+    std::uint32_t state = 12345u;
+    std::uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+    float uniform(float lo, float hi) {
+        return lo + (hi - lo) * static_cast<float>(next() >> 8) / 16777216.0f;
+    }
+};
+
+struct Scene {
+    duck::Registry registry;
+    std::vector<duck::EntityID> dynamicBodies;
+    float worldSize = 0.0f;
+};
+
+// 平均每 3600 px²（60x60）一個 solid，密度接近壓測場景的敵人圈
+// staticEvery：每 5 個裡有幾個是靜態石頭（預設 2 → 40%；0 → 全部是移動的圓）
+void buildScene(Scene& scene, int solidCount, int staticEvery = 2) {
+    Lcg rng;
+    scene.worldSize = std::sqrt(static_cast<float>(solidCount) * 3600.0f);
+    auto& reg = scene.registry;
+
+    for (int i = 0; i < solidCount; ++i) {
+        auto e = reg.create();
+        float x = rng.uniform(0.0f, scene.worldSize);
+        float y = rng.uniform(0.0f, scene.worldSize);
+        reg.addComponent<duck::Transform>(e, x, y, 0.0f, 1.0f, 1.0f);
+        if (i % 5 < staticEvery) {
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::AABB, 22.0f, 22.0f, 22.0f, true);
+        } else {
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 19.0f, 19.0f, 19.0f, true);
+            reg.addComponent<duck::RigidBody>(e, rng.uniform(-180.0f, 180.0f),
+                                              rng.uniform(-180.0f, 180.0f), 1.0f, 1.0f);
+            scene.dynamicBodies.push_back(e);
+        }
+    }
+    reg.registerQuery<duck::Transform, duck::Collider>();
+}
+
+// 簡化版 MovementSystem：等速移動 + 邊界反彈（不含摩擦，讓每個 tick 都有東西在動）
+void moveBodies(Scene& scene, float dt) {
+    for (auto e : scene.dynamicBodies) {
+        if (!scene.registry.alive(e)) continue;
+        auto& tf = scene.registry.getComponent<duck::Transform>(e);
+        auto& rb = scene.registry.getComponent<duck::RigidBody>(e);
+        tf.x += rb.vx * dt;
+        tf.y += rb.vy * dt;
+        if (tf.x < 0.0f || tf.x > scene.worldSize) rb.vx = -rb.vx;
+        if (tf.y < 0.0f || tf.y > scene.worldSize) rb.vy = -rb.vy;
+    }
+}
+
+// BroadPhaseStats 累加 ticks 個 tick 後的每 tick 平均，印在時間那一行下面
+void printBroadPhaseStats(const duck::BroadPhaseStats& stats, int ticks) {
+    auto avg = [ticks](size_t value) { return value / static_cast<size_t>(ticks); };
+    std::printf("           nodes %zu, aabb tests %zu, candidates %zu, max depth %zu, entries/node",
+                avg(stats.nodesVisited), avg(stats.aabbTests), avg(stats.candidatePairs), stats.maxDepth);
+    for (size_t i = 0; i < duck::BroadPhaseStats::HISTOGRAM_BUCKETS; ++i) {
+        std::printf(i == 0 ? " %zu" : "/%zu", avg(stats.entriesHistogram[i]));
+    }
+    std::printf("\n");
+}
+
+void bench_collision_tick(duck::BroadPhaseType type, int solidCount, int ticks) {
+    const float dt = 1.0f / 60.0f;
+    Scene scene;
+    buildScene(scene, solidCount);
+    scene.registry.context<duck::CollisionWorld>().setBroadPhase(type);
+
+    duck::CollisionSystem system;
+    system.update(scene.registry, dt);  // 暖身：第一次 tick 會建立所有結構
+
+    double totalMs = 0.0;
+    duck::CollisionStats stats;
+    for (int t = 0; t < ticks; ++t) {
+        moveBodies(scene, dt);
+        auto t0 = Clock::now();
+        system.update(scene.registry, dt);
+        totalMs += elapsedMs(t0, Clock::now());
+        stats.add(system.lastStats());
+    }
+    std::printf("  %-8s %6d solids : %9.3f ms/tick（pairs %zu = %zu dynamic + %zu static, narrow tests %zu, hits %zu）\n",
+                duck::broadPhaseName(type), solidCount, totalMs / ticks, stats.pairs / stats.ticks,
+                stats.broadPhase.pairs / stats.ticks, stats.staticPairs / stats.ticks,
+                stats.narrowTests / stats.ticks, stats.hits / stats.ticks);
+}
+
+// 靜態距離場：同一個場景（grid），牆走配對（cellSize = 0）vs 每個圓取樣一次距離場；
+// 另外量第一次 sync 的烘焙時間
+void bench_static_field(float cellSize, int solidCount, int ticks) {
+    const float dt = 1.0f / 60.0f;
+    Scene scene;
+    buildScene(scene, solidCount);
+    auto& world = scene.registry.context<duck::CollisionWorld>();
+    world.setBroadPhase(duck::BroadPhaseType::HashGrid);
+    world.setStaticFieldCellSize(cellSize);
+    auto bake0 = Clock::now();
+    world.sync(scene.registry);
+    double bakeMs = elapsedMs(bake0, Clock::now());
+
+    duck::CollisionSystem system;
+    system.update(scene.registry, dt);
+
+    double totalMs = 0.0;
+    duck::CollisionStats stats;
+    for (int t = 0; t < ticks; ++t) {
+        moveBodies(scene, dt);
+        auto t0 = Clock::now();
+        system.update(scene.registry, dt);
+        totalMs += elapsedMs(t0, Clock::now());
+        stats.add(system.lastStats());
+    }
+    // 節點超過 DistanceField::MAX_NODES 時格子會被自動放大，印實際的格子大小
+    float actualCell = world.staticField().empty() ? 0.0f : world.staticField().cellSize();
+    std::printf("  cell %4.1f %6d solids : %9.3f ms/tick, bake %8.3f ms, %7zu nodes"
+                "（static pairs %zu, field bodies %zu, field pushes %zu）\n",
+                actualCell, solidCount, totalMs / ticks, bakeMs, world.staticField().nodeCount(),
+                stats.staticPairs / stats.ticks, stats.fieldBodies / stats.ticks, stats.fieldPushes / stats.ticks);
+}
+
+// 旋轉的石頭：同一個場景，石頭全部改成隨機角度的 OBB（圓 vs OBB 的 SAT 桶）對照原本的 AABB
+void bench_rotated_rocks(bool rotated, duck::SimdLevel level, int solidCount, int ticks) {
+    const float dt = 1.0f / 60.0f;
+    Scene scene;
+    buildScene(scene, solidCount);
+    if (rotated) {
+        Lcg rng;
+        scene.registry.view<duck::Transform, duck::Collider>([&](duck::EntityID e) {
+            auto& col = scene.registry.getComponent<duck::Collider>(e);
+            if (col.type != duck::Collider::Type::AABB) return;
+            col.type = duck::Collider::Type::OBB;
+            scene.registry.getComponent<duck::Transform>(e).rotation = rng.uniform(-3.14159f, 3.14159f);
+        });
+    }
+    scene.registry.context<duck::CollisionWorld>().setBroadPhase(duck::BroadPhaseType::HashGrid);
+
+    duck::CollisionSystem system;
+    system.setSimdLevel(level);
+    system.update(scene.registry, dt);
+
+    double totalMs = 0.0;
+    duck::CollisionStats stats;
+    for (int t = 0; t < ticks; ++t) {
+        moveBodies(scene, dt);
+        auto t0 = Clock::now();
+        system.update(scene.registry, dt);
+        totalMs += elapsedMs(t0, Clock::now());
+        stats.add(system.lastStats());
+    }
+    std::printf("  %-4s %-6s %6d solids : %9.3f ms/tick（narrow tests %zu, hits %zu）\n",
+                rotated ? "obb" : "aabb", duck::simdLevelName(system.simdLevel()), solidCount, totalMs / ticks,
+                stats.narrowTests / stats.ticks, stats.hits / stats.ticks);
+}
+
+// 只量 broad phase：CollisionWorld::sync + findPairs（不含 narrow phase 與推開）
+void bench_broad_phase(duck::BroadPhaseType type, int solidCount, int ticks, int staticEvery = 2) {
+    const float dt = 1.0f / 60.0f;
+    Scene scene;
+    buildScene(scene, solidCount, staticEvery);
+
+    auto& world = scene.registry.context<duck::CollisionWorld>();
+    world.setBroadPhase(type);
+    std::vector<duck::BodyPair> pairs;
+    world.sync(scene.registry);
+
+    double syncMs = 0.0;
+    double pairMs = 0.0;
+    size_t pairCount = 0;
+    size_t reinserts = 0;
+    duck::BroadPhaseStats stats;
+    for (int t = 0; t < ticks; ++t) {
+        moveBodies(scene, dt);
+        auto t0 = Clock::now();
+        world.sync(scene.registry);
+        auto t1 = Clock::now();
+        pairs.clear();
+        world.findPairs(pairs);
+        auto t2 = Clock::now();
+        syncMs += elapsedMs(t0, t1);
+        pairMs += elapsedMs(t1, t2);
+        pairCount += pairs.size();
+        reinserts += world.lastReinsertCount();
+        stats.add(world.lastBroadPhaseStats());
+    }
+    std::printf("  %-8s %6d solids : sync %7.3f ms + pairs %7.3f ms（%zu pairs, %zu reinserts/tick）\n",
+                duck::broadPhaseName(type), solidCount, syncMs / ticks, pairMs / ticks,
+                pairCount / static_cast<size_t>(ticks), reinserts / static_cast<size_t>(ticks));
+    printBroadPhaseStats(stats, ticks);
+}
+
+// 全部傳送：每個 tick 所有動態物體都瞬移到隨機位置（傳送、整波重新生成），
+// 增量結構這時每個 proxy 都要重插，量的是 sync + findPairs
+void bench_teleport(duck::BroadPhaseType type, int solidCount, int ticks, unsigned threads = 1) {
+    Scene scene;
+    buildScene(scene, solidCount, 0);
+    auto& world = scene.registry.context<duck::CollisionWorld>();
+    world.setBroadPhaseThreadCount(threads);
+    world.setBroadPhase(type);
+    world.sync(scene.registry);
+
+    Lcg rng;
+    std::vector<duck::BodyPair> pairs;
+    double totalMs = 0.0;
+    size_t pairCount = 0;
+    for (int t = 0; t < ticks; ++t) {
+        for (auto e : scene.dynamicBodies) {
+            auto& tf = scene.registry.getComponent<duck::Transform>(e);
+            tf.x = rng.uniform(0.0f, scene.worldSize);
+            tf.y = rng.uniform(0.0f, scene.worldSize);
+        }
+        auto t0 = Clock::now();
+        world.sync(scene.registry);
+        pairs.clear();
+        world.findPairs(pairs);
+        totalMs += elapsedMs(t0, Clock::now());
+        pairCount += pairs.size();
+    }
+    std::printf("  %-8s %6d bodies, %u thread(s) : %8.3f ms/tick（%zu pairs）\n", duck::broadPhaseName(type),
+                solidCount, threads, totalMs / ticks, pairCount / static_cast<size_t>(ticks));
+}
+
+// LinearBvh 單獨量：所有 proxy 換位置後重建一次（Morton code + 基數排序 + Karras + refit），
+// 和接著的 findPairs 分開計時
+void bench_lbvh_rebuild(unsigned threads, int count, int ticks) {
+    Lcg rng;
+    const float worldSize = std::sqrt(static_cast<float>(count) * 3600.0f);
+    duck::LinearBvh bvh;
+    bvh.setThreadCount(threads);
+    std::vector<duck::BroadPhase::ProxyID> proxies;
+    for (int i = 0; i < count; ++i) {
+        auto b = duck::makeAabb(rng.uniform(0.0f, worldSize), rng.uniform(0.0f, worldSize), 19.0f, 19.0f);
+        proxies.push_back(bvh.insert(static_cast<duck::EntityID>(i), b, false, {}));
+    }
+    bvh.build();
+
+    std::vector<duck::BodyPair> pairs;
+    double buildMs = 0.0;
+    double pairMs = 0.0;
+    for (int t = 0; t < ticks; ++t) {
+        for (auto id : proxies) {
+            bvh.update(id, duck::makeAabb(rng.uniform(0.0f, worldSize), rng.uniform(0.0f, worldSize), 19.0f, 19.0f));
+        }
+        auto t0 = Clock::now();
+        bvh.build();
+        auto t1 = Clock::now();
+        pairs.clear();
+        bvh.findPairs(pairs);
+        auto t2 = Clock::now();
+        buildMs += elapsedMs(t0, t1);
+        pairMs += elapsedMs(t1, t2);
+    }
+    std::printf("  lbvh %6d proxies, %u thread(s) : rebuild %7.3f ms + pairs %7.3f ms（%zu pairs）\n",
+                count, threads, buildMs / ticks, pairMs / ticks, pairs.size());
+}
+
+// 壓測場景（Engine::setupStressScene）的無視窗複製版：
+//   格狀石頭（7x10，每 3 格空一格）+ 玩家 + 兩圈敵人（內圈 24、外圈 40，半徑 19）
+// ringScale > 1 時每圈敵人數量乘上倍數（位置加一點隨機擾動），模擬更大的敵人潮；
+// 敵人以固定速度朝玩家（場景中心）前進，擠成一團，量的是完整 CollisionSystem::update
+void bench_stress_scene(duck::BroadPhaseType type, int ringScale, int ticks,
+                        duck::SimdLevel simd = duck::detectSimdLevel()) {
+    const float dt = 1.0f / 60.0f;
+    Lcg rng;
+    Scene scene;
+    scene.worldSize = 1280.0f;
+    auto& reg = scene.registry;
+
+    auto player = reg.create();
+    reg.addComponent<duck::Transform>(player, 640.0f, 360.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::RigidBody>(player, 0.0f, 0.0f, 1.0f, 0.85f);
+    reg.addComponent<duck::Collider>(player, duck::Collider::Type::Circle, 24.0f, 24.0f, 24.0f, true);
+
+    for (int row = 0; row < 7; ++row) {
+        for (int col = 0; col < 10; ++col) {
+            if ((row + col) % 3 == 0) continue;
+            auto rock = reg.create();
+            reg.addComponent<duck::Transform>(rock, 110.0f + col * 115.0f, 90.0f + row * 78.0f, 0.0f, 1.0f, 1.0f);
+            reg.addComponent<duck::Collider>(rock, duck::Collider::Type::AABB, 22.0f, 22.0f, 22.0f, true);
+        }
+    }
+
+    const int innerRingCount = 24 * ringScale;
+    const int outerRingCount = 40 * ringScale;
+    for (int i = 0; i < innerRingCount + outerRingCount; ++i) {
+        bool outer = i >= innerRingCount;
+        int ringIndex = outer ? i - innerRingCount : i;
+        int ringCount = outer ? outerRingCount : innerRingCount;
+        float radius = (outer ? 290.0f : 170.0f) + (ringScale > 1 ? rng.uniform(-120.0f, 120.0f) : 0.0f);
+        float angle = (static_cast<float>(ringIndex) / static_cast<float>(ringCount)) * 6.2831853f;
+
+        auto enemy = reg.create();
+        reg.addComponent<duck::Transform>(enemy, 640.0f + std::cos(angle) * radius,
+                                          360.0f + std::sin(angle) * radius, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::RigidBody>(enemy, -std::cos(angle) * 80.0f, -std::sin(angle) * 80.0f, 1.0f, 0.88f);
+        reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 19.0f, 19.0f, 19.0f, true);
+        scene.dynamicBodies.push_back(enemy);
+    }
+    reg.registerQuery<duck::Transform, duck::Collider>();
+    reg.context<duck::CollisionWorld>().setBroadPhase(type);
+
+    duck::CollisionSystem system;
+    system.setSimdLevel(simd);
+    system.update(reg, dt);
+
+    double totalMs = 0.0;
+    size_t pairCount = 0;
+    for (int t = 0; t < ticks; ++t) {
+        moveBodies(scene, dt);
+        auto t0 = Clock::now();
+        system.update(reg, dt);
+        totalMs += elapsedMs(t0, Clock::now());
+        pairCount += system.lastPairCount();
+    }
+    std::printf("  %-8s x%-3d %-6s (%5d enemies) : %8.4f ms/tick（%zu pairs/tick）\n",
+                duck::broadPhaseName(type), ringScale, duck::simdLevelName(system.simdLevel()), innerRingCount + outerRingCount,
+                totalMs / ticks, pairCount / static_cast<size_t>(ticks));
+}
+
+// 5 萬個彼此重疊的圓（每 900 px² 一個，半徑 19）：量 CollisionSystem::update 隨執行緒數的變化
+// broad phase 和接觸事件仍是循序的，只有 narrow phase 的各階段會平行
+void bench_crowd_threads(unsigned threads, int bodyCount, int ticks) {
+    const float dt = 1.0f / 60.0f;
+    Lcg rng;
+    Scene scene;
+    scene.worldSize = std::sqrt(static_cast<float>(bodyCount) * 900.0f);
+    auto& reg = scene.registry;
+    for (int i = 0; i < bodyCount; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, rng.uniform(0.0f, scene.worldSize),
+                                          rng.uniform(0.0f, scene.worldSize), 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 19.0f, 19.0f, 19.0f, true);
+        reg.addComponent<duck::RigidBody>(e, rng.uniform(-60.0f, 60.0f), rng.uniform(-60.0f, 60.0f), 1.0f, 1.0f);
+        scene.dynamicBodies.push_back(e);
+    }
+    reg.registerQuery<duck::Transform, duck::Collider>();
+    reg.context<duck::CollisionWorld>().setBroadPhase(duck::BroadPhaseType::HashGrid);
+
+    duck::CollisionSystem system;
+    system.setThreadCount(threads);
+    system.update(reg, dt);
+
+    double totalMs = 0.0;
+    size_t contacts = 0;
+    for (int t = 0; t < ticks; ++t) {
+        moveBodies(scene, dt);
+        auto t0 = Clock::now();
+        system.update(reg, dt);
+        totalMs += elapsedMs(t0, Clock::now());
+        contacts += reg.context<duck::ContactCache>().contactCount();
+    }
+    std::printf("  %2u threads (%d bodies) : %8.3f ms/tick（%zu contacts/tick）\n",
+                system.threadCount(), bodyCount, totalMs / ticks, contacts / static_cast<size_t>(ticks));
+}
+
+// 一大群靜止的敵人擠在格子上（間距 40、半徑 19、位置抖動 ±3，部分相鄰的圓重疊幾 px）：
+// 先跑 settleTicks 讓它們推開、靜止，再量之後每個 tick 的 CollisionSystem::update。
+// 休眠開啟時整群睡著，broad phase 與 narrow phase 幾乎沒有工作
+void bench_idle_crowd(bool sleeping, int iterations, int bodyCount, int settleTicks, int ticks) {
+    const float dt = 1.0f / 60.0f;
+    duck::Registry reg;
+    Lcg rng;
+    int side = static_cast<int>(std::sqrt(static_cast<float>(bodyCount)));
+    for (int i = 0; i < side * side; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, 40.0f * static_cast<float>(i % side) + rng.uniform(-3.0f, 3.0f),
+                                          40.0f * static_cast<float>(i / side) + rng.uniform(-3.0f, 3.0f),
+                                          0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 19.0f, 19.0f, 19.0f, true);
+        reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+    }
+    auto& world = reg.context<duck::CollisionWorld>();
+    world.setBroadPhase(duck::BroadPhaseType::HashGrid);
+    world.setSleepingEnabled(sleeping);
+
+    duck::CollisionSystem system;
+    system.setThreadCount(1);
+    system.setSolverIterations(iterations);
+    auto s0 = Clock::now();
+    for (int t = 0; t < settleTicks; ++t) system.update(reg, dt);
+    double settleMs = elapsedMs(s0, Clock::now());
+
+    double totalMs = 0.0;
+    for (int t = 0; t < ticks; ++t) {
+        auto t0 = Clock::now();
+        system.update(reg, dt);
+        totalMs += elapsedMs(t0, Clock::now());
+    }
+    std::printf("  sleep=%-3s iterations=%d (%d bodies) : settle %8.1f ms, idle %8.3f ms/tick"
+                "（asleep %zu, pairs %zu）\n",
+                sleeping ? "on" : "off", iterations, side * side, settleMs, totalMs / ticks,
+                world.sleepingCount(), system.lastPairCount());
+}
+
+} // namespace
+
+// 視線：每個動態物體朝場景中心拉一條最長 400px 的線段（敵人的偵測距離），整批 raycast。
+// obstacleOnly = true 是 EnemySystem 的用法（只被石頭擋，不查 broad phase）；
+// false 時動態物體也會擋（hitscan 武器的用法）
+void bench_line_of_sight(duck::BroadPhaseType type, int solidCount, bool obstacleOnly, int ticks) {
+    const float dt = 1.0f / 60.0f;
+    Scene scene;
+    buildScene(scene, solidCount);
+    auto& reg = scene.registry;
+    reg.view<duck::Collider>([&](duck::EntityID e) {
+        if (!reg.hasComponent<duck::RigidBody>(e)) reg.getComponent<duck::Collider>(e).layer = duck::CollisionLayer::Obstacle;
+    });
+    auto& world = reg.context<duck::CollisionWorld>();
+    world.setBroadPhase(type);
+    world.sync(reg);
+
+    std::vector<duck::RayCast> rays;
+    std::vector<duck::RayHit> hits;
+    const float center = scene.worldSize * 0.5f;
+    double totalMs = 0.0;
+    size_t hitCount = 0;
+    for (int t = 0; t < ticks; ++t) {
+        moveBodies(scene, dt);
+        world.sync(reg);
+        rays.clear();
+        for (auto e : scene.dynamicBodies) {
+            const auto& tf = reg.getComponent<duck::Transform>(e);
+            float dx = center - tf.x;
+            float dy = center - tf.y;
+            float len = std::sqrt(dx * dx + dy * dy);
+            float scale = len > 400.0f ? 400.0f / len : 1.0f;
+            duck::RayCast ray;
+            ray.x = tf.x;
+            ray.y = tf.y;
+            ray.dx = dx * scale;
+            ray.dy = dy * scale;
+            ray.filter = {duck::CollisionLayer::Enemy,
+                          obstacleOnly ? duck::CollisionLayer::Obstacle : duck::CollisionLayer::All};
+            ray.ignore = e;
+            rays.push_back(ray);
+        }
+        auto t0 = Clock::now();
+        world.raycast(reg, rays, hits);
+        totalMs += elapsedMs(t0, Clock::now());
+        for (const auto& hit : hits) hitCount += hit.hit() ? 1 : 0;
+    }
+    std::printf("  %-8s %6d solids, %6zu rays %-9s : %8.3f ms/batch（%zu hits）\n",
+                duck::broadPhaseName(type), solidCount, rays.size(), obstacleOnly ? "obstacle" : "all",
+                totalMs / ticks, hitCount / static_cast<size_t>(ticks));
+}
+
+// 彈幕：bulletCount 顆子彈在 20k solid 的場景裡亂飛（900 px/s，壽命夠長不會過期），
+// 量 ProjectileManager 每個 tick 的 integrate + sweep；batch = 1 等於每顆子彈各查一次 broad phase
+void bench_projectiles(int bulletCount, size_t batch, duck::SimdLevel simd, int ticks) {
+    const float dt = 1.0f / 60.0f;
+    Scene scene;
+    buildScene(scene, 20000);
+    auto& reg = scene.registry;
+    auto& world = reg.context<duck::CollisionWorld>();
+    world.setBroadPhase(duck::BroadPhaseType::HashGrid);
+    world.sync(reg);
+
+    // 撞到東西的子彈在 tick 之間（不計時）補回來，子彈數量維持固定
+    Lcg rng;
+    auto& projectiles = reg.context<duck::ProjectileManager>();
+    projectiles.setSimdLevel(simd);
+    projectiles.setSweepBatchSize(batch);
+    auto spawnRandom = [&]() {
+        duck::ProjectileSpawn spawn;
+        spawn.x = rng.uniform(0.0f, scene.worldSize);
+        spawn.y = rng.uniform(0.0f, scene.worldSize);
+        float angle = rng.uniform(0.0f, 6.2831853f);
+        spawn.vx = std::cos(angle) * 900.0f;
+        spawn.vy = std::sin(angle) * 900.0f;
+        spawn.lifetime = 1000.0f;
+        projectiles.spawn(spawn);
+    };
+    for (int i = 0; i < bulletCount; ++i) spawnRandom();
+
+    std::vector<duck::ProjectileHit> hits;
+    double integrateMs = 0.0;
+    double sweepMs = 0.0;
+    size_t batches = 0;
+    size_t hitCount = 0;
+    for (int t = 0; t < ticks; ++t) {
+        auto t0 = Clock::now();
+        projectiles.integrate(dt);
+        auto t1 = Clock::now();
+        hits.clear();
+        projectiles.sweep(reg, world, dt, hits);
+        auto t2 = Clock::now();
+        integrateMs += elapsedMs(t0, t1);
+        sweepMs += elapsedMs(t1, t2);
+        batches += projectiles.lastBatchCount();
+        hitCount += hits.size();
+        for (size_t h = 0; h < hits.size(); ++h) spawnRandom();
+    }
+    std::printf("  %6d bullets batch=%-3zu %-6s : integrate %7.4f ms, sweep %8.4f ms"
+                "（%zu queries, %zu hits /tick）\n",
+                bulletCount, batch, duck::simdLevelName(projectiles.simdLevel()),
+                integrateMs / ticks, sweepMs / ticks, batches / static_cast<size_t>(ticks),
+                hitCount / static_cast<size_t>(ticks));
+}
+
+// 掉落物：itemCount 個靜態 trigger 散在 20k solid + 500 敵人的場景裡，一個玩家在場上走來走去，
+// 量整個 fixed tick 會碰到掉落物的部分：SpatialIndex 重建 + EnemySystem + CollisionSystem + PickupSystem
+// （SpatialIndex 和 Engine 一樣只建 EnemySystem 查的層）。
+// 對照組：全部層都建的 SpatialIndex（舊的寫法，掉落物也進 grid），
+// 以及每個 tick 對每個掉落物算一次到玩家的距離（舊的拾取寫法）
+void bench_pickup_triggers(int itemCount, int ticks) {
+    const float dt = 1.0f / 60.0f;
+    Scene scene;
+    buildScene(scene, 20000);
+    auto& reg = scene.registry;
+    Lcg rng;
+    rng.state = 777u;
+    for (int i = 0; i < 500; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, rng.uniform(0.0f, scene.worldSize), rng.uniform(0.0f, scene.worldSize),
+                                          0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 16.0f, 16.0f, 16.0f, true,
+                                         duck::CollisionLayer::Enemy, duck::CollisionLayer::All);
+        reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        reg.addComponent<duck::Health>(e, 50.0f, 50.0f);
+        reg.addComponent<duck::EnemyState>(e, duck::EnemyState{});
+    }
+    for (int i = 0; i < itemCount; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, rng.uniform(0.0f, scene.worldSize), rng.uniform(0.0f, scene.worldSize),
+                                          0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Item>(e);
+        reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 36.0f, 36.0f, 36.0f, false,
+                                         duck::CollisionLayer::Pickup, duck::CollisionLayer::Player);
+    }
+    auto player = reg.create();
+    reg.addComponent<duck::Transform>(player, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(player, duck::Collider::Type::Circle, 24.0f, 24.0f, 24.0f, true,
+                                     duck::CollisionLayer::Player, duck::CollisionLayer::All);
+    reg.addComponent<duck::RigidBody>(player, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::InputControlled>(player);
+    reg.addComponent<duck::Inventory>(player);
+    // 和 Engine 註冊同一組快取查詢：沒註冊的 view 會從頭掃整個 Transform pool（掉落物也在裡面）
+    reg.registerQuery<duck::Transform, duck::InputControlled>();
+    reg.registerQuery<duck::Transform, duck::RigidBody, duck::EnemyState>();
+    reg.registerQuery<duck::Transform, duck::Item>();
+    reg.registerQuery<duck::Health, duck::InputControlled>();
+    auto& world = reg.context<duck::CollisionWorld>();
+    world.setBroadPhase(duck::BroadPhaseType::HashGrid);
+    world.sync(reg);
+    auto& index = reg.context<duck::SpatialIndex>();
+    index.setLayers(duck::EnemySystem::NEARBY_LAYERS);
+    duck::SpatialIndex allLayers;
+
+    duck::EnemySystem enemies;
+    duck::CollisionSystem collision;
+    duck::PickupSystem pickups;
+    double tickMs = 0.0;
+    double indexMs = 0.0;
+    double allLayersMs = 0.0;
+    double scanMs = 0.0;
+    size_t candidates = 0;
+    size_t scanHits = 0;
+    for (int t = 0; t < ticks; ++t) {
+        moveBodies(scene, dt);
+        auto& tf = reg.getComponent<duck::Transform>(player);
+        tf.x = scene.worldSize * static_cast<float>(t + 1) / static_cast<float>(ticks + 1);
+        tf.y = tf.x;
+        auto t0 = Clock::now();
+        index.rebuild(reg);
+        auto t1 = Clock::now();
+        enemies.update(reg, dt);
+        collision.update(reg, dt);
+        pickups.update(reg);
+        auto t2 = Clock::now();
+        allLayers.rebuild(reg);
+        auto t3 = Clock::now();
+        const auto& playerTf = reg.getComponent<duck::Transform>(player);
+        reg.view<duck::Transform, duck::Item>([&](duck::EntityID e) {
+            const auto& itemTf = reg.getComponent<duck::Transform>(e);
+            float dx = itemTf.x - playerTf.x;
+            float dy = itemTf.y - playerTf.y;
+            float r = reg.getComponent<duck::Item>(e).pickupRadius;
+            if (dx * dx + dy * dy <= r * r) ++scanHits;
+        });
+        auto t4 = Clock::now();
+        tickMs += elapsedMs(t0, t2);
+        indexMs += elapsedMs(t0, t1);
+        allLayersMs += elapsedMs(t2, t3);
+        scanMs += elapsedMs(t3, t4);
+        candidates += world.lastTriggerCandidates();
+    }
+    std::printf("  %6d items : tick %8.4f ms（index %7.4f ms, %zu trigger candidates /tick）, "
+                "all-layer index %8.4f ms, per-item scan %8.4f ms（%zu hits /tick）\n",
+                itemCount, tickMs / ticks, indexMs / ticks, candidates / static_cast<size_t>(ticks),
+                allLayersMs / ticks, scanMs / ticks, scanHits / static_cast<size_t>(ticks));
+}
+
+int main() {
+    std::printf("=== Collision Benchmarks ===\n");
+    const duck::BroadPhaseType types[] = {duck::BroadPhaseType::Quadtree, duck::BroadPhaseType::HashGrid,
+                                          duck::BroadPhaseType::SweepAndPrune, duck::BroadPhaseType::Lbvh};
+
+    std::printf("--- Stress scene replica（Engine::setupStressScene 的配置）---\n");
+    for (int scale : {1, 10, 40}) {
+        for (auto type : types) bench_stress_scene(type, scale, 120);
+    }
+    std::printf("--- Narrow phase：純量 vs 批次 SIMD（stress x40）---\n");
+    for (auto level : {duck::SimdLevel::Scalar, duck::SimdLevel::SSE2, duck::SimdLevel::AVX2}) {
+        bench_stress_scene(duck::BroadPhaseType::SweepAndPrune, 40, 120, level);
+    }
+    std::printf("--- CollisionSystem::update（40%% static AABB + 60%% moving circles）---\n");
+    for (auto type : types) {
+        bench_collision_tick(type, 5000, 30);
+        bench_collision_tick(type, 20000, 20);
+        bench_collision_tick(type, 100000, 5);
+    }
+    std::printf("--- Broad phase only（sync + findPairs）---\n");
+    for (auto type : types) {
+        bench_broad_phase(type, 5000, 30);
+        bench_broad_phase(type, 20000, 20);
+        bench_broad_phase(type, 100000, 5);
+    }
+    std::printf("--- Broad phase only, 50k moving circles（no statics）---\n");
+    for (auto type : types) bench_broad_phase(type, 50000, 10, 0);
+    std::printf("--- LBVH 整棵重建，100k proxies 全部換位置 ---\n");
+    for (unsigned threads : {1u, 2u, 4u, 8u}) bench_lbvh_rebuild(threads, 100000, 10);
+    std::printf("--- 全部傳送：100k moving circles 每 tick 瞬移（sync + findPairs）---\n");
+    for (auto type : types) bench_teleport(type, 100000, 5);
+    bench_teleport(duck::BroadPhaseType::Lbvh, 100000, 5, 8);
+    std::printf("--- 平行 narrow phase，50k overlapping circles（grid）---\n");
+    for (unsigned threads : {1u, 2u, 4u, 8u}) bench_crowd_threads(threads, 50000, 10);
+    std::printf("--- 靜止的密集敵人群：relaxation 輪數 × 休眠（grid）---\n");
+    for (int iterations : {1, duck::CollisionSystem::DEFAULT_SOLVER_ITERATIONS}) {
+        bench_idle_crowd(false, iterations, 20000, 120, 20);
+        bench_idle_crowd(true, iterations, 20000, 120, 20);
+    }
+    std::printf("--- 牆：StaticBvh 配對 vs 靜態距離場（grid）---\n");
+    for (int solids : {5000, 20000}) {
+        for (float cell : {0.0f, 8.0f, duck::DistanceField::DEFAULT_CELL_SIZE, 2.0f}) bench_static_field(cell, solids, 20);
+    }
+    std::printf("--- 旋轉的石頭：AABB vs OBB（SAT），20k solids（grid）---\n");
+    for (auto level : {duck::SimdLevel::Scalar, duck::SimdLevel::AVX2}) {
+        bench_rotated_rocks(false, level, 20000, 20);
+        bench_rotated_rocks(true, level, 20000, 20);
+    }
+    std::printf("--- 視線 / hitscan：CollisionWorld::raycast，每個動態物體一條 ≤400px 的線段 ---\n");
+    for (int solids : {5000, 20000}) {
+        bench_line_of_sight(duck::BroadPhaseType::HashGrid, solids, true, 10);
+        for (auto type : types) bench_line_of_sight(type, solids, false, 10);
+    }
+    std::printf("--- 彈幕：ProjectileManager integrate + sweep（20k solids, grid）---\n");
+    for (auto level : {duck::SimdLevel::Scalar, duck::SimdLevel::AVX2}) {
+        bench_projectiles(50000, 1, level, 10);
+        bench_projectiles(50000, duck::ProjectileManager::SWEEP_BATCH, level, 10);
+    }
+    std::printf("--- 掉落物：整個 fixed tick（index + enemy + collision + pickup），20k solids + 500 enemies（grid）---\n");
+    for (int items : {1000, 10000, 100000}) bench_pickup_triggers(items, 20);
+    return 0;
+}
@@ -0,0 +1,287 @@
+// benchmarks/bench_ecs.cpp
+// ECS 微基準測試：不依賴 OpenGL/SDL2，純 CPU
+// 用法：./bench_ecs（建議 Release 編譯，Debug 的 assert 會扭曲結果）
+
+#include "ecs/Components.h"
+#include "ecs/Registry.h"
+#include "systems/EnemySystem.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point begin, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+// 固定種子的 LCG：每次跑出來的受害者集合都一樣，結果可重現
+struct Lcg {
+    std::uint32_t state = 12345u;
+    std::uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+};
+
+// 建立與壓測場景類似的 entity 組成：全部有 Transform/Sprite/Collider，
+// 一半有 RigidBody，四分之一有 Health
+void populate(duck::Registry& reg, int count, std::vector<duck::EntityID>& outEntities) {
+    outEntities.clear();
+    outEntities.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        auto e = reg.create();
+        float x = static_cast<float>(i % 1000);
+        float y = static_cast<float>(i / 1000);
+        reg.addComponent<duck::Transform>(e, x, y, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Sprite>(e, 1u, 16.0f, 16.0f, 4, 1.0f, 1.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 8.0f, 8.0f, 8.0f, true);
+        if (i % 2 == 0) reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        if (i % 4 == 0) reg.addComponent<duck::Health>(e, 1.0f, 1.0f);
+        outEntities.push_back(e);
+    }
+}
+
+std::vector<duck::EntityID> pickVictims(const std::vector<duck::EntityID>& entities, int percent) {
+    Lcg rng;
+    std::vector<duck::EntityID> victims;
+    for (auto e : entities) {
+        if (static_cast<int>(rng.next() % 100u) < percent) victims.push_back(e);
+    }
+    return victims;
+}
+
+// --------------------------------------------------
+// destroy 迴圈 vs destroyMany：100k entity 中銷毀 10%
+// --------------------------------------------------
+void bench_destroy_many() {
+    const int entityCount = 100000;
+    const int percent = 10;
+    const int repeats = 5;
+
+    double loopMs = 0.0;
+    double batchMs = 0.0;
+    size_t victimCount = 0;
+
+    for (int r = 0; r < repeats; ++r) {
+        std::vector<duck::EntityID> entities;
+
+        {
+            duck::Registry reg;
+            populate(reg, entityCount, entities);
+            auto victims = pickVictims(entities, percent);
+            victimCount = victims.size();
+
+            auto t0 = Clock::now();
+            for (auto e : victims) {
+                if (reg.alive(e)) reg.destroy(e);
+            }
+            loopMs += elapsedMs(t0, Clock::now());
+        }
+
+        {
+            duck::Registry reg;
+            populate(reg, entityCount, entities);
+            auto victims = pickVictims(entities, percent);
+
+            auto t0 = Clock::now();
+            reg.destroyMany(victims);
+            batchMs += elapsedMs(t0, Clock::now());
+        }
+    }
+
+    loopMs /= repeats;
+    batchMs /= repeats;
+    std::printf("  destroy loop   : %8.3f ms（%zu / %d entities）\n", loopMs, victimCount, entityCount);
+    std::printf("  destroyMany    : %8.3f ms（x%.2f）\n", batchMs, batchMs > 0.0 ? loopMs / batchMs : 0.0);
+}
+
+// --------------------------------------------------
+// Enemy 熱/冷拆分：100k 敵人
+// --------------------------------------------------
+// LegacyEnemy 是拆分前 Components.h 裡的 Enemy（72 bytes），
+// 兩個 kernel 做一樣的事：冷卻倒數、距離判斷、狀態轉換、巡邏目標計算，
+// 只差在調校值是從每隻自己的欄位讀，還是從共享 archetype 表讀。
+struct LegacyEnemy {
+    enum class State { Idle, Chase, Attack, Patrol, Dead };
+    State state = State::Idle;
+    float touchDamage = 1.0f;
+    float touchInterval = 0.75f;
+    float touchCooldown = 0.0f;
+    float detectRange = 320.0f;
+    float attackRange = 56.0f;
+    float loseSightDelay = 1.5f;
+    float loseSightTimer = 1.5f;
+    float moveAcceleration = 1100.0f;
+    float patrolRadius = 90.0f;
+    float patrolAngle = 0.0f;
+    float patrolWaitTimer = 0.0f;
+    float patrolWaitDuration = 0.7f;
+    float deadTimer = 0.5f;
+    float deadLifetime = 0.5f;
+    float homeX = 0.0f;
+    float homeY = 0.0f;
+    bool homeInitialized = false;
+};
+
+template <typename EnemyT, typename GetArchetype>
+float runEnemyKernel(std::vector<EnemyT>& enemies,
+                     const std::vector<duck::Transform>& transforms,
+                     GetArchetype getArchetype,
+                     float playerX, float playerY, float dt) {
+    float accel = 0.0f;
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        auto& enemy = enemies[i];
+        const auto& arch = getArchetype(enemy);
+        const auto& tf = transforms[i];
+
+        if (enemy.touchCooldown > 0.0f) enemy.touchCooldown -= dt;
+        float dx = playerX - tf.x;
+        float dy = playerY - tf.y;
+        float distSq = dx * dx + dy * dy;
+        bool sees = distSq <= arch.detectRange * arch.detectRange;
+        bool inAttack = distSq <= arch.attackRange * arch.attackRange;
+
+        if (sees) {
+            enemy.loseSightTimer = arch.loseSightDelay;
+            enemy.state = inAttack ? decltype(enemy.state)(2) : decltype(enemy.state)(1);
+            accel += arch.moveAcceleration * dt;
+        } else {
+            enemy.loseSightTimer -= dt;
+            enemy.patrolWaitTimer -= dt;
+            if (enemy.patrolWaitTimer <= 0.0f) {
+                enemy.patrolAngle += 1.65f;
+                enemy.patrolWaitTimer = arch.patrolWaitDuration;
+            }
+            accel += enemy.homeX + arch.patrolRadius * enemy.patrolAngle * 1e-6f;
+        }
+    }
+    return accel;
+}
+
+void bench_enemy_hot_cold_split() {
+    const int enemyCount = 100000;
+    const int ticks = 60;
+    const float dt = 1.0f / 60.0f;
+
+    std::vector<duck::Transform> transforms(static_cast<size_t>(enemyCount));
+    for (int i = 0; i < enemyCount; ++i) {
+        transforms[static_cast<size_t>(i)].x = static_cast<float>(i % 1000) * 4.0f;
+        transforms[static_cast<size_t>(i)].y = static_cast<float>(i / 1000) * 4.0f;
+    }
+
+    std::vector<LegacyEnemy> legacy(static_cast<size_t>(enemyCount));
+    std::vector<duck::EnemyState> states(static_cast<size_t>(enemyCount));
+    duck::EnemyArchetypeTable table;
+    duck::EnemyArchetype outer;
+    outer.detectRange = 420.0f;
+    uint16_t outerID = table.add(outer);
+    for (int i = 0; i < enemyCount; ++i) {
+        if (i % 2) {
+            legacy[static_cast<size_t>(i)].detectRange = 420.0f;
+            states[static_cast<size_t>(i)].archetype = outerID;
+        }
+    }
+
+    float sink = 0.0f;
+    auto t0 = Clock::now();
+    for (int t = 0; t < ticks; ++t) {
+        sink += runEnemyKernel(legacy, transforms,
+            [](const LegacyEnemy& e) -> const LegacyEnemy& { return e; },
+            2000.0f, 200.0f, dt);
+    }
+    double legacyMs = elapsedMs(t0, Clock::now()) / ticks;
+
+    t0 = Clock::now();
+    for (int t = 0; t < ticks; ++t) {
+        sink += runEnemyKernel(states, transforms,
+            [&](const duck::EnemyState& e) -> const duck::EnemyArchetype& { return table.get(e.archetype); },
+            2000.0f, 200.0f, dt);
+    }
+    double splitMs = elapsedMs(t0, Clock::now()) / ticks;
+
+    double legacyMB = static_cast<double>(sizeof(LegacyEnemy)) * enemyCount / (1024.0 * 1024.0);
+    double splitMB = static_cast<double>(sizeof(duck::EnemyState)) * enemyCount / (1024.0 * 1024.0);
+    std::printf("  fat Enemy      : %3zu B/enemy, %6.2f MB/tick, %8.3f ms/tick\n",
+                sizeof(LegacyEnemy), legacyMB, legacyMs);
+    std::printf("  EnemyState     : %3zu B/enemy, %6.2f MB/tick, %8.3f ms/tick（x%.2f）\n",
+                sizeof(duck::EnemyState), splitMB, splitMs, splitMs > 0.0 ? legacyMs / splitMs : 0.0);
+
+    // 實際的 EnemySystem（含 Registry 查詢成本），給個絕對量級參考
+    duck::Registry reg;
+    auto player = reg.create();
+    reg.addComponent<duck::Transform>(player, 2000.0f, 200.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::InputControlled>(player);
+    for (int i = 0; i < enemyCount; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, transforms[static_cast<size_t>(i)]);
+        reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.88f);
+        reg.addComponent<duck::EnemyState>(e, states[static_cast<size_t>(i)]);
+    }
+    reg.registerQuery<duck::Transform, duck::RigidBody, duck::EnemyState>();
+    duck::EnemySystem system;
+    t0 = Clock::now();
+    for (int t = 0; t < 10; ++t) system.update(reg, dt);
+    std::printf("  EnemySystem    : %8.3f ms/tick（Registry + 狀態機完整路徑）\n",
+                elapsedMs(t0, Clock::now()) / 10.0);
+
+    if (sink == 12345.0f) std::printf("%f\n", sink);  // 防止編譯器把 kernel 整段優化掉
+}
+
+// --------------------------------------------------
+// 分頁 dense 儲存：1M 次 push_back 的最壞單次延遲 + 遍歷
+// --------------------------------------------------
+template <typename Container>
+void measureGrowth(const char* label, Container& storage, int count) {
+    double worstUs = 0.0;
+    auto start = Clock::now();
+    for (int i = 0; i < count; ++i) {
+        auto t0 = Clock::now();
+        storage.push_back(duck::Transform{static_cast<float>(i), 0.0f, 0.0f, 1.0f, 1.0f});
+        double us = elapsedMs(t0, Clock::now()) * 1000.0;
+        if (us > worstUs) worstUs = us;
+    }
+    std::printf("  %-14s : total %8.3f ms, worst push_back %8.1f us\n",
+                label, elapsedMs(start, Clock::now()), worstUs);
+}
+
+void bench_paged_storage() {
+    const int count = 1000000;
+
+    std::vector<duck::Transform> flat;
+    measureGrowth("std::vector", flat, count);
+
+    duck::PagedVector<duck::Transform, 1024> paged;
+    measureGrowth("PagedVector", paged, count);
+
+    float sink = 0.0f;
+    auto t0 = Clock::now();
+    for (const auto& tf : flat) sink += tf.x;
+    double flatMs = elapsedMs(t0, Clock::now());
+
+    t0 = Clock::now();
+    paged.forEachPage([&](duck::Transform* data, size_t n) {
+        for (size_t i = 0; i < n; ++i) sink += data[i].x;
+    });
+    double pagedMs = elapsedMs(t0, Clock::now());
+    std::printf("  iterate 1M     : vector %6.3f ms, paged %6.3f ms\n", flatMs, pagedMs);
+
+    if (sink == 12345.0f) std::printf("%f\n", sink);
+}
+
+} // namespace
+
+int main() {
+    std::printf("=== ECS Benchmarks ===\n");
+    std::printf("--- destroy vs destroyMany ---\n");
+    bench_destroy_many();
+    std::printf("--- Enemy hot/cold split（100k enemies）---\n");
+    bench_enemy_hot_cold_split();
+    std::printf("--- Paged dense storage（1M Transform）---\n");
+    bench_paged_storage();
+    return 0;
+}
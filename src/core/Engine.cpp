@@ -1,5 +1,6 @@
 #include "core/Engine.h"
 #include "ecs/Components.h"
+#include "physics/SpatialIndex.h"
 #include <SDL2/SDL.h>
 #include <algorithm>
 #include <cmath>
@@ -9,6 +10,9 @@
 
 namespace duck {
 
+// --validate-collision 第一次抓到差異時寫的場景（tests/test_collision_validation 可以直接重播）
+static constexpr const char* COLLISION_REPRO_PATH = "collision_repro.scene";
+
 // 輔助：建立純色紋理並登記到資源表，回傳 ID
 static uint32_t registerTexture(
     std::unordered_map<uint32_t, std::unique_ptr<Texture>>& store,
@@ -73,7 +77,18 @@ Engine::Engine()
 
 Engine::Engine(Config config)
     : m_stressMode(config.stressMode),
-      m_infinitePlayerHealth(config.stressMode) {}
+      m_infinitePlayerHealth(config.stressMode) {
+    m_registry.context<CollisionWorld>().setBroadPhaseThreadCount(config.collisionThreads);
+    m_registry.context<CollisionWorld>().setBroadPhase(config.broadPhase);
+    m_registry.context<CollisionWorld>().setSleepingEnabled(config.sleeping);
+    m_registry.context<CollisionWorld>().setStaticFieldCellSize(config.staticFieldCellSize);
+    m_collisionSystem.setThreadCount(config.collisionThreads);
+    m_collisionSystem.setSolverIterations(config.solverIterations);
+    // SpatialIndex 目前只有 EnemySystem 在查：其他層（掉落物、牆）不必每個 tick 重建
+    m_registry.context<SpatialIndex>().setLayers(EnemySystem::NEARBY_LAYERS);
+    m_validateCollision = config.validateCollision;
+    if (m_validateCollision) m_collisionSystem.setValidator(&m_collisionValidator);
+}
 
 bool Engine::init() {
     const char* title = m_stressMode
@@ -83,6 +98,7 @@ bool Engine::init() {
     if (!m_renderer.init(1280, 720)) return false;
 
     setupScene();
+    registerHotQueries();
 
     // 建立 DebugDraw 用的 1x1 白色紋理
     uint32_t debugTexID = registerTexture(m_textureStore, m_texturePtrs, m_nextTextureID,
@@ -96,12 +112,44 @@ bool Engine::init() {
     if (m_stressMode) {
         std::printf("Stress mode: ON（大量敵人/障礙物 + 每秒 profiler）\n");
     }
+    std::printf("Broad phase: %s\n",
+                broadPhaseName(m_registry.context<CollisionWorld>().broadPhaseType()));
+    std::printf("Collision threads: %u（narrow phase %s）\n",
+                m_collisionSystem.threadCount(), simdLevelName(m_collisionSystem.simdLevel()));
+    std::printf("Collision solver: %d 輪 relaxation，休眠 %s\n",
+                m_collisionSystem.solverIterations(),
+                m_registry.context<CollisionWorld>().sleepingEnabled() ? "ON" : "OFF");
+    if (m_registry.context<CollisionWorld>().staticFieldCellSize() > 0.0f) {
+        std::printf("Static distance field: %.1fpx 格子\n",
+                    m_registry.context<CollisionWorld>().staticFieldCellSize());
+    } else {
+        std::printf("Static distance field: OFF\n");
+    }
+    if (m_validateCollision) {
+        std::printf("Collision validation: ON（每個 tick 對照 O(n²) 暴力法，出錯時寫 %s）\n",
+                    COLLISION_REPRO_PATH);
+    }
 
     std::printf("=== Engine 初始化完成 ===\n");
     std::printf("WASD 移動，滑鼠瞄準，左鍵射擊，ESC 退出\n");
     return true;
 }
 
+// fixed tick 每次都會跑的 view 簽名：註冊成快取查詢後，
+// 穩定狀態下遍歷不需要逐一檢查元件（順序要和各 System 的 view 呼叫一致）
+void Engine::registerHotQueries() {
+    m_registry.registerQuery<Transform, InputControlled>();
+    m_registry.registerQuery<Transform, RigidBody, EnemyState>();
+    m_registry.registerQuery<Transform, RigidBody, InputControlled>();
+    m_registry.registerQuery<Transform, RigidBody>();
+    m_registry.registerQuery<Transform, Weapon, InputControlled>();
+    m_registry.registerQuery<Transform, Inventory, InputControlled>();
+    m_registry.registerQuery<Transform, Item>();
+    m_registry.registerQuery<Transform, Collider>();
+    m_registry.registerQuery<Transform, Sprite>();
+    m_registry.registerQuery<Health, InputControlled>();
+}
+
 void Engine::setupScene() {
     if (m_stressMode) {
         setupStressScene();
@@ -161,7 +209,8 @@ void Engine::setupStressScene() {
     m_registry.addComponent<RigidBody>(player, 0.0f, 0.0f, 1.0f, 0.85f);
     m_registry.addComponent<InputControlled>(player);
     m_registry.addComponent<Weapon>(player, bulletID, 900.0f, 0.06f, 0.0f, 2.0f, 10.0f, 1.0f);
-    m_registry.addComponent<Collider>(player, Collider::Type::Circle, 24.0f, 24.0f, 24.0f, true);
+    m_registry.addComponent<Collider>(player, Collider::Type::Circle, 24.0f, 24.0f, 24.0f, true,
+                                      CollisionLayer::Player, CollisionLayer::All);
     m_registry.addComponent<Health>(player, 10.0f, 10.0f);
     m_registry.addComponent<Inventory>(player);
 
@@ -174,11 +223,26 @@ void Engine::setupStressScene() {
             float y = 90.0f + static_cast<float>(row) * 78.0f;
             m_registry.addComponent<Transform>(rock, x, y, 0.0f, 1.0f, 1.0f);
             m_registry.addComponent<Sprite>(rock, rockID, 44.0f, 44.0f, 2, 1.0f, 1.0f, 1.0f, 1.0f);
-            m_registry.addComponent<Collider>(rock, Collider::Type::AABB, 22.0f, 22.0f, 22.0f, true);
+            m_registry.addComponent<Collider>(rock, Collider::Type::AABB, 22.0f, 22.0f, 22.0f, true,
+                                              CollisionLayer::Obstacle, CollisionLayer::All);
         }
     }
 
     // 兩圈敵人，讓碰撞、AI、Quadtree 都有壓力
+    // 內外圈各一種 archetype，所有敵人只共用兩筆調校資料
+    auto& archetypes = m_registry.context<EnemyArchetypeTable>();
+    EnemyArchetype innerArchetype;
+    innerArchetype.detectRange = 300.0f;
+    innerArchetype.attackRange = 52.0f;
+    innerArchetype.moveAcceleration = 1180.0f;
+    innerArchetype.patrolRadius = 48.0f;
+    EnemyArchetype outerArchetype = innerArchetype;
+    outerArchetype.detectRange = 420.0f;
+    outerArchetype.moveAcceleration = 980.0f;
+    outerArchetype.patrolRadius = 70.0f;
+    uint16_t innerArchetypeID = archetypes.add(innerArchetype);
+    uint16_t outerArchetypeID = archetypes.add(outerArchetype);
+
     const int innerRingCount = 24;
     const int outerRingCount = 40;
     for (int i = 0; i < innerRingCount + outerRingCount; ++i) {
@@ -194,28 +258,42 @@ void Engine::setupStressScene() {
         m_registry.addComponent<Transform>(enemy, x, y, 0.0f, 1.0f, 1.0f);
         m_registry.addComponent<Sprite>(enemy, duckID, 40.0f, 40.0f, 4, 0.85f, 0.2f, 0.2f, 1.0f);
         m_registry.addComponent<RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.88f);
-        m_registry.addComponent<Collider>(enemy, Collider::Type::Circle, 19.0f, 19.0f, 19.0f, true);
+        m_registry.addComponent<Collider>(enemy, Collider::Type::Circle, 19.0f, 19.0f, 19.0f, true,
+                                          CollisionLayer::Enemy, CollisionLayer::All);
         m_registry.addComponent<Health>(enemy, outer ? 4.0f : 3.0f, outer ? 4.0f : 3.0f);
 
-        Enemy enemyData;
-        enemyData.detectRange = outer ? 420.0f : 300.0f;
-        enemyData.attackRange = 52.0f;
-        enemyData.moveAcceleration = outer ? 980.0f : 1180.0f;
-        enemyData.patrolRadius = outer ? 70.0f : 48.0f;
+        EnemyState enemyData;
+        enemyData.archetype = outer ? outerArchetypeID : innerArchetypeID;
         enemyData.patrolAngle = angle;
-        m_registry.addComponent<Enemy>(enemy, enemyData);
+        m_registry.addComponent<EnemyState>(enemy, enemyData);
     }
 }
 
+// broad phase 和暴力法不一致：印出這個 tick 的差異，第一次出錯時另外把場景存成 repro
+void Engine::reportCollisionMismatch() {
+    const ValidationReport& report = m_collisionValidator.report();
+    for (const PairMismatch& mismatch : m_collisionValidator.lastMismatches()) {
+        std::printf("[validate] tick %zu: %s pair (%u, %u)\n", report.ticks - 1,
+                    pairMismatchName(mismatch.kind), mismatch.a, mismatch.b);
+    }
+    if (m_collisionReproWritten) return;
+    m_collisionReproWritten = true;
+    size_t bodies = 0;
+    bool reproduced = CollisionValidator::writeRepro(m_registry, m_registry.context<CollisionWorld>(),
+                                                     COLLISION_REPRO_PATH, bodies);
+    std::printf("[validate] %s 寫入 %s（%zu bodies）\n",
+                reproduced ? "從頭建 world 可以重現，縮小後" : "從頭建 world 無法重現（和歷史狀態有關），整個場景",
+                COLLISION_REPRO_PATH, bodies);
+}
+
 void Engine::printProfilerReport(double elapsedSeconds) {
     if (m_profileFrameCount <= 0) return;
 
     int enemyCount = 0;
-    int bulletCount = 0;
+    int bulletCount = static_cast<int>(m_registry.context<ProjectileManager>().size());
     int solidCount = 0;
 
-    m_registry.view<Enemy>([&](EntityID) { ++enemyCount; });
-    m_registry.view<Bullet>([&](EntityID) { ++bulletCount; });
+    m_registry.view<EnemyState>([&](EntityID) { ++enemyCount; });
     m_registry.view<Collider>([&](EntityID entity) {
         if (m_registry.getComponent<Collider>(entity).isSolid) ++solidCount;
     });
@@ -234,23 +312,70 @@ void Engine::printProfilerReport(double elapsedSeconds) {
         ? m_profileAccumWeaponMs / static_cast<double>(m_profileFixedStepCount) : 0.0;
     double avgCollisionMs = m_profileFixedStepCount > 0
         ? m_profileAccumCollisionMs / static_cast<double>(m_profileFixedStepCount) : 0.0;
+    // 碰撞計數都換成每 tick 平均
+    const CollisionStats& stats = m_profileCollision;
+    const BroadPhaseStats& broad = stats.broadPhase;
+    double perTick = stats.ticks > 0 ? 1.0 / static_cast<double>(stats.ticks) : 0.0;
+    double avgPairs = static_cast<double>(stats.pairs) * perTick;
+    double avgPruned = static_cast<double>(stats.prunedPairs) * perTick;
 
     double fps = elapsedSeconds > 0.0
         ? static_cast<double>(m_profileFrameCount) / elapsedSeconds : 0.0;
 
+    const QueryStats& queryStats = m_registry.queryStats();
+
     std::printf(
         "[profiler] fps=%.1f frame=%.3fms render=%.3fms fixed/frame=%.2f "
         "enemy=%.3fms move=%.3fms weapon=%.3fms collision=%.3fms "
-        "enemies=%d bullets=%d solids=%d\n",
+        "broadphase=%s pairs=%.0f pruned=%.0f "
+        "enemies=%d bullets=%d solids=%d sleeping=%zu "
+        "query_hit=%llu query_miss=%llu query_rebuild=%llu\n",
         fps, avgFrameMs, avgRenderMs, fixedStepsPerFrame,
         avgEnemyMs, avgMoveMs, avgWeaponMs, avgCollisionMs,
-        enemyCount, bulletCount, solidCount
+        broadPhaseName(m_registry.context<CollisionWorld>().broadPhaseType()), avgPairs, avgPruned,
+        enemyCount, bulletCount, solidCount, m_registry.context<CollisionWorld>().sleepingCount(),
+        static_cast<unsigned long long>(queryStats.hits),
+        static_cast<unsigned long long>(queryStats.misses),
+        static_cast<unsigned long long>(queryStats.rebuilds)
     );
+    m_registry.resetQueryStats();
+
+    // 直方圖：每 tick 平均有幾個節點 / bucket 落在 0、1、2-3、4-7、... 個 entry
+    char histogram[128];
+    int written = 0;
+    for (size_t i = 0; i < BroadPhaseStats::HISTOGRAM_BUCKETS; ++i) {
+        written += std::snprintf(histogram + written, sizeof(histogram) - static_cast<size_t>(written),
+                                 i == 0 ? "%.0f" : "/%.0f",
+                                 static_cast<double>(broad.entriesHistogram[i]) * perTick);
+    }
+    std::printf(
+        "[profiler] collision: nodes=%.0f max_depth=%zu entries/node=%s aabb_tests=%.0f "
+        "candidates=%.0f pairs=%.0f (static=%.0f) pruned=%.0f narrow_tests=%.0f hits=%.0f iterations=%.2f "
+        "field_bodies=%.0f field_pushes=%.0f bullet_queries=%.0f bullet_candidates/query=%.1f bullet_hits=%.0f\n",
+        static_cast<double>(broad.nodesVisited) * perTick, broad.maxDepth, histogram,
+        static_cast<double>(broad.aabbTests) * perTick,
+        static_cast<double>(broad.candidatePairs) * perTick, avgPairs,
+        static_cast<double>(stats.staticPairs) * perTick, avgPruned,
+        static_cast<double>(stats.narrowTests) * perTick, static_cast<double>(stats.hits) * perTick,
+        static_cast<double>(stats.iterations) * perTick,
+        static_cast<double>(stats.fieldBodies) * perTick, static_cast<double>(stats.fieldPushes) * perTick,
+        static_cast<double>(stats.bulletQueries) * perTick,
+        stats.bulletQueries > 0
+            ? static_cast<double>(stats.bulletCandidates) / static_cast<double>(stats.bulletQueries) : 0.0,
+        static_cast<double>(stats.bulletHits) * perTick);
+    if (m_validateCollision) {
+        // 驗證結果從開始累計，不隨 profiler 視窗歸零
+        const ValidationReport& report = m_collisionValidator.report();
+        std::printf("[profiler] validation: ticks=%zu mismatch_ticks=%zu expected=%zu reported=%zu extra=%zu\n",
+                    report.ticks, report.mismatchTicks, report.expectedPairs, report.reportedPairs,
+                    report.extraPairs);
+    }
 
     m_profileAccumMovementMs = 0.0;
     m_profileAccumWeaponMs = 0.0;
     m_profileAccumEnemyMs = 0.0;
     m_profileAccumCollisionMs = 0.0;
+    m_profileCollision = CollisionStats{};
     m_profileAccumRenderMs = 0.0;
     m_profileAccumFrameMs = 0.0;
     m_profileElapsedSeconds = 0.0;
@@ -310,22 +435,28 @@ void Engine::run() {
 
         while (accumulator >= FIXED_DT) {
             Uint64 t0 = SDL_GetPerformanceCounter();
+            // 共用的空間查詢每個 tick 開頭重建一次（時間算進 enemy 那一段），
+            // 之後的系統都查這份快照
+            m_registry.context<SpatialIndex>().rebuild(m_registry);
             m_enemySystem.update(m_registry, FIXED_DT);
             Uint64 t1 = SDL_GetPerformanceCounter();
             m_movementSystem.update(m_registry, m_input, FIXED_DT);
             Uint64 t2 = SDL_GetPerformanceCounter();
             m_weaponSystem.update(m_registry, m_input, FIXED_DT);
             Uint64 t3 = SDL_GetPerformanceCounter();
-            m_pickupSystem.update(m_registry);
-            Uint64 tPickup = SDL_GetPerformanceCounter();
             m_collisionSystem.update(m_registry, FIXED_DT);
             Uint64 t4 = SDL_GetPerformanceCounter();
+            if (m_validateCollision && m_collisionValidator.lastTickFailed()) reportCollisionMismatch();
+            // 拾取吃 CollisionSystem 這個 tick 產生的 trigger 事件，所以排在它後面（時間算進 weapon 那一段）
+            m_pickupSystem.update(m_registry);
+            Uint64 tPickup = SDL_GetPerformanceCounter();
 
             double counterToMs = 1000.0 / static_cast<double>(freq);
             m_profileAccumEnemyMs += static_cast<double>(t1 - t0) * counterToMs;
             m_profileAccumMovementMs += static_cast<double>(t2 - t1) * counterToMs;
-            m_profileAccumWeaponMs += static_cast<double>(tPickup - t2) * counterToMs;
-            m_profileAccumCollisionMs += static_cast<double>(t4 - tPickup) * counterToMs;
+            m_profileAccumWeaponMs += static_cast<double>((t3 - t2) + (tPickup - t4)) * counterToMs;
+            m_profileAccumCollisionMs += static_cast<double>(t4 - t3) * counterToMs;
+            m_profileCollision.add(m_collisionSystem.lastStats());
             ++m_profileFixedStepCount;
 
             bool playerDead = false;
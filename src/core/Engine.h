@@ -10,6 +10,7 @@
 #include "systems/WeaponSystem.h"
 #include "systems/EnemySystem.h"
 #include "systems/CollisionSystem.h"
+#include "physics/CollisionValidator.h"
 #include "systems/PickupSystem.h"
 #include <unordered_map>
 #include <memory>
@@ -42,6 +43,18 @@ class Engine {
 public:
     struct Config {
         bool stressMode = false;
+        // 碰撞 broad phase（--broadphase=quadtree|grid|sap|lbvh）
+        BroadPhaseType broadPhase = BroadPhaseType::Quadtree;
+        // 碰撞 narrow phase（與 lbvh 建樹）的執行緒數（--threads=N，0 = 硬體執行緒數）
+        unsigned collisionThreads = 0;
+        // 每個 tick 推開重疊的輪數（--solver-iterations=N）
+        int solverIterations = CollisionSystem::DEFAULT_SOLVER_ITERATIONS;
+        // 靜止的身體進入休眠（--no-sleep 關掉）
+        bool sleeping = true;
+        // 靜態距離場的格子大小（--sdf-cell=N 像素，0 = 關閉、牆全部走配對）
+        float staticFieldCellSize = DistanceField::DEFAULT_CELL_SIZE;
+        // 每個 tick 用 O(n²) 暴力法檢查 broad phase 的配對（--validate-collision，很慢，只用來抓 bug）
+        bool validateCollision = false;
     };
 
     Engine();
@@ -55,7 +68,9 @@ private:
     void setupScene();
     void setupStandardScene();
     void setupStressScene();
+    void registerHotQueries();
     void printProfilerReport(double elapsedSeconds);
+    void reportCollisionMismatch();
 
     // 子系統（宣告順序 = 初始化順序 = 解構相反順序）
     Window   m_window;
@@ -68,6 +83,9 @@ private:
     WeaponSystem   m_weaponSystem;
     EnemySystem    m_enemySystem;
     CollisionSystem m_collisionSystem;
+    CollisionValidator m_collisionValidator;   // --validate-collision 時才掛進 m_collisionSystem
+    bool m_validateCollision = false;
+    bool m_collisionReproWritten = false;      // 只在第一次出錯時寫 repro
     PickupSystem   m_pickupSystem;
     MapLoader      m_mapLoader;
 
@@ -93,6 +111,7 @@ private:
     double m_profileAccumWeaponMs = 0.0;
     double m_profileAccumEnemyMs = 0.0;
     double m_profileAccumCollisionMs = 0.0;
+    CollisionStats m_profileCollision;    // 每個 fixed tick 的 CollisionSystem::lastStats() 累加
     double m_profileAccumRenderMs = 0.0;
     double m_profileAccumFrameMs = 0.0;
     double m_profileElapsedSeconds = 0.0;
@@ -14,6 +14,31 @@ Item::Type parseItemType(const std::string& type) {
     return Item::Type::DuckCoin;
 }
 
+uint32_t parseCollisionLayer(const std::string& name) {
+    if (name == "default") return CollisionLayer::Default;
+    if (name == "player") return CollisionLayer::Player;
+    if (name == "enemy") return CollisionLayer::Enemy;
+    if (name == "obstacle") return CollisionLayer::Obstacle;
+    if (name == "projectile") return CollisionLayer::Projectile;
+    if (name == "all") return CollisionLayer::All;
+    return 0;
+}
+
+// "layer": "enemy" 或 "mask": ["player", "obstacle"]：字串或字串陣列，名稱見上面
+uint32_t parseCollisionLayers(const JsonValue& value) {
+    if (!value.isArray()) return parseCollisionLayer(value.asString());
+    uint32_t bits = 0;
+    for (const auto& name : value.asArray()) bits |= parseCollisionLayer(name.asString());
+    return bits;
+}
+
+// 地圖資料可以覆寫各物件預設的 layer / mask
+Collider withCollisionLayers(const JsonValue& data, Collider col) {
+    if (data.contains("layer")) col.layer = parseCollisionLayers(data.at("layer"));
+    if (data.contains("mask")) col.mask = parseCollisionLayers(data.at("mask"));
+    return col;
+}
+
 void createPlayer(const JsonValue& playerData,
                   Registry& registry,
                   const MapSceneAssets& assets) {
@@ -28,7 +53,8 @@ void createPlayer(const JsonValue& playerData,
     registry.addComponent<RigidBody>(entity, 0.0f, 0.0f, 1.0f, 0.85f);
     registry.addComponent<InputControlled>(entity);
     registry.addComponent<Weapon>(entity, assets.bulletTexID, 900.0f, 0.1f, 0.0f, 2.0f, 10.0f, 1.0f);
-    registry.addComponent<Collider>(entity, Collider::Type::Circle, 24.0f, 24.0f, 24.0f, true);
+    registry.addComponent<Collider>(entity, withCollisionLayers(playerData, Collider{
+        Collider::Type::Circle, 24.0f, 24.0f, 24.0f, true, CollisionLayer::Player, CollisionLayer::All}));
     registry.addComponent<Health>(entity, hp, hp);
     registry.addComponent<Inventory>(entity);
 }
@@ -60,7 +86,11 @@ void createObstacle(const JsonValue& obstacleData,
     registry.addComponent<Transform>(entity, x, y, rotation, 1.0f, 1.0f);
     registry.addComponent<Sprite>(entity, assets.obstacleTexID, width, height, 2,
                                   1.0f, 1.0f, 1.0f, 1.0f);
-    registry.addComponent<Collider>(entity, Collider::Type::AABB, width * 0.5f, height * 0.5f, width * 0.5f, true);
+    // 有旋轉的障礙物用 OBB，碰撞形狀和畫面上的 sprite 一致；沒旋轉的維持 AABB（最便宜）
+    Collider::Type shape = rotation != 0.0f ? Collider::Type::OBB : Collider::Type::AABB;
+    registry.addComponent<Collider>(entity, withCollisionLayers(obstacleData, Collider{
+        shape, width * 0.5f, height * 0.5f, width * 0.5f, true,
+        CollisionLayer::Obstacle, CollisionLayer::All}));
 }
 
 void createEnemy(const JsonValue& enemyData,
@@ -70,20 +100,27 @@ void createEnemy(const JsonValue& enemyData,
     float y = enemyData.value("y", 0.0f);
     float hp = enemyData.value("hp", 3.0f);
 
-    Enemy enemy;
-    enemy.detectRange = enemyData.value("detect_range", enemy.detectRange);
-    enemy.attackRange = enemyData.value("attack_range", enemy.attackRange);
-    enemy.moveAcceleration = enemyData.value("move_acceleration", enemy.moveAcceleration);
-    enemy.patrolRadius = enemyData.value("patrol_radius", enemy.patrolRadius);
+    // 調校值寫進共享 archetype 表，相同設定的敵人共用同一筆
+    EnemyArchetype archetype;
+    archetype.detectRange = enemyData.value("detect_range", archetype.detectRange);
+    archetype.attackRange = enemyData.value("attack_range", archetype.attackRange);
+    archetype.moveAcceleration = enemyData.value("move_acceleration", archetype.moveAcceleration);
+    archetype.patrolRadius = enemyData.value("patrol_radius", archetype.patrolRadius);
+
+    EnemyState enemy;
+    enemy.archetype = registry.context<EnemyArchetypeTable>().add(archetype);
+    enemy.loseSightTimer = archetype.loseSightDelay;
+    enemy.deadTimer = archetype.deadLifetime;
 
     auto entity = registry.create();
     registry.addComponent<Transform>(entity, x, y, 0.0f, 1.0f, 1.0f);
     registry.addComponent<Sprite>(entity, assets.playerTexID, 42.0f, 42.0f, 4,
                                   0.85f, 0.2f, 0.2f, 1.0f);
     registry.addComponent<RigidBody>(entity, 0.0f, 0.0f, 1.0f, 0.88f);
-    registry.addComponent<Collider>(entity, Collider::Type::Circle, 20.0f, 20.0f, 20.0f, true);
+    registry.addComponent<Collider>(entity, withCollisionLayers(enemyData, Collider{
+        Collider::Type::Circle, 20.0f, 20.0f, 20.0f, true, CollisionLayer::Enemy, CollisionLayer::All}));
     registry.addComponent<Health>(entity, hp, hp);
-    registry.addComponent<Enemy>(entity, enemy);
+    registry.addComponent<EnemyState>(entity, enemy);
 }
 
 void createItem(const JsonValue& itemData,
@@ -117,6 +154,9 @@ void createItem(const JsonValue& itemData,
     registry.addComponent<Transform>(entity, x, y, 0.0f, 1.0f, 1.0f);
     registry.addComponent<Sprite>(entity, texID, width, height, 3, r, g, b, 1.0f);
     registry.addComponent<Item>(entity, item);
+    // 拾取範圍是一個 trigger 圓：玩家的 Collider 碰到它就撿起來（PickupSystem 吃 trigger 事件）
+    registry.addComponent<Collider>(entity, Collider::Type::Circle, item.pickupRadius, item.pickupRadius,
+                                    item.pickupRadius, false, CollisionLayer::Pickup, CollisionLayer::Player);
 }
 
 } // namespace
@@ -0,0 +1,81 @@
+#include "core/WorkerPool.h"
+#include <algorithm>
+
+namespace duck {
+
+WorkerPool::WorkerPool(unsigned threadCount) {
+    setThreadCount(threadCount);
+}
+
+WorkerPool::~WorkerPool() {
+    stopThreads();
+}
+
+void WorkerPool::setThreadCount(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (threadCount == this->threadCount()) return;
+
+    stopThreads();
+    m_stop = false;
+    // 新 worker 從目前的 generation 開始等，不會把上一次的工作當成新的
+    unsigned generation = m_generation;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        m_threads.emplace_back([this, generation] { workerLoop(generation); });
+    }
+}
+
+void WorkerPool::stopThreads() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) thread.join();
+    m_threads.clear();
+}
+
+void WorkerPool::dispatch(size_t count, size_t grain, const std::function<void(size_t, size_t)>& job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_grain = grain;
+        m_chunkCount = (count + grain - 1) / grain;
+        m_nextChunk.store(0, std::memory_order_relaxed);
+        m_busy = static_cast<unsigned>(m_threads.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    // 呼叫端也一起搶區塊，然後等所有 worker 回報做完
+    drain();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_job = nullptr;
+}
+
+void WorkerPool::drain() {
+    for (;;) {
+        size_t chunk = m_nextChunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= m_chunkCount) return;
+        size_t begin = chunk * m_grain;
+        size_t end = std::min(m_count, begin + m_grain);
+        (*m_job)(begin, end);
+    }
+}
+
+void WorkerPool::workerLoop(unsigned seen) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+        drain();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy == 0) m_done.notify_one();
+    }
+}
+
+} // namespace duck
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace duck {
+
+// ============================================================
+// WorkerPool — 常駐的工作執行緒 + 分塊 parallelFor
+// ============================================================
+// 每個 tick 只會派幾次大工作（例如 narrow phase 的幾個階段），
+// 所以設計成最簡單的形式：
+//   - 執行緒在建構 / setThreadCount 時建立，之後一直睡在 condition_variable 上
+//   - parallelFor 把 [0, count) 切成 grain 大小的區塊，所有執行緒（含呼叫端）
+//     用 atomic 計數器搶下一塊，做完才回傳
+//   - 區塊怎麼分給執行緒是不固定的；呼叫端要保證每一塊寫的資料互不重疊、
+//     結果也不依賴執行順序，這樣結果才會和執行緒數量無關
+//
+// threadCount = 1 時不建立任何執行緒，parallelFor 直接在呼叫端跑完。
+class WorkerPool {
+public:
+    // threadCount 包含呼叫端；0 = std::thread::hardware_concurrency()
+    explicit WorkerPool(unsigned threadCount = 1);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void setThreadCount(unsigned threadCount);
+    unsigned threadCount() const { return static_cast<unsigned>(m_threads.size()) + 1; }
+
+    // func(begin, end)：處理 [begin, end)；每塊最多 grain 個
+    template <typename Func>
+    void parallelFor(size_t count, size_t grain, Func&& func) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+        if (m_threads.empty() || count <= grain) {
+            for (size_t begin = 0; begin < count; begin += grain) {
+                func(begin, count - begin < grain ? count : begin + grain);
+            }
+            return;
+        }
+        std::function<void(size_t, size_t)> job = std::ref(func);
+        dispatch(count, grain, job);
+    }
+
+private:
+    void dispatch(size_t count, size_t grain, const std::function<void(size_t, size_t)>& job);
+    void drain();
+    void workerLoop(unsigned seen);
+    void stopThreads();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stop = false;
+    unsigned m_generation = 0;            // 每派一次工作加一，worker 靠它分辨新工作
+    unsigned m_busy = 0;                  // 還沒做完這次工作的 worker 數
+
+    // 目前這次工作（m_mutex 保護寫入；worker 被喚醒後只讀）
+    const std::function<void(size_t, size_t)>* m_job = nullptr;
+    size_t m_count = 0;
+    size_t m_grain = 1;
+    size_t m_chunkCount = 0;
+    std::atomic<size_t> m_nextChunk{0};
+};
+
+} // namespace duck
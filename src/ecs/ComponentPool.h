@@ -1,8 +1,13 @@
 #pragma once
 #include "ecs/Entity.h"
+#include "ecs/PagedStorage.h"
 #include <vector>
-#include <unordered_map>
+#include <memory>
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
 namespace duck {
 
@@ -20,6 +25,62 @@ public:
     virtual ~IComponentPool() = default;
     virtual void remove(EntityID entity) = 0;
     virtual bool has(EntityID entity) const = 0;
+    virtual size_t size() const = 0;
+    virtual const std::vector<EntityID>& entities() const = 0;
+
+    // 批次移除：victims 是已去重的受害者列表，
+    // marked[entity] != 0 代表該 entity 要被移除（index = EntityID）
+    virtual void removeMany(const std::vector<EntityID>& victims,
+                            const std::vector<std::uint8_t>& marked) = 0;
+};
+
+// ============================================================
+// SparseIndex — Entity → Dense index 的分頁稀疏陣列
+// ============================================================
+// 為什麼不用 unordered_map<EntityID, size_t>？
+//   每次 has/get/remove 都要算 hash、追 bucket 鏈結串列的節點（散落在 heap），
+//   destroy 一個 entity 要對每個 pool 做好幾次 hash 查詢 + erase。
+// 分頁陣列：EntityID 直接當索引，查詢是「兩次陣列讀取」
+//   page = entity >> PAGE_BITS，slot = entity & (PAGE_SIZE - 1)
+// 只在某段 ID 範圍真的有元件時才配置那一頁，
+// 所以只掛在少數 entity 上的元件（例如 InputControlled）不會為整個 ID 空間付記憶體。
+class SparseIndex {
+public:
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+
+    bool contains(EntityID entity) const {
+        return get(entity) != NONE;
+    }
+
+    // 回傳 dense index，不存在時回傳 NONE
+    std::uint32_t get(EntityID entity) const {
+        size_t page = entity >> PAGE_BITS;
+        if (page >= m_pages.size() || !m_pages[page]) return NONE;
+        return m_pages[page][entity & PAGE_MASK];
+    }
+
+    void set(EntityID entity, std::uint32_t index) {
+        size_t page = entity >> PAGE_BITS;
+        if (page >= m_pages.size()) m_pages.resize(page + 1);
+        if (!m_pages[page]) {
+            m_pages[page] = std::make_unique<std::uint32_t[]>(PAGE_SIZE);
+            std::fill_n(m_pages[page].get(), PAGE_SIZE, NONE);
+        }
+        m_pages[page][entity & PAGE_MASK] = index;
+    }
+
+    void erase(EntityID entity) {
+        size_t page = entity >> PAGE_BITS;
+        if (page >= m_pages.size() || !m_pages[page]) return;
+        m_pages[page][entity & PAGE_MASK] = NONE;
+    }
+
+private:
+    static constexpr std::uint32_t PAGE_BITS = 12;              // 每頁 4096 個 entity
+    static constexpr std::uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+    static constexpr std::uint32_t PAGE_MASK = PAGE_SIZE - 1;
+
+    std::vector<std::unique_ptr<std::uint32_t[]>> m_pages;
 };
 
 // ============================================================
@@ -38,31 +99,37 @@ public:
 // 記憶體佈局示意：
 //   m_components:    [Transform_A] [Transform_B] [Transform_C]  ← 連續！
 //   m_indexToEntity:  [entity_5]    [entity_2]    [entity_8]
-//   m_entityToIndex:  {5→0, 2→1, 8→2}
+//   m_entityToIndex:  [.., .., 1, .., .., 0, .., .., 2]  ← SparseIndex，以 EntityID 為索引
 //
+// m_components 的容器由 ComponentStorage<T> 決定：
+//   預設是 std::vector<T>；特化了 pageSize 的元件用 PagedVector（新增時參照不失效）
 template <typename T>
 class ComponentPool : public IComponentPool {
 public:
+    using Storage = std::conditional_t<ComponentStorage<T>::pageSize == 0,
+                                       std::vector<T>,
+                                       PagedVector<T, ComponentStorage<T>::pageSize>>;
+
     // 新增元件到指定 entity
     T& add(EntityID entity, T component) {
         assert(!has(entity) && "Entity already has this component");
         size_t index = m_components.size();
         m_components.push_back(std::move(component));
         m_indexToEntity.push_back(entity);
-        m_entityToIndex[entity] = index;
+        m_entityToIndex.set(entity, static_cast<std::uint32_t>(index));
         return m_components.back();
     }
 
     // 取得 entity 的元件參照（可修改）
     T& get(EntityID entity) {
         assert(has(entity) && "Entity does not have this component");
-        return m_components[m_entityToIndex[entity]];
+        return m_components[m_entityToIndex.get(entity)];
     }
 
     // 取得 entity 的元件參照（唯讀）
     const T& get(EntityID entity) const {
         assert(has(entity) && "Entity does not have this component");
-        return m_components[m_entityToIndex.at(entity)];
+        return m_components[m_entityToIndex.get(entity)];
     }
 
     // 移除 entity 的元件
@@ -71,9 +138,10 @@ public:
     // Swap-and-Pop 則是把最後一個元素搬到被刪除的位置，然後 pop_back（O(1)）
     // 代價是不保證順序，但 ECS 不需要保證順序
     void remove(EntityID entity) override {
-        if (!has(entity)) return;
+        std::uint32_t slot = m_entityToIndex.get(entity);
+        if (slot == SparseIndex::NONE) return;
 
-        size_t indexToRemove = m_entityToIndex[entity];
+        size_t indexToRemove = slot;
         size_t lastIndex = m_components.size() - 1;
 
         if (indexToRemove != lastIndex) {
@@ -81,7 +149,7 @@ public:
             m_components[indexToRemove] = std::move(m_components[lastIndex]);
             EntityID lastEntity = m_indexToEntity[lastIndex];
             m_indexToEntity[indexToRemove] = lastEntity;
-            m_entityToIndex[lastEntity] = indexToRemove;
+            m_entityToIndex.set(lastEntity, static_cast<std::uint32_t>(indexToRemove));
         }
 
         m_components.pop_back();
@@ -89,32 +157,93 @@ public:
         m_entityToIndex.erase(entity);
     }
 
+    // 批次移除：一次線性掃描把所有受害者壓實掉
+    // 演算法（雙指標版 Swap-and-Pop）：
+    //   i 從前往後找「洞」（被標記的元件），
+    //   last 從後往前跳過同樣被標記的尾端元素，
+    //   把最後一個倖存者搬進洞裡，最後一次 erase 掉尾巴。
+    // 每個倖存者最多被搬一次，搬動次數 <= 受害者數量，
+    // 而且不像逐一 remove() 那樣每次都要重新查 lastIndex、單獨 pop_back。
+    //
+    // 受害者只佔 pool 一部分時（例如 100k Transform 裡死 3 顆子彈，或 10% 被炸死），
+    // 掃整個 pool 反而比較慢：倖存者的 marked[] 查詢是隨機存取，
+    // 而 SparseIndex 下單次 Swap-and-Pop 只是幾次陣列寫入。
+    // 實測（bench_ecs）大約要死掉 3/4 以上，整池壓實才划算。
+    void removeMany(const std::vector<EntityID>& victims,
+                    const std::vector<std::uint8_t>& marked) override {
+        if (m_components.empty() || victims.empty()) return;
+
+        if (victims.size() * 4 < m_components.size() * 3) {
+            for (EntityID entity : victims) remove(entity);
+            return;
+        }
+
+        auto isMarked = [&](EntityID entity) {
+            return entity < marked.size() && marked[entity] != 0;
+        };
+
+        size_t count = m_components.size();
+        size_t i = 0;
+        while (i < count) {
+            EntityID entity = m_indexToEntity[i];
+            if (!isMarked(entity)) { ++i; continue; }
+
+            m_entityToIndex.erase(entity);
+
+            // 從尾端丟掉同樣被標記的元素，找到最後一個倖存者
+            size_t last = count - 1;
+            while (last > i && isMarked(m_indexToEntity[last])) {
+                m_entityToIndex.erase(m_indexToEntity[last]);
+                --last;
+            }
+
+            if (last > i) {
+                m_components[i] = std::move(m_components[last]);
+                EntityID moved = m_indexToEntity[last];
+                m_indexToEntity[i] = moved;
+                m_entityToIndex.set(moved, static_cast<std::uint32_t>(i));
+                ++i;
+            }
+            count = last;
+        }
+
+        // 尾端都是已被搬走或被標記的元素，逐一 pop（兩種 Storage 都支援）
+        while (m_components.size() > count) m_components.pop_back();
+        m_indexToEntity.resize(count);
+    }
+
     // 檢查 entity 是否擁有此類型元件
     bool has(EntityID entity) const override {
-        return m_entityToIndex.find(entity) != m_entityToIndex.end();
+        return m_entityToIndex.contains(entity);
     }
 
+    // entity 在 dense array 的 index（沒有這個元件時回傳 SparseIndex::NONE）
+    // 需要「每個元件一格」的平行陣列時拿來當 key（例如 CollisionSystem 依物體分組推開量）
+    std::uint32_t indexOf(EntityID entity) const { return m_entityToIndex.get(entity); }
+
     // 元件數量
-    size_t size() const { return m_components.size(); }
+    size_t size() const override { return m_components.size(); }
 
     // 供 View 遍歷用 — 回傳所有擁有此元件的 entity 列表
-    const std::vector<EntityID>& entities() const { return m_indexToEntity; }
+    const std::vector<EntityID>& entities() const override { return m_indexToEntity; }
 
     // 直接存取底層元件陣列（進階用途）
-    std::vector<T>& components() { return m_components; }
+    // 分頁儲存時回傳 PagedVector，用 forEachPage 逐頁遍歷
+    Storage& components() { return m_components; }
 
 private:
     // Dense Array：所有同類型元件連續存放
     // 這是效能的關鍵！CPU 讀取記憶體時會預取相鄰的資料（cache line 通常 64 bytes）
     // 連續存放意味著遍歷時幾乎每次都是 cache hit
-    std::vector<T> m_components;
+    // （分頁儲存時是「每頁內連續」，頁大小遠大於 cache line，效果相同）
+    Storage m_components;
 
     // Dense → Entity 映射：index i 對應哪個 entity
     std::vector<EntityID> m_indexToEntity;
 
     // Entity → Dense 映射：查詢特定 entity 的元件在哪個 index
-    // 用 unordered_map 實現 O(1) 查詢
-    std::unordered_map<EntityID, size_t> m_entityToIndex;
+    // 用分頁稀疏陣列實現 O(1) 查詢（見 SparseIndex）
+    SparseIndex m_entityToIndex;
 };
 
 } // namespace duck
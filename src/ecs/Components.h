@@ -1,5 +1,8 @@
 #pragma once
+#include "ecs/PagedStorage.h"
 #include <cstdint>
+#include <cstring>
+#include <vector>
 
 namespace duck {
 
@@ -22,6 +25,11 @@ struct Transform {
     float scaleY = 1.0f;
 };
 
+// Transform 用分頁儲存：數量最多（每顆子彈、每個敵人都有），
+// 而且 WeaponSystem 會拿著玩家的 Transform& 生成子彈的 Transform。
+// 1024 個一頁 = 20KB，擴容時只配置一頁，不會複製整個陣列。
+template <> struct ComponentStorage<Transform> { static constexpr size_t pageSize = 1024; };
+
 struct Sprite {
     uint32_t textureID = 0;   // 對應 Renderer 的紋理 ID
     float width = 0.0f;
@@ -44,29 +52,62 @@ struct RigidBody {
 // 就能精確篩選出「受玩家控制的、有物理屬性的實體」
 struct InputControlled {};
 
-// 敵人元件：最小版完整狀態機
-// 狀態流：IDLE -> CHASE -> ATTACK -> PATROL -> DEAD
-struct Enemy {
-    enum class State { Idle, Chase, Attack, Patrol, Dead };
-
-    State state = State::Idle;
+// 敵人調校參數（冷資料）：同一種敵人共用一份，不隨 tick 改變
+// 存在 EnemyArchetypeTable（Registry context）裡，EnemyState 只記 index
+struct EnemyArchetype {
     float touchDamage = 1.0f;
     float touchInterval = 0.75f;
-    float touchCooldown = 0.0f;
     float detectRange = 320.0f;
     float attackRange = 56.0f;
     float loseSightDelay = 1.5f;
-    float loseSightTimer = 1.5f;
     float moveAcceleration = 1100.0f;
     float patrolRadius = 90.0f;
+    float patrolWaitDuration = 0.7f;
+    float deadLifetime = 0.5f;
+};
+
+// 敵人元件（熱資料）：最小版完整狀態機
+// 狀態流：IDLE -> CHASE -> ATTACK -> PATROL -> DEAD
+//
+// 為什麼拆成 EnemyState + EnemyArchetype？（Flyweight）
+//   原本的 Enemy 是 72 bytes，其中 9 個欄位是每隻都一樣的調校值，
+//   EnemySystem 每個 tick 卻要把整份資料讀進 cache。
+//   拆開後每隻只剩 32 bytes（兩隻塞進一條 64-byte cache line），
+//   調校值從一張很小、常駐 cache 的表讀取。
+struct EnemyState {
+    enum class State : uint8_t { Idle, Chase, Attack, Patrol, Dead };
+
+    State state = State::Idle;
+    bool homeInitialized = false;
+    uint16_t archetype = 0;        // EnemyArchetypeTable 的 index，0 = 預設 archetype
+    float touchCooldown = 0.0f;
+    float loseSightTimer = 1.5f;
     float patrolAngle = 0.0f;
     float patrolWaitTimer = 0.0f;
-    float patrolWaitDuration = 0.7f;
     float deadTimer = 0.5f;
-    float deadLifetime = 0.5f;
     float homeX = 0.0f;
     float homeY = 0.0f;
-    bool homeInitialized = false;
+};
+
+// 所有 EnemyArchetype 的共享表（Registry::context<EnemyArchetypeTable>()）
+// index 0 永遠是預設值，沒指定 archetype 的敵人就用它。
+struct EnemyArchetypeTable {
+    std::vector<EnemyArchetype> archetypes{EnemyArchetype{}};
+
+    // 加入一份調校；完全相同的調校會共用同一個 index，表保持很小
+    uint16_t add(const EnemyArchetype& archetype) {
+        for (size_t i = 0; i < archetypes.size(); ++i) {
+            if (std::memcmp(&archetypes[i], &archetype, sizeof(EnemyArchetype)) == 0) {
+                return static_cast<uint16_t>(i);
+            }
+        }
+        archetypes.push_back(archetype);
+        return static_cast<uint16_t>(archetypes.size() - 1);
+    }
+
+    const EnemyArchetype& get(uint16_t index) const {
+        return index < archetypes.size() ? archetypes[index] : archetypes[0];
+    }
 };
 
 // 武器元件：描述槍枝屬性
@@ -85,17 +126,20 @@ struct Weapon {
     float damage        = 1.0f;
 };
 
-// 子彈元件：子彈自己帶速度而非依賴 RigidBody
-// 為什麼不用 RigidBody？子彈不需要摩擦力，應該直線等速飛行
-// 用獨立元件讓 WeaponSystem 只需要 view<Transform, Bullet>，
-// 不會誤處理到有 RigidBody 的玩家/敵人
-struct Bullet {
-    float vx = 0.0f;
-    float vy = 0.0f;
-    float lifetime = 2.0f;  // 剩餘存活時間（秒）
-    float radius   = 5.0f;  // 子彈碰撞半徑（像素）
-    float damage   = 1.0f;  // 命中時造成的傷害
-};
+// 子彈不是元件：放在 physics/ProjectileManager 的 SoA 陣列裡（見該檔說明）
+
+// 碰撞層：每個 Collider 屬於一或多層（layer），並用 mask 指定願意和哪些層碰撞
+// 兩者都同意才會碰：(a.layer & b.mask) && (b.layer & a.mask)
+// 過濾在 broad phase 產生配對時就做完，被濾掉的配對不會進 narrow phase
+namespace CollisionLayer {
+constexpr uint32_t Default    = 1u << 0;
+constexpr uint32_t Player     = 1u << 1;
+constexpr uint32_t Enemy      = 1u << 2;
+constexpr uint32_t Obstacle   = 1u << 3;
+constexpr uint32_t Projectile = 1u << 4;
+constexpr uint32_t Pickup     = 1u << 5;   // Item 的拾取 trigger（mask = Player）
+constexpr uint32_t All        = 0xFFFFFFFFu;
+} // namespace CollisionLayer
 
 // 最小版生命元件
 // currentHP 歸零後由系統刪除 entity
@@ -113,12 +157,15 @@ struct Inventory {
     int totalPickups = 0;
 };
 
+// PickupSystem 整個迴圈都拿著 Inventory&，分頁儲存保證期間新增的背包不會讓它失效
+template <> struct ComponentStorage<Inventory> { static constexpr size_t pageSize = 64; };
+
 struct Item {
     enum class Type { DuckCoin, Ammo, Medkit };
 
     Type type = Type::DuckCoin;
     int amount = 1;
-    float pickupRadius = 36.0f;
+    float pickupRadius = 36.0f;   // MapLoader 以此為半徑掛 trigger 圓，碰到玩家的 Collider 就撿起
 };
 
 // 碰撞元件：描述實體的碰撞形狀
@@ -126,16 +173,24 @@ struct Item {
 // AABB：軸對齊矩形，最適合方形牆壁/箱子
 // 注意：因含 enum class，Collider 不是嚴格 POD，不可直接 memcpy 序列化。
 struct Collider {
-    enum class Type { Circle, AABB };
+    // OBB：以 Transform::rotation 旋轉的矩形（halfW / halfH 是旋轉前的半寬 / 半高）；
+    // AABB 不看 rotation，永遠和座標軸對齊
+    enum class Type { Circle, AABB, OBB };
     Type type = Type::Circle;
 
-    float halfW  = 16.0f;  // AABB 半寬（中心到右邊緣）
-    float halfH  = 16.0f;  // AABB 半高（中心到下邊緣）
+    float halfW  = 16.0f;  // AABB / OBB 半寬（中心到右邊緣）
+    float halfH  = 16.0f;  // AABB / OBB 半高（中心到下邊緣）
     float radius = 16.0f;  // Circle 半徑
 
     // isSolid=true：碰到後會被推開（牆壁、玩家、箱子）
-    // isSolid=false：穿透觸發（未來 Trigger 區域用）
+    // isSolid=false：trigger，不推開任何東西，只產生 Enter / Stay / Exit 事件（見 CollisionWorld）
+    // 加入 CollisionWorld 之後要改請用 CollisionWorld::setSolid（直接改欄位 world 不會知道）
     bool isSolid = true;
+
+    // 碰撞層（見 CollisionLayer）：預設在 Default 層、和所有層碰撞
+    // 只在加入 CollisionWorld 時讀取一次；之後要改請 remove + add Collider
+    uint32_t layer = CollisionLayer::Default;
+    uint32_t mask  = CollisionLayer::All;
 };
 
 } // namespace duck
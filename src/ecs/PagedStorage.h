@@ -0,0 +1,125 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+
+namespace duck {
+
+// ============================================================
+// ComponentStorage<T> — 元件的儲存策略（編譯期選擇）
+// ============================================================
+// 預設 pageSize = 0：ComponentPool 用一條 std::vector<T>，最緊密、遍歷最快。
+// 特化成 pageSize = N（2 的冪）：改用 PagedVector<T, N>，
+// 元件放在固定大小、永不搬移的區塊裡。
+//
+// 什麼時候要開？
+//   1. 持有元件參照的同時會新增同型別元件
+//      例：WeaponSystem 拿著玩家的 Transform& 生成子彈（也是 Transform）
+//   2. 元件數量很大（數十萬以上），vector 擴容的一次性複製會造成掉幀
+//
+// 用法（寫在元件定義旁邊）：
+//   template <> struct ComponentStorage<Transform> { static constexpr size_t pageSize = 1024; };
+template <typename T>
+struct ComponentStorage {
+    static constexpr size_t pageSize = 0;
+};
+
+// ============================================================
+// PagedVector<T, PageSize> — 分頁的 dense 陣列
+// ============================================================
+// 和 std::vector 的差別：
+//   std::vector 滿了會配置 2 倍空間，把所有元素搬過去 → 舊參照全部失效，
+//   而且 1M 個元素那一次 push_back 要複製整個陣列（一次很大的尖峰）。
+//   PagedVector 滿了只再配置一頁，已存在的元素永遠不搬動 →
+//   push_back 不會讓任何參照失效，成長是穩定的 O(1)。
+//
+// 記憶體佈局：
+//   m_pages: [ptr] [ptr] [ptr]        ← 只有這個指標表會 realloc（很小）
+//              │     │     │
+//              ▼     ▼     ▼
+//           [T×N] [T×N] [T×k]         ← 每頁內部連續，遍歷仍是逐頁線性
+//
+// 注意：只保證「新增」時參照穩定。
+// ComponentPool::remove 的 Swap-and-Pop 仍會把最後一個元素搬進洞裡，
+// 被搬動的那一個的參照會失效（和 vector 版一樣）。
+template <typename T, size_t PageSize>
+class PagedVector {
+    static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0,
+                  "PageSize must be a power of two");
+
+public:
+    static constexpr size_t PAGE_SIZE = PageSize;
+
+    PagedVector() = default;
+    PagedVector(const PagedVector&) = delete;
+    PagedVector& operator=(const PagedVector&) = delete;
+
+    ~PagedVector() { clear(); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t capacity() const { return m_pages.size() * PageSize; }
+
+    T& operator[](size_t index) {
+        assert(index < m_size);
+        return slot(index);
+    }
+
+    const T& operator[](size_t index) const {
+        assert(index < m_size);
+        return const_cast<PagedVector*>(this)->slot(index);
+    }
+
+    T& back() { return (*this)[m_size - 1]; }
+
+    void push_back(T value) {
+        // 需要新頁時只配置一頁；已配置的頁（之前 pop 掉留下的）直接重用
+        if (m_size == capacity()) {
+            m_pages.push_back(std::make_unique<Page>());
+        }
+        new (&slot(m_size)) T(std::move(value));
+        ++m_size;
+    }
+
+    void pop_back() {
+        assert(m_size > 0);
+        --m_size;
+        slot(m_size).~T();
+    }
+
+    // 解構所有元素；頁面保留給之後的 push_back 重用
+    void clear() {
+        while (m_size > 0) pop_back();
+    }
+
+    // 逐頁遍歷：func(T* data, size_t count)，每頁內部是連續陣列，
+    // 熱迴圈可以在頁內照常讓編譯器向量化
+    template <typename Func>
+    void forEachPage(Func&& func) {
+        size_t remaining = m_size;
+        for (size_t p = 0; remaining > 0; ++p) {
+            size_t count = remaining < PageSize ? remaining : PageSize;
+            func(reinterpret_cast<T*>(m_pages[p]->bytes), count);
+            remaining -= count;
+        }
+    }
+
+private:
+    struct Page {
+        alignas(T) unsigned char bytes[sizeof(T) * PageSize];
+    };
+
+    T& slot(size_t index) {
+        // PageSize 是 2 的冪：除法和取餘數都變成位元運算
+        Page& page = *m_pages[index / PageSize];
+        return *std::launder(reinterpret_cast<T*>(page.bytes) + index % PageSize);
+    }
+
+    std::vector<std::unique_ptr<Page>> m_pages;
+    size_t m_size = 0;
+};
+
+} // namespace duck
@@ -5,21 +5,182 @@ namespace duck {
 EntityID Registry::create() {
     EntityID id = m_nextID++;
     m_alive.insert(id);
+    m_enabled.push_back(1);
     return id;
 }
 
 void Registry::destroy(EntityID entity) {
+    if (!m_signals.empty() && alive(entity)) emitEntityRemoved(entity);
+
     // 遍歷所有 pool，移除該 entity 的所有元件
     // 這就是 IComponentPool 型別擦除的價值：
     // 不需要知道具體的元件類型，就能呼叫 remove()
     for (auto& [type, pool] : m_pools) {
         pool->remove(entity);
     }
+    if (!m_queries.empty()) onEntityRemoved(entity);
     m_alive.erase(entity);
 }
 
+void Registry::destroyMany(const std::vector<EntityID>& entities) {
+    if (entities.empty()) return;
+    if (m_destroyMarks.size() < m_nextID) m_destroyMarks.resize(m_nextID, 0);
+
+    // 去重 + 過濾：只留下存活且尚未標記的 entity
+    m_destroyVictims.clear();
+    for (EntityID entity : entities) {
+        if (entity >= m_destroyMarks.size() || m_destroyMarks[entity]) continue;
+        if (!alive(entity)) continue;
+        m_destroyMarks[entity] = 1;
+        m_destroyVictims.push_back(entity);
+    }
+
+    if (!m_destroyVictims.empty()) {
+        if (!m_signals.empty()) {
+            for (EntityID entity : m_destroyVictims) emitEntityRemoved(entity);
+        }
+        for (auto& [type, pool] : m_pools) {
+            pool->removeMany(m_destroyVictims, m_destroyMarks);
+        }
+        for (EntityID entity : m_destroyVictims) {
+            if (!m_queries.empty()) onEntityRemoved(entity);
+            m_alive.erase(entity);
+            m_destroyMarks[entity] = 0;
+        }
+    }
+}
+
 bool Registry::alive(EntityID entity) const {
     return m_alive.count(entity) > 0;
 }
 
+void Registry::setEnabled(EntityID entity, bool enabled) {
+    if (entity >= m_enabled.size()) return;
+    bool wasEnabled = m_enabled[entity] != 0;
+    m_enabled[entity] = enabled ? 1 : 0;
+    if (m_queries.empty() || wasEnabled == enabled) return;
+
+    // 快取只收啟用中的 entity：停用 → 從所有查詢移除；啟用 → 重新檢查所有查詢
+    for (auto& [key, query] : m_queries) {
+        if (enabled) {
+            if (queryMatches(*query, entity)) queryInsert(*query, entity);
+        } else {
+            queryErase(*query, entity);
+        }
+    }
+}
+
+// ============================================================
+// 快取查詢的增量維護
+// ============================================================
+
+bool Registry::queryMatches(const CachedQuery& query, EntityID entity) const {
+    if (!isEnabled(entity)) return false;
+    for (const IComponentPool* pool : query.pools) {
+        if (!pool->has(entity)) return false;
+    }
+    return true;
+}
+
+void Registry::queryInsert(CachedQuery& query, EntityID entity) {
+    if (query.slots.contains(entity)) return;
+    query.slots.set(entity, static_cast<std::uint32_t>(query.entities.size()));
+    query.entities.push_back(entity);
+}
+
+// Swap-and-Pop，和 ComponentPool::remove 同一招；遍歷中只留洞（見 viewCached）
+void Registry::queryErase(CachedQuery& query, EntityID entity) {
+    std::uint32_t slot = query.slots.get(entity);
+    if (slot == SparseIndex::NONE) return;
+
+    query.slots.erase(entity);
+    if (query.iterating > 0) {
+        query.entities[slot] = INVALID_ENTITY;
+        ++query.holes;
+        return;
+    }
+    EntityID last = query.entities.back();
+    query.entities[slot] = last;
+    if (last != entity) query.slots.set(last, slot);
+    query.entities.pop_back();
+}
+
+// 遍歷結束後把洞擠掉，順序不變
+void Registry::compactQuery(CachedQuery& query) {
+    size_t count = 0;
+    for (EntityID entity : query.entities) {
+        if (entity == INVALID_ENTITY) continue;
+        query.slots.set(entity, static_cast<std::uint32_t>(count));
+        query.entities[count++] = entity;
+    }
+    query.entities.resize(count);
+    query.holes = 0;
+}
+
+// 註冊時從頭建立：用最小的 pool 當起點，逐一檢查其餘元件
+void Registry::rebuildQuery(CachedQuery& query) {
+    for (EntityID entity : query.entities) {
+        if (entity != INVALID_ENTITY) query.slots.erase(entity);
+    }
+    query.entities.clear();
+    query.holes = 0;
+    ++m_queryStats.rebuilds;
+
+    const IComponentPool* smallest = nullptr;
+    for (const IComponentPool* pool : query.pools) {
+        if (!smallest || pool->size() < smallest->size()) smallest = pool;
+    }
+    if (!smallest) return;
+
+    for (EntityID entity : smallest->entities()) {
+        if (queryMatches(query, entity)) queryInsert(query, entity);
+    }
+}
+
+void Registry::onComponentAdded(std::type_index type, EntityID entity) {
+    auto it = m_queriesByType.find(type);
+    if (it == m_queriesByType.end()) return;
+    for (CachedQuery* query : it->second) {
+        if (queryMatches(*query, entity)) queryInsert(*query, entity);
+    }
+}
+
+void Registry::onComponentRemoved(std::type_index type, EntityID entity) {
+    auto it = m_queriesByType.find(type);
+    if (it == m_queriesByType.end()) return;
+    for (CachedQuery* query : it->second) {
+        queryErase(*query, entity);
+    }
+}
+
+void Registry::onEntityRemoved(EntityID entity) {
+    for (auto& [key, query] : m_queries) {
+        queryErase(*query, entity);
+    }
+}
+
+// ============================================================
+// 元件訊號
+// ============================================================
+
+void Registry::emitAdded(std::type_index type, EntityID entity) {
+    auto it = m_signals.find(type);
+    if (it == m_signals.end()) return;
+    for (auto& callback : it->second.added) callback(entity);
+}
+
+void Registry::emitRemoved(std::type_index type, EntityID entity) {
+    auto it = m_signals.find(type);
+    if (it == m_signals.end()) return;
+    for (auto& callback : it->second.removed) callback(entity);
+}
+
+void Registry::emitEntityRemoved(EntityID entity) {
+    for (auto& [type, signals] : m_signals) {
+        if (signals.removed.empty()) continue;
+        if (!m_pools.at(type)->has(entity)) continue;
+        for (auto& callback : signals.removed) callback(entity);
+    }
+}
+
 } // namespace duck
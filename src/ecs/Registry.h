@@ -6,9 +6,26 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <functional>
+#include <vector>
+#include <cstdint>
 
 namespace duck {
 
+// view() 的篩選模式
+// EnabledOnly：預設，跳過被 setEnabled(e, false) 停用的 entity
+// IncludeDisabled：連停用的 entity 一起遍歷（例如存檔、DebugDraw、重新啟用邏輯）
+enum class ViewFilter { EnabledOnly, IncludeDisabled };
+
+// 快取查詢的統計（給 profiler 看）
+// hits：view 直接走快取清單
+// misses：view 沒有對應的註冊查詢，退回逐一檢查元件
+// rebuilds：註冊查詢時從頭建立快取清單的次數
+struct QueryStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t rebuilds = 0;
+};
+
 // ============================================================
 // Registry — ECS 的核心管理器
 // ============================================================
@@ -40,9 +57,35 @@ public:
     // 銷毀 entity：移除它的所有 component，再從存活集合中刪除
     void destroy(EntityID entity);
 
+    // 批次銷毀：一次爆炸/霰彈打死上百個 entity 時用
+    // 1. 去重 + 過濾已死亡的 ID（同一個 ID 出現多次只算一次）
+    // 2. 在 m_destroyMarks 標記所有受害者
+    // 3. 每個 pool 只做一次線性壓實（見 ComponentPool::removeMany）
+    // 相較於逐一 destroy()：不必對每個受害者 × 每個 pool 都做一次虛擬呼叫 + 查 lastIndex
+    // 呼叫端可以安全地傳入含重複或已銷毀 ID 的列表
+    void destroyMany(const std::vector<EntityID>& entities);
+
     // 檢查 entity 是否仍然存活
     bool alive(EntityID entity) const;
 
+    // --------------------------------------------------
+    // Enable / Disable（不做結構變更的休眠）
+    // --------------------------------------------------
+    // 停用的 entity 仍然存活、元件也都留在 pool 原位，
+    // 只是預設的 view() 會跳過它。
+    //
+    // 為什麼不用 removeComponent / addComponent 來「關掉」entity？
+    //   每次移除都會在每個 pool 做 swap-and-pop + 索引更新，
+    //   重新啟用時又要 push_back + 索引寫入，池化子彈、藏起來的掉落物
+    //   這類頻繁切換的情境會一直搬動記憶體。
+    // 這裡只翻一個 byte，O(1)，不動任何 pool。
+    void setEnabled(EntityID entity, bool enabled);
+
+    // inline：view 的熱迴圈每個 entity 都會呼叫
+    bool isEnabled(EntityID entity) const {
+        return entity < m_enabled.size() && m_enabled[entity] != 0;
+    }
+
     // --------------------------------------------------
     // Component 操作（模板方法，定義在 header 中）
     // --------------------------------------------------
@@ -55,7 +98,10 @@ public:
     template <typename T, typename... Args>
     T& addComponent(EntityID entity, Args&&... args) {
         auto& pool = getOrCreatePool<T>();
-        return pool.add(entity, T{std::forward<Args>(args)...});
+        T& component = pool.add(entity, T{std::forward<Args>(args)...});
+        if (!m_queries.empty()) onComponentAdded(std::type_index(typeid(T)), entity);
+        if (!m_signals.empty()) emitAdded(std::type_index(typeid(T)), entity);
+        return component;
     }
 
     // 取得 entity 的元件參照（可修改）
@@ -64,6 +110,16 @@ public:
         return getPool<T>().get(entity);
     }
 
+    // 取得指定類型的 pool（不存在回傳 nullptr，不會建立）
+    // 熱迴圈先取一次 pool，之後每次 get / has 只剩 SparseIndex 查表，
+    // 不必每次都經過 type_index 的雜湊查找
+    template <typename T>
+    ComponentPool<T>* findPool() {
+        auto it = m_pools.find(std::type_index(typeid(T)));
+        if (it == m_pools.end()) return nullptr;
+        return static_cast<ComponentPool<T>*>(it->second.get());
+    }
+
     // 檢查 entity 是否擁有指定元件
     template <typename T>
     bool hasComponent(EntityID entity) const {
@@ -75,7 +131,86 @@ public:
     // 移除 entity 的指定元件
     template <typename T>
     void removeComponent(EntityID entity) {
+        if (!m_signals.empty() && hasComponent<T>(entity)) {
+            emitRemoved(std::type_index(typeid(T)), entity);
+        }
         getPool<T>().remove(entity);
+        if (!m_queries.empty()) onComponentRemoved(std::type_index(typeid(T)), entity);
+    }
+
+    // --------------------------------------------------
+    // 元件訊號（Component Signals）
+    // --------------------------------------------------
+    // onAdd<Collider>(cb)：每次有 entity 掛上 Collider 後呼叫 cb(entity)
+    // onRemove<Collider>(cb)：Collider 被移除「之前」呼叫 cb(entity)
+    //   removeComponent、destroy、destroyMany 都會觸發，callback 裡元件仍然讀得到
+    //
+    // 給需要自己維護持久結構的子系統用（例如 CollisionWorld 的 broad phase），
+    // 不必每個 tick 掃整個 view 來找出誰新增、誰消失。
+    // 沒有註冊任何訊號時，add/remove/destroy 的額外成本只有一次 empty() 檢查。
+    //
+    // 沒有取消訂閱：訂閱者應該和 Registry 同壽命（通常放在 context<T>() 裡）。
+    using ComponentCallback = std::function<void(EntityID)>;
+
+    template <typename T>
+    void onAdd(ComponentCallback callback) {
+        getOrCreatePool<T>();
+        m_signals[std::type_index(typeid(T))].added.push_back(std::move(callback));
+    }
+
+    template <typename T>
+    void onRemove(ComponentCallback callback) {
+        getOrCreatePool<T>();
+        m_signals[std::type_index(typeid(T))].removed.push_back(std::move(callback));
+    }
+
+    // --------------------------------------------------
+    // 快取查詢（Persistent Query）
+    // --------------------------------------------------
+    // registerQuery<Transform, Collider>() 之後，
+    // view<Transform, Collider>() 不再從 pool 逐一檢查元件，
+    // 而是直接遍歷一份「已知符合條件」的緊密 entity 清單。
+    //
+    // 清單怎麼保持正確？
+    //   addComponent / removeComponent / destroy / setEnabled 發生時，
+    //   只重新檢查「簽名含有該元件型別」的查詢（增量維護），
+    //   穩定的查詢在每個 tick 完全不需要過濾。
+    //
+    // 注意：簽名有順序，view<A, B> 和 view<B, A> 是兩個不同的查詢，
+    // 要用和 view 呼叫處相同的順序註冊。
+    // 快取只包含啟用中的 entity；ViewFilter::IncludeDisabled 一律走未快取路徑。
+    template <typename... Ts>
+    void registerQuery() {
+        std::type_index key(typeid(QuerySignature<Ts...>));
+        if (m_queries.count(key)) return;
+
+        auto query = std::make_unique<CachedQuery>();
+        (query->pools.push_back(&getOrCreatePool<Ts>()), ...);
+        (m_queriesByType[std::type_index(typeid(Ts))].push_back(query.get()), ...);
+        rebuildQuery(*query);
+        m_queries[key] = std::move(query);
+    }
+
+    const QueryStats& queryStats() const { return m_queryStats; }
+    void resetQueryStats() { m_queryStats = QueryStats{}; }
+
+    // --------------------------------------------------
+    // Context — 每個 Registry 每種型別一份的共享資料
+    // --------------------------------------------------
+    // 不屬於任何 entity、但多個 System 都要讀的資料放這裡，
+    // 例如敵人的 archetype 調校表（MapLoader 填、EnemySystem/CollisionSystem 讀）。
+    // 第一次存取時自動以預設建構建立，和 getOrCreatePool 同樣的策略。
+    template <typename T>
+    T& context() {
+        auto key = std::type_index(typeid(T));
+        auto it = m_context.find(key);
+        if (it == m_context.end()) {
+            auto value = std::make_shared<T>();
+            T& ref = *value;
+            m_context[key] = std::move(value);
+            return ref;
+        }
+        return *static_cast<T*>(it->second.get());
     }
 
     // --------------------------------------------------
@@ -98,23 +233,87 @@ public:
     // 進階優化（未實作）：
     // 可以先找最小的 pool 作為起點，減少遍歷次數。
     // 目前先用第一個參數的 pool，Phase 1 夠用。
+    //
+    // 預設跳過停用的 entity；需要連停用的一起看時傳 ViewFilter::IncludeDisabled。
     template <typename... Ts>
-    void view(std::function<void(EntityID)> func) {
+    void view(std::function<void(EntityID)> func,
+              ViewFilter filter = ViewFilter::EnabledOnly) {
+        if (filter == ViewFilter::EnabledOnly && !m_queries.empty()) {
+            auto it = m_queries.find(std::type_index(typeid(QuerySignature<Ts...>)));
+            if (it != m_queries.end()) {
+                ++m_queryStats.hits;
+                viewCached(*it->second, func);
+                return;
+            }
+        }
+        ++m_queryStats.misses;
+
         // 用 viewImpl 把第一個類型拆出來
-        viewImpl<Ts...>(func);
+        viewImpl<Ts...>(func, filter);
     }
 
 private:
+    // 只拿來產生 typeid 當作查詢簽名的 key，不會被實例化
+    template <typename... Ts>
+    struct QuerySignature {};
+
+    // 一個註冊查詢的快取：符合條件的 entity 緊密排列，加上反向索引方便 O(1) 移除
+    struct CachedQuery {
+        std::vector<IComponentPool*> pools;  // 簽名中每個型別的 pool（pool 由 unique_ptr 持有，位址穩定）
+        std::vector<EntityID> entities;      // 符合條件的 entity（dense）
+        SparseIndex slots;                   // entity → entities 中的 index
+        std::uint32_t iterating = 0;         // 正在遍歷這份清單的 view 層數（callback 裡可能再 view 一次）
+        size_t holes = 0;                    // 遍歷中被移除、先留成 INVALID_ENTITY 的格子
+    };
+
+    bool queryMatches(const CachedQuery& query, EntityID entity) const;
+    void queryInsert(CachedQuery& query, EntityID entity);
+    void queryErase(CachedQuery& query, EntityID entity);
+    void rebuildQuery(CachedQuery& query);
+    void compactQuery(CachedQuery& query);
+    void onComponentAdded(std::type_index type, EntityID entity);
+    void onComponentRemoved(std::type_index type, EntityID entity);
+    void onEntityRemoved(EntityID entity);
+
+    struct ComponentSignals {
+        std::vector<ComponentCallback> added;
+        std::vector<ComponentCallback> removed;
+    };
+
+    void emitAdded(std::type_index type, EntityID entity);
+    void emitRemoved(std::type_index type, EntityID entity);
+    // destroy 前呼叫：對 entity 擁有的每個有訂閱者的元件型別發出 removed
+    void emitEntityRemoved(EntityID entity);
+
+    // 走快取清單遍歷：就地走，不複製清單
+    // callback 可能 destroy / removeComponent / addComponent，所以遍歷期間結構變動都延後：
+    //   移除只把那一格改成 INVALID_ENTITY（不做 Swap-and-Pop，沒走到的不會被搬到走過的位置）
+    //   新加入的接在尾端，這次遍歷走不到（和複製清單時一樣）
+    // 最外層的遍歷結束時，有洞才壓實一次。
+    void viewCached(CachedQuery& query, std::function<void(EntityID)>& func) {
+        const size_t end = query.entities.size();
+        ++query.iterating;
+        for (size_t i = 0; i < end; ++i) {
+            EntityID entity = query.entities[i];
+            if (entity != INVALID_ENTITY) func(entity);
+        }
+        if (--query.iterating == 0 && query.holes > 0) compactQuery(query);
+    }
+
     // 拆開參數包：First 是第一個類型，用它的 pool 作遍歷起點
     // 這避免了 alias template + pack expansion 的 GCC 相容性問題
     template <typename First, typename... Rest>
-    void viewImpl(std::function<void(EntityID)>& func) {
+    void viewImpl(std::function<void(EntityID)>& func, ViewFilter filter) {
         auto* pool = getPoolPtr<First>();
         if (!pool) return;
 
+        bool skipDisabled = filter == ViewFilter::EnabledOnly;
+
         // 複製 entities 列表，因為 callback 中可能修改 pool
         auto entities = pool->entities();
         for (EntityID entity : entities) {
+            // 停用旗標是以 EntityID 直接索引的陣列，檢查成本是一次陣列讀取
+            if (skipDisabled && !isEnabled(entity)) continue;
             // fold expression：檢查是否同時擁有所有指定元件
             if ((hasComponent<First>(entity) && ... && hasComponent<Rest>(entity))) {
                 func(entity);
@@ -159,10 +358,33 @@ private:
     // 存活 entity 集合
     std::unordered_set<EntityID> m_alive;
 
+    // 啟用旗標：index = EntityID，1 = 啟用，0 = 停用
+    // EntityID 是從 0 遞增且不重複使用，所以可以直接當陣列索引，
+    // 比 unordered_set 查詢便宜（view 每個 entity 都要看一次）
+    std::vector<std::uint8_t> m_enabled;
+
+    // destroyMany 的暫存標記（index = EntityID），用完立即清回 0，重複使用避免每次配置
+    std::vector<std::uint8_t> m_destroyMarks;
+    std::vector<EntityID> m_destroyVictims;
+
     // 所有 ComponentPool 的容器
     // key = type_index（由 typeid(T) 產生）
     // value = unique_ptr<IComponentPool>（型別擦除的 pool）
     std::unordered_map<std::type_index, std::unique_ptr<IComponentPool>> m_pools;
+
+    // 註冊的快取查詢：key = typeid(QuerySignature<Ts...>)
+    std::unordered_map<std::type_index, std::unique_ptr<CachedQuery>> m_queries;
+
+    // 元件型別 → 簽名含有此型別的查詢（add/remove 時只需檢查這些）
+    std::unordered_map<std::type_index, std::vector<CachedQuery*>> m_queriesByType;
+
+    QueryStats m_queryStats;
+
+    // 元件型別 → add/remove 訂閱者
+    std::unordered_map<std::type_index, ComponentSignals> m_signals;
+
+    // Context 資料：shared_ptr<void> 會記住真正的 deleter，型別擦除後也能正確解構
+    std::unordered_map<std::type_index, std::shared_ptr<void>> m_context;
 };
 
 } // namespace duck
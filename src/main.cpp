@@ -1,4 +1,5 @@
 #include "core/Engine.h"
+#include <cstdlib>
 #include <string_view>
 
 int main(int argc, char* argv[]) {
@@ -7,6 +8,24 @@ int main(int argc, char* argv[]) {
         std::string_view arg = argv[i];
         if (arg == "--stress") {
             config.stressMode = true;
+        } else if (arg == "--broadphase=grid") {
+            config.broadPhase = duck::BroadPhaseType::HashGrid;
+        } else if (arg == "--broadphase=sap") {
+            config.broadPhase = duck::BroadPhaseType::SweepAndPrune;
+        } else if (arg == "--broadphase=lbvh") {
+            config.broadPhase = duck::BroadPhaseType::Lbvh;
+        } else if (arg == "--broadphase=quadtree") {
+            config.broadPhase = duck::BroadPhaseType::Quadtree;
+        } else if (arg.substr(0, 10) == "--threads=") {
+            config.collisionThreads = static_cast<unsigned>(std::atoi(argv[i] + 10));
+        } else if (arg.substr(0, 20) == "--solver-iterations=") {
+            config.solverIterations = std::atoi(argv[i] + 20);
+        } else if (arg == "--no-sleep") {
+            config.sleeping = false;
+        } else if (arg.substr(0, 11) == "--sdf-cell=") {
+            config.staticFieldCellSize = static_cast<float>(std::atof(argv[i] + 11));
+        } else if (arg == "--validate-collision") {
+            config.validateCollision = true;
         }
     }
 
@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+namespace duck {
+
+// ============================================================
+// Aabb — broad phase 用的軸對齊包圍盒（min/max 表示）
+// ============================================================
+// 為什麼 broad phase 不沿用「中心 + 半寬」？
+//   broad phase 最常做的是「重疊」和「包含」兩種比較，
+//   min/max 表示下都是 4 次比較、不需要 abs 和加法；
+//   fat bounds 外擴也只是 min 減、max 加。
+// 幾何 narrow phase（CollisionSystem.h）仍然用中心 + 半寬，和 Collider 欄位一致。
+struct Aabb {
+    float minX = 0.0f;
+    float minY = 0.0f;
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+};
+
+inline Aabb makeAabb(float cx, float cy, float halfW, float halfH) {
+    return {cx - halfW, cy - halfH, cx + halfW, cy + halfH};
+}
+
+// 旋轉矩形（OBB，旋轉前的半寬 / 半高 + rotation 的 cos / sin）的外接 AABB
+inline Aabb makeRotatedAabb(float cx, float cy, float halfW, float halfH, float c, float s) {
+    float extentX = std::abs(c) * halfW + std::abs(s) * halfH;
+    float extentY = std::abs(s) * halfW + std::abs(c) * halfH;
+    return makeAabb(cx, cy, extentX, extentY);
+}
+
+// 邊界相切也算重疊（和舊版 Quadtree 的 boundsIntersect 一致，保守）
+inline bool aabbOverlap(const Aabb& a, const Aabb& b) {
+    return a.minX <= b.maxX && b.minX <= a.maxX
+        && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+inline bool aabbContains(const Aabb& outer, const Aabb& inner) {
+    return inner.minX >= outer.minX && inner.maxX <= outer.maxX
+        && inner.minY >= outer.minY && inner.maxY <= outer.maxY;
+}
+
+inline Aabb aabbInflate(const Aabb& a, float margin) {
+    return {a.minX - margin, a.minY - margin, a.maxX + margin, a.maxY + margin};
+}
+
+inline Aabb aabbUnion(const Aabb& a, const Aabb& b) {
+    return {std::min(a.minX, b.minX), std::min(a.minY, b.minY),
+            std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY)};
+}
+
+// 線段的 slab 測試用：位移分量的倒數。分量為 0 時用一個很大的有限值代替無限大，
+// 避免 0 * inf 產生 NaN（起點剛好在邊界上時）
+inline float rayInverse(float d) {
+    return d != 0.0f ? 1.0f / d : 1e30f;
+}
+
+// 線段 origin + d * t（t ∈ [0, tMax]）第一次進入 box 的 t（slab 法，邊界相切也算，保守）；
+// 碰不到回傳比 tMax 大的值。invDx / invDy 是 rayInverse(dx) / rayInverse(dy)，
+// 一條線段測很多個 box 時只算一次
+inline float segmentEnterAabb(float ox, float oy, float invDx, float invDy, const Aabb& box, float tMax) {
+    float tx1 = (box.minX - ox) * invDx;
+    float tx2 = (box.maxX - ox) * invDx;
+    float ty1 = (box.minY - oy) * invDy;
+    float ty2 = (box.maxY - oy) * invDy;
+    float tEnter = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), 0.0f);
+    float tExit = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), tMax);
+    return tEnter <= tExit ? tEnter : tMax + 1.0f;
+}
+
+inline bool segmentOverlapsAabb(float ox, float oy, float invDx, float invDy, const Aabb& box, float tMax) {
+    return segmentEnterAabb(ox, oy, invDx, invDy, box, tMax) <= tMax;
+}
+
+} // namespace duck
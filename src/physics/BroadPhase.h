@@ -0,0 +1,152 @@
+#pragma once
+#include "ecs/Entity.h"
+#include "physics/Aabb.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+// broad phase 輸出的候選配對（a、b 都是 solid collider 的 entity）
+struct BodyPair {
+    EntityID a = INVALID_ENTITY;
+    EntityID b = INVALID_ENTITY;
+};
+
+// 碰撞過濾（來自 Collider::layer / mask，見 Components.h 的 CollisionLayer）
+struct CollisionFilter {
+    std::uint32_t layer = ~0u;
+    std::uint32_t mask = ~0u;
+};
+
+// 雙方都同意才會碰
+inline bool filtersAccept(const CollisionFilter& a, const CollisionFilter& b) {
+    return (a.layer & b.mask) != 0 && (b.layer & a.mask) != 0;
+}
+
+// 上一次 findPairs 的結構統計（profiler / benchmark 用，調 broad phase 參數時看這些數字）
+// 各實作只填適用的欄位，其他維持 0：
+//   nodesVisited：四叉樹走過的節點、網格掃過的 bucket、lbvh 走過的內部節點（sap 沒有節點）
+//   maxDepth：四叉樹最深的非空節點（其他實作 0）
+//   aabbTests：entry 對 entry 的 AABB 測試次數 —— broad phase 真正的工作量
+//   candidatePairs：AABB 重疊、送進 emitPair 的配對；其中 prunedPairs 被 layer / mask 濾掉，
+//                   其餘 pairs 輸出（配對規則保證不重複，輸出的就是去重後的配對）
+//   entriesHistogram：四叉樹每個節點 / 網格每個 bucket 的 entry 數分布，第 0 格是空的，
+//                     第 i 格（i ≥ 1）是 entry 數落在 [2^(i-1), 2^i) 的，最後一格收所有更多的
+struct BroadPhaseStats {
+    static constexpr size_t HISTOGRAM_BUCKETS = 8;
+
+    size_t nodesVisited = 0;
+    size_t maxDepth = 0;
+    size_t aabbTests = 0;
+    size_t candidatePairs = 0;
+    size_t prunedPairs = 0;
+    size_t pairs = 0;
+    std::array<size_t, HISTOGRAM_BUCKETS> entriesHistogram{};
+
+    // entry 數 count 的節點記進直方圖
+    void addNode(size_t count) {
+        size_t bucket = 0;
+        while (count > 0 && bucket + 1 < HISTOGRAM_BUCKETS) {
+            ++bucket;
+            count >>= 1;
+        }
+        ++entriesHistogram[bucket];
+    }
+
+    // 跨 tick 累加（maxDepth 取最大）
+    void add(const BroadPhaseStats& other) {
+        nodesVisited += other.nodesVisited;
+        maxDepth = other.maxDepth > maxDepth ? other.maxDepth : maxDepth;
+        aabbTests += other.aabbTests;
+        candidatePairs += other.candidatePairs;
+        prunedPairs += other.prunedPairs;
+        pairs += other.pairs;
+        for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) entriesHistogram[i] += other.entriesHistogram[i];
+    }
+};
+
+// 可選的 broad phase 實作（Engine::Config / --broadphase= 選擇）
+enum class BroadPhaseType {
+    Quadtree,   // 持久鬆散四叉樹：大小差異大的場景（大牆 + 小子彈）表現穩定
+    HashGrid,   // 均勻雜湊網格：大小相近的圓（敵人潮）最快
+    SweepAndPrune,  // X 軸排序掃描：物體每 tick 只移動一點點時，插入排序幾乎不用搬
+    Lbvh,       // Morton code 排序的線性 BVH：每次整棵平行重建，大量物體同時傳送 / 生成時不會卡
+};
+
+inline const char* broadPhaseName(BroadPhaseType type) {
+    switch (type) {
+        case BroadPhaseType::HashGrid:      return "grid";
+        case BroadPhaseType::SweepAndPrune: return "sap";
+        case BroadPhaseType::Lbvh:          return "lbvh";
+        default:                            return "quadtree";
+    }
+}
+
+// ============================================================
+// BroadPhase — 候選配對產生器的共同介面
+// ============================================================
+// CollisionWorld 管理 entity ↔ proxy 的對應與生命週期，
+// 實際的空間結構藏在這個介面後面，可以在執行期替換。
+//
+// 配對規則（所有實作都要遵守，CollisionSystem 依賴它）：
+//   動態 vs 靜態：輸出一次，a 是動態那方
+//   動態 vs 動態：只輸出一次，a < b
+//   靜態 vs 靜態：永遠不輸出
+//   layer / mask 不相容的配對：不輸出，計入 lastPrunedPairs()
+//
+// CollisionWorld 只把動態物體放進 broad phase（靜態的在 StaticBvh）；
+// 各實作仍保留靜態 proxy 的處理，單獨拿來用時配對規則不變。
+class BroadPhase {
+public:
+    using ProxyID = std::int32_t;
+    static constexpr ProxyID NULL_PROXY = -1;
+
+    virtual ~BroadPhase() = default;
+
+    // bounds 是緊密邊界；要不要外擴由實作決定
+    virtual ProxyID insert(EntityID entity, const Aabb& bounds, bool isStatic, CollisionFilter filter) = 0;
+    virtual void remove(ProxyID id) = 0;
+
+    // 動態物體每個 tick 回報新的緊密邊界
+    // 回傳 true 代表結構真的被改動（重插），給統計用
+    virtual bool update(ProxyID id, const Aabb& bounds) = 0;
+
+    // 產生候選配對（不清空 out）
+    virtual void findPairs(std::vector<BodyPair>& outPairs) = 0;
+
+    // 邊界與 area 重疊的 entity 寫進 out（不清空 out）
+    virtual void query(const Aabb& area, std::vector<EntityID>& outEntities) = 0;
+
+    // 目前存的邊界（切換 broad phase 時搬移資料用）
+    virtual Aabb bounds(ProxyID id) const = 0;
+
+    virtual BroadPhaseType type() const = 0;
+
+    // 可以平行建構 / 配對的實作用幾條執行緒（0 = 硬體執行緒數）；其他實作忽略
+    virtual void setThreadCount(unsigned /*threadCount*/) {}
+
+    // 上一次 findPairs 因 layer / mask 被濾掉的配對數（profiler 用）
+    size_t lastPrunedPairs() const { return m_stats.prunedPairs; }
+    // 上一次 findPairs 的完整統計
+    const BroadPhaseStats& lastStats() const { return m_stats; }
+
+protected:
+    // 所有實作輸出配對都走這裡：過濾不通過只計數，不進 out
+    void emitPair(std::vector<BodyPair>& outPairs, EntityID a, EntityID b,
+                  const CollisionFilter& filterA, const CollisionFilter& filterB) {
+        ++m_stats.candidatePairs;
+        if (filtersAccept(filterA, filterB)) {
+            outPairs.push_back({a, b});
+            ++m_stats.pairs;
+        } else {
+            ++m_stats.prunedPairs;
+        }
+    }
+
+    // 各實作在 findPairs 開頭清空，過程中累加
+    BroadPhaseStats m_stats;
+};
+
+} // namespace duck
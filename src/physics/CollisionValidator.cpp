@@ -0,0 +1,396 @@
+#include "physics/CollisionValidator.h"
+#include "physics/CollisionWorld.h"
+#include "physics/ContactCache.h"
+#include "systems/CollisionSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace duck {
+
+namespace {
+
+constexpr BroadPhaseType ALL_BROAD_PHASES[] = {BroadPhaseType::Quadtree, BroadPhaseType::HashGrid,
+                                               BroadPhaseType::SweepAndPrune, BroadPhaseType::Lbvh};
+
+const char* kindName(SceneBody::Kind kind) {
+    if (kind == SceneBody::Kind::Static) return "static";
+    if (kind == SceneBody::Kind::Player) return "player";
+    return "dynamic";
+}
+
+const char* shapeName(Collider::Type shape) {
+    if (shape == Collider::Type::AABB) return "aabb";
+    if (shape == Collider::Type::OBB) return "obb";
+    return "circle";
+}
+
+} // namespace
+
+// --------------------------------------------------
+// 場景檔
+// --------------------------------------------------
+
+bool saveValidationScene(const ValidationScene& scene, const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "duck-collision-scene 1\n");
+    std::fprintf(file, "broadphase %s\n", broadPhaseName(scene.broadPhase));
+    std::fprintf(file, "field %.9g\n", static_cast<double>(scene.fieldCellSize));
+    std::fprintf(file, "sleeping %d\n", scene.sleeping ? 1 : 0);
+    std::fprintf(file, "bodies %zu\n", scene.bodies.size());
+    // kind shape x y rotation vx vy radius halfW halfH layer mask solid enabled
+    for (const SceneBody& body : scene.bodies) {
+        std::fprintf(file, "%s %s %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %u %u %d %d\n",
+                     kindName(body.kind), shapeName(body.shape), static_cast<double>(body.x),
+                     static_cast<double>(body.y), static_cast<double>(body.rotation), static_cast<double>(body.vx),
+                     static_cast<double>(body.vy), static_cast<double>(body.radius), static_cast<double>(body.halfW),
+                     static_cast<double>(body.halfH), static_cast<unsigned>(body.layer),
+                     static_cast<unsigned>(body.mask), body.solid ? 1 : 0, body.enabled ? 1 : 0);
+    }
+    return std::fclose(file) == 0;
+}
+
+bool loadValidationScene(const std::string& path, ValidationScene& outScene) {
+    std::ifstream input(path);
+    if (!input.is_open()) return false;
+
+    std::string magic, key, name;
+    int version = 0;
+    if (!(input >> magic >> version) || magic != "duck-collision-scene" || version != 1) return false;
+
+    ValidationScene scene;
+    int sleeping = 1;
+    size_t count = 0;
+    if (!(input >> key >> name) || key != "broadphase") return false;
+    bool known = false;
+    for (BroadPhaseType type : ALL_BROAD_PHASES) {
+        if (name != broadPhaseName(type)) continue;
+        scene.broadPhase = type;
+        known = true;
+    }
+    if (!known) return false;
+    if (!(input >> key >> scene.fieldCellSize) || key != "field") return false;
+    if (!(input >> key >> sleeping) || key != "sleeping") return false;
+    if (!(input >> key >> count) || key != "bodies") return false;
+    scene.sleeping = sleeping != 0;
+
+    scene.bodies.resize(count);
+    for (SceneBody& body : scene.bodies) {
+        std::string kind, shape;
+        int solid = 1, enabled = 1;
+        if (!(input >> kind >> shape >> body.x >> body.y >> body.rotation >> body.vx >> body.vy >> body.radius
+                    >> body.halfW >> body.halfH >> body.layer >> body.mask >> solid >> enabled)) {
+            return false;
+        }
+        body.kind = kind == "static" ? SceneBody::Kind::Static
+                  : kind == "player" ? SceneBody::Kind::Player : SceneBody::Kind::Dynamic;
+        body.shape = shape == "aabb" ? Collider::Type::AABB
+                   : shape == "obb" ? Collider::Type::OBB : Collider::Type::Circle;
+        body.solid = solid != 0;
+        body.enabled = enabled != 0;
+    }
+    outScene = std::move(scene);
+    return true;
+}
+
+void buildValidationScene(const ValidationScene& scene, Registry& registry, std::vector<EntityID>* outEntities) {
+    auto& world = registry.context<CollisionWorld>();
+    world.setBroadPhase(scene.broadPhase);
+    world.setStaticFieldCellSize(scene.fieldCellSize);
+    world.setSleepingEnabled(scene.sleeping);
+    if (outEntities) outEntities->clear();
+
+    for (const SceneBody& body : scene.bodies) {
+        EntityID entity = registry.create();
+        registry.addComponent<Transform>(entity, body.x, body.y, body.rotation, 1.0f, 1.0f);
+        registry.addComponent<Collider>(entity, body.shape, body.halfW, body.halfH, body.radius, body.solid,
+                                        body.layer, body.mask);
+        if (body.kind != SceneBody::Kind::Static) registry.addComponent<RigidBody>(entity, body.vx, body.vy, 1.0f, 1.0f);
+        if (body.kind == SceneBody::Kind::Player) registry.addComponent<InputControlled>(entity);
+        if (!body.enabled) registry.setEnabled(entity, false);
+        if (outEntities) outEntities->push_back(entity);
+    }
+}
+
+void recordValidationScene(Registry& registry, const CollisionWorld& world, ValidationScene& outScene) {
+    outScene = ValidationScene{};
+    outScene.broadPhase = world.broadPhaseType();
+    outScene.fieldCellSize = world.staticFieldCellSize();
+    outScene.sleeping = world.sleepingEnabled();
+
+    std::vector<EntityID> entities;
+    registry.view<Transform, Collider>([&](EntityID entity) { entities.push_back(entity); },
+                                       ViewFilter::IncludeDisabled);
+    std::sort(entities.begin(), entities.end());
+
+    outScene.bodies.reserve(entities.size());
+    for (EntityID entity : entities) {
+        const auto& tf = registry.getComponent<Transform>(entity);
+        const auto& col = registry.getComponent<Collider>(entity);
+        SceneBody body;
+        body.kind = !registry.hasComponent<RigidBody>(entity)     ? SceneBody::Kind::Static
+                  : registry.hasComponent<InputControlled>(entity) ? SceneBody::Kind::Player
+                                                                   : SceneBody::Kind::Dynamic;
+        if (body.kind != SceneBody::Kind::Static) {
+            const auto& rb = registry.getComponent<RigidBody>(entity);
+            body.vx = rb.vx;
+            body.vy = rb.vy;
+        }
+        body.shape = col.type;
+        body.x = tf.x;
+        body.y = tf.y;
+        body.rotation = tf.rotation;
+        body.radius = col.radius;
+        body.halfW = col.halfW;
+        body.halfH = col.halfH;
+        body.layer = col.layer;
+        body.mask = col.mask;
+        body.solid = col.isSolid;
+        body.enabled = registry.isEnabled(entity);
+        outScene.bodies.push_back(body);
+    }
+}
+
+void stepValidationScene(Registry& registry, float dt) {
+    registry.view<Transform, RigidBody>([&](EntityID entity) {
+        auto& tf = registry.getComponent<Transform>(entity);
+        const auto& rb = registry.getComponent<RigidBody>(entity);
+        tf.x += rb.vx * dt;
+        tf.y += rb.vy * dt;
+    });
+}
+
+// --------------------------------------------------
+// oracle 與比對
+// --------------------------------------------------
+
+bool CollisionValidator::pairAllowed(const Entry& a, const Entry& b) {
+    if (!a.moving && !b.moving) return false;
+    if (!filtersAccept(a.filter, b.filter)) return false;
+    // 用距離場的物體不再和烘進場裡的靜態物體配對
+    if ((a.fieldBody && b.inField) || (b.fieldBody && a.inField)) return false;
+    return true;
+}
+
+void CollisionValidator::collectEntries(Registry& registry, const CollisionWorld& world) {
+    for (const Entry& entry : m_entries) {
+        m_entryIndex[entry.entity] = NO_ENTRY;
+        if (entry.entity < m_fieldFlags.size()) m_fieldFlags[entry.entity] = 0;
+    }
+    m_entries.clear();
+    for (EntityID entity : world.fieldBodies()) {
+        if (entity >= m_fieldFlags.size()) m_fieldFlags.resize(entity + 1, 0);
+        m_fieldFlags[entity] = 1;
+    }
+
+    // solid 的集合只看元件（isSolid），不問 world：world 漏收或沒把 trigger 移出去都會變成差異。
+    // 停用的 entity 不收（view 預設跳過），narrow phase 也不看它們
+    registry.view<Transform, Collider>([&](EntityID entity) {
+        const auto& col = registry.getComponent<Collider>(entity);
+        if (!col.isSolid) return;
+        float c = 1.0f, s = 0.0f;
+        world.orientation(entity, c, s);
+        Entry entry;
+        entry.bounds = colliderBounds(registry.getComponent<Transform>(entity), col, c, s);
+        entry.entity = entity;
+        entry.filter = {col.layer, col.mask};
+        entry.moving = !world.isStaticBody(entity) && !world.isSleeping(entity);
+        entry.fieldBody = entity < m_fieldFlags.size() && m_fieldFlags[entity] != 0;
+        entry.inField = world.inStaticField(entity);
+        if (entity >= m_entryIndex.size()) m_entryIndex.resize(entity + 1, NO_ENTRY);
+        m_entryIndex[entity] = static_cast<std::uint32_t>(m_entries.size());
+        m_entries.push_back(entry);
+    });
+}
+
+void CollisionValidator::bruteForcePairs(Registry& registry, const CollisionWorld& world,
+                                         std::vector<BodyPair>& outPairs) {
+    collectEntries(registry, world);
+    outPairs.clear();
+    const size_t count = m_entries.size();
+    for (size_t i = 0; i < count; ++i) {
+        const Entry& a = m_entries[i];
+        for (size_t j = i + 1; j < count; ++j) {
+            const Entry& b = m_entries[j];
+            if (!aabbOverlap(a.bounds, b.bounds) || !pairAllowed(a, b)) continue;
+            outPairs.push_back(pairOrdered(a, b) ? BodyPair{a.entity, b.entity} : BodyPair{b.entity, a.entity});
+        }
+    }
+    std::sort(outPairs.begin(), outPairs.end(), [](const BodyPair& x, const BodyPair& y) {
+        return makePairKey(x.a, x.b) < makePairKey(y.a, y.b);
+    });
+}
+
+void CollisionValidator::addMismatch(PairMismatch::Kind kind, EntityID a, EntityID b) {
+    if (m_lastMismatches.size() < MAX_RECORDED) m_lastMismatches.push_back({kind, a, b});
+}
+
+void CollisionValidator::processPairs(Registry& registry, const CollisionWorld& world, std::vector<BodyPair>& pairs) {
+    bruteForcePairs(registry, world, m_expected);
+    m_lastMismatches.clear();
+    ++m_report.ticks;
+    if (m_role == Role::Oracle) {
+        pairs = m_expected;
+        return;
+    }
+
+    m_expectedKeys.clear();
+    for (const BodyPair& pair : m_expected) m_expectedKeys.push_back(makePairKey(pair.a, pair.b));
+    m_reported.clear();
+    for (const BodyPair& pair : pairs) {
+        if (!registry.isEnabled(pair.a) || !registry.isEnabled(pair.b)) continue;
+        m_reported.push_back({makePairKey(pair.a, pair.b), pair});
+    }
+    std::stable_sort(m_reported.begin(), m_reported.end(),
+                     [](const auto& x, const auto& y) { return x.first < y.first; });
+
+    // 兩條都依 key 排好：一次合併就分出 Missing / Duplicate / 多給的候選
+    size_t mismatches = 0;
+    size_t expected = 0;
+    size_t kept = 0;
+    for (size_t i = 0; i < m_reported.size(); ++i) {
+        const std::uint64_t key = m_reported[i].first;
+        const BodyPair& pair = m_reported[i].second;
+        if (i > 0 && m_reported[i - 1].first == key) {
+            addMismatch(PairMismatch::Kind::Duplicate, pair.a, pair.b);
+            ++mismatches;
+            continue;
+        }
+        const Entry* a = entryOf(pair.a);
+        const Entry* b = entryOf(pair.b);
+        if (!a || !b || !pairAllowed(*a, *b) || !pairOrdered(*a, *b)) {
+            addMismatch(PairMismatch::Kind::Invalid, pair.a, pair.b);
+            ++mismatches;
+        }
+        for (; expected < m_expectedKeys.size() && m_expectedKeys[expected] < key; ++expected) {
+            addMismatch(PairMismatch::Kind::Missing, m_expected[expected].a, m_expected[expected].b);
+            ++mismatches;
+        }
+        if (expected < m_expectedKeys.size() && m_expectedKeys[expected] == key) {
+            // canonical：留 oracle 那一份（順序的錯誤上面已經記過）
+            if (m_canonical) pairs[kept++] = m_expected[expected];
+            ++expected;
+        } else {
+            ++m_report.extraPairs;
+        }
+    }
+    for (; expected < m_expectedKeys.size(); ++expected) {
+        addMismatch(PairMismatch::Kind::Missing, m_expected[expected].a, m_expected[expected].b);
+        ++mismatches;
+    }
+    if (m_canonical) pairs.resize(kept);
+
+    m_report.expectedPairs += m_expected.size();
+    m_report.reportedPairs += m_reported.size();
+    if (mismatches > 0) {
+        if (m_report.firstMismatchTick == ValidationReport::NO_TICK) m_report.firstMismatchTick = m_report.ticks - 1;
+        ++m_report.mismatchTicks;
+    }
+}
+
+// --------------------------------------------------
+// repro
+// --------------------------------------------------
+
+bool CollisionValidator::sceneFails(const ValidationScene& scene) {
+    Registry registry;
+    buildValidationScene(scene, registry);
+    auto& world = registry.context<CollisionWorld>();
+    world.sync(registry);
+    std::vector<BodyPair> pairs;
+    world.findPairs(pairs);
+    CollisionValidator validator;
+    validator.processPairs(registry, world, pairs);
+    return validator.lastTickFailed();
+}
+
+ValidationScene CollisionValidator::shrinkScene(const ValidationScene& scene,
+                                                const std::function<bool(const ValidationScene&)>& fails) {
+    ValidationScene current = scene;
+    size_t chunks = 2;
+    while (current.bodies.size() > 1) {
+        const size_t chunk = (current.bodies.size() + chunks - 1) / chunks;
+        bool removed = false;
+        for (size_t start = 0; start < current.bodies.size();) {
+            ValidationScene candidate = current;
+            size_t end = std::min(start + chunk, candidate.bodies.size());
+            candidate.bodies.erase(candidate.bodies.begin() + static_cast<std::ptrdiff_t>(start),
+                                   candidate.bodies.begin() + static_cast<std::ptrdiff_t>(end));
+            if (!candidate.bodies.empty() && fails(candidate)) {
+                current = std::move(candidate);
+                removed = true;               // 同一個 start 現在是下一塊
+            } else {
+                start = end;
+            }
+        }
+        if (removed) {
+            chunks = std::max<size_t>(chunks - 1, 2);
+        } else if (chunk == 1) {
+            break;
+        } else {
+            chunks = std::min(chunks * 2, current.bodies.size());
+        }
+    }
+    return current;
+}
+
+bool CollisionValidator::writeRepro(Registry& registry, const CollisionWorld& world, const std::string& path,
+                                    size_t& outBodies) {
+    ValidationScene scene;
+    recordValidationScene(registry, world, scene);
+    bool reproduces = sceneFails(scene);
+    if (reproduces) scene = shrinkScene(scene, sceneFails);
+    outBodies = saveValidationScene(scene, path) ? scene.bodies.size() : 0;
+    return reproduces;
+}
+
+// --------------------------------------------------
+// side-by-side
+// --------------------------------------------------
+
+SideBySideResult runSideBySide(const ValidationScene& scene, int ticks, float dt) {
+    SideBySideResult result;
+    Registry checked;
+    Registry oracle;
+    std::vector<EntityID> checkedIds;
+    std::vector<EntityID> oracleIds;
+    buildValidationScene(scene, checked, &checkedIds);
+    buildValidationScene(scene, oracle, &oracleIds);
+
+    CollisionValidator checkValidator;
+    CollisionValidator oracleValidator;
+    checkValidator.setCanonicalPairs(true);
+    oracleValidator.setRole(CollisionValidator::Role::Oracle);
+    oracleValidator.setCanonicalPairs(true);
+    CollisionSystem checkSystem;
+    CollisionSystem oracleSystem;
+    checkSystem.setValidator(&checkValidator);
+    oracleSystem.setValidator(&oracleValidator);
+
+    for (int tick = 0; tick < ticks; ++tick) {
+        stepValidationScene(checked, dt);
+        stepValidationScene(oracle, dt);
+        checkSystem.update(checked, dt);
+        oracleSystem.update(oracle, dt);
+        if (checkValidator.lastTickFailed() && result.firstMismatches.empty()) {
+            result.firstMismatches = checkValidator.lastMismatches();
+        }
+        for (size_t i = 0; i < checkedIds.size(); ++i) {
+            const auto& a = checked.getComponent<Transform>(checkedIds[i]);
+            const auto& b = oracle.getComponent<Transform>(oracleIds[i]);
+            float error = std::max(std::abs(a.x - b.x), std::abs(a.y - b.y));
+            if (error == 0.0f) continue;
+            if (result.firstPositionTick == ValidationReport::NO_TICK) {
+                result.firstPositionTick = static_cast<size_t>(tick);
+                result.firstPositionEntity = checkedIds[i];
+            }
+            result.maxPositionError = std::max(result.maxPositionError, error);
+        }
+    }
+    result.pairs = checkValidator.report();
+    return result;
+}
+
+} // namespace duck
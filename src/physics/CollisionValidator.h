@@ -0,0 +1,194 @@
+#pragma once
+#include "ecs/Components.h"
+#include "ecs/Entity.h"
+#include "ecs/Registry.h"
+#include "physics/Aabb.h"
+#include "physics/BroadPhase.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace duck {
+
+class CollisionWorld;
+
+// ============================================================
+// 驗證場景：碰撞需要的最小狀態，可以存成文字檔重播
+// ============================================================
+// 一個 body 一筆，依原本的 EntityID 由小到大排列；重建時第 i 筆是第 i 個建立的 entity，
+// 所以「動態 vs 動態只在 a < b 時輸出」的順序和原本的場景一致。
+// 休眠狀態不記：重播一律從醒著開始。
+struct SceneBody {
+    // Static：沒有 RigidBody；Player：多一個 InputControlled（永遠不睡）
+    enum class Kind { Static, Dynamic, Player };
+
+    Kind kind = Kind::Dynamic;
+    Collider::Type shape = Collider::Type::Circle;
+    float x = 0.0f;
+    float y = 0.0f;
+    float rotation = 0.0f;
+    float vx = 0.0f;                      // 重播時每個 tick 的移動（Static 忽略）
+    float vy = 0.0f;
+    float radius = 16.0f;
+    float halfW = 16.0f;
+    float halfH = 16.0f;
+    std::uint32_t layer = CollisionLayer::Default;
+    std::uint32_t mask = CollisionLayer::All;
+    bool solid = true;                    // false = trigger
+    bool enabled = true;
+};
+
+struct ValidationScene {
+    BroadPhaseType broadPhase = BroadPhaseType::Quadtree;
+    float fieldCellSize = 0.0f;           // CollisionWorld::setStaticFieldCellSize
+    bool sleeping = true;
+    std::vector<SceneBody> bodies;
+};
+
+// 文字格式（一行一個欄位 / 一個 body，浮點數存 9 位有效數字，讀回來逐位元相同）；失敗回傳 false
+bool saveValidationScene(const ValidationScene& scene, const std::string& path);
+bool loadValidationScene(const std::string& path, ValidationScene& outScene);
+// 把場景建進一個空的 Registry，並套用 broad phase / 距離場 / 休眠設定；outEntities[i] 是第 i 筆 body
+void buildValidationScene(const ValidationScene& scene, Registry& registry,
+                          std::vector<EntityID>* outEntities = nullptr);
+// 錄下 registry 目前所有掛 Transform + Collider 的 entity（含停用的與 trigger）
+void recordValidationScene(Registry& registry, const CollisionWorld& world, ValidationScene& outScene);
+// 重播用的移動：每個有 RigidBody 的 entity 照速度走一步（不含摩擦）
+void stepValidationScene(Registry& registry, float dt);
+
+// findPairs 和 oracle 不一致的一筆
+struct PairMismatch {
+    // Missing：邊界重疊、規則上該輸出卻沒輸出；Duplicate：同一對輸出兩次；
+    // Invalid：違反配對規則（兩邊都不動、順序不對、layer / mask 不相容、該由距離場處理、不是 solid）
+    enum class Kind { Missing, Duplicate, Invalid };
+
+    Kind kind = Kind::Missing;
+    EntityID a = INVALID_ENTITY;
+    EntityID b = INVALID_ENTITY;
+};
+
+inline const char* pairMismatchName(PairMismatch::Kind kind) {
+    switch (kind) {
+        case PairMismatch::Kind::Duplicate: return "duplicate";
+        case PairMismatch::Kind::Invalid:   return "invalid";
+        default:                            return "missing";
+    }
+}
+
+// 累計結果：pair 數都是所有驗證過的 tick 加總
+struct ValidationReport {
+    static constexpr size_t NO_TICK = ~size_t(0);
+
+    size_t ticks = 0;
+    size_t expectedPairs = 0;             // oracle 的配對（邊界真的重疊的）
+    size_t reportedPairs = 0;             // findPairs 的輸出
+    size_t extraPairs = 0;                // findPairs 多給、邊界沒有重疊的候選（fat bounds，合法）
+    size_t mismatchTicks = 0;
+    size_t firstMismatchTick = NO_TICK;   // 從 0 數
+
+    bool ok() const { return mismatchTicks == 0; }
+};
+
+// ============================================================
+// CollisionValidator — 用 O(n²) 暴力法當 oracle 檢查 broad phase
+// ============================================================
+// oracle 不碰任何加速結構：直接拿每個 solid（看 Collider::isSolid）在這個 tick sync() 後的緊密邊界兩兩比對，
+// 套上 CollisionWorld::findPairs 的規則（靜態 vs 靜態、睡著 vs 不動的不輸出，layer / mask，
+// 距離場接手的牆）；只向 world 問分類（靜態 / 睡著 / 進了距離場），不問空間結構。
+// 邊界重疊的配對 findPairs 一定要給；多給的候選（fat bounds）合法、只記數量。
+// 停用的 entity 兩邊都不看（narrow phase 本來就跳過）。
+//
+// 兩種角色，透過 CollisionSystem::setValidator 掛在 findPairs 之後：
+//   Check ：比對 findPairs 的輸出，差異記進 lastMismatches() / report()
+//   Oracle：直接換成暴力法的配對（side-by-side 的對照組）
+// canonical 打開時，Check 只留下 oracle 也有的配對、兩種角色都依 pair key 排序，
+// broad phase 沒有漏掉任何一對時兩邊的 solver 吃到同一份清單，推開後的位置逐位元相同。
+class CollisionValidator {
+public:
+    enum class Role { Check, Oracle };
+    // lastMismatches() 最多保留幾筆（report 的計數不受限）
+    static constexpr size_t MAX_RECORDED = 16;
+
+    void setRole(Role role) { m_role = role; }
+    Role role() const { return m_role; }
+    void setCanonicalPairs(bool canonical) { m_canonical = canonical; }
+
+    // CollisionSystem 在 world.findPairs 之後呼叫；pairs 可能被換掉或重排（見上）
+    void processPairs(Registry& registry, const CollisionWorld& world, std::vector<BodyPair>& pairs);
+
+    // oracle：規則上該輸出的配對，依 pair key 排序（a、b 的順序和 findPairs 的規則一樣）
+    void bruteForcePairs(Registry& registry, const CollisionWorld& world, std::vector<BodyPair>& outPairs);
+
+    bool lastTickFailed() const { return !m_lastMismatches.empty(); }
+    const std::vector<PairMismatch>& lastMismatches() const { return m_lastMismatches; }
+    const ValidationReport& report() const { return m_report; }
+    void resetReport() { m_report = ValidationReport{}; }
+
+    // 從頭建一個 world、sync + findPairs 一次，有任何差異就回傳 true
+    static bool sceneFails(const ValidationScene& scene);
+    // 一次刪掉一塊 body（塊越切越小），刪了仍然 fails 就留著刪掉的版本，
+    // 直到刪任何一個 body 都不再重現為止（1-minimal）
+    static ValidationScene shrinkScene(const ValidationScene& scene,
+                                       const std::function<bool(const ValidationScene&)>& fails);
+    // 錄下目前的場景：從頭建 world 能重現就縮到最小再存，不能重現（差異和狀態的歷史有關）就存整個場景。
+    // 回傳是否重現；outBodies 是存下的 body 數
+    static bool writeRepro(Registry& registry, const CollisionWorld& world, const std::string& path,
+                           size_t& outBodies);
+
+private:
+    struct Entry {
+        Aabb bounds;
+        EntityID entity = INVALID_ENTITY;
+        CollisionFilter filter;
+        bool moving = false;              // 醒著的動態物體（才會主動產生配對）
+        bool fieldBody = false;           // 這個 tick 改用距離場處理牆
+        bool inField = false;             // 烘進距離場的靜態物體
+    };
+
+    // 一對 entity 依 findPairs 的規則該不該輸出（不看邊界、不看順序）
+    static bool pairAllowed(const Entry& a, const Entry& b);
+    // findPairs 的順序：醒著的動態在前，兩邊都醒著時 a < b
+    static bool pairOrdered(const Entry& a, const Entry& b) {
+        return a.moving && (!b.moving || a.entity < b.entity);
+    }
+    const Entry* entryOf(EntityID entity) const {
+        return entity < m_entryIndex.size() && m_entryIndex[entity] != NO_ENTRY ? &m_entries[m_entryIndex[entity]]
+                                                                               : nullptr;
+    }
+    void collectEntries(Registry& registry, const CollisionWorld& world);
+    void addMismatch(PairMismatch::Kind kind, EntityID a, EntityID b);
+
+    static constexpr std::uint32_t NO_ENTRY = ~0u;
+
+    Role m_role = Role::Check;
+    bool m_canonical = false;
+    ValidationReport m_report;
+    std::vector<PairMismatch> m_lastMismatches;
+
+    // 每個 tick 重用的暫存
+    std::vector<Entry> m_entries;
+    std::vector<std::uint32_t> m_entryIndex;   // index = EntityID
+    std::vector<std::uint8_t> m_fieldFlags;
+    std::vector<BodyPair> m_expected;
+    std::vector<std::uint64_t> m_expectedKeys;
+    std::vector<std::pair<std::uint64_t, BodyPair>> m_reported;
+};
+
+// side-by-side：同一個場景建兩份，一份用場景的 broad phase（Check），一份用 oracle 的配對，
+// 每個 tick 先照速度移動、各跑一次 CollisionSystem::update，再比對所有 body 的位置
+struct SideBySideResult {
+    ValidationReport pairs;               // Check 那一份的配對比對結果
+    std::vector<PairMismatch> firstMismatches;   // 第一個出錯的 tick 的差異
+    size_t firstPositionTick = ValidationReport::NO_TICK;
+    EntityID firstPositionEntity = INVALID_ENTITY;
+    float maxPositionError = 0.0f;
+
+    bool ok() const { return pairs.ok() && firstPositionTick == ValidationReport::NO_TICK; }
+};
+
+SideBySideResult runSideBySide(const ValidationScene& scene, int ticks, float dt);
+
+} // namespace duck
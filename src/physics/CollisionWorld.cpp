@@ -0,0 +1,483 @@
+#include "physics/CollisionWorld.h"
+#include "physics/LinearBvh.h"
+#include "physics/LooseQuadtree.h"
+#include "physics/SpatialHashGrid.h"
+#include "physics/SweepAndPrune.h"
+#include "systems/CollisionSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace duck {
+
+namespace {
+
+std::unique_ptr<BroadPhase> makeBroadPhase(BroadPhaseType type) {
+    if (type == BroadPhaseType::HashGrid) return std::make_unique<SpatialHashGrid>();
+    if (type == BroadPhaseType::SweepAndPrune) return std::make_unique<SweepAndPrune>();
+    if (type == BroadPhaseType::Lbvh) return std::make_unique<LinearBvh>();
+    return std::make_unique<LooseQuadtree>();
+}
+
+} // namespace
+
+CollisionWorld::CollisionWorld() : m_broadPhase(makeBroadPhase(BroadPhaseType::Quadtree)) {}
+
+CollisionWorld::~CollisionWorld() = default;
+
+void CollisionWorld::setBroadPhase(BroadPhaseType type) {
+    if (m_broadPhase->type() == type) return;
+
+    auto next = makeBroadPhase(type);
+    next->setThreadCount(m_broadPhaseThreads);
+    if (auto* tree = dynamic_cast<LooseQuadtree*>(next.get())) {
+        // 新的四叉樹沿用舊結構裡所有物體（含靜態）的範圍當世界邊界
+        m_staticBvh.build();
+        Aabb world;
+        bool any = m_staticBvh.rootBounds(world);
+        for (const Body& body : m_dynamic) {
+            Aabb b = body.asleep ? body.tight : m_broadPhase->bounds(body.proxy);
+            world = any ? aabbUnion(world, b) : b;
+            any = true;
+        }
+        if (any) tree->reset(aabbInflate(world, 64.0f));
+    }
+
+    // 靜態物體在 StaticBvh、睡著的在 m_sleepingBvh，都不受影響；只搬醒著的動態
+    for (Body& body : m_dynamic) {
+        if (body.asleep) continue;
+        body.proxy = next->insert(body.entity, m_broadPhase->bounds(body.proxy), false, body.filter);
+    }
+    m_broadPhase = std::move(next);
+}
+
+void CollisionWorld::setBroadPhaseThreadCount(unsigned threadCount) {
+    m_broadPhaseThreads = threadCount;
+    m_broadPhase->setThreadCount(threadCount);
+}
+
+void CollisionWorld::attach(Registry& registry) {
+    m_attached = true;
+    registry.onAdd<Collider>([this](EntityID entity) { m_pending.push_back(entity); });
+    registry.onRemove<Collider>([this](EntityID entity) { removeBody(entity); });
+
+    // 訂閱之前就已存在的 Collider（例如地圖載入）：
+    // 先算出它們的整體範圍當作樹的世界邊界，再一次全部排進 pending
+    bool any = false;
+    Aabb world;
+    registry.view<Transform, Collider>([&](EntityID entity) {
+        Aabb bounds = colliderBounds(registry.getComponent<Transform>(entity),
+                                     registry.getComponent<Collider>(entity));
+        world = any ? aabbUnion(world, bounds) : bounds;
+        any = true;
+        m_pending.push_back(entity);
+    }, ViewFilter::IncludeDisabled);
+
+    if (!any) return;
+    if (auto* tree = dynamic_cast<LooseQuadtree*>(m_broadPhase.get())) {
+        tree->reset(aabbInflate(world, 64.0f));
+    }
+}
+
+void CollisionWorld::addBody(Registry& registry, EntityID entity) {
+    if (m_slots.contains(entity) || m_triggerSlots.contains(entity)) return;
+    if (!registry.alive(entity)) return;
+    if (!registry.hasComponent<Collider>(entity) || !registry.hasComponent<Transform>(entity)) return;
+
+    const auto& col = registry.getComponent<Collider>(entity);
+    const auto& tf = registry.getComponent<Transform>(entity);
+    bool oriented = col.type == Collider::Type::OBB;
+    float c = oriented ? std::cos(tf.rotation) : 1.0f;
+    float s = oriented ? std::sin(tf.rotation) : 0.0f;
+    Aabb bounds = colliderBounds(tf, col, c, s);
+    bool isStatic = !registry.hasComponent<RigidBody>(entity);
+    CollisionFilter filter{col.layer, col.mask};
+    if (!col.isSolid) {
+        addTrigger(entity, bounds, isStatic, filter);
+        return;
+    }
+
+    Body* body = nullptr;
+    if (isStatic) {
+        auto item = m_staticBvh.insert(entity, bounds, filter);
+        m_slots.set(entity, static_cast<std::uint32_t>(m_static.size()) | STATIC_BIT);
+        m_static.push_back({entity, item, bounds, filter});
+        body = &m_static.back();
+        m_fieldDirty = true;
+    } else {
+        auto proxy = m_broadPhase->insert(entity, bounds, false, filter);
+        m_slots.set(entity, static_cast<std::uint32_t>(m_dynamic.size()));
+        m_dynamic.push_back({entity, proxy, bounds, filter});
+        body = &m_dynamic.back();
+        body->circle = col.type == Collider::Type::Circle;
+        m_dynamicLayers |= filter.layer;
+    }
+    body->oriented = oriented;
+    body->cosR = c;
+    body->sinR = s;
+}
+
+void CollisionWorld::addTrigger(EntityID entity, const Aabb& bounds, bool isStatic, CollisionFilter filter) {
+    if (isStatic) {
+        auto item = m_triggerBvh.insert(entity, bounds, filter);
+        m_triggerSlots.set(entity, static_cast<std::uint32_t>(m_staticTriggers.size()) | STATIC_BIT);
+        m_staticTriggers.push_back({entity, item, filter});
+        m_staticTriggerMasks |= filter.mask;
+    } else {
+        m_triggerSlots.set(entity, static_cast<std::uint32_t>(m_movingTriggers.size()));
+        m_movingTriggers.push_back({entity, StaticBvh::NULL_ITEM, filter});
+    }
+}
+
+// 同樣 Swap-and-Pop；還在重疊的配對下一次 updateTriggers() 自然變成 exit 事件
+void CollisionWorld::removeTrigger(EntityID entity, std::uint32_t slot) {
+    bool isStatic = (slot & STATIC_BIT) != 0;
+    auto& triggers = isStatic ? m_staticTriggers : m_movingTriggers;
+    std::uint32_t index = slot & ~STATIC_BIT;
+
+    if (isStatic) m_triggerBvh.remove(triggers[index].item);
+    if (index != triggers.size() - 1) {
+        triggers[index] = triggers.back();
+        m_triggerSlots.set(triggers[index].entity, index | (isStatic ? STATIC_BIT : 0u));
+    }
+    triggers.pop_back();
+    m_triggerSlots.erase(entity);
+}
+
+// Swap-and-Pop，和 ComponentPool::remove 同一招
+void CollisionWorld::removeBody(EntityID entity) {
+    std::uint32_t triggerSlot = m_triggerSlots.get(entity);
+    if (triggerSlot != SparseIndex::NONE) {
+        removeTrigger(entity, triggerSlot);
+        return;
+    }
+    std::uint32_t slot = m_slots.get(entity);
+    if (slot == SparseIndex::NONE) return;
+
+    bool isStatic = (slot & STATIC_BIT) != 0;
+    auto& bodies = isStatic ? m_static : m_dynamic;
+    std::uint32_t index = slot & ~STATIC_BIT;
+
+    if (isStatic) {
+        m_staticBvh.remove(bodies[index].proxy);
+        m_fieldDirty = true;
+    } else if (bodies[index].asleep) {
+        m_sleepingBvh.remove(bodies[index].sleepItem);
+        --m_sleepingCount;
+    } else {
+        m_broadPhase->remove(bodies[index].proxy);
+    }
+    if (index != bodies.size() - 1) {
+        bodies[index] = bodies.back();
+        m_slots.set(bodies[index].entity, index | (isStatic ? STATIC_BIT : 0u));
+    }
+    bodies.pop_back();
+    m_slots.erase(entity);
+}
+
+void CollisionWorld::setSolid(Registry& registry, EntityID entity, bool solid) {
+    if (!registry.hasComponent<Collider>(entity)) return;
+    auto& col = registry.getComponent<Collider>(entity);
+    if (col.isSolid == solid) return;
+    col.isSolid = solid;
+    m_reclassify.push_back(entity);
+}
+
+// setSolid 排進來的物體：分類（solid / trigger）和 isSolid 不一致就整個拿掉，再照新的值重新加入；
+// 原本的重疊在下一次 findPairs / updateTriggers 自然結束。同一個 tick 來回切換的不會動
+void CollisionWorld::reclassify(Registry& registry) {
+    m_lastReclassified = 0;
+    for (EntityID entity : m_reclassify) {
+        if (!registry.alive(entity) || !registry.hasComponent<Collider>(entity)) continue;
+        bool solid = registry.getComponent<Collider>(entity).isSolid;
+        if (solid ? !m_triggerSlots.contains(entity) : !m_slots.contains(entity)) continue;
+        removeBody(entity);
+        addBody(registry, entity);
+        ++m_lastReclassified;
+    }
+    m_reclassify.clear();
+}
+
+void CollisionWorld::sync(Registry& registry) {
+    if (!m_attached) attach(registry);
+
+    for (EntityID entity : m_pending) addBody(registry, entity);
+    m_pending.clear();
+    reclassify(registry);
+    // 只有靜態物體增加（地圖載入）或移除太多時才真的重建
+    m_staticBvh.build();
+    m_triggerBvh.build();
+    if (m_fieldDirty) rebuildField(registry);
+
+    m_lastReinserts = 0;
+    auto* transforms = registry.findPool<Transform>();
+    auto* colliders = registry.findPool<Collider>();
+    auto* rigidBodies = registry.findPool<RigidBody>();
+    for (Body& body : m_dynamic) {
+        const Transform& tf = transforms->get(body.entity);
+        // 動態 OBB 的 cos / sin 每個 tick 只算一次，narrow phase 直接讀
+        bool turned = false;
+        if (body.oriented) {
+            float c = std::cos(tf.rotation);
+            float s = std::sin(tf.rotation);
+            turned = c != body.cosR || s != body.sinR;
+            body.cosR = c;
+            body.sinR = s;
+        }
+        Aabb tight = colliderBounds(tf, colliders->get(body.entity), body.cosR, body.sinR);
+        // 加入後才被拿掉 RigidBody 的動態物體視為靜止
+        bool resting = true;
+        if (rigidBodies && rigidBodies->has(body.entity)) {
+            const RigidBody& rb = rigidBodies->get(body.entity);
+            resting = rb.vx == 0.0f && rb.vy == 0.0f;
+        }
+
+        if (body.asleep) {
+            // 睡著的物體一點點都不該動：Transform 被改過（移動、被推、傳送）或有了速度就叫醒
+            if (resting && !turned && std::memcmp(&tight, &body.tight, sizeof(Aabb)) == 0) continue;
+            wakeBody(body, tight);
+            body.tight = tight;
+            ++m_lastReinserts;
+            continue;
+        }
+
+        float moved = std::max({std::abs(tight.minX - body.tight.minX), std::abs(tight.minY - body.tight.minY),
+                                std::abs(tight.maxX - body.tight.maxX), std::abs(tight.maxY - body.tight.maxY)});
+        body.tight = tight;
+        if (m_broadPhase->update(body.proxy, body.tight)) ++m_lastReinserts;
+
+        if (!m_sleepingEnabled || !resting || moved > SLEEP_DISTANCE) {
+            body.stillTicks = 0;
+        } else if (++body.stillTicks >= SLEEP_TICKS && !registry.hasComponent<InputControlled>(body.entity)) {
+            sleepBody(body);
+        }
+    }
+    // 這個 tick 有物體睡著才重建
+    m_sleepingBvh.build();
+}
+
+void CollisionWorld::setStaticFieldCellSize(float cellSize) {
+    m_fieldCellSize = cellSize > 0.0f ? cellSize : 0.0f;
+    m_fieldDirty = true;
+    if (m_fieldCellSize == 0.0f) {
+        m_field.clear();
+        m_fieldLayers = 0;
+    }
+}
+
+// 靜態物體有增減（或換了格子大小）之後的第一次 sync() 重烘；地圖載入時就是一次
+void CollisionWorld::rebuildField(Registry& registry) {
+    m_fieldDirty = false;
+    m_fieldLayers = 0;
+    m_fieldExcluded = 0;
+    std::vector<DistanceFieldShape> shapes;
+    for (Body& body : m_static) {
+        body.inField = false;
+        if (m_fieldCellSize == 0.0f) continue;
+        const auto& col = registry.getComponent<Collider>(body.entity);
+        // mask 挑過的靜態物體只跟部分的層相撞，烘進去就分不出誰能穿過它
+        body.inField = col.mask == CollisionLayer::All && registry.isEnabled(body.entity);
+        if (!body.inField) {
+            ++m_fieldExcluded;
+            continue;
+        }
+        const auto& tf = registry.getComponent<Transform>(body.entity);
+        bool isCircle = col.type == Collider::Type::Circle;
+        shapes.push_back({tf.x, tf.y, isCircle ? col.radius : col.halfW, isCircle ? col.radius : col.halfH, isCircle,
+                          body.cosR, body.sinR});
+        m_fieldLayers |= col.layer;
+    }
+    if (shapes.empty()) {
+        m_field.clear();
+        return;
+    }
+    m_field.build(shapes, m_fieldCellSize);
+}
+
+void CollisionWorld::sleepBody(Body& body) {
+    m_broadPhase->remove(body.proxy);
+    body.proxy = BroadPhase::NULL_PROXY;
+    body.sleepItem = m_sleepingBvh.insert(body.entity, body.tight, body.filter);
+    body.asleep = true;
+    ++m_sleepingCount;
+}
+
+// 移除只在葉節點留空格，m_sleepingBvh 不必重建
+void CollisionWorld::wakeBody(Body& body, const Aabb& bounds) {
+    m_sleepingBvh.remove(body.sleepItem);
+    body.sleepItem = StaticBvh::NULL_ITEM;
+    body.proxy = m_broadPhase->insert(body.entity, bounds, false, body.filter);
+    body.asleep = false;
+    body.stillTicks = 0;
+    --m_sleepingCount;
+}
+
+void CollisionWorld::wake(EntityID entity) {
+    if (!isSleeping(entity)) return;
+    Body& body = m_dynamic[m_slots.get(entity)];
+    wakeBody(body, body.tight);
+}
+
+void CollisionWorld::setSleepingEnabled(bool enabled) {
+    m_sleepingEnabled = enabled;
+    if (enabled) return;
+    for (Body& body : m_dynamic) {
+        if (body.asleep) wakeBody(body, body.tight);
+        body.stillTicks = 0;
+    }
+}
+
+void CollisionWorld::findPairs(std::vector<BodyPair>& outPairs) {
+    m_broadPhase->findPairs(outPairs);
+    m_lastPruned = m_broadPhase->lastPrunedPairs();
+    size_t first = outPairs.size();
+    m_fieldBodies.clear();
+    // 動態 vs 靜態、動態 vs 睡著：都由醒著的那一方查；睡著的物體不出發
+    // 用距離場的物體只查沒進場的靜態物體（全部都進場時整棵樹都不必查）
+    for (const Body& body : m_dynamic) {
+        if (body.asleep) continue;
+        if (!usesField(body)) {
+            m_staticBvh.query(body.tight, body.filter, m_lastPruned,
+                              [&](EntityID other) { outPairs.push_back({body.entity, other}); });
+        } else {
+            m_fieldBodies.push_back(body.entity);
+            if (m_fieldExcluded > 0) {
+                m_staticBvh.query(body.tight, body.filter, m_lastPruned, [&](EntityID other) {
+                    if (!m_static[m_slots.get(other) & ~STATIC_BIT].inField) outPairs.push_back({body.entity, other});
+                });
+            }
+        }
+        m_sleepingBvh.query(body.tight, body.filter, m_lastPruned,
+                            [&](EntityID other) { outPairs.push_back({body.entity, other}); });
+    }
+    m_lastStaticPairs = outPairs.size() - first;
+}
+
+void CollisionWorld::query(const Aabb& area, const CollisionFilter& filter, std::vector<EntityID>& outEntities) {
+    // broad phase 只回傳 entity：先照常查，再用 m_slots 找回各自的 filter 就地壓縮
+    size_t first = outEntities.size();
+    m_broadPhase->query(area, outEntities);
+    size_t kept = first;
+    for (size_t i = first; i < outEntities.size(); ++i) {
+        const Body& body = m_dynamic[m_slots.get(outEntities[i])];
+        if (filtersAccept(filter, body.filter)) outEntities[kept++] = outEntities[i];
+    }
+    outEntities.resize(kept);
+
+    size_t pruned = 0;
+    m_sleepingBvh.query(area, filter, pruned, [&](EntityID entity) { outEntities.push_back(entity); });
+    m_staticBvh.query(area, filter, pruned, [&](EntityID entity) { outEntities.push_back(entity); });
+}
+
+void CollisionWorld::raycast(Registry& registry, const std::vector<RayCast>& rays, std::vector<RayHit>& outHits) {
+    outHits.assign(rays.size(), RayHit{});
+    auto* transforms = registry.findPool<Transform>();
+    auto* colliders = registry.findPool<Collider>();
+    if (!transforms || !colliders) return;
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        const RayCast& ray = rays[i];
+        RayHit& best = outHits[i];
+
+        // 候選的精確測試：更早（或同 t 但 EntityID 較小）才取代目前的命中
+        auto test = [&](EntityID entity) {
+            if (entity == ray.ignore || !registry.isEnabled(entity)) return;
+            const Transform& tf = transforms->get(entity);
+            const Collider& col = colliders->get(entity);
+            float t = 0.0f, nx = 0.0f, ny = 0.0f;
+            bool hit = false;
+            if (col.type == Collider::Type::Circle) {
+                hit = rayVsCircle(ray.x, ray.y, ray.dx, ray.dy, tf.x, tf.y, col.radius, t, nx, ny);
+            } else if (col.type == Collider::Type::OBB) {
+                float c = 1.0f, s = 0.0f;
+                orientation(entity, c, s);
+                hit = rayVsObb(ray.x, ray.y, ray.dx, ray.dy, tf.x, tf.y, col.halfW, col.halfH, c, s, t, nx, ny);
+            } else {
+                hit = rayVsBox(ray.x, ray.y, ray.dx, ray.dy, tf.x, tf.y, col.halfW, col.halfH, t, nx, ny);
+            }
+            if (!hit || t > best.t || (t == best.t && entity >= best.entity)) return;
+            best.entity = entity;
+            best.t = t;
+            best.nx = nx;
+            best.ny = ny;
+        };
+
+        m_staticBvh.raycast(ray.x, ray.y, ray.dx, ray.dy, ray.filter, best.t, test);
+        m_sleepingBvh.raycast(ray.x, ray.y, ray.dx, ray.dy, ray.filter, best.t, test);
+        if ((ray.filter.mask & m_dynamicLayers) != 0 && !m_dynamic.empty()) {
+            // 已經有命中時只需要查到命中點為止
+            float endX = ray.x + ray.dx * best.t;
+            float endY = ray.y + ray.dy * best.t;
+            Aabb area{std::min(ray.x, endX), std::min(ray.y, endY), std::max(ray.x, endX), std::max(ray.y, endY)};
+            m_rayCandidates.clear();
+            m_broadPhase->query(area, m_rayCandidates);
+            for (EntityID entity : m_rayCandidates) {
+                if (!filtersAccept(ray.filter, m_dynamic[m_slots.get(entity)].filter)) continue;
+                test(entity);
+            }
+        }
+
+        if (best.hit()) {
+            best.x = ray.x + ray.dx * best.t;
+            best.y = ray.y + ray.dy * best.t;
+            best.distance = std::sqrt(ray.dx * ray.dx + ray.dy * ray.dy) * best.t;
+        }
+    }
+}
+
+void CollisionWorld::updateTriggers(Registry& registry) {
+    m_triggerContacts.beginFrame();
+    m_lastTriggerCandidates = 0;
+    auto* transforms = registry.findPool<Transform>();
+    auto* colliders = registry.findPool<Collider>();
+
+    auto test = [&](EntityID trigger, EntityID other) {
+        ++m_lastTriggerCandidates;
+        if (triggerOverlaps(registry, trigger, other)) m_triggerContacts.touch(trigger, other);
+    };
+
+    // 1. 靜態 trigger：layer 可能被它們收的動態物體（含睡著的）拿推開後的邊界查 m_triggerBvh；
+    //    掉落物再多，只要沒有人站在附近就一次形狀測試都不做
+    if (!m_staticTriggers.empty()) {
+        size_t pruned = 0;
+        for (const Body& body : m_dynamic) {
+            if ((body.filter.layer & m_staticTriggerMasks) == 0) continue;
+            Aabb bounds = colliderBounds(transforms->get(body.entity), colliders->get(body.entity), body.cosR, body.sinR);
+            m_triggerBvh.query(bounds, body.filter, pruned, [&](EntityID trigger) { test(trigger, body.entity); });
+        }
+    }
+
+    // 2. kinematic trigger：自己查所有 solid（動態 + 睡著 + 靜態）
+    for (const Trigger& trigger : m_movingTriggers) {
+        m_triggerCandidates.clear();
+        query(colliderBounds(transforms->get(trigger.entity), colliders->get(trigger.entity)), trigger.filter,
+              m_triggerCandidates);
+        for (EntityID other : m_triggerCandidates) test(trigger.entity, other);
+    }
+    m_triggerContacts.endFrame();
+}
+
+// trigger 和 solid 的形狀是否真的重疊（停用的 entity 不算）；AABB 當成 c = 1、s = 0 的 OBB
+bool CollisionWorld::triggerOverlaps(Registry& registry, EntityID trigger, EntityID other) const {
+    if (!registry.isEnabled(trigger) || !registry.isEnabled(other)) return false;
+    const Transform& ta = registry.getComponent<Transform>(trigger);
+    const Transform& tb = registry.getComponent<Transform>(other);
+    const Collider& ca = registry.getComponent<Collider>(trigger);
+    const Collider& cb = registry.getComponent<Collider>(other);
+    float ac = 1.0f, as = 0.0f, bc = 1.0f, bs = 0.0f;
+    if (ca.type == Collider::Type::OBB) {
+        ac = std::cos(ta.rotation);
+        as = std::sin(ta.rotation);
+    }
+    orientation(other, bc, bs);
+
+    float dx = 0.0f, dy = 0.0f, depth = 0.0f;
+    bool aCircle = ca.type == Collider::Type::Circle;
+    bool bCircle = cb.type == Collider::Type::Circle;
+    if (aCircle && bCircle) return circleVsCircle(ta.x, ta.y, ca.radius, tb.x, tb.y, cb.radius, dx, dy, depth);
+    if (aCircle) return circleVsObb(ta.x, ta.y, ca.radius, tb.x, tb.y, cb.halfW, cb.halfH, bc, bs, dx, dy, depth);
+    if (bCircle) return circleVsObb(tb.x, tb.y, cb.radius, ta.x, ta.y, ca.halfW, ca.halfH, ac, as, dx, dy, depth);
+    return obbVsObb(ta.x, ta.y, ca.halfW, ca.halfH, ac, as, tb.x, tb.y, cb.halfW, cb.halfH, bc, bs, dx, dy, depth);
+}
+
+} // namespace duck
@@ -0,0 +1,309 @@
+#pragma once
+#include "ecs/Registry.h"
+#include "ecs/Components.h"
+#include "physics/Aabb.h"
+#include "physics/BroadPhase.h"
+#include "physics/ContactCache.h"
+#include "physics/DistanceField.h"
+#include "physics/StaticBvh.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace duck {
+
+// Collider 在目前 Transform 下的緊密包圍盒；OBB 的 cos / sin 已經算好時用第二個版本
+inline Aabb colliderBounds(const Transform& tf, const Collider& col, float c, float s) {
+    if (col.type == Collider::Type::Circle) {
+        return makeAabb(tf.x, tf.y, col.radius, col.radius);
+    }
+    if (col.type == Collider::Type::OBB) {
+        return makeRotatedAabb(tf.x, tf.y, col.halfW, col.halfH, c, s);
+    }
+    return makeAabb(tf.x, tf.y, col.halfW, col.halfH);
+}
+
+inline Aabb colliderBounds(const Transform& tf, const Collider& col) {
+    if (col.type == Collider::Type::OBB) {
+        return colliderBounds(tf, col, std::cos(tf.rotation), std::sin(tf.rotation));
+    }
+    return colliderBounds(tf, col, 1.0f, 0.0f);
+}
+
+// 一條射線 / 線段查詢：從 (x, y) 走到 (x + dx, y + dy)；要「無限長」的射線就給夠長的位移
+struct RayCast {
+    float x = 0.0f;
+    float y = 0.0f;
+    float dx = 0.0f;
+    float dy = 0.0f;
+    // 只和 filter 相容的 collider 測試（視線：layer = 自己的層、mask = Obstacle）
+    CollisionFilter filter;
+    EntityID ignore = INVALID_ENTITY;     // 通常是發射者自己
+};
+
+// 第一個碰到的 collider；entity == INVALID_ENTITY 代表整段都沒碰到
+struct RayHit {
+    EntityID entity = INVALID_ENTITY;
+    float t = 1.0f;                       // 0 = 起點、1 = 終點
+    float distance = 0.0f;                // 起點到命中點的距離（像素）
+    float x = 0.0f;                       // 命中點
+    float y = 0.0f;
+    float nx = 0.0f;                      // 命中面的單位法向量（指向射線來的那一側）
+    float ny = 0.0f;
+
+    bool hit() const { return entity != INVALID_ENTITY; }
+};
+
+// ============================================================
+// CollisionWorld — 跨 tick 保留的碰撞世界（存在 Registry::context）
+// ============================================================
+// 管理所有 solid Collider 在 broad phase 裡的 proxy（trigger 另外管，見下方）：
+//   - 新 Collider：透過 Registry::onAdd<Collider> 排進 pending，下一次 sync() 才插入
+//     （那時 Transform / RigidBody 都已掛好，能正確分類）
+//   - 移除：透過 Registry::onRemove<Collider>，removeComponent / destroy / destroyMany
+//     當下就把 proxy 拿掉，不必每個 tick 掃描找出消失的 entity
+//   - 靜態（沒有 RigidBody）：放進獨立的 StaticBvh，地圖載入後建一次，永遠不會重插
+//   - 動態（有 RigidBody）：每個 tick 把新的緊密邊界交給 broad phase
+//   - 動態 vs 動態的空間結構在 BroadPhase 介面後面（預設四叉樹，可換成雜湊網格 / sap），
+//     broad phase 裡只有動態物體；動態 vs 靜態由每個動態物體查 StaticBvh 產生
+//
+// 休眠：動態物體連續 SLEEP_TICKS 個 tick 速度為 0、位移不超過 SLEEP_DISTANCE 就睡著，
+// 從 broad phase 搬進另一棵 StaticBvh（m_sleepingBvh），待遇和靜態物體一樣：
+//   - 睡著的物體之間、睡著 vs 靜態都不產生配對，只有醒著的物體會拿自己的邊界查它們
+//   - sync() 發現睡著的物體被移動（Transform 變了）或有了速度，就叫醒搬回 broad phase
+//   - 醒著的物體壓進來超過 WAKE_DEPTH 時，CollisionSystem 呼叫 wake()
+// 玩家（InputControlled）永遠不睡：接觸傷害要靠玩家那一方產生配對。
+//
+// 靜態距離場（預設關閉，setStaticFieldCellSize 打開）：mask = All 的靜態物體烘成一張 DistanceField，
+// 靜態物體增減後的下一次 sync() 重烘。醒著的動態圓形如果本來就會和場裡每一層相撞，
+// findPairs 就不再替它查這些靜態物體（fieldBodies() 列出這些物體），
+// 改由 CollisionSystem 取樣距離場一次、沿梯度推出牆外 —— 推開的結果相同，但不產生接觸事件。
+// 矩形、mask 挑過的物體和沒進場的靜態物體照舊走配對。
+//
+// Collider::layer / mask 在加入時讀一次，存成 CollisionFilter 交給 broad phase 與 StaticBvh，
+// 互相不碰的配對在產生配對時就被丟掉，不會進 narrow phase（也不會去查元件）。
+//
+// Trigger（isSolid = false 的 Collider）：不推開任何東西、不進配對，只產生重疊事件。
+//   - 靜態 trigger（沒有 RigidBody，例如地上的掉落物、撤離區）：放進另一棵 StaticBvh（m_triggerBvh），
+//     由 layer 可能碰到它們的動態物體（醒著或睡著）拿目前的邊界去查
+//   - kinematic trigger（有 RigidBody，跟著 Transform 移動）：每次反過來拿自己的邊界查 solid
+//   - trigger 之間、靜態 trigger vs 靜態 solid 都不產生事件
+// 候選再用 Collider 的形狀精確測試，重疊的記進 m_triggerContacts（另一份 ContactCache），
+// 得到 triggerEnters / triggerStays / triggerExits（a 是 trigger，b 是 solid）。
+// 成本跟著「會觸發的動態物體數 + 重疊數」走，和場上有幾個 trigger 無關。
+//
+// Collider::isSolid 也只在加入時分類；遊戲中途要改請呼叫 setSolid()，下一次 sync() 只把這些物體
+// 在 solid 和 trigger 之間搬家：敵人死掉（改成 false）後不再推開別人、也不再擋子彈，
+// 原本所在的 trigger 收到 Exit；改回 true 則反過來。
+//
+// 約定：沒有 RigidBody 的 Collider 視為永遠不動；
+// 需要移動的物體請掛 RigidBody（速度為 0 也可以）。
+//
+// 為什麼放在 Registry::context 而不是 CollisionSystem 成員？
+//   結構的生命週期和 entity 綁在一起：換一個 Registry（測試、重新載入地圖）
+//   就是一個全新的世界，不會殘留上一個場景的 proxy。
+class CollisionWorld {
+public:
+    CollisionWorld();
+    ~CollisionWorld();
+
+    // 換一種 broad phase：既有的 proxy 以目前的邊界搬到新結構，
+    // 遊戲中途切換也不會漏掉任何物體
+    void setBroadPhase(BroadPhaseType type);
+    BroadPhaseType broadPhaseType() const { return m_broadPhase->type(); }
+    // broad phase 的執行緒數（只有 lbvh 用得到）；之後換的 broad phase 也沿用
+    void setBroadPhaseThreadCount(unsigned threadCount);
+
+    // 每個 fixed tick 開頭呼叫：第一次會訂閱訊號並掃描既有的 Collider，
+    // 之後只處理 pending 的新 Collider 和動態物體的 fat bounds 檢查
+    void sync(Registry& registry);
+
+    // 產生候選配對（規則見 BroadPhase.h）：
+    //   動態 vs 靜態：由動態那方輸出一次
+    //   動態 vs 動態：只在 a < b 時輸出，不需要 hash set 去重
+    //   靜態 vs 靜態：永遠不會產生（兩邊都不動，推開也沒有意義）
+    // 先輸出動態 vs 動態（broad phase），再依 m_dynamic 順序輸出動態 vs 靜態（StaticBvh）
+    // layer / mask 不相容的配對不會輸出，數量見 lastPrunedPairs()
+    void findPairs(std::vector<BodyPair>& outPairs);
+    size_t lastPrunedPairs() const { return m_lastPruned; }
+    // 上一次 findPairs 中動態 vs 動態的結構統計（BroadPhaseStats），
+    // 以及動態 vs 靜態 / 睡著（StaticBvh）輸出的配對數
+    const BroadPhaseStats& lastBroadPhaseStats() const { return m_broadPhase->lastStats(); }
+    size_t lastStaticPairs() const { return m_lastStaticPairs; }
+    // 上一次 findPairs 中改用距離場處理靜態物體的動態物體（依 m_dynamic 順序）
+    const std::vector<EntityID>& fieldBodies() const { return m_fieldBodies; }
+
+    // 範圍查詢：邊界與 area 重疊的 solid entity（動態 + 睡著 + 靜態）寫進 out（不清空 out）
+    void query(const Aabb& area, std::vector<EntityID>& outEntities) {
+        m_broadPhase->query(area, outEntities);
+        m_sleepingBvh.query(area, outEntities);
+        m_staticBvh.query(area, outEntities);
+    }
+    // 同上，但只留下和 filter 相容的 entity（子彈用自己的 layer / mask 查）
+    void query(const Aabb& area, const CollisionFilter& filter, std::vector<EntityID>& outEntities);
+
+    // 一次處理一整批射線：outHits 調整成 rays.size()，第 i 格是第 i 條射線最早碰到的 collider
+    // （同一個 t 取 EntityID 小的，結果和走訪順序無關）。
+    //   - 靜態 / 睡著：沿著 StaticBvh 走，節點用 slab 測試，找到命中後更遠的子樹直接剔除
+    //   - 動態：只在 filter 可能碰到動態物體的層時，以線段的範圍查 broad phase
+    //   - 候選的精確測試用 Collider 的形狀（CollisionSystem.h 的 rayVsCircle / rayVsBox / rayVsObb）
+    // 呼叫前 world 必須 sync() 過（見 ensureSynced）；停用的 entity 不會被打到。
+    void raycast(Registry& registry, const std::vector<RayCast>& rays, std::vector<RayHit>& outHits);
+
+    // 重新計算 trigger 的重疊並產生事件；CollisionSystem 在推開之後呼叫（位置是這個 tick 最後的結果）。
+    // kinematic trigger 查 broad phase 時用的是這個 tick sync() 時的邊界，被推開的幾個像素下一個 tick 才反映
+    void updateTriggers(Registry& registry);
+    // 事件只保留到下一次 updateTriggers()；ends 可能包含已被 destroy 的 entity，消費端要檢查 alive
+    const std::vector<ContactEvent>& triggerEnters() const { return m_triggerContacts.begins(); }
+    const std::vector<ContactEvent>& triggerStays() const { return m_triggerContacts.stays(); }
+    const std::vector<ContactEvent>& triggerExits() const { return m_triggerContacts.ends(); }
+    bool inTrigger(EntityID trigger, EntityID other) const { return m_triggerContacts.touching(trigger, other); }
+    size_t triggerCount() const { return m_staticTriggers.size() + m_movingTriggers.size(); }
+    // 上一次 updateTriggers() 做了幾次形狀測試（候選數），以及目前仍在重疊的配對數
+    size_t lastTriggerCandidates() const { return m_lastTriggerCandidates; }
+    size_t triggerOverlapCount() const { return m_triggerContacts.contactCount(); }
+
+    // 還沒 sync 過才 sync（給在 CollisionSystem 之前跑、又要查 world 的系統，例如 EnemySystem 的視線）
+    void ensureSynced(Registry& registry) {
+        if (!m_attached) sync(registry);
+    }
+
+    // 休眠的門檻：連續幾個 tick、每 tick 位移最多幾個像素（而且速度為 0）
+    static constexpr std::uint16_t SLEEP_TICKS = 30;
+    static constexpr float SLEEP_DISTANCE = 0.05f;
+    // 醒著的物體壓進睡著的物體超過這個深度才叫醒它；更淺的重疊把睡著的一方當成靜態
+    static constexpr float WAKE_DEPTH = 0.05f;
+
+    // 關掉時立刻叫醒所有睡著的物體（預設開啟）
+    void setSleepingEnabled(bool enabled);
+    bool sleepingEnabled() const { return m_sleepingEnabled; }
+    // 只讀，narrow phase 的平行階段可以同時呼叫
+    bool isSleeping(EntityID entity) const {
+        std::uint32_t slot = m_slots.get(entity);
+        return slot != SparseIndex::NONE && (slot & STATIC_BIT) == 0 && m_dynamic[slot].asleep;
+    }
+    // OBB 目前的 rotation cos / sin（靜態物體加入時算一次，動態的每次 sync() 算一次）；
+    // 其他形狀和不在 world 裡的 entity 給 c = 1、s = 0。只讀，可以從多條執行緒同時呼叫
+    void orientation(EntityID entity, float& outC, float& outS) const {
+        outC = 1.0f;
+        outS = 0.0f;
+        std::uint32_t slot = m_slots.get(entity);
+        if (slot == SparseIndex::NONE) return;
+        const Body& body = (slot & STATIC_BIT) ? m_static[slot & ~STATIC_BIT] : m_dynamic[slot];
+        outC = body.cosR;
+        outS = body.sinR;
+    }
+    // 叫醒（沒睡著就什麼都不做）；下一次 sync() 起重新參與 broad phase
+    void wake(EntityID entity);
+    // 改 Collider::isSolid 並排進下一次 sync() 重新分類（solid ↔ trigger）；沒有 Collider 就什麼都不做
+    void setSolid(Registry& registry, EntityID entity, bool solid);
+    // 上一次 sync() 因為 setSolid 重新分類的物體數
+    size_t lastReclassifiedCount() const { return m_lastReclassified; }
+    size_t sleepingCount() const { return m_sleepingCount; }
+
+    // 靜態距離場的格子大小（像素）：越小越精確、記憶體越多；0 = 關閉（預設），全部走配對
+    void setStaticFieldCellSize(float cellSize);
+    float staticFieldCellSize() const { return m_fieldCellSize; }
+    const DistanceField& staticField() const { return m_field; }
+    // 沒有烘進距離場的靜態物體數（mask 不是 All、或烘焙時停用）
+    size_t staticFieldExcluded() const { return m_fieldExcluded; }
+
+    // 分類查詢（CollisionValidator 的 oracle 用）：靜態的 solid、烘進距離場的靜態
+    bool isStaticBody(EntityID entity) const {
+        std::uint32_t slot = m_slots.get(entity);
+        return slot != SparseIndex::NONE && (slot & STATIC_BIT) != 0;
+    }
+    bool inStaticField(EntityID entity) const {
+        return isStaticBody(entity) && m_static[m_slots.get(entity) & ~STATIC_BIT].inField;
+    }
+
+    size_t dynamicCount() const { return m_dynamic.size(); }
+    size_t staticCount() const { return m_static.size(); }
+    // 上一次 sync() 中 broad phase 結構真的被改動的動態物體數
+    size_t lastReinsertCount() const { return m_lastReinserts; }
+    const BroadPhase& broadPhase() const { return *m_broadPhase; }
+    const StaticBvh& staticBvh() const { return m_staticBvh; }
+
+private:
+    // 靜態物體的 proxy 是 StaticBvh::ItemID，動態的是 BroadPhase::ProxyID
+    struct Body {
+        EntityID entity = INVALID_ENTITY;
+        BroadPhase::ProxyID proxy = BroadPhase::NULL_PROXY;
+        Aabb tight;                       // 動態：上一次 sync() 的緊密邊界，拿來查 StaticBvh
+        CollisionFilter filter;
+        StaticBvh::ItemID sleepItem = StaticBvh::NULL_ITEM;   // 睡著時在 m_sleepingBvh 的位置
+        std::uint16_t stillTicks = 0;     // 連續幾個 tick 幾乎沒動
+        bool asleep = false;              // 睡著時 proxy 是 NULL_PROXY
+        bool circle = false;              // 動態：Collider 是圓（才能用距離場推開）
+        bool inField = false;             // 靜態：烘進了距離場
+        bool oriented = false;            // Collider 是 OBB：cosR / sinR 跟著 Transform::rotation
+        float cosR = 1.0f;
+        float sinR = 0.0f;
+    };
+
+    // Trigger 的 item 是 m_triggerBvh 的 ItemID（kinematic 的是 NULL_ITEM）
+    struct Trigger {
+        EntityID entity = INVALID_ENTITY;
+        StaticBvh::ItemID item = StaticBvh::NULL_ITEM;
+        CollisionFilter filter;
+    };
+
+    // m_slots 的值：低 31 bits 是 m_dynamic / m_static 的 index，最高位代表靜態
+    static constexpr std::uint32_t STATIC_BIT = 0x80000000u;
+
+    void attach(Registry& registry);
+    void addBody(Registry& registry, EntityID entity);
+    void removeBody(EntityID entity);
+    void reclassify(Registry& registry);
+    void addTrigger(EntityID entity, const Aabb& bounds, bool isStatic, CollisionFilter filter);
+    void removeTrigger(EntityID entity, std::uint32_t slot);
+    bool triggerOverlaps(Registry& registry, EntityID trigger, EntityID other) const;
+    void sleepBody(Body& body);
+    void wakeBody(Body& body, const Aabb& bounds);
+    void rebuildField(Registry& registry);
+    bool usesField(const Body& body) const {
+        return !m_field.empty() && body.circle && (body.filter.mask & m_fieldLayers) == m_fieldLayers;
+    }
+
+    bool m_attached = false;
+    std::unique_ptr<BroadPhase> m_broadPhase;
+    unsigned m_broadPhaseThreads = 1;
+    StaticBvh m_staticBvh;
+    StaticBvh m_sleepingBvh;
+    std::vector<Body> m_dynamic;
+    std::vector<Body> m_static;
+    SparseIndex m_slots;
+    std::vector<EntityID> m_pending;
+    std::vector<EntityID> m_reclassify;       // setSolid 排進來、下一次 sync() 重新分類
+    size_t m_lastReclassified = 0;
+    size_t m_lastReinserts = 0;
+    size_t m_lastPruned = 0;
+    size_t m_lastStaticPairs = 0;
+    size_t m_sleepingCount = 0;
+    bool m_sleepingEnabled = true;
+    // 所有加入過的動態物體的 layer 聯集（只增不減）：射線的 mask 碰不到就不查 broad phase
+    std::uint32_t m_dynamicLayers = 0;
+    std::vector<EntityID> m_rayCandidates;
+
+    // trigger：m_triggerSlots 的值和 m_slots 一樣，最高位代表靜態（m_staticTriggers）
+    StaticBvh m_triggerBvh;
+    std::vector<Trigger> m_staticTriggers;
+    std::vector<Trigger> m_movingTriggers;
+    SparseIndex m_triggerSlots;
+    // 所有加入過的靜態 trigger 的 mask 聯集（只增不減）：layer 碰不到的動態物體不查 m_triggerBvh
+    std::uint32_t m_staticTriggerMasks = 0;
+    ContactCache m_triggerContacts;
+    std::vector<EntityID> m_triggerCandidates;
+    size_t m_lastTriggerCandidates = 0;
+
+    DistanceField m_field;
+    float m_fieldCellSize = 0.0f;
+    bool m_fieldDirty = false;
+    std::uint32_t m_fieldLayers = 0;      // 場裡所有靜態物體的 layer 聯集
+    size_t m_fieldExcluded = 0;
+    std::vector<EntityID> m_fieldBodies;
+};
+
+} // namespace duck
@@ -0,0 +1,98 @@
+#include "physics/ContactCache.h"
+
+namespace duck {
+
+ContactCache::ContactCache() {
+    m_slots.resize(64);
+}
+
+// Fibonacci hashing：乘上 2^64 / 黃金比例，高位元分布均勻，再取低位當起點
+size_t ContactCache::probeStart(std::uint64_t key) const {
+    std::uint64_t h = key * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h ^ (h >> 32)) & (m_slots.size() - 1);
+}
+
+void ContactCache::rehash(size_t capacity) {
+    std::vector<Slot> old;
+    old.swap(m_slots);
+    m_slots.assign(capacity, Slot{});
+    m_tombstones = 0;
+
+    const size_t mask = capacity - 1;
+    for (const Slot& slot : old) {
+        if (slot.key == EMPTY || slot.key == TOMBSTONE) continue;
+        size_t i = probeStart(slot.key);
+        while (m_slots[i].key != EMPTY) i = (i + 1) & mask;
+        m_slots[i] = slot;
+    }
+}
+
+void ContactCache::beginFrame() {
+    ++m_frame;
+    m_begins.clear();
+    m_stays.clear();
+    m_ends.clear();
+}
+
+void ContactCache::touch(EntityID a, EntityID b) {
+    // 負載（含墓碑）超過 1/2：活的太多就加倍，不然只是清掉墓碑
+    if ((m_live + m_tombstones + 1) * 2 > m_slots.size()) {
+        rehash(m_live * 4 >= m_slots.size() ? m_slots.size() * 2 : m_slots.size());
+    }
+
+    const std::uint64_t key = makePairKey(a, b);
+    const size_t mask = m_slots.size() - 1;
+    size_t firstFree = m_slots.size();
+    size_t i = probeStart(key);
+    for (;; i = (i + 1) & mask) {
+        Slot& slot = m_slots[i];
+        if (slot.key == key) {
+            if (slot.frame + 1 == m_frame) {
+                m_stays.push_back({slot.a, slot.b});
+            } else {
+                m_begins.push_back({slot.a, slot.b});
+            }
+            slot.frame = m_frame;
+            return;
+        }
+        if (slot.key == TOMBSTONE) {
+            if (firstFree == m_slots.size()) firstFree = i;
+            continue;
+        }
+        if (slot.key == EMPTY) break;
+    }
+
+    // 新配對：優先填進路上遇到的第一個墓碑
+    if (firstFree == m_slots.size()) {
+        firstFree = i;
+    } else {
+        --m_tombstones;
+    }
+    m_slots[firstFree] = {key, a, b, m_frame};
+    ++m_live;
+    m_begins.push_back({a, b});
+}
+
+// 這個 tick 沒被 touch 到的配對 → End，留下墓碑
+void ContactCache::endFrame() {
+    for (Slot& slot : m_slots) {
+        if (slot.key == EMPTY || slot.key == TOMBSTONE) continue;
+        if (slot.frame == m_frame) continue;
+        m_ends.push_back({slot.a, slot.b});
+        slot.key = TOMBSTONE;
+        --m_live;
+        ++m_tombstones;
+    }
+}
+
+bool ContactCache::touching(EntityID a, EntityID b) const {
+    const std::uint64_t key = makePairKey(a, b);
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = probeStart(key);; i = (i + 1) & mask) {
+        const Slot& slot = m_slots[i];
+        if (slot.key == key) return true;
+        if (slot.key == EMPTY) return false;
+    }
+}
+
+} // namespace duck
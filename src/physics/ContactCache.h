@@ -0,0 +1,77 @@
+#pragma once
+#include "ecs/Entity.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+// 一對 entity 的 64-bit key：小的放高位，(a, b) 和 (b, a) 得到同一個 key
+inline std::uint64_t makePairKey(EntityID a, EntityID b) {
+    EntityID lo = a < b ? a : b;
+    EntityID hi = a < b ? b : a;
+    return (static_cast<std::uint64_t>(lo) << 32) | hi;
+}
+
+// 接觸事件：a、b 的順序沿用 broad phase 第一次給出的順序（動態在前 / 動態 vs 動態 a < b）
+struct ContactEvent {
+    EntityID a = INVALID_ENTITY;
+    EntityID b = INVALID_ENTITY;
+};
+
+// ============================================================
+// ContactCache — 跨 tick 保留的接觸配對表（存在 Registry::context）
+// ============================================================
+// 每個 tick：
+//   beginFrame() → narrow phase 對每一對真的重疊的呼叫 touch(a, b) → endFrame()
+// 得到三條事件流：
+//   begins()：這個 tick 才開始接觸
+//   stays() ：上個 tick 就在接觸、這個 tick 仍然接觸
+//   ends()  ：上個 tick 在接觸、這個 tick 沒有（包含其中一方已被 destroy，消費端要檢查 alive）
+//
+// 雜湊表是開放定址（linear probing），容量 2 的冪次、負載 ≤ 1/2：
+//   - 每一格直接存 key、a、b 和「最後一次接觸的 frame 編號」，沒有任何 per-pair 配置
+//   - 判斷 Begin / Stay 只看 frame 編號是不是上一個 tick，不需要每 tick 清表
+//   - 結束的配對留下墓碑（TOMBSTONE），墓碑太多時整張表重新雜湊一次
+class ContactCache {
+public:
+    ContactCache();
+
+    void beginFrame();
+    // 同一個 tick 內同一對只能呼叫一次（broad phase 保證配對不重複）
+    void touch(EntityID a, EntityID b);
+    void endFrame();
+
+    const std::vector<ContactEvent>& begins() const { return m_begins; }
+    const std::vector<ContactEvent>& stays() const { return m_stays; }
+    const std::vector<ContactEvent>& ends() const { return m_ends; }
+
+    bool touching(EntityID a, EntityID b) const;
+    size_t contactCount() const { return m_live; }
+    size_t capacity() const { return m_slots.size(); }
+
+private:
+    static constexpr std::uint64_t EMPTY = ~0ull;
+    static constexpr std::uint64_t TOMBSTONE = ~0ull - 1;
+
+    struct Slot {
+        std::uint64_t key = EMPTY;
+        EntityID a = INVALID_ENTITY;
+        EntityID b = INVALID_ENTITY;
+        std::uint32_t frame = 0;          // 最後一次 touch 的 frame 編號
+    };
+
+    size_t probeStart(std::uint64_t key) const;
+    void rehash(size_t capacity);
+
+    std::vector<Slot> m_slots;
+    size_t m_live = 0;
+    size_t m_tombstones = 0;
+    std::uint32_t m_frame = 1;
+
+    std::vector<ContactEvent> m_begins;
+    std::vector<ContactEvent> m_stays;
+    std::vector<ContactEvent> m_ends;
+};
+
+} // namespace duck
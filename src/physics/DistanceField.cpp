@@ -0,0 +1,241 @@
+#include "physics/DistanceField.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace duck {
+
+// 精確距離直接算的範圍：形狀邊界外幾格（再遠的交給 sweeping）
+static constexpr float EXACT_BAND_CELLS = 2.0f;
+// march 最多走幾步；每步至少前進 1/8 格，擦過牆邊時不會原地打轉
+static constexpr int MAX_MARCH_STEPS = 256;
+static constexpr float MIN_MARCH_STEP_CELLS = 0.125f;
+
+// 有號距離 + 最近的表面點
+static float signedDistance(const DistanceFieldShape& shape, float px, float py, float& outNearX, float& outNearY) {
+    float dx = px - shape.x;
+    float dy = py - shape.y;
+    if (shape.isCircle) {
+        float len = std::sqrt(dx * dx + dy * dy);
+        if (len == 0.0f) {
+            outNearX = shape.x + shape.halfW;
+            outNearY = shape.y;
+            return -shape.halfW;
+        }
+        outNearX = shape.x + dx / len * shape.halfW;
+        outNearY = shape.y + dy / len * shape.halfW;
+        return len - shape.halfW;
+    }
+
+    // 矩形：轉進局部座標算，最近點再轉回世界座標
+    const float c = shape.cosR;
+    const float s = shape.sinR;
+    float lx = c * dx + s * dy;
+    float ly = c * dy - s * dx;
+    float qx = std::abs(lx) - shape.halfW;
+    float qy = std::abs(ly) - shape.halfH;
+    float nearLx = 0.0f, nearLy = 0.0f, d = 0.0f;
+    if (qx > 0.0f || qy > 0.0f) {
+        nearLx = std::clamp(lx, -shape.halfW, shape.halfW);
+        nearLy = std::clamp(ly, -shape.halfH, shape.halfH);
+        float ox = std::max(qx, 0.0f);
+        float oy = std::max(qy, 0.0f);
+        d = std::sqrt(ox * ox + oy * oy);
+    } else if (qx > qy) {
+        // 在矩形裡：最近的是離得最近的那一面
+        nearLx = lx < 0.0f ? -shape.halfW : shape.halfW;
+        nearLy = ly;
+        d = qx;
+    } else {
+        nearLx = lx;
+        nearLy = ly < 0.0f ? -shape.halfH : shape.halfH;
+        d = qy;
+    }
+    outNearX = shape.x + (c * nearLx - s * nearLy);
+    outNearY = shape.y + (s * nearLx + c * nearLy);
+    return d;
+}
+
+static Aabb shapeBounds(const DistanceFieldShape& shape) {
+    if (shape.isCircle) return makeAabb(shape.x, shape.y, shape.halfW, shape.halfW);
+    return makeRotatedAabb(shape.x, shape.y, shape.halfW, shape.halfH, shape.cosR, shape.sinR);
+}
+
+float exactSignedDistance(const DistanceFieldShape& shape, float px, float py) {
+    float nearX = 0.0f, nearY = 0.0f;
+    return signedDistance(shape, px, py, nearX, nearY);
+}
+
+void DistanceField::clear() {
+    m_dist.clear();
+    m_columns = 0;
+    m_rows = 0;
+    m_bounds = Aabb{};
+}
+
+void DistanceField::build(const std::vector<DistanceFieldShape>& shapes, float cellSize, float margin) {
+    clear();
+    m_cellSize = cellSize > 0.0f ? cellSize : DEFAULT_CELL_SIZE;
+    m_margin = std::max(margin, 0.0f);
+    if (shapes.empty()) return;
+
+    Aabb area;
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        Aabb b = shapeBounds(shapes[i]);
+        area = i == 0 ? b : aabbUnion(area, b);
+    }
+    area = aabbInflate(area, m_margin);
+
+    // 至少 2 × 2 個節點才能內插；太多就放大格子
+    for (;;) {
+        m_columns = std::max(2, static_cast<int>(std::ceil((area.maxX - area.minX) / m_cellSize)) + 1);
+        m_rows = std::max(2, static_cast<int>(std::ceil((area.maxY - area.minY) / m_cellSize)) + 1);
+        if (static_cast<size_t>(m_columns) * static_cast<size_t>(m_rows) <= MAX_NODES) break;
+        m_cellSize *= 2.0f;
+    }
+    m_bounds = {area.minX, area.minY, area.minX + static_cast<float>(m_columns - 1) * m_cellSize,
+                area.minY + static_cast<float>(m_rows - 1) * m_cellSize};
+
+    const size_t nodeCount = static_cast<size_t>(m_columns) * static_cast<size_t>(m_rows);
+    m_dist.assign(nodeCount, std::numeric_limits<float>::infinity());
+    m_nearX.assign(nodeCount, 0.0f);
+    m_nearY.assign(nodeCount, 0.0f);
+    m_hasNearest.assign(nodeCount, 0);
+
+    // 1. 種子：每個形狀附近的節點算精確距離（多個形狀取最小）
+    const float band = EXACT_BAND_CELLS * m_cellSize;
+    for (const DistanceFieldShape& shape : shapes) {
+        Aabb near = aabbInflate(shapeBounds(shape), band);
+        int cx0 = std::max(0, static_cast<int>(std::ceil((near.minX - m_bounds.minX) / m_cellSize)));
+        int cy0 = std::max(0, static_cast<int>(std::ceil((near.minY - m_bounds.minY) / m_cellSize)));
+        int cx1 = std::min(m_columns - 1, static_cast<int>(std::floor((near.maxX - m_bounds.minX) / m_cellSize)));
+        int cy1 = std::min(m_rows - 1, static_cast<int>(std::floor((near.maxY - m_bounds.minY) / m_cellSize)));
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            float py = m_bounds.minY + static_cast<float>(cy) * m_cellSize;
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                float px = m_bounds.minX + static_cast<float>(cx) * m_cellSize;
+                float nearX = 0.0f, nearY = 0.0f;
+                float d = signedDistance(shape, px, py, nearX, nearY);
+                size_t i = nodeIndex(cx, cy);
+                if (d >= m_dist[i]) continue;
+                m_dist[i] = d;
+                m_nearX[i] = nearX;
+                m_nearY[i] = nearY;
+                m_hasNearest[i] = 1;
+            }
+        }
+    }
+
+    // 2. fast sweeping：四個對角方向各一遍
+    sweep(1, 1);
+    sweep(-1, 1);
+    sweep(1, -1);
+    sweep(-1, -1);
+
+    // 最近點只在烘焙時用得到
+    std::vector<float>().swap(m_nearX);
+    std::vector<float>().swap(m_nearY);
+    std::vector<unsigned char>().swap(m_hasNearest);
+}
+
+// 沿 (stepX, stepY) 的順序走過所有節點，從「已經走過」的四個鄰居接手最近的表面點；
+// 裡面的節點都在種子範圍內（距離 ≤ 0 已經是精確值），只更新外面的
+void DistanceField::sweep(int stepX, int stepY) {
+    const int x0 = stepX > 0 ? 0 : m_columns - 1;
+    const int y0 = stepY > 0 ? 0 : m_rows - 1;
+    const int xEnd = stepX > 0 ? m_columns : -1;
+    const int yEnd = stepY > 0 ? m_rows : -1;
+    const int offsets[4][2] = {{-stepX, 0}, {0, -stepY}, {-stepX, -stepY}, {stepX, -stepY}};
+
+    for (int cy = y0; cy != yEnd; cy += stepY) {
+        float py = m_bounds.minY + static_cast<float>(cy) * m_cellSize;
+        for (int cx = x0; cx != xEnd; cx += stepX) {
+            size_t i = nodeIndex(cx, cy);
+            if (m_dist[i] <= 0.0f) continue;
+            float px = m_bounds.minX + static_cast<float>(cx) * m_cellSize;
+            for (const auto& offset : offsets) {
+                int nx = cx + offset[0];
+                int ny = cy + offset[1];
+                if (nx < 0 || ny < 0 || nx >= m_columns || ny >= m_rows) continue;
+                size_t n = nodeIndex(nx, ny);
+                if (!m_hasNearest[n]) continue;
+                float ex = px - m_nearX[n];
+                float ey = py - m_nearY[n];
+                float d = std::sqrt(ex * ex + ey * ey);
+                if (d >= m_dist[i]) continue;
+                m_dist[i] = d;
+                m_nearX[i] = m_nearX[n];
+                m_nearY[i] = m_nearY[n];
+                m_hasNearest[i] = 1;
+            }
+        }
+    }
+}
+
+float DistanceField::sample(float x, float y, float& outGx, float& outGy) const {
+    outGx = 0.0f;
+    outGy = 0.0f;
+    if (m_dist.empty()) return std::numeric_limits<float>::max();
+
+    // 網格外：離所有形狀至少 margin，梯度指向遠離網格
+    float clampX = std::clamp(x, m_bounds.minX, m_bounds.maxX);
+    float clampY = std::clamp(y, m_bounds.minY, m_bounds.maxY);
+    if (clampX != x || clampY != y) {
+        float ox = x - clampX;
+        float oy = y - clampY;
+        float len = std::sqrt(ox * ox + oy * oy);
+        outGx = ox / len;
+        outGy = oy / len;
+        return m_margin + len;
+    }
+
+    float fx = (x - m_bounds.minX) / m_cellSize;
+    float fy = (y - m_bounds.minY) / m_cellSize;
+    int cx = std::min(static_cast<int>(fx), m_columns - 2);
+    int cy = std::min(static_cast<int>(fy), m_rows - 2);
+    float tx = fx - static_cast<float>(cx);
+    float ty = fy - static_cast<float>(cy);
+
+    size_t i = nodeIndex(cx, cy);
+    float d00 = m_dist[i];
+    float d10 = m_dist[i + 1];
+    float d01 = m_dist[i + static_cast<size_t>(m_columns)];
+    float d11 = m_dist[i + static_cast<size_t>(m_columns) + 1];
+
+    float bottom = d00 + (d10 - d00) * tx;
+    float top = d01 + (d11 - d01) * tx;
+    outGx = ((d10 - d00) * (1.0f - ty) + (d11 - d01) * ty) / m_cellSize;
+    outGy = (top - bottom) / m_cellSize;
+    return bottom + (top - bottom) * ty;
+}
+
+float DistanceField::distance(float x, float y) const {
+    float gx = 0.0f, gy = 0.0f;
+    return sample(x, y, gx, gy);
+}
+
+bool DistanceField::march(float x, float y, float dx, float dy, float radius, float& outT) const {
+    outT = 0.0f;
+    if (m_dist.empty()) return false;
+    float len = std::sqrt(dx * dx + dy * dy);
+    if (len == 0.0f) return distance(x, y) <= radius;
+
+    const float minStep = MIN_MARCH_STEP_CELLS * m_cellSize / len;
+    float t = 0.0f;
+    for (int step = 0; step < MAX_MARCH_STEPS && t <= 1.0f; ++step) {
+        float d = distance(x + dx * t, y + dy * t) - radius;
+        if (d <= 0.0f) {
+            outT = t;
+            return true;
+        }
+        t += std::max(d / len, minStep);
+    }
+    // 最後一步可能跨過終點：終點本身也要檢查
+    if (t > 1.0f && distance(x + dx, y + dy) <= radius) {
+        outT = 1.0f;
+        return true;
+    }
+    return false;
+}
+
+} // namespace duck
@@ -0,0 +1,86 @@
+#pragma once
+#include "physics/Aabb.h"
+#include <cstddef>
+#include <vector>
+
+namespace duck {
+
+// 烘進距離場的一個靜態形狀：圓用 halfW 當半徑；矩形可以旋轉（rotation 的 cos / sin，AABB 是 1 / 0）
+struct DistanceFieldShape {
+    float x = 0.0f;
+    float y = 0.0f;
+    float halfW = 0.0f;
+    float halfH = 0.0f;
+    bool isCircle = false;
+    float cosR = 1.0f;
+    float sinR = 0.0f;
+};
+
+// 單一形狀的精確有號距離（外面為正、裡面為負），也是測試拿來比對的標準答案
+float exactSignedDistance(const DistanceFieldShape& shape, float px, float py);
+
+// ============================================================
+// DistanceField — 靜態幾何的 2D 有號距離場（SDF）
+// ============================================================
+// 地圖載入（靜態物體改變）時烘一次，之後只有讀：
+//   - 網格節點蓋住所有形狀的聯集再往外 margin 像素，節點間距 = cellSize
+//   - 每個形狀附近（邊界外 2 格以內）的節點直接算精確距離，並記下最近的表面點
+//   - 其餘節點用 fast sweeping：四個方向各掃一遍，從已知鄰居接手「最近的表面點」
+//     再重算真正的歐氏距離（不是把鄰居的距離加一格），所以誤差不會隨距離累積
+//   - 好幾個形狀重疊時取最小值（聯集的距離）；節點只存距離，最近點是烘焙時的暫存
+//
+// 取樣用雙線性內插，梯度是內插函式的解析導數：牆面附近距離是線性的，內插完全精確，
+// 只有角落附近（距離是圓弧）會有和 cellSize 成正比的誤差 —— cellSize 就是精確度的旋鈕。
+// 網格外的點離所有形狀至少 margin，回傳「margin + 到網格的距離」當下界。
+//
+// 查詢都是 const、不碰暫存，可以從多條執行緒同時呼叫。
+class DistanceField {
+public:
+    static constexpr float DEFAULT_CELL_SIZE = 4.0f;
+    static constexpr float DEFAULT_MARGIN = 64.0f;
+    // 節點數上限：超過就自動把格子放大（和 SpatialIndex 的格子預算同一個想法）
+    static constexpr size_t MAX_NODES = size_t(1) << 22;
+
+    void build(const std::vector<DistanceFieldShape>& shapes, float cellSize = DEFAULT_CELL_SIZE,
+               float margin = DEFAULT_MARGIN);
+    void clear();
+    bool empty() const { return m_dist.empty(); }
+
+    // (x, y) 到最近靜態表面的有號距離（雙線性內插）
+    float distance(float x, float y) const;
+    // 同上，並給出距離的梯度（沒有正規化；表面附近長度約為 1，指向遠離表面的方向）
+    float sample(float x, float y, float& outGx, float& outGy) const;
+
+    // 半徑 radius 的圓從 (x, y) 沿 (dx, dy) 前進（sphere tracing：每步走「目前的距離」那麼遠），
+    // 第一次距離 ≤ radius 的位置寫進 outT（0 = 起點、1 = 終點）；整段都沒碰到回傳 false。
+    // 只知道「撞到牆」不知道撞到哪一個：需要 entity 時用 CollisionWorld::raycast
+    bool march(float x, float y, float dx, float dy, float radius, float& outT) const;
+
+    float cellSize() const { return m_cellSize; }
+    int columns() const { return m_columns; }
+    int rows() const { return m_rows; }
+    size_t nodeCount() const { return m_dist.size(); }
+    // 網格涵蓋的範圍（節點 (0, 0) 在 minX, minY）
+    const Aabb& bounds() const { return m_bounds; }
+
+private:
+    size_t nodeIndex(int cx, int cy) const {
+        return static_cast<size_t>(cy) * static_cast<size_t>(m_columns) + static_cast<size_t>(cx);
+    }
+    // 四個方向的 fast sweeping 之一：stepX / stepY = ±1
+    void sweep(int stepX, int stepY);
+
+    Aabb m_bounds;
+    float m_cellSize = DEFAULT_CELL_SIZE;
+    float m_margin = DEFAULT_MARGIN;
+    int m_columns = 0;
+    int m_rows = 0;
+    std::vector<float> m_dist;
+
+    // 烘焙時的暫存：每個節點目前最近的表面點（沒有的話 m_hasNearest = 0）
+    std::vector<float> m_nearX;
+    std::vector<float> m_nearY;
+    std::vector<unsigned char> m_hasNearest;
+};
+
+} // namespace duck
@@ -0,0 +1,401 @@
+#include "physics/LinearBvh.h"
+#include <algorithm>
+#include <cmath>
+
+namespace duck {
+
+namespace {
+
+constexpr std::uint32_t NO_PARENT = ~0u;
+constexpr std::uint64_t DEAD_KEY = ~std::uint64_t(0);
+// key 不重複、只有 64 bits，樹最多 64 層；深度優先每層最多多壓一個，堆疊不會超過 65
+constexpr size_t STACK_SIZE = 128;
+
+// 16 bits 攤開成偶數位：abcd → 0a0b0c0d
+std::uint32_t spreadBits(std::uint32_t v) {
+    v &= 0xFFFFu;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+int countLeadingZeros(std::uint64_t v) {
+    return v == 0 ? 64 : __builtin_clzll(v);
+}
+
+} // namespace
+
+LinearBvh::ProxyID LinearBvh::insert(EntityID entity, const Aabb& bounds, bool isStatic, CollisionFilter filter) {
+    ProxyID id;
+    if (!m_freeProxies.empty()) {
+        id = m_freeProxies.back();
+        m_freeProxies.pop_back();
+    } else {
+        id = static_cast<ProxyID>(m_proxies.size());
+        m_proxies.emplace_back();
+    }
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    p.bounds = bounds;
+    p.entity = entity;
+    p.filter = filter;
+    p.isStatic = isStatic;
+    ++m_proxyCount;
+    m_dirty = true;
+    return id;
+}
+
+void LinearBvh::remove(ProxyID id) {
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    p.entity = INVALID_ENTITY;
+    m_freeProxies.push_back(id);
+    --m_proxyCount;
+    m_dirty = true;
+}
+
+bool LinearBvh::update(ProxyID id, const Aabb& bounds) {
+    m_proxies[static_cast<size_t>(id)].bounds = bounds;
+    m_dirty = true;
+    return false;
+}
+
+Aabb LinearBvh::bounds(ProxyID id) const {
+    return m_proxies[static_cast<size_t>(id)].bounds;
+}
+
+void LinearBvh::build() {
+    if (!m_dirty) return;
+    m_dirty = false;
+    ++m_builds;
+
+    const size_t slots = m_proxies.size();
+    const size_t n = m_proxyCount;
+    m_leaves.resize(n);
+    m_nodes.clear();
+    if (n == 0) return;
+
+    // 1. 所有中心的範圍：每塊各算一份，再循序合併
+    const size_t chunks = (slots + BUILD_GRAIN - 1) / BUILD_GRAIN;
+    m_chunkBounds.assign(chunks, Aabb{});
+    std::vector<unsigned char> chunkAny(chunks, 0);
+    m_workers.parallelFor(slots, BUILD_GRAIN, [&](size_t begin, size_t end) {
+        const size_t chunk = begin / BUILD_GRAIN;
+        Aabb area;
+        bool any = false;
+        for (size_t i = begin; i < end; ++i) {
+            const Proxy& p = m_proxies[i];
+            if (p.entity == INVALID_ENTITY) continue;
+            float cx = (p.bounds.minX + p.bounds.maxX) * 0.5f;
+            float cy = (p.bounds.minY + p.bounds.maxY) * 0.5f;
+            Aabb point{cx, cy, cx, cy};
+            area = any ? aabbUnion(area, point) : point;
+            any = true;
+        }
+        m_chunkBounds[chunk] = area;
+        chunkAny[chunk] = any ? 1 : 0;
+    });
+    Aabb centers;
+    bool any = false;
+    for (size_t c = 0; c < chunks; ++c) {
+        if (!chunkAny[c]) continue;
+        centers = any ? aabbUnion(centers, m_chunkBounds[c]) : m_chunkBounds[c];
+        any = true;
+    }
+
+    // 2. Morton code：x 最多量化到 0xFFFE，活的 key 永遠不會是全 1，
+    //    空的 slot 給 DEAD_KEY，排序後自然全部落在最後面
+    const float spanX = centers.maxX - centers.minX;
+    const float spanY = centers.maxY - centers.minY;
+    const float scaleX = spanX > 0.0f ? 65534.0f / spanX : 0.0f;
+    const float scaleY = spanY > 0.0f ? 65535.0f / spanY : 0.0f;
+    m_keys.resize(slots);
+    m_workers.parallelFor(slots, BUILD_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Proxy& p = m_proxies[i];
+            if (p.entity == INVALID_ENTITY) {
+                m_keys[i] = DEAD_KEY;
+                continue;
+            }
+            float cx = (p.bounds.minX + p.bounds.maxX) * 0.5f;
+            float cy = (p.bounds.minY + p.bounds.maxY) * 0.5f;
+            auto qx = static_cast<std::uint32_t>(std::min((cx - centers.minX) * scaleX, 65534.0f));
+            auto qy = static_cast<std::uint32_t>(std::min((cy - centers.minY) * scaleY, 65535.0f));
+            std::uint64_t code = spreadBits(qx) | (spreadBits(qy) << 1);
+            m_keys[i] = (code << 32) | static_cast<std::uint64_t>(i);
+        }
+    });
+
+    sortKeys();
+
+    // 排好的前 n 個 key 就是活的 proxy
+    m_workers.parallelFor(n, BUILD_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Proxy& p = m_proxies[static_cast<size_t>(m_keys[i] & 0xFFFFFFFFu)];
+            Leaf& leaf = m_leaves[i];
+            leaf.bounds = p.bounds;
+            leaf.entity = p.entity;
+            leaf.filter = p.filter;
+            leaf.isStatic = p.isStatic;
+        }
+    });
+
+    if (n == 1) return;   // 根就是唯一的葉
+    buildNodes();
+    refit();
+}
+
+// LSD 基數排序，只排 key 的高 32 bits（Morton code）：
+// 低 32 bits 是 proxy 編號，輸入本來就依它遞增，穩定排序保留這個順序
+void LinearBvh::sortKeys() {
+    const size_t count = m_keys.size();
+    const size_t chunks = (count + BUILD_GRAIN - 1) / BUILD_GRAIN;
+    m_sortBuffer.resize(count);
+    m_histogram.resize(chunks * 256);
+
+    for (int pass = 0; pass < 4; ++pass) {
+        const int shift = 32 + pass * 8;
+        std::fill(m_histogram.begin(), m_histogram.end(), 0u);
+        m_workers.parallelFor(count, BUILD_GRAIN, [&](size_t begin, size_t end) {
+            std::uint32_t* hist = &m_histogram[(begin / BUILD_GRAIN) * 256];
+            for (size_t i = begin; i < end; ++i) ++hist[(m_keys[i] >> shift) & 0xFFu];
+        });
+
+        // 每個 digit 的起點：先排 digit、同一個 digit 裡再依塊的順序
+        std::uint32_t offset = 0;
+        bool single = false;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            std::uint32_t total = 0;
+            for (size_t c = 0; c < chunks; ++c) {
+                std::uint32_t& h = m_histogram[c * 256 + digit];
+                std::uint32_t countHere = h;
+                h = offset + total;
+                total += countHere;
+            }
+            if (total == count) single = true;
+            offset += total;
+        }
+        // 全部落在同一個 digit（例如物體都擠在一小塊）：這一輪不用搬
+        if (single) continue;
+
+        m_workers.parallelFor(count, BUILD_GRAIN, [&](size_t begin, size_t end) {
+            std::uint32_t* next = &m_histogram[(begin / BUILD_GRAIN) * 256];
+            for (size_t i = begin; i < end; ++i) {
+                std::uint64_t key = m_keys[i];
+                m_sortBuffer[next[(key >> shift) & 0xFFu]++] = key;
+            }
+        });
+        m_keys.swap(m_sortBuffer);
+    }
+}
+
+// Karras 2012：內部節點 i 的一端一定是葉 i，從相鄰 key 的共同前綴長度判斷往哪邊延伸，
+// 倍增找出範圍上界、二分搜尋另一端 j，再二分搜尋共同前綴開始不同的切點 gamma
+void LinearBvh::buildNodes() {
+    const auto n = static_cast<std::int64_t>(m_leaves.size());
+    m_nodes.resize(static_cast<size_t>(n - 1));
+    m_leafParent.resize(static_cast<size_t>(n));
+    m_nodeParent.resize(static_cast<size_t>(n - 1));
+    m_nodeParent[0] = NO_PARENT;
+
+    const std::uint64_t* keys = m_keys.data();
+    auto delta = [keys, n](std::int64_t i, std::int64_t j) -> int {
+        if (j < 0 || j >= n) return -1;
+        return countLeadingZeros(keys[i] ^ keys[j]);   // key 含 proxy 編號，不會重複
+    };
+
+    m_workers.parallelFor(static_cast<size_t>(n - 1), BUILD_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t node = begin; node < end; ++node) {
+            const auto i = static_cast<std::int64_t>(node);
+            const std::int64_t d = delta(i, i + 1) - delta(i, i - 1) >= 0 ? 1 : -1;
+
+            const int minPrefix = delta(i, i - d);
+            std::int64_t lmax = 2;
+            while (delta(i, i + lmax * d) > minPrefix) lmax *= 2;
+            std::int64_t l = 0;
+            for (std::int64_t t = lmax / 2; t >= 1; t /= 2) {
+                if (delta(i, i + (l + t) * d) > minPrefix) l += t;
+            }
+            const std::int64_t j = i + l * d;
+
+            const int nodePrefix = delta(i, j);
+            std::int64_t s = 0;
+            std::int64_t t = l;
+            do {
+                t = (t + 1) >> 1;
+                if (delta(i, i + (s + t) * d) > nodePrefix) s += t;
+            } while (t > 1);
+            const std::int64_t gamma = i + s * d + std::min<std::int64_t>(d, 0);
+
+            Node& out = m_nodes[node];
+            const auto g = static_cast<std::uint32_t>(gamma);
+            if (std::min(i, j) == gamma) {
+                out.left = g | LEAF_BIT;
+                m_leafParent[g] = static_cast<std::uint32_t>(node);
+            } else {
+                out.left = g;
+                m_nodeParent[g] = static_cast<std::uint32_t>(node);
+            }
+            if (std::max(i, j) == gamma + 1) {
+                out.right = (g + 1) | LEAF_BIT;
+                m_leafParent[g + 1] = static_cast<std::uint32_t>(node);
+            } else {
+                out.right = g + 1;
+                m_nodeParent[g + 1] = static_cast<std::uint32_t>(node);
+            }
+            out.count = static_cast<std::uint32_t>(std::abs(j - i) + 1);
+        }
+    });
+}
+
+// 每個葉往上走；每個節點第二個抵達的子節點（兩邊的邊界都算好了）才合併並繼續往上
+void LinearBvh::refit() {
+    const size_t n = m_leaves.size();
+    const size_t nodes = n - 1;
+    if (m_arrivalCapacity < nodes) {
+        m_arrivals = std::make_unique<std::atomic<std::uint32_t>[]>(nodes);
+        m_arrivalCapacity = nodes;
+    }
+    m_workers.parallelFor(nodes, BUILD_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) m_arrivals[i].store(0, std::memory_order_relaxed);
+    });
+
+    auto childStatics = [this](std::uint32_t child) -> std::uint32_t {
+        if (child & LEAF_BIT) return m_leaves[child & ~LEAF_BIT].isStatic ? 1u : 0u;
+        return m_nodes[child].statics;
+    };
+
+    m_workers.parallelFor(n, BUILD_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t leaf = begin; leaf < end; ++leaf) {
+            std::uint32_t node = m_leafParent[leaf];
+            while (node != NO_PARENT) {
+                // acq_rel：先抵達的那方寫的邊界，對後抵達的這方可見
+                if (m_arrivals[node].fetch_add(1, std::memory_order_acq_rel) == 0) break;
+                Node& out = m_nodes[node];
+                out.bounds = aabbUnion(childBounds(out.left), childBounds(out.right));
+                out.statics = childStatics(out.left) + childStatics(out.right);
+                node = m_nodeParent[node];
+            }
+        }
+    });
+}
+
+// 兩個葉測一次；配對規則（動態在前、動態 vs 動態 a < b）在這裡決定
+void LinearBvh::testLeaves(std::uint32_t x, std::uint32_t y, BroadPhaseStats& stats,
+                           std::vector<BodyPair>& outPairs) const {
+    const Leaf& lx = m_leaves[x];
+    const Leaf& ly = m_leaves[y];
+    if (lx.isStatic && ly.isStatic) return;
+    ++stats.aabbTests;
+    if (!aabbOverlap(lx.bounds, ly.bounds)) return;
+    const bool xFirst = ly.isStatic || (!lx.isStatic && lx.entity < ly.entity);
+    const Leaf& a = xFirst ? lx : ly;
+    const Leaf& b = xFirst ? ly : lx;
+    // 和 BroadPhase::emitPair 相同，只是計數寫進呼叫端給的統計（平行時每塊一份）
+    ++stats.candidatePairs;
+    if (filtersAccept(a.filter, b.filter)) {
+        outPairs.push_back({a.entity, b.entity});
+        ++stats.pairs;
+    } else {
+        ++stats.prunedPairs;
+    }
+}
+
+// 走一步：自我碰撞（a == b，一定是內部節點）拆成兩個子節點之間 + 兩個子節點各自；
+// 兩邊之間的工作：都是葉就直接測，否則邊界重疊時拆開涵蓋葉比較多的那一邊
+void LinearBvh::visit(Task task, BroadPhaseStats& stats, std::vector<Task>& next,
+                      std::vector<BodyPair>& outPairs) const {
+    if (task.a == task.b) {
+        ++stats.nodesVisited;
+        const Node& node = m_nodes[task.a];
+        if (node.statics == node.count) return;
+        next.push_back({node.left, node.right});
+        if (!(node.left & LEAF_BIT)) next.push_back({node.left, node.left});
+        if (!(node.right & LEAF_BIT)) next.push_back({node.right, node.right});
+        return;
+    }
+    if ((task.a & LEAF_BIT) && (task.b & LEAF_BIT)) {
+        testLeaves(task.a & ~LEAF_BIT, task.b & ~LEAF_BIT, stats, outPairs);
+        return;
+    }
+    if (allStatic(task.a) && allStatic(task.b)) return;
+    ++stats.nodesVisited;
+    if (!aabbOverlap(childBounds(task.a), childBounds(task.b))) return;
+    const bool splitB = (task.a & LEAF_BIT) || (!(task.b & LEAF_BIT) && leafCount(task.b) > leafCount(task.a));
+    if (splitB) {
+        const Node& node = m_nodes[task.b];
+        next.push_back({task.a, node.left});
+        next.push_back({task.a, node.right});
+    } else {
+        const Node& node = m_nodes[task.a];
+        next.push_back({node.left, task.b});
+        next.push_back({node.right, task.b});
+    }
+}
+
+// 樹對自己的雙樹走訪：從 (根, 根) 開始，每一對葉只會在它們最低的共同祖先拆開時走到一次，
+// 不需要去重。先在呼叫端一層一層展開到至少 PAIR_TASKS 個子問題（數量和執行緒數無關），
+// 再依序切塊平行做完，各塊的配對依塊的順序串接
+void LinearBvh::findPairs(std::vector<BodyPair>& outPairs) {
+    build();
+    m_stats = BroadPhaseStats{};
+    if (m_nodes.empty()) return;
+
+    m_tasks.clear();
+    m_tasks.push_back({0, 0});
+    while (!m_tasks.empty() && m_tasks.size() < PAIR_TASKS) {
+        m_nextTasks.clear();
+        for (const Task& task : m_tasks) visit(task, m_stats, m_nextTasks, outPairs);
+        m_tasks.swap(m_nextTasks);
+    }
+
+    const size_t chunks = (m_tasks.size() + PAIR_GRAIN - 1) / PAIR_GRAIN;
+    m_chunkPairs.resize(chunks);
+    m_chunkStats.assign(chunks, BroadPhaseStats{});
+    m_workers.parallelFor(m_tasks.size(), PAIR_GRAIN, [&](size_t begin, size_t end) {
+        const size_t chunk = begin / PAIR_GRAIN;
+        std::vector<BodyPair>& pairs = m_chunkPairs[chunk];
+        BroadPhaseStats& stats = m_chunkStats[chunk];
+        pairs.clear();
+        std::vector<Task> stack;
+        for (size_t t = begin; t < end; ++t) {
+            stack.push_back(m_tasks[t]);
+            while (!stack.empty()) {
+                Task task = stack.back();
+                stack.pop_back();
+                visit(task, stats, stack, pairs);
+            }
+        }
+    });
+
+    for (size_t c = 0; c < chunks; ++c) {
+        outPairs.insert(outPairs.end(), m_chunkPairs[c].begin(), m_chunkPairs[c].end());
+        m_stats.add(m_chunkStats[c]);
+    }
+}
+
+void LinearBvh::query(const Aabb& area, std::vector<EntityID>& outEntities) {
+    build();
+    if (m_leaves.empty()) return;
+    if (m_nodes.empty()) {
+        if (aabbOverlap(area, m_leaves[0].bounds)) outEntities.push_back(m_leaves[0].entity);
+        return;
+    }
+
+    std::uint32_t stack[STACK_SIZE];
+    size_t top = 0;
+    if (aabbOverlap(area, m_nodes[0].bounds)) stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+        for (std::uint32_t child : {node.left, node.right}) {
+            if (!aabbOverlap(area, childBounds(child))) continue;
+            if (child & LEAF_BIT) {
+                outEntities.push_back(m_leaves[child & ~LEAF_BIT].entity);
+            } else {
+                stack[top++] = child;
+            }
+        }
+    }
+}
+
+} // namespace duck
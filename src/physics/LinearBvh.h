@@ -0,0 +1,135 @@
+#pragma once
+#include "core/WorkerPool.h"
+#include "ecs/Entity.h"
+#include "physics/Aabb.h"
+#include "physics/BroadPhase.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace duck {
+
+// ============================================================
+// LinearBvh — 每次整棵重建、可平行的 BVH broad phase（LBVH）
+// ============================================================
+// 四叉樹的 insert 要一路往下找節點、必要時分裂再重新分配，只能一個一個來，
+// 大量物體同時換位置（一次生成一大群、傳送、關卡開始）時整個 tick 都卡在重插。
+// 這裡乾脆不做增量更新：update 只記下新邊界，下一次 findPairs / query 前整棵重建，
+// 每一步都是可以切塊平行的 O(n)：
+//   1. Morton code：每個 proxy 中心在所有中心的範圍裡量化成 16 + 16 bits，交錯成 32 bits
+//   2. 基數排序：key = code << 32 | proxy，LSD 每輪 8 bits、只排 code 那四輪
+//      （各塊先數直方圖、循序 prefix sum、各塊再依序寫回，穩定排序，proxy 小的自然排前面）
+//   3. Karras（2012）建樹：n 個葉、n − 1 個內部節點，內部節點 i 只看排好的 key
+//      就能自己找出涵蓋的葉範圍與切點，每個節點互不相依
+//   4. 由下往上 refit：每個葉往父節點走，第二個抵達的子節點才合併邊界並繼續往上
+// 內部節點是一條扁平的 vector（根是 0），查詢和配對都只讀這條陣列和排好的葉。
+//
+// 配對：樹對自己的雙樹走訪（self-collision），節點對節點、每一對葉只測一次；
+// 每個內部節點記著涵蓋的葉數與靜態葉數，兩邊全是靜態的就不必進去。
+// 先展開成固定數量的子問題再切塊平行，各塊寫自己的暫存再依序串接，結果和執行緒數無關。
+class LinearBvh : public BroadPhase {
+public:
+    // 平行切塊的大小：建樹各階段每塊幾個葉；配對先展開到至少 PAIR_TASKS 個子問題，每塊 PAIR_GRAIN 個
+    static constexpr size_t BUILD_GRAIN = 4096;
+    static constexpr size_t PAIR_TASKS = 1024;
+    static constexpr size_t PAIR_GRAIN = 16;
+
+    ProxyID insert(EntityID entity, const Aabb& bounds, bool isStatic, CollisionFilter filter) override;
+    void remove(ProxyID id) override;
+
+    // 只寫入新邊界，下一次 findPairs / query 才整棵重建；沒有重插的概念，一律回傳 false
+    bool update(ProxyID id, const Aabb& bounds) override;
+
+    void findPairs(std::vector<BodyPair>& outPairs) override;
+    void query(const Aabb& area, std::vector<EntityID>& outEntities) override;
+    Aabb bounds(ProxyID id) const override;
+    BroadPhaseType type() const override { return BroadPhaseType::Lbvh; }
+    void setThreadCount(unsigned threadCount) override { m_workers.setThreadCount(threadCount); }
+
+    // 有變動才重建（findPairs / query 會自動呼叫；基準測試用來單獨量建樹時間）
+    void build();
+
+    size_t proxyCount() const { return m_proxyCount; }
+    size_t nodeCount() const { return m_nodes.size(); }
+    // 總共重建了幾次（測試用來確認沒有變動時不會重建）
+    size_t buildCount() const { return m_builds; }
+
+private:
+    struct Proxy {
+        Aabb bounds;
+        EntityID entity = INVALID_ENTITY; // INVALID_ENTITY = 空的（在 free list 上）
+        CollisionFilter filter;
+        bool isStatic = false;
+    };
+
+    // 排好順序的葉：查詢走到葉時讀的是同一段連續記憶體
+    struct Leaf {
+        Aabb bounds;
+        EntityID entity = INVALID_ENTITY;
+        CollisionFilter filter;
+        bool isStatic = false;
+    };
+
+    // 內部節點，32 bytes；子節點 index 的最高位代表葉
+    struct Node {
+        Aabb bounds;
+        std::uint32_t left = 0;
+        std::uint32_t right = 0;
+        std::uint32_t count = 0;          // 子樹裡的葉數
+        std::uint32_t statics = 0;        // 子樹裡的靜態葉數
+    };
+
+    static constexpr std::uint32_t LEAF_BIT = 0x80000000u;
+
+    // 雙樹走訪的一個子問題：a == b 是節點對自己，否則是兩棵不相交子樹（或葉）之間
+    struct Task {
+        std::uint32_t a = 0;
+        std::uint32_t b = 0;
+    };
+
+    void sortKeys();
+    void buildNodes();
+    void refit();
+    void visit(Task task, BroadPhaseStats& stats, std::vector<Task>& next, std::vector<BodyPair>& outPairs) const;
+    void testLeaves(std::uint32_t x, std::uint32_t y, BroadPhaseStats& stats, std::vector<BodyPair>& outPairs) const;
+    const Aabb& childBounds(std::uint32_t child) const {
+        return (child & LEAF_BIT) ? m_leaves[child & ~LEAF_BIT].bounds : m_nodes[child].bounds;
+    }
+    std::uint32_t leafCount(std::uint32_t child) const {
+        return (child & LEAF_BIT) ? 1u : m_nodes[child].count;
+    }
+    bool allStatic(std::uint32_t child) const {
+        return (child & LEAF_BIT) ? m_leaves[child & ~LEAF_BIT].isStatic
+                                  : m_nodes[child].statics == m_nodes[child].count;
+    }
+
+    WorkerPool m_workers;
+    std::vector<Proxy> m_proxies;
+    std::vector<ProxyID> m_freeProxies;
+    size_t m_proxyCount = 0;
+    bool m_dirty = false;
+    size_t m_builds = 0;
+
+    // 建樹的暫存（跨次重複使用）
+    std::vector<std::uint64_t> m_keys;
+    std::vector<std::uint64_t> m_sortBuffer;
+    std::vector<std::uint32_t> m_histogram;   // 每塊 256 格
+    std::vector<Aabb> m_chunkBounds;
+    std::vector<std::uint32_t> m_leafParent;
+    std::vector<std::uint32_t> m_nodeParent;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> m_arrivals;
+    size_t m_arrivalCapacity = 0;
+
+    std::vector<Leaf> m_leaves;
+    std::vector<Node> m_nodes;
+
+    // 配對的暫存：展開的子問題，以及每塊一份的輸出，依塊的順序串接
+    std::vector<Task> m_tasks;
+    std::vector<Task> m_nextTasks;
+    std::vector<std::vector<BodyPair>> m_chunkPairs;
+    std::vector<BroadPhaseStats> m_chunkStats;
+};
+
+} // namespace duck
@@ -0,0 +1,305 @@
+#include "physics/LooseQuadtree.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace duck {
+
+LooseQuadtree::LooseQuadtree() {
+    reset({0.0f, 0.0f, 1280.0f, 720.0f});
+}
+
+void LooseQuadtree::reset(const Aabb& worldBounds) {
+    m_proxies.clear();
+    m_freeProxy = NULL_PROXY;
+    m_proxyCount = 0;
+    rebuild(worldBounds);
+}
+
+void LooseQuadtree::rebuild(const Aabb& worldBounds) {
+    m_worldBounds = worldBounds;
+    m_nodes.clear();
+    m_outsideCount = 0;
+
+    // 根格子取正方形，邊長 = 世界邊界較長的那一邊
+    float cx = (worldBounds.minX + worldBounds.maxX) * 0.5f;
+    float cy = (worldBounds.minY + worldBounds.maxY) * 0.5f;
+    float half = std::max(worldBounds.maxX - worldBounds.minX,
+                          worldBounds.maxY - worldBounds.minY) * 0.5f;
+    allocNode(cx, cy, std::max(half, 1.0f), 0);
+
+    for (size_t i = 0; i < m_proxies.size(); ++i) {
+        if (m_proxies[i].node < 0) continue;
+        link(static_cast<ProxyID>(i));
+    }
+}
+
+std::int32_t LooseQuadtree::allocNode(float cx, float cy, float half, std::int32_t depth) {
+    Node node;
+    node.cx = cx;
+    node.cy = cy;
+    node.half = half;
+    node.depth = depth;
+    m_nodes.push_back(node);
+    return static_cast<std::int32_t>(m_nodes.size() - 1);
+}
+
+// 鬆散四叉樹的放置規則：
+//   ext = 物件半寬/半高較大者
+//   往下走，直到子格子的半寬 < 2 * ext
+//   （理論上到 childHalf < ext 才放不進 2 倍鬆散範圍，但再深一層的格子裡
+//    平均只剩 1~2 個物件，查詢多走一層節點的成本比多比幾個 entry 還高，
+//    bench 在 100k 物體時停在 2 * ext 最快）
+//   每一層由中心點落在哪個象限決定子節點，不需要任何包含測試
+std::int32_t LooseQuadtree::chooseNode(const Aabb& fat, bool& outside) {
+    float cx = (fat.minX + fat.maxX) * 0.5f;
+    float cy = (fat.minY + fat.maxY) * 0.5f;
+    float ext = std::max(fat.maxX - fat.minX, fat.maxY - fat.minY) * 0.5f;
+
+    const Node& root = m_nodes[0];
+    outside = std::abs(cx - root.cx) > root.half
+           || std::abs(cy - root.cy) > root.half
+           || ext > root.half;
+    if (outside) return 0;
+
+    std::int32_t index = 0;
+    while (m_nodes[static_cast<size_t>(index)].depth < MAX_DEPTH) {
+        const Node& node = m_nodes[static_cast<size_t>(index)];
+        float childHalf = node.half * 0.5f;
+        if (ext * 2.0f > childHalf) break;
+
+        int quadrant = (cx >= node.cx ? 1 : 0) | (cy >= node.cy ? 2 : 0);
+        std::int32_t child = node.children[quadrant];
+        if (child < 0) {
+            float childX = node.cx + ((quadrant & 1) ? childHalf : -childHalf);
+            float childY = node.cy + ((quadrant & 2) ? childHalf : -childHalf);
+            std::int32_t depth = node.depth + 1;
+            // allocNode 可能讓 m_nodes 重新配置，之後不能再用 node 參照
+            child = allocNode(childX, childY, childHalf, depth);
+            m_nodes[static_cast<size_t>(index)].children[quadrant] = child;
+        }
+        index = child;
+    }
+    return index;
+}
+
+void LooseQuadtree::link(ProxyID id) {
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    bool outside = false;
+    std::int32_t nodeIndex = chooseNode(p.fat, outside);
+    Node& node = m_nodes[static_cast<size_t>(nodeIndex)];
+
+    p.node = nodeIndex;
+    p.slot = static_cast<std::int32_t>(node.entries.size());
+    p.outside = outside;
+    node.entries.push_back({p.fat, id});
+    if (outside) ++m_outsideCount;
+}
+
+// Swap-and-Pop：節點最後一筆搬進空位，更新被搬動 proxy 的 slot
+void LooseQuadtree::unlink(ProxyID id) {
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    auto& entries = m_nodes[static_cast<size_t>(p.node)].entries;
+    if (static_cast<size_t>(p.slot) != entries.size() - 1) {
+        entries[static_cast<size_t>(p.slot)] = entries.back();
+        m_proxies[static_cast<size_t>(entries.back().id)].slot = p.slot;
+    }
+    entries.pop_back();
+    if (p.outside) --m_outsideCount;
+    p.slot = -1;
+    p.outside = false;
+}
+
+LooseQuadtree::ProxyID LooseQuadtree::insert(EntityID entity, const Aabb& bounds, bool isStatic,
+                                             CollisionFilter filter) {
+    ProxyID id;
+    if (m_freeProxy != NULL_PROXY) {
+        id = m_freeProxy;
+        m_freeProxy = m_proxies[static_cast<size_t>(id)].slot;
+    } else {
+        id = static_cast<ProxyID>(m_proxies.size());
+        m_proxies.emplace_back();
+    }
+
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    p.fat = isStatic ? bounds : aabbInflate(bounds, FAT_MARGIN);
+    p.entity = entity;
+    p.isStatic = isStatic;
+    p.filter = filter;
+    link(id);
+    ++m_proxyCount;
+    return id;
+}
+
+void LooseQuadtree::remove(ProxyID id) {
+    unlink(id);
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    p.node = -1;
+    p.entity = INVALID_ENTITY;
+    p.slot = m_freeProxy;
+    m_freeProxy = id;
+    --m_proxyCount;
+}
+
+bool LooseQuadtree::update(ProxyID id, const Aabb& tight) {
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    if (aabbContains(p.fat, tight)) return false;
+
+    unlink(id);
+    p.fat = aabbInflate(tight, FAT_MARGIN);
+    link(id);
+    return true;
+}
+
+void LooseQuadtree::queryProxies(const Aabb& area, std::vector<ProxyID>& out) const {
+    size_t nodesVisited = 0;
+    size_t aabbTests = 0;
+    queryProxies(area, out, nodesVisited, aabbTests);
+}
+
+void LooseQuadtree::queryProxies(const Aabb& area, std::vector<ProxyID>& out,
+                                 size_t& nodesVisited, size_t& aabbTests) const {
+    // 深度上限 MAX_DEPTH，每層最多壓 3 個兄弟節點，64 格的堆疊綽綽有餘
+    std::array<std::int32_t, 64> stack;
+    size_t top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = m_nodes[static_cast<size_t>(stack[--top])];
+        ++nodesVisited;
+        aabbTests += node.entries.size();
+
+        // 根節點一律進入（可能放著世界外的物件），子節點在入堆疊前已用 2 倍鬆散範圍剔除
+        for (const Entry& entry : node.entries) {
+            if (aabbOverlap(entry.fat, area)) out.push_back(entry.id);
+        }
+
+        // 子節點先測鬆散範圍再入堆疊，省掉大部分的 push/pop。
+        // 子格子的中心和鬆散半徑都能從父節點算出來（中心 = 父中心 ± 父半寬/2，
+        // 鬆散半徑 = 2 * 子半寬 = 父半寬），不必為了剔除去讀子節點的記憶體
+        float childHalf = node.half * 0.5f;
+        float loose = node.half;
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            std::int32_t child = node.children[quadrant];
+            if (child < 0) continue;
+            float ccx = node.cx + ((quadrant & 1) ? childHalf : -childHalf);
+            float ccy = node.cy + ((quadrant & 2) ? childHalf : -childHalf);
+            if (area.maxX < ccx - loose || area.minX > ccx + loose) continue;
+            if (area.maxY < ccy - loose || area.minY > ccy + loose) continue;
+            stack[top++] = child;
+        }
+    }
+}
+
+void LooseQuadtree::query(const Aabb& area, std::vector<EntityID>& outEntities) {
+    m_scratch.clear();
+    queryProxies(area, m_scratch);
+    for (auto id : m_scratch) outEntities.push_back(proxy(id).entity);
+}
+
+// 太多物件跑到根格子外（全部擠在根節點）時，用目前所有物件的範圍重建節點
+void LooseQuadtree::growIfNeeded() {
+    if (m_outsideCount < 32 || m_outsideCount * 8 < m_proxyCount) return;
+
+    Aabb world = m_worldBounds;
+    for (const Proxy& p : m_proxies) {
+        if (p.node >= 0) world = aabbUnion(world, p.fat);
+    }
+    rebuild(aabbInflate(world, 64.0f));
+}
+
+void LooseQuadtree::findPairs(std::vector<BodyPair>& outPairs) {
+    growIfNeeded();
+    m_stats = BroadPhaseStats{};
+    for (const Node& node : m_nodes) {
+        m_stats.addNode(node.entries.size());
+        if (!node.entries.empty() && static_cast<size_t>(node.depth) > m_stats.maxDepth) {
+            m_stats.maxDepth = static_cast<size_t>(node.depth);
+        }
+    }
+
+    selfPairs(0, outPairs);
+}
+
+// 兩個 entry 測一次；配對規則（動態在前、動態 vs 動態 a < b）在這裡決定
+void LooseQuadtree::testEntries(const Entry& x, const Entry& y, std::vector<BodyPair>& outPairs) {
+    const Proxy& px = proxy(x.id);
+    const Proxy& py = proxy(y.id);
+    if (px.isStatic && py.isStatic) return;
+    ++m_stats.aabbTests;
+    if (!aabbOverlap(x.fat, y.fat)) return;
+    if (py.isStatic || (!px.isStatic && px.entity < py.entity)) {
+        emitPair(outPairs, px.entity, py.entity, px.filter, py.filter);
+    } else {
+        emitPair(outPairs, py.entity, px.entity, py.filter, px.filter);
+    }
+}
+
+// 節點自己的 entry 對 sub 整棵子樹：每個 entry 像 queryProxies 一樣用鬆散範圍剔除往下走
+void LooseQuadtree::entriesVsSubtree(std::int32_t nodeIndex, std::int32_t sub, std::vector<BodyPair>& outPairs) {
+    std::array<std::int32_t, 64> stack;
+    for (const Entry& entry : m_nodes[static_cast<size_t>(nodeIndex)].entries) {
+        if (!aabbOverlap(entry.fat, looseBounds(sub))) continue;
+        size_t top = 0;
+        stack[top++] = sub;
+        while (top > 0) {
+            const std::int32_t current = stack[--top];
+            ++m_stats.nodesVisited;
+            for (const Entry& other : m_nodes[static_cast<size_t>(current)].entries) {
+                testEntries(entry, other, outPairs);
+            }
+            for (std::int32_t child : m_nodes[static_cast<size_t>(current)].children) {
+                if (child >= 0 && aabbOverlap(entry.fat, looseBounds(child))) stack[top++] = child;
+            }
+        }
+    }
+}
+
+// 自我碰撞：節點內兩兩、節點對自己的子樹、每個子樹自己、兩兩子樹之間；每一對只會走到一次
+void LooseQuadtree::selfPairs(std::int32_t nodeIndex, std::vector<BodyPair>& outPairs) {
+    ++m_stats.nodesVisited;
+    const auto& entries = m_nodes[static_cast<size_t>(nodeIndex)].entries;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        for (size_t j = i + 1; j < entries.size(); ++j) testEntries(entries[i], entries[j], outPairs);
+    }
+
+    const std::int32_t* children = m_nodes[static_cast<size_t>(nodeIndex)].children;
+    for (int i = 0; i < 4; ++i) {
+        if (children[i] < 0) continue;
+        entriesVsSubtree(nodeIndex, children[i], outPairs);
+        selfPairs(children[i], outPairs);
+        for (int j = i + 1; j < 4; ++j) {
+            if (children[j] >= 0) crossPairs(children[i], children[j], outPairs);
+        }
+    }
+}
+
+// 兩棵不相交的子樹之間：鬆散範圍不重疊就整個跳過，
+// 否則兩邊的 entry 互測、各自的 entry 對另一邊的子節點子樹，再兩兩遞迴到子節點
+void LooseQuadtree::crossPairs(std::int32_t a, std::int32_t b, std::vector<BodyPair>& outPairs) {
+    const Aabb looseB = looseBounds(b);
+    if (!aabbOverlap(looseBounds(a), looseB)) return;
+    ++m_stats.nodesVisited;
+    // 鬆散範圍比格子大兩倍，相鄰的節點幾乎都重疊：entry 先和對方的鬆散範圍比一次再逐一測
+    if (!m_nodes[static_cast<size_t>(b)].entries.empty()) {
+        for (const Entry& x : m_nodes[static_cast<size_t>(a)].entries) {
+            if (!aabbOverlap(x.fat, looseB)) continue;
+            for (const Entry& y : m_nodes[static_cast<size_t>(b)].entries) testEntries(x, y, outPairs);
+        }
+    }
+
+    const std::int32_t* childrenA = m_nodes[static_cast<size_t>(a)].children;
+    const std::int32_t* childrenB = m_nodes[static_cast<size_t>(b)].children;
+    for (int i = 0; i < 4; ++i) {
+        if (childrenB[i] >= 0) entriesVsSubtree(a, childrenB[i], outPairs);
+        if (childrenA[i] >= 0) entriesVsSubtree(b, childrenA[i], outPairs);
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (childrenA[i] < 0) continue;
+        for (int j = 0; j < 4; ++j) {
+            if (childrenB[j] >= 0) crossPairs(childrenA[i], childrenB[j], outPairs);
+        }
+    }
+}
+
+} // namespace duck
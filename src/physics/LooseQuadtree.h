@@ -0,0 +1,145 @@
+#pragma once
+#include "ecs/Entity.h"
+#include "physics/Aabb.h"
+#include "physics/BroadPhase.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+// ============================================================
+// LooseQuadtree — 持久、增量更新的鬆散四叉樹
+// ============================================================
+// 舊版 CollisionSystem 每個 tick：
+//   重算世界邊界 → new 一整棵 unique_ptr<Node> 樹 → 把所有 solid 重插一次
+//   （包含永遠不動的石頭），tick 結束後整棵樹丟掉。
+//
+// 這裡的做法：
+//   1. 樹跨 tick 保留，節點放在一條 vector<Node>（節點池），用 int32 index 互指，
+//      不做任何單一節點的 heap 配置
+//   2. 「鬆散」：每個節點的查詢範圍是格子的 2 倍（looseness = 2），
+//      物件只要「中心落在格子裡、半徑不超過格子半寬」就能放進那一格，
+//      插入位置由大小和中心 O(depth) 直接算出，不需要 subdivide + 重新分配
+//   3. 每個 proxy 存的是 fat bounds（實際範圍再外擴 margin），
+//      物體在 fat bounds 內小幅移動時完全不碰樹，離開才 remove + insert
+//   4. 節點內的 entry（fat bounds + proxy id）連續存放在節點自己的陣列，
+//      proxy 記住自己在哪個節點的第幾格，移除是 O(1) 的 Swap-and-Pop。
+//      一開始用 proxy 間的鏈結串列，但查詢時每個 entry 都是一次隨機記憶體存取，
+//      100k 物體時查詢時間被 cache miss 吃掉；改成連續陣列後快了約 3 倍。
+//
+// 世界外的物件：中心在根格子外、或比根格子還大 → 放在根節點；
+// 太多物件擠在根節點時，findPairs 開頭會用所有物件的範圍重建節點。
+class LooseQuadtree : public BroadPhase {
+public:
+    static constexpr int MAX_DEPTH = 10;
+
+    // 動態物體 fat bounds 的外擴量（像素）
+    // 每 tick 移動幾個像素的物體，大約每 2~3 tick 才需要重插一次
+    static constexpr float FAT_MARGIN = 6.0f;
+
+    struct Proxy {
+        Aabb fat;                         // broad phase 用的外擴邊界
+        EntityID entity = INVALID_ENTITY;
+        std::int32_t node = -1;           // 所在節點；-1 代表這格 proxy 是空的（在 free list 上）
+        std::int32_t slot = -1;           // 在節點 entries 中的 index；空的 proxy 拿來串 free list
+        bool isStatic = false;
+        bool outside = false;             // 落在根格子外（被迫放在根節點）
+        CollisionFilter filter;
+    };
+
+    LooseQuadtree();
+
+    // 清空所有節點與 proxy，以新的世界邊界開始
+    void reset(const Aabb& worldBounds);
+
+    // 保留所有 proxy（ID 不變），用新的世界邊界重建節點
+    void rebuild(const Aabb& worldBounds);
+
+    // 靜態物體直接用緊密邊界；動態物體外擴 FAT_MARGIN
+    ProxyID insert(EntityID entity, const Aabb& bounds, bool isStatic, CollisionFilter filter) override;
+    void remove(ProxyID id) override;
+
+    // tight 還在 fat bounds 內 → 什麼都不做，回傳 false
+    // 離開了 → 以 tight 外擴 FAT_MARGIN 當新的 fat bounds 重新放置，回傳 true
+    bool update(ProxyID id, const Aabb& tight) override;
+
+    // 樹對自己的雙樹走訪（self-collision）：節點對節點、節點對自己的子樹，
+    // 每一對只測一次，不必每個物體各查一次再丟掉 a > b 的那一半
+    void findPairs(std::vector<BodyPair>& outPairs) override;
+    void query(const Aabb& area, std::vector<EntityID>& outEntities) override;
+    Aabb bounds(ProxyID id) const override { return proxy(id).fat; }
+    BroadPhaseType type() const override { return BroadPhaseType::Quadtree; }
+
+    // 把 fat bounds 和 area 重疊的 proxy 寫進 out（不清空 out）
+    void queryProxies(const Aabb& area, std::vector<ProxyID>& out) const;
+
+    // 依樹的深度優先順序走訪所有 proxy：func(ProxyID)
+    // 相鄰呼叫的物體在空間上也相鄰，拿來當查詢順序時節點和 entry 都還在 cache 裡
+    template <typename Func>
+    void forEachProxy(Func&& func) const {
+        std::vector<std::int32_t>& stack = m_walkStack;
+        stack.clear();
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& node = m_nodes[static_cast<size_t>(stack.back())];
+            stack.pop_back();
+            for (const Entry& entry : node.entries) func(entry.id);
+            for (std::int32_t child : node.children) {
+                if (child >= 0) stack.push_back(child);
+            }
+        }
+    }
+
+    const Proxy& proxy(ProxyID id) const { return m_proxies[static_cast<size_t>(id)]; }
+
+    size_t proxyCount() const { return m_proxyCount; }
+    size_t nodeCount() const { return m_nodes.size(); }
+    size_t outOfBoundsCount() const { return m_outsideCount; }
+    const Aabb& worldBounds() const { return m_worldBounds; }
+
+private:
+    // 節點內的一筆資料：查詢只需要 fat bounds，和 id 放在一起讓掃描保持連續
+    struct Entry {
+        Aabb fat;
+        ProxyID id = NULL_PROXY;
+    };
+
+    struct Node {
+        float cx = 0.0f;                  // 格子中心
+        float cy = 0.0f;
+        float half = 0.0f;                // 格子半寬（正方形）；查詢範圍是 2 * half
+        std::int32_t children[4] = {-1, -1, -1, -1};
+        std::int32_t depth = 0;
+        std::vector<Entry> entries;
+    };
+
+    // queryProxies 的本體：順便累加走過的節點數與 AABB 測試數（findPairs 的統計用）
+    void queryProxies(const Aabb& area, std::vector<ProxyID>& out, size_t& nodesVisited, size_t& aabbTests) const;
+    // findPairs 的雙樹走訪
+    void selfPairs(std::int32_t nodeIndex, std::vector<BodyPair>& outPairs);
+    void crossPairs(std::int32_t a, std::int32_t b, std::vector<BodyPair>& outPairs);
+    void entriesVsSubtree(std::int32_t nodeIndex, std::int32_t sub, std::vector<BodyPair>& outPairs);
+    void testEntries(const Entry& x, const Entry& y, std::vector<BodyPair>& outPairs);
+    // 節點的鬆散範圍：格子中心 ± 2 倍半寬（節點內所有 entry 的 fat bounds 都在裡面，根節點的世界外物件除外）
+    Aabb looseBounds(std::int32_t nodeIndex) const {
+        const Node& node = m_nodes[static_cast<size_t>(nodeIndex)];
+        return makeAabb(node.cx, node.cy, 2.0f * node.half, 2.0f * node.half);
+    }
+    std::int32_t allocNode(float cx, float cy, float half, std::int32_t depth);
+    std::int32_t chooseNode(const Aabb& fat, bool& outside);
+    void link(ProxyID id);
+    void unlink(ProxyID id);
+    void growIfNeeded();
+
+    std::vector<Node> m_nodes;
+    std::vector<Proxy> m_proxies;
+    ProxyID m_freeProxy = NULL_PROXY;
+    size_t m_proxyCount = 0;
+    size_t m_outsideCount = 0;
+    Aabb m_worldBounds;
+    mutable std::vector<std::int32_t> m_walkStack;
+    std::vector<ProxyID> m_scratch;
+};
+
+} // namespace duck
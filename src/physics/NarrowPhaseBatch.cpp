@@ -0,0 +1,736 @@
+#include "physics/NarrowPhaseBatch.h"
+#include "systems/CollisionSystem.h"
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define DUCK_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace duck {
+
+using Lanes = NarrowPhaseBatch::Lanes;
+
+SimdLevel detectSimdLevel() {
+#ifdef DUCK_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE2: return "sse2";
+        default:              return "scalar";
+    }
+}
+
+// ------------------------------------------------------------
+// 純量 kernel：[begin, end) 逐一呼叫 CollisionSystem.h 的參考實作
+// 非 x86 平台全部走這裡；向量版處理不完的尾端也走這裡
+// ------------------------------------------------------------
+static void scalarCircleCircle(Lanes& l, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float nx = 0.0f, ny = 0.0f, depth = 0.0f;
+        bool hit = circleVsCircle(l.ax[i], l.ay[i], l.aw[i], l.bx[i], l.by[i], l.bw[i], nx, ny, depth);
+        l.nx[i] = hit ? nx : 0.0f;
+        l.ny[i] = hit ? ny : 0.0f;
+        l.depth[i] = hit ? depth : 0.0f;
+        l.hit[i] = hit ? 1.0f : 0.0f;
+    }
+}
+
+static void scalarAabbAabb(Lanes& l, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float nx = 0.0f, ny = 0.0f, depth = 0.0f;
+        bool hit = aabbVsAabb(l.ax[i], l.ay[i], l.aw[i], l.ah[i],
+                              l.bx[i], l.by[i], l.bw[i], l.bh[i], nx, ny, depth);
+        l.nx[i] = hit ? nx : 0.0f;
+        l.ny[i] = hit ? ny : 0.0f;
+        l.depth[i] = hit ? depth : 0.0f;
+        l.hit[i] = hit ? 1.0f : 0.0f;
+    }
+}
+
+static void scalarCircleAabb(Lanes& l, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float nx = 0.0f, ny = 0.0f, depth = 0.0f;
+        bool hit = circleVsAabb(l.ax[i], l.ay[i], l.aw[i],
+                                l.bx[i], l.by[i], l.bw[i], l.bh[i], nx, ny, depth);
+        l.nx[i] = hit ? nx : 0.0f;
+        l.ny[i] = hit ? ny : 0.0f;
+        l.depth[i] = hit ? depth : 0.0f;
+        l.hit[i] = hit ? 1.0f : 0.0f;
+    }
+}
+
+static void scalarCircleObb(Lanes& l, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float nx = 0.0f, ny = 0.0f, depth = 0.0f;
+        bool hit = circleVsObb(l.ax[i], l.ay[i], l.aw[i],
+                               l.bx[i], l.by[i], l.bw[i], l.bh[i], l.bc[i], l.bs[i], nx, ny, depth);
+        l.nx[i] = hit ? nx : 0.0f;
+        l.ny[i] = hit ? ny : 0.0f;
+        l.depth[i] = hit ? depth : 0.0f;
+        l.hit[i] = hit ? 1.0f : 0.0f;
+    }
+}
+
+static void scalarObbObb(Lanes& l, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float nx = 0.0f, ny = 0.0f, depth = 0.0f;
+        bool hit = obbVsObb(l.ax[i], l.ay[i], l.aw[i], l.ah[i], l.ac[i], l.as[i],
+                            l.bx[i], l.by[i], l.bw[i], l.bh[i], l.bc[i], l.bs[i], nx, ny, depth);
+        l.nx[i] = hit ? nx : 0.0f;
+        l.ny[i] = hit ? ny : 0.0f;
+        l.depth[i] = hit ? depth : 0.0f;
+        l.hit[i] = hit ? 1.0f : 0.0f;
+    }
+}
+
+#ifdef DUCK_SIMD_X86
+
+// ------------------------------------------------------------
+// SSE2 kernel（4 對一組），回傳處理到哪裡
+// SSE2 沒有 blendv：select(m, a, b) = (m & a) | (~m & b)
+// ------------------------------------------------------------
+static inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void storeResult4(Lanes& l, size_t i, __m128 hit, __m128 nx, __m128 ny, __m128 depth) {
+    _mm_storeu_ps(&l.nx[i], _mm_and_ps(hit, nx));
+    _mm_storeu_ps(&l.ny[i], _mm_and_ps(hit, ny));
+    _mm_storeu_ps(&l.depth[i], _mm_and_ps(hit, depth));
+    _mm_storeu_ps(&l.hit[i], _mm_and_ps(hit, _mm_set1_ps(1.0f)));
+}
+
+static size_t sse2CircleCircle(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{3});
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 eps = _mm_set1_ps(0.0001f);
+    for (size_t i = begin; i < n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&l.bx[i]), _mm_loadu_ps(&l.ax[i]));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&l.by[i]), _mm_loadu_ps(&l.ay[i]));
+        __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 minDist = _mm_add_ps(_mm_loadu_ps(&l.aw[i]), _mm_loadu_ps(&l.bw[i]));
+        __m128 hit = _mm_cmpnge_ps(distSq, _mm_mul_ps(minDist, minDist));
+
+        __m128 dist = _mm_sqrt_ps(distSq);
+        __m128 depth = _mm_sub_ps(minDist, dist);
+        __m128 far = _mm_cmpgt_ps(dist, eps);
+        __m128 nx = select4(far, _mm_div_ps(dx, dist), one);
+        __m128 ny = select4(far, _mm_div_ps(dy, dist), zero);
+        storeResult4(l, i, hit, nx, ny, depth);
+    }
+    return n;
+}
+
+static size_t sse2AabbAabb(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{3});
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (size_t i = begin; i < n; i += 4) {
+        __m128 ax = _mm_loadu_ps(&l.ax[i]);
+        __m128 ay = _mm_loadu_ps(&l.ay[i]);
+        __m128 bx = _mm_loadu_ps(&l.bx[i]);
+        __m128 by = _mm_loadu_ps(&l.by[i]);
+        __m128 overlapX = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(&l.aw[i]), _mm_loadu_ps(&l.bw[i])),
+                                     _mm_and_ps(_mm_sub_ps(bx, ax), absMask));
+        __m128 overlapY = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(&l.ah[i]), _mm_loadu_ps(&l.bh[i])),
+                                     _mm_and_ps(_mm_sub_ps(by, ay), absMask));
+        __m128 hit = _mm_and_ps(_mm_cmpnle_ps(overlapX, zero), _mm_cmpnle_ps(overlapY, zero));
+
+        __m128 useX = _mm_cmplt_ps(overlapX, overlapY);
+        __m128 signX = select4(_mm_cmpgt_ps(bx, ax), one, minusOne);
+        __m128 signY = select4(_mm_cmpgt_ps(by, ay), one, minusOne);
+        __m128 depth = select4(useX, overlapX, overlapY);
+        __m128 nx = select4(useX, signX, zero);
+        __m128 ny = select4(useX, zero, signY);
+        storeResult4(l, i, hit, nx, ny, depth);
+    }
+    return n;
+}
+
+// 圓 vs AABB 的本體：圓心在外沿最近點推，在內依序比較四邊（嚴格小於才換，和純量版同順序）。
+// 圓 vs OBB 把圓心轉進局部座標後也呼叫這裡（盒子中心 = 0）
+static inline void circleAabb4(__m128 cx, __m128 cy, __m128 cr, __m128 bx, __m128 by, __m128 bhw, __m128 bhh,
+                               __m128& hit, __m128& nx, __m128& ny, __m128& depth) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 eps = _mm_set1_ps(0.0001f);
+    __m128 left = _mm_sub_ps(bx, bhw);
+    __m128 right = _mm_add_ps(bx, bhw);
+    __m128 top = _mm_sub_ps(by, bhh);
+    __m128 bottom = _mm_add_ps(by, bhh);
+
+    __m128 nearX = select4(_mm_cmplt_ps(cx, left), left, select4(_mm_cmpgt_ps(cx, right), right, cx));
+    __m128 nearY = select4(_mm_cmplt_ps(cy, top), top, select4(_mm_cmpgt_ps(cy, bottom), bottom, cy));
+    __m128 dx = _mm_sub_ps(nearX, cx);
+    __m128 dy = _mm_sub_ps(nearY, cy);
+    __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    hit = _mm_cmpnge_ps(distSq, _mm_mul_ps(cr, cr));
+
+    // 圓心在外：沿最近點方向推
+    __m128 dist = _mm_sqrt_ps(distSq);
+    __m128 far = _mm_cmpgt_ps(dist, eps);
+    __m128 outDepth = _mm_sub_ps(cr, dist);
+    __m128 outNx = _mm_div_ps(dx, dist);
+    __m128 outNy = _mm_div_ps(dy, dist);
+
+    // 圓心在內：依序比較左、右、上、下四邊距離
+    __m128 minDist = _mm_sub_ps(cx, left);
+    __m128 inNx = one;
+    __m128 inNy = zero;
+    __m128 closer = _mm_cmplt_ps(_mm_sub_ps(right, cx), minDist);
+    minDist = select4(closer, _mm_sub_ps(right, cx), minDist);
+    inNx = select4(closer, minusOne, inNx);
+    inNy = select4(closer, zero, inNy);
+    closer = _mm_cmplt_ps(_mm_sub_ps(cy, top), minDist);
+    minDist = select4(closer, _mm_sub_ps(cy, top), minDist);
+    inNx = select4(closer, zero, inNx);
+    inNy = select4(closer, one, inNy);
+    closer = _mm_cmplt_ps(_mm_sub_ps(bottom, cy), minDist);
+    minDist = select4(closer, _mm_sub_ps(bottom, cy), minDist);
+    inNx = select4(closer, zero, inNx);
+    inNy = select4(closer, minusOne, inNy);
+    __m128 inDepth = _mm_add_ps(cr, minDist);
+
+    nx = select4(far, outNx, inNx);
+    ny = select4(far, outNy, inNy);
+    depth = select4(far, outDepth, inDepth);
+}
+
+static size_t sse2CircleAabb(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{3});
+    for (size_t i = begin; i < n; i += 4) {
+        __m128 hit, nx, ny, depth;
+        circleAabb4(_mm_loadu_ps(&l.ax[i]), _mm_loadu_ps(&l.ay[i]), _mm_loadu_ps(&l.aw[i]),
+                    _mm_loadu_ps(&l.bx[i]), _mm_loadu_ps(&l.by[i]), _mm_loadu_ps(&l.bw[i]), _mm_loadu_ps(&l.bh[i]),
+                    hit, nx, ny, depth);
+        storeResult4(l, i, hit, nx, ny, depth);
+    }
+    return n;
+}
+
+static size_t sse2CircleObb(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{3});
+    const __m128 zero = _mm_setzero_ps();
+    for (size_t i = begin; i < n; i += 4) {
+        __m128 bc = _mm_loadu_ps(&l.bc[i]);
+        __m128 bs = _mm_loadu_ps(&l.bs[i]);
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&l.ax[i]), _mm_loadu_ps(&l.bx[i]));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&l.ay[i]), _mm_loadu_ps(&l.by[i]));
+        __m128 lx = _mm_add_ps(_mm_mul_ps(bc, dx), _mm_mul_ps(bs, dy));
+        __m128 ly = _mm_sub_ps(_mm_mul_ps(bc, dy), _mm_mul_ps(bs, dx));
+        __m128 hit, lnx, lny, depth;
+        circleAabb4(lx, ly, _mm_loadu_ps(&l.aw[i]), zero, zero, _mm_loadu_ps(&l.bw[i]), _mm_loadu_ps(&l.bh[i]),
+                    hit, lnx, lny, depth);
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(bc, lnx), _mm_mul_ps(bs, lny));
+        __m128 ny = _mm_add_ps(_mm_mul_ps(bs, lnx), _mm_mul_ps(bc, lny));
+        storeResult4(l, i, hit, nx, ny, depth);
+    }
+    return n;
+}
+
+// SAT：四個軸的重疊量，取最小的那一軸（嚴格小於才換，和純量版同順序）
+static size_t sse2ObbObb(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{3});
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (size_t i = begin; i < n; i += 4) {
+        __m128 ahw = _mm_loadu_ps(&l.aw[i]);
+        __m128 ahh = _mm_loadu_ps(&l.ah[i]);
+        __m128 ac = _mm_loadu_ps(&l.ac[i]);
+        __m128 as = _mm_loadu_ps(&l.as[i]);
+        __m128 bhw = _mm_loadu_ps(&l.bw[i]);
+        __m128 bhh = _mm_loadu_ps(&l.bh[i]);
+        __m128 bc = _mm_loadu_ps(&l.bc[i]);
+        __m128 bs = _mm_loadu_ps(&l.bs[i]);
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&l.bx[i]), _mm_loadu_ps(&l.ax[i]));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&l.by[i]), _mm_loadu_ps(&l.ay[i]));
+        __m128 uu = _mm_and_ps(_mm_add_ps(_mm_mul_ps(ac, bc), _mm_mul_ps(as, bs)), absMask);
+        __m128 uv = _mm_and_ps(_mm_sub_ps(_mm_mul_ps(as, bc), _mm_mul_ps(ac, bs)), absMask);
+
+        __m128 distA0 = _mm_add_ps(_mm_mul_ps(dx, ac), _mm_mul_ps(dy, as));
+        __m128 distA1 = _mm_sub_ps(_mm_mul_ps(dy, ac), _mm_mul_ps(dx, as));
+        __m128 distB0 = _mm_add_ps(_mm_mul_ps(dx, bc), _mm_mul_ps(dy, bs));
+        __m128 distB1 = _mm_sub_ps(_mm_mul_ps(dy, bc), _mm_mul_ps(dx, bs));
+        __m128 overlapA0 = _mm_sub_ps(_mm_add_ps(ahw, _mm_add_ps(_mm_mul_ps(bhw, uu), _mm_mul_ps(bhh, uv))),
+                                      _mm_and_ps(distA0, absMask));
+        __m128 overlapA1 = _mm_sub_ps(_mm_add_ps(ahh, _mm_add_ps(_mm_mul_ps(bhw, uv), _mm_mul_ps(bhh, uu))),
+                                      _mm_and_ps(distA1, absMask));
+        __m128 overlapB0 = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ahw, uu), _mm_mul_ps(ahh, uv)), bhw),
+                                      _mm_and_ps(distB0, absMask));
+        __m128 overlapB1 = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ahw, uv), _mm_mul_ps(ahh, uu)), bhh),
+                                      _mm_and_ps(distB1, absMask));
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpnle_ps(overlapA0, zero), _mm_cmpnle_ps(overlapA1, zero)),
+                                _mm_and_ps(_mm_cmpnle_ps(overlapB0, zero), _mm_cmpnle_ps(overlapB1, zero)));
+
+        __m128 depth = overlapA0, axisX = ac, axisY = as, dist = distA0;
+        __m128 closer = _mm_cmplt_ps(overlapA1, depth);
+        depth = select4(closer, overlapA1, depth);
+        axisX = select4(closer, _mm_xor_ps(as, signMask), axisX);
+        axisY = select4(closer, ac, axisY);
+        dist = select4(closer, distA1, dist);
+        closer = _mm_cmplt_ps(overlapB0, depth);
+        depth = select4(closer, overlapB0, depth);
+        axisX = select4(closer, bc, axisX);
+        axisY = select4(closer, bs, axisY);
+        dist = select4(closer, distB0, dist);
+        closer = _mm_cmplt_ps(overlapB1, depth);
+        depth = select4(closer, overlapB1, depth);
+        axisX = select4(closer, _mm_xor_ps(bs, signMask), axisX);
+        axisY = select4(closer, bc, axisY);
+        dist = select4(closer, distB1, dist);
+        __m128 sign = select4(_mm_cmpgt_ps(dist, zero), one, minusOne);
+        storeResult4(l, i, hit, _mm_mul_ps(axisX, sign), _mm_mul_ps(axisY, sign), depth);
+    }
+    return n;
+}
+
+// ------------------------------------------------------------
+// AVX2 kernel（8 對一組）：和 SSE2 版一行對一行，只是寬度加倍
+// 用 target 屬性單獨開啟 AVX2，其餘程式碼仍以基本指令集編譯，
+// 沒有 AVX2 的 CPU 只要不呼叫這幾個函式就不會出事
+// ------------------------------------------------------------
+#define DUCK_AVX2 __attribute__((target("avx2")))
+
+DUCK_AVX2 static void storeResult8(Lanes& l, size_t i, __m256 hit, __m256 nx, __m256 ny, __m256 depth) {
+    _mm256_storeu_ps(&l.nx[i], _mm256_and_ps(hit, nx));
+    _mm256_storeu_ps(&l.ny[i], _mm256_and_ps(hit, ny));
+    _mm256_storeu_ps(&l.depth[i], _mm256_and_ps(hit, depth));
+    _mm256_storeu_ps(&l.hit[i], _mm256_and_ps(hit, _mm256_set1_ps(1.0f)));
+}
+
+// blendv 依 mask 的最高位選 b（mask 為真）或 a
+DUCK_AVX2 static inline __m256 select8(__m256 mask, __m256 a, __m256 b) {
+    return _mm256_blendv_ps(b, a, mask);
+}
+
+DUCK_AVX2 static size_t avx2CircleCircle(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{7});
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 eps = _mm256_set1_ps(0.0001f);
+    for (size_t i = begin; i < n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&l.bx[i]), _mm256_loadu_ps(&l.ax[i]));
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&l.by[i]), _mm256_loadu_ps(&l.ay[i]));
+        __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 minDist = _mm256_add_ps(_mm256_loadu_ps(&l.aw[i]), _mm256_loadu_ps(&l.bw[i]));
+        __m256 hit = _mm256_cmp_ps(distSq, _mm256_mul_ps(minDist, minDist), _CMP_NGE_UQ);
+
+        __m256 dist = _mm256_sqrt_ps(distSq);
+        __m256 depth = _mm256_sub_ps(minDist, dist);
+        __m256 far = _mm256_cmp_ps(dist, eps, _CMP_GT_OQ);
+        __m256 nx = select8(far, _mm256_div_ps(dx, dist), one);
+        __m256 ny = select8(far, _mm256_div_ps(dy, dist), zero);
+        storeResult8(l, i, hit, nx, ny, depth);
+    }
+    return n;
+}
+
+DUCK_AVX2 static size_t avx2AabbAabb(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{7});
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    for (size_t i = begin; i < n; i += 8) {
+        __m256 ax = _mm256_loadu_ps(&l.ax[i]);
+        __m256 ay = _mm256_loadu_ps(&l.ay[i]);
+        __m256 bx = _mm256_loadu_ps(&l.bx[i]);
+        __m256 by = _mm256_loadu_ps(&l.by[i]);
+        __m256 overlapX = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(&l.aw[i]), _mm256_loadu_ps(&l.bw[i])),
+                                        _mm256_and_ps(_mm256_sub_ps(bx, ax), absMask));
+        __m256 overlapY = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(&l.ah[i]), _mm256_loadu_ps(&l.bh[i])),
+                                        _mm256_and_ps(_mm256_sub_ps(by, ay), absMask));
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(overlapX, zero, _CMP_NLE_UQ),
+                                   _mm256_cmp_ps(overlapY, zero, _CMP_NLE_UQ));
+
+        __m256 useX = _mm256_cmp_ps(overlapX, overlapY, _CMP_LT_OQ);
+        __m256 signX = select8(_mm256_cmp_ps(bx, ax, _CMP_GT_OQ), one, minusOne);
+        __m256 signY = select8(_mm256_cmp_ps(by, ay, _CMP_GT_OQ), one, minusOne);
+        __m256 depth = select8(useX, overlapX, overlapY);
+        __m256 nx = select8(useX, signX, zero);
+        __m256 ny = select8(useX, zero, signY);
+        storeResult8(l, i, hit, nx, ny, depth);
+    }
+    return n;
+}
+
+DUCK_AVX2 static inline void circleAabb8(__m256 cx, __m256 cy, __m256 cr, __m256 bx, __m256 by, __m256 bhw, __m256 bhh,
+                               __m256& hit, __m256& nx, __m256& ny, __m256& depth) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 eps = _mm256_set1_ps(0.0001f);
+    __m256 left = _mm256_sub_ps(bx, bhw);
+    __m256 right = _mm256_add_ps(bx, bhw);
+    __m256 top = _mm256_sub_ps(by, bhh);
+    __m256 bottom = _mm256_add_ps(by, bhh);
+
+    __m256 nearX = select8(_mm256_cmp_ps(cx, left, _CMP_LT_OQ), left, select8(_mm256_cmp_ps(cx, right, _CMP_GT_OQ), right, cx));
+    __m256 nearY = select8(_mm256_cmp_ps(cy, top, _CMP_LT_OQ), top, select8(_mm256_cmp_ps(cy, bottom, _CMP_GT_OQ), bottom, cy));
+    __m256 dx = _mm256_sub_ps(nearX, cx);
+    __m256 dy = _mm256_sub_ps(nearY, cy);
+    __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    hit = _mm256_cmp_ps(distSq, _mm256_mul_ps(cr, cr), _CMP_NGE_UQ);
+
+    __m256 dist = _mm256_sqrt_ps(distSq);
+    __m256 far = _mm256_cmp_ps(dist, eps, _CMP_GT_OQ);
+    __m256 outDepth = _mm256_sub_ps(cr, dist);
+    __m256 outNx = _mm256_div_ps(dx, dist);
+    __m256 outNy = _mm256_div_ps(dy, dist);
+
+    __m256 minDist = _mm256_sub_ps(cx, left);
+    __m256 inNx = one;
+    __m256 inNy = zero;
+    __m256 closer = _mm256_cmp_ps(_mm256_sub_ps(right, cx), minDist, _CMP_LT_OQ);
+    minDist = select8(closer, _mm256_sub_ps(right, cx), minDist);
+    inNx = select8(closer, minusOne, inNx);
+    inNy = select8(closer, zero, inNy);
+    closer = _mm256_cmp_ps(_mm256_sub_ps(cy, top), minDist, _CMP_LT_OQ);
+    minDist = select8(closer, _mm256_sub_ps(cy, top), minDist);
+    inNx = select8(closer, zero, inNx);
+    inNy = select8(closer, one, inNy);
+    closer = _mm256_cmp_ps(_mm256_sub_ps(bottom, cy), minDist, _CMP_LT_OQ);
+    minDist = select8(closer, _mm256_sub_ps(bottom, cy), minDist);
+    inNx = select8(closer, zero, inNx);
+    inNy = select8(closer, minusOne, inNy);
+    __m256 inDepth = _mm256_add_ps(cr, minDist);
+
+    nx = select8(far, outNx, inNx);
+    ny = select8(far, outNy, inNy);
+    depth = select8(far, outDepth, inDepth);
+}
+
+DUCK_AVX2 static size_t avx2CircleAabb(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{7});
+    for (size_t i = begin; i < n; i += 8) {
+        __m256 hit, nx, ny, depth;
+        circleAabb8(_mm256_loadu_ps(&l.ax[i]), _mm256_loadu_ps(&l.ay[i]), _mm256_loadu_ps(&l.aw[i]),
+                    _mm256_loadu_ps(&l.bx[i]), _mm256_loadu_ps(&l.by[i]), _mm256_loadu_ps(&l.bw[i]), _mm256_loadu_ps(&l.bh[i]),
+                    hit, nx, ny, depth);
+        storeResult8(l, i, hit, nx, ny, depth);
+    }
+    return n;
+}
+
+DUCK_AVX2 static size_t avx2CircleObb(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{7});
+    const __m256 zero = _mm256_setzero_ps();
+    for (size_t i = begin; i < n; i += 8) {
+        __m256 bc = _mm256_loadu_ps(&l.bc[i]);
+        __m256 bs = _mm256_loadu_ps(&l.bs[i]);
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&l.ax[i]), _mm256_loadu_ps(&l.bx[i]));
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&l.ay[i]), _mm256_loadu_ps(&l.by[i]));
+        __m256 lx = _mm256_add_ps(_mm256_mul_ps(bc, dx), _mm256_mul_ps(bs, dy));
+        __m256 ly = _mm256_sub_ps(_mm256_mul_ps(bc, dy), _mm256_mul_ps(bs, dx));
+        __m256 hit, lnx, lny, depth;
+        circleAabb8(lx, ly, _mm256_loadu_ps(&l.aw[i]), zero, zero, _mm256_loadu_ps(&l.bw[i]), _mm256_loadu_ps(&l.bh[i]),
+                    hit, lnx, lny, depth);
+        __m256 nx = _mm256_sub_ps(_mm256_mul_ps(bc, lnx), _mm256_mul_ps(bs, lny));
+        __m256 ny = _mm256_add_ps(_mm256_mul_ps(bs, lnx), _mm256_mul_ps(bc, lny));
+        storeResult8(l, i, hit, nx, ny, depth);
+    }
+    return n;
+}
+
+DUCK_AVX2 static size_t avx2ObbObb(Lanes& l, size_t begin, size_t end) {
+    const size_t n = begin + ((end - begin) & ~size_t{7});
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    for (size_t i = begin; i < n; i += 8) {
+        __m256 ahw = _mm256_loadu_ps(&l.aw[i]);
+        __m256 ahh = _mm256_loadu_ps(&l.ah[i]);
+        __m256 ac = _mm256_loadu_ps(&l.ac[i]);
+        __m256 as = _mm256_loadu_ps(&l.as[i]);
+        __m256 bhw = _mm256_loadu_ps(&l.bw[i]);
+        __m256 bhh = _mm256_loadu_ps(&l.bh[i]);
+        __m256 bc = _mm256_loadu_ps(&l.bc[i]);
+        __m256 bs = _mm256_loadu_ps(&l.bs[i]);
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&l.bx[i]), _mm256_loadu_ps(&l.ax[i]));
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&l.by[i]), _mm256_loadu_ps(&l.ay[i]));
+        __m256 uu = _mm256_and_ps(_mm256_add_ps(_mm256_mul_ps(ac, bc), _mm256_mul_ps(as, bs)), absMask);
+        __m256 uv = _mm256_and_ps(_mm256_sub_ps(_mm256_mul_ps(as, bc), _mm256_mul_ps(ac, bs)), absMask);
+
+        __m256 distA0 = _mm256_add_ps(_mm256_mul_ps(dx, ac), _mm256_mul_ps(dy, as));
+        __m256 distA1 = _mm256_sub_ps(_mm256_mul_ps(dy, ac), _mm256_mul_ps(dx, as));
+        __m256 distB0 = _mm256_add_ps(_mm256_mul_ps(dx, bc), _mm256_mul_ps(dy, bs));
+        __m256 distB1 = _mm256_sub_ps(_mm256_mul_ps(dy, bc), _mm256_mul_ps(dx, bs));
+        __m256 overlapA0 = _mm256_sub_ps(_mm256_add_ps(ahw, _mm256_add_ps(_mm256_mul_ps(bhw, uu), _mm256_mul_ps(bhh, uv))),
+                                      _mm256_and_ps(distA0, absMask));
+        __m256 overlapA1 = _mm256_sub_ps(_mm256_add_ps(ahh, _mm256_add_ps(_mm256_mul_ps(bhw, uv), _mm256_mul_ps(bhh, uu))),
+                                      _mm256_and_ps(distA1, absMask));
+        __m256 overlapB0 = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ahw, uu), _mm256_mul_ps(ahh, uv)), bhw),
+                                      _mm256_and_ps(distB0, absMask));
+        __m256 overlapB1 = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ahw, uv), _mm256_mul_ps(ahh, uu)), bhh),
+                                      _mm256_and_ps(distB1, absMask));
+        __m256 hit = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(overlapA0, zero, _CMP_NLE_UQ), _mm256_cmp_ps(overlapA1, zero, _CMP_NLE_UQ)),
+                                _mm256_and_ps(_mm256_cmp_ps(overlapB0, zero, _CMP_NLE_UQ), _mm256_cmp_ps(overlapB1, zero, _CMP_NLE_UQ)));
+
+        __m256 depth = overlapA0, axisX = ac, axisY = as, dist = distA0;
+        __m256 closer = _mm256_cmp_ps(overlapA1, depth, _CMP_LT_OQ);
+        depth = select8(closer, overlapA1, depth);
+        axisX = select8(closer, _mm256_xor_ps(as, signMask), axisX);
+        axisY = select8(closer, ac, axisY);
+        dist = select8(closer, distA1, dist);
+        closer = _mm256_cmp_ps(overlapB0, depth, _CMP_LT_OQ);
+        depth = select8(closer, overlapB0, depth);
+        axisX = select8(closer, bc, axisX);
+        axisY = select8(closer, bs, axisY);
+        dist = select8(closer, distB0, dist);
+        closer = _mm256_cmp_ps(overlapB1, depth, _CMP_LT_OQ);
+        depth = select8(closer, overlapB1, depth);
+        axisX = select8(closer, _mm256_xor_ps(bs, signMask), axisX);
+        axisY = select8(closer, bc, axisY);
+        dist = select8(closer, distB1, dist);
+        __m256 sign = select8(_mm256_cmp_ps(dist, zero, _CMP_GT_OQ), one, minusOne);
+        storeResult8(l, i, hit, _mm256_mul_ps(axisX, sign), _mm256_mul_ps(axisY, sign), depth);
+    }
+    return n;
+}
+
+#undef DUCK_AVX2
+
+#endif // DUCK_SIMD_X86
+
+// ------------------------------------------------------------
+// NarrowPhaseBatch
+// ------------------------------------------------------------
+void Lanes::clear() {
+    ax.clear(); ay.clear(); aw.clear(); ah.clear();
+    bx.clear(); by.clear(); bw.clear(); bh.clear();
+    if (rotated) {
+        ac.clear(); as.clear(); bc.clear(); bs.clear();
+    }
+    pair.clear();
+    flip.clear();
+}
+
+void Lanes::resize(size_t count) {
+    ax.resize(count); ay.resize(count); aw.resize(count); ah.resize(count);
+    bx.resize(count); by.resize(count); bw.resize(count); bh.resize(count);
+    if (rotated) {
+        ac.resize(count); as.resize(count); bc.resize(count); bs.resize(count);
+    }
+    pair.resize(count);
+    flip.resize(count);
+    resizeOutputs();
+}
+
+void Lanes::resizeOutputs() {
+    nx.resize(size());
+    ny.resize(size());
+    depth.resize(size());
+    hit.resize(size());
+}
+
+NarrowPhaseBatch::NarrowPhaseBatch() : m_level(detectSimdLevel()) {
+    m_circleObb.rotated = true;
+    m_obbObb.rotated = true;
+}
+
+void NarrowPhaseBatch::setSimdLevel(SimdLevel level) {
+    SimdLevel supported = detectSimdLevel();
+    m_level = static_cast<int>(level) > static_cast<int>(supported) ? supported : level;
+}
+
+void NarrowPhaseBatch::reset(size_t pairCount) {
+    m_circleCircle.clear();
+    m_aabbAabb.clear();
+    m_circleAabb.clear();
+    m_circleObb.clear();
+    m_obbObb.clear();
+    m_results.assign(pairCount, Result{});
+}
+
+void NarrowPhaseBatch::addCircleCircle(std::uint32_t pair, float ax, float ay, float ar,
+                                       float bx, float by, float br) {
+    Lanes& l = m_circleCircle;
+    l.ax.push_back(ax); l.ay.push_back(ay); l.aw.push_back(ar); l.ah.push_back(ar);
+    l.bx.push_back(bx); l.by.push_back(by); l.bw.push_back(br); l.bh.push_back(br);
+    l.pair.push_back(pair);
+    l.flip.push_back(0);
+}
+
+void NarrowPhaseBatch::addAabbAabb(std::uint32_t pair, float ax, float ay, float ahw, float ahh,
+                                   float bx, float by, float bhw, float bhh) {
+    Lanes& l = m_aabbAabb;
+    l.ax.push_back(ax); l.ay.push_back(ay); l.aw.push_back(ahw); l.ah.push_back(ahh);
+    l.bx.push_back(bx); l.by.push_back(by); l.bw.push_back(bhw); l.bh.push_back(bhh);
+    l.pair.push_back(pair);
+    l.flip.push_back(0);
+}
+
+void NarrowPhaseBatch::addCircleAabb(std::uint32_t pair, float cx, float cy, float cr,
+                                     float bx, float by, float bhw, float bhh, bool flip) {
+    Lanes& l = m_circleAabb;
+    l.ax.push_back(cx); l.ay.push_back(cy); l.aw.push_back(cr); l.ah.push_back(cr);
+    l.bx.push_back(bx); l.by.push_back(by); l.bw.push_back(bhw); l.bh.push_back(bhh);
+    l.pair.push_back(pair);
+    l.flip.push_back(flip ? 1 : 0);
+}
+
+void NarrowPhaseBatch::addCircleObb(std::uint32_t pair, float cx, float cy, float cr,
+                                    float bx, float by, float bhw, float bhh, float bc, float bs, bool flip) {
+    Lanes& l = m_circleObb;
+    l.ax.push_back(cx); l.ay.push_back(cy); l.aw.push_back(cr); l.ah.push_back(cr);
+    l.bx.push_back(bx); l.by.push_back(by); l.bw.push_back(bhw); l.bh.push_back(bhh);
+    l.ac.push_back(1.0f); l.as.push_back(0.0f); l.bc.push_back(bc); l.bs.push_back(bs);
+    l.pair.push_back(pair);
+    l.flip.push_back(flip ? 1 : 0);
+}
+
+void NarrowPhaseBatch::addObbObb(std::uint32_t pair, float ax, float ay, float ahw, float ahh, float ac, float as,
+                                 float bx, float by, float bhw, float bhh, float bc, float bs) {
+    Lanes& l = m_obbObb;
+    l.ax.push_back(ax); l.ay.push_back(ay); l.aw.push_back(ahw); l.ah.push_back(ahh);
+    l.bx.push_back(bx); l.by.push_back(by); l.bw.push_back(bhw); l.bh.push_back(bhh);
+    l.ac.push_back(ac); l.as.push_back(as); l.bc.push_back(bc); l.bs.push_back(bs);
+    l.pair.push_back(pair);
+    l.flip.push_back(0);
+}
+
+void NarrowPhaseBatch::resize(size_t pairCount, size_t circleCircle, size_t aabbAabb, size_t circleAabb,
+                              size_t circleObb, size_t obbObb) {
+    m_circleCircle.resize(circleCircle);
+    m_aabbAabb.resize(aabbAabb);
+    m_circleAabb.resize(circleAabb);
+    m_circleObb.resize(circleObb);
+    m_obbObb.resize(obbObb);
+    m_results.assign(pairCount, Result{});
+}
+
+void NarrowPhaseBatch::setCircleCircle(size_t slot, std::uint32_t pair, float ax, float ay, float ar,
+                                       float bx, float by, float br) {
+    Lanes& l = m_circleCircle;
+    l.ax[slot] = ax; l.ay[slot] = ay; l.aw[slot] = ar; l.ah[slot] = ar;
+    l.bx[slot] = bx; l.by[slot] = by; l.bw[slot] = br; l.bh[slot] = br;
+    l.pair[slot] = pair;
+    l.flip[slot] = 0;
+}
+
+void NarrowPhaseBatch::setAabbAabb(size_t slot, std::uint32_t pair, float ax, float ay, float ahw, float ahh,
+                                   float bx, float by, float bhw, float bhh) {
+    Lanes& l = m_aabbAabb;
+    l.ax[slot] = ax; l.ay[slot] = ay; l.aw[slot] = ahw; l.ah[slot] = ahh;
+    l.bx[slot] = bx; l.by[slot] = by; l.bw[slot] = bhw; l.bh[slot] = bhh;
+    l.pair[slot] = pair;
+    l.flip[slot] = 0;
+}
+
+void NarrowPhaseBatch::setCircleAabb(size_t slot, std::uint32_t pair, float cx, float cy, float cr,
+                                     float bx, float by, float bhw, float bhh, bool flip) {
+    Lanes& l = m_circleAabb;
+    l.ax[slot] = cx; l.ay[slot] = cy; l.aw[slot] = cr; l.ah[slot] = cr;
+    l.bx[slot] = bx; l.by[slot] = by; l.bw[slot] = bhw; l.bh[slot] = bhh;
+    l.pair[slot] = pair;
+    l.flip[slot] = flip ? 1 : 0;
+}
+
+void NarrowPhaseBatch::setCircleObb(size_t slot, std::uint32_t pair, float cx, float cy, float cr,
+                                    float bx, float by, float bhw, float bhh, float bc, float bs, bool flip) {
+    Lanes& l = m_circleObb;
+    l.ax[slot] = cx; l.ay[slot] = cy; l.aw[slot] = cr; l.ah[slot] = cr;
+    l.bx[slot] = bx; l.by[slot] = by; l.bw[slot] = bhw; l.bh[slot] = bhh;
+    l.ac[slot] = 1.0f; l.as[slot] = 0.0f; l.bc[slot] = bc; l.bs[slot] = bs;
+    l.pair[slot] = pair;
+    l.flip[slot] = flip ? 1 : 0;
+}
+
+void NarrowPhaseBatch::setObbObb(size_t slot, std::uint32_t pair, float ax, float ay, float ahw, float ahh,
+                                 float ac, float as, float bx, float by, float bhw, float bhh, float bc, float bs) {
+    Lanes& l = m_obbObb;
+    l.ax[slot] = ax; l.ay[slot] = ay; l.aw[slot] = ahw; l.ah[slot] = ahh;
+    l.bx[slot] = bx; l.by[slot] = by; l.bw[slot] = bhw; l.bh[slot] = bhh;
+    l.ac[slot] = ac; l.as[slot] = as; l.bc[slot] = bc; l.bs[slot] = bs;
+    l.pair[slot] = pair;
+    l.flip[slot] = 0;
+}
+
+size_t NarrowPhaseBatch::laneCount() const {
+    return m_circleCircle.size() + m_aabbAabb.size() + m_circleAabb.size() + m_circleObb.size() + m_obbObb.size();
+}
+
+void NarrowPhaseBatch::run() {
+    m_circleCircle.resizeOutputs();
+    m_aabbAabb.resizeOutputs();
+    m_circleAabb.resizeOutputs();
+    m_circleObb.resizeOutputs();
+    m_obbObb.resizeOutputs();
+    run(0, laneCount());
+}
+
+void NarrowPhaseBatch::run(size_t begin, size_t end) {
+    size_t offset = 0;
+    for (Shape shape : {Shape::CircleCircle, Shape::AabbAabb, Shape::CircleAabb, Shape::CircleObb, Shape::ObbObb}) {
+        Lanes& lanes = this->lanes(shape);
+        size_t lo = begin > offset ? begin - offset : 0;
+        size_t hi = end > offset ? std::min(end - offset, lanes.size()) : 0;
+        if (lo < hi) runLanes(shape, lanes, lo, hi);
+        offset += lanes.size();
+    }
+}
+
+NarrowPhaseBatch::Lanes& NarrowPhaseBatch::lanes(Shape shape) {
+    if (shape == Shape::CircleCircle) return m_circleCircle;
+    if (shape == Shape::AabbAabb) return m_aabbAabb;
+    if (shape == Shape::CircleAabb) return m_circleAabb;
+    if (shape == Shape::CircleObb) return m_circleObb;
+    return m_obbObb;
+}
+
+// 向量 kernel 先算完整的 4 / 8 對，剩下不足一組的交給純量版；
+// 各等級逐位元相同，所以 [begin, end) 怎麼切都不影響結果
+void NarrowPhaseBatch::runLanes(Shape shape, Lanes& lanes, size_t begin, size_t end) {
+    size_t done = begin;
+#ifdef DUCK_SIMD_X86
+    if (m_level == SimdLevel::AVX2) {
+        if (shape == Shape::CircleCircle) done = avx2CircleCircle(lanes, begin, end);
+        if (shape == Shape::AabbAabb) done = avx2AabbAabb(lanes, begin, end);
+        if (shape == Shape::CircleAabb) done = avx2CircleAabb(lanes, begin, end);
+        if (shape == Shape::CircleObb) done = avx2CircleObb(lanes, begin, end);
+        if (shape == Shape::ObbObb) done = avx2ObbObb(lanes, begin, end);
+    } else if (m_level == SimdLevel::SSE2) {
+        if (shape == Shape::CircleCircle) done = sse2CircleCircle(lanes, begin, end);
+        if (shape == Shape::AabbAabb) done = sse2AabbAabb(lanes, begin, end);
+        if (shape == Shape::CircleAabb) done = sse2CircleAabb(lanes, begin, end);
+        if (shape == Shape::CircleObb) done = sse2CircleObb(lanes, begin, end);
+        if (shape == Shape::ObbObb) done = sse2ObbObb(lanes, begin, end);
+    }
+#endif
+    if (shape == Shape::CircleCircle) scalarCircleCircle(lanes, done, end);
+    if (shape == Shape::AabbAabb) scalarAabbAabb(lanes, done, end);
+    if (shape == Shape::CircleAabb) scalarCircleAabb(lanes, done, end);
+    if (shape == Shape::CircleObb) scalarCircleObb(lanes, done, end);
+    if (shape == Shape::ObbObb) scalarObbObb(lanes, done, end);
+    scatter(lanes, begin, end);
+}
+
+void NarrowPhaseBatch::scatter(const Lanes& lanes, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        if (lanes.hit[i] == 0.0f) continue;
+        Result& r = m_results[lanes.pair[i]];
+        r.hit = true;
+        r.nx = lanes.flip[i] ? -lanes.nx[i] : lanes.nx[i];
+        r.ny = lanes.flip[i] ? -lanes.ny[i] : lanes.ny[i];
+        r.depth = lanes.depth[i];
+    }
+}
+
+} // namespace duck
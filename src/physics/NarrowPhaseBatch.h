@@ -0,0 +1,125 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+// 執行期偵測到的 SIMD 指令集（由低到高）
+enum class SimdLevel {
+    Scalar,     // 非 x86 平台：直接呼叫 CollisionSystem.h 的純量函式
+    SSE2,       // x86-64 的基本配備：4 個 float 一組
+    AVX2,       // 8 個 float 一組
+};
+
+// 用 __builtin_cpu_supports 偵測目前 CPU 支援的最高等級
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// ============================================================
+// NarrowPhaseBatch — 依形狀配對分桶、SoA 排列的批次 narrow phase
+// ============================================================
+// 舊的 narrow phase 一次處理一對：每對都要依 Collider::Type 分支，
+// 各個形狀組合交錯在一起，編譯器沒辦法向量化。
+//
+// 這裡分三個階段：
+//   1. gather：CollisionSystem 把每一對的位置與尺寸依形狀組合丟進五個桶
+//      （圓 vs 圓、AABB vs AABB、圓 vs AABB、圓 vs OBB、OBB vs OBB），每個桶是 SoA：ax[]、ay[]、... 各一條陣列；
+//      兩個 OBB 桶另外帶旋轉的 cos / sin（AABB 和 OBB 相撞時 AABB 給 c = 1、s = 0）
+//   2. kernel：每個桶一次算 4（SSE2）或 8（AVX2）對，分支全部改成 mask + select，
+//      產生 hit、法向量與穿透深度
+//   3. scatter：結果依原本的配對編號寫回，CollisionSystem 再依配對順序推開
+//
+// 結果必須和 CollisionSystem.h 的純量函式逐位元相同：
+//   - 運算順序與純量版一致（先乘再加、不用 FMA）；sqrt / 除法在 IEEE 下本來就正確捨入
+//   - 比較的 NaN 行為也照抄（純量是「>= 就沒撞」，向量用 NGE 比較）
+//   - 不足一組的尾端直接呼叫純量函式
+// tests/test_collision.cpp 用隨機輸入逐一比對三種等級的結果。
+class NarrowPhaseBatch {
+public:
+    struct Result {
+        float nx = 0.0f;
+        float ny = 0.0f;
+        float depth = 0.0f;
+        bool hit = false;
+    };
+
+    NarrowPhaseBatch();
+
+    // 開始新的一批：pairCount 是配對總數，result(i) 預設為沒撞到
+    void reset(size_t pairCount);
+
+    // pair 是配對編號（result 的 index）
+    void addCircleCircle(std::uint32_t pair, float ax, float ay, float ar,
+                         float bx, float by, float br);
+    void addAabbAabb(std::uint32_t pair, float ax, float ay, float ahw, float ahh,
+                     float bx, float by, float bhw, float bhh);
+    // 圓一律放在前面；原本 A 是 AABB 時傳 flip = true，結果的法向量會反轉（和純量版的慣例一樣）
+    void addCircleAabb(std::uint32_t pair, float cx, float cy, float cr,
+                       float bx, float by, float bhw, float bhh, bool flip);
+    // OBB 的 (c, s) 是 rotation 的 cos / sin；flip 的意思和 addCircleAabb 一樣
+    void addCircleObb(std::uint32_t pair, float cx, float cy, float cr,
+                      float bx, float by, float bhw, float bhh, float bc, float bs, bool flip);
+    void addObbObb(std::uint32_t pair, float ax, float ay, float ahw, float ahh, float ac, float as,
+                   float bx, float by, float bhw, float bhh, float bc, float bs);
+
+    void run();
+
+    // 平行版的填入方式：先 resize 出各桶的大小，各執行緒再用 set* 寫進自己分到的 slot
+    void resize(size_t pairCount, size_t circleCircle, size_t aabbAabb, size_t circleAabb,
+                size_t circleObb = 0, size_t obbObb = 0);
+    void setCircleCircle(size_t slot, std::uint32_t pair, float ax, float ay, float ar,
+                         float bx, float by, float br);
+    void setAabbAabb(size_t slot, std::uint32_t pair, float ax, float ay, float ahw, float ahh,
+                     float bx, float by, float bhw, float bhh);
+    void setCircleAabb(size_t slot, std::uint32_t pair, float cx, float cy, float cr,
+                       float bx, float by, float bhw, float bhh, bool flip);
+    void setCircleObb(size_t slot, std::uint32_t pair, float cx, float cy, float cr,
+                      float bx, float by, float bhw, float bhh, float bc, float bs, bool flip);
+    void setObbObb(size_t slot, std::uint32_t pair, float ax, float ay, float ahw, float ahh, float ac, float as,
+                   float bx, float by, float bhw, float bhh, float bc, float bs);
+
+    // 所有桶依序串成一條 [0, laneCount())：run(begin, end) 只算這一段並寫回 result。
+    // 每一段寫到的 result 互不重疊，不同段可以同時交給不同執行緒
+    size_t laneCount() const;
+    void run(size_t begin, size_t end);
+
+    const Result& result(size_t pair) const { return m_results[pair]; }
+
+    // 預設是 detectSimdLevel()；設得比 CPU 支援的還高會被壓回去（測試用來比對各等級）
+    void setSimdLevel(SimdLevel level);
+    SimdLevel simdLevel() const { return m_level; }
+
+    // SoA 桶：A、B 的中心與尺寸（圓的 w = h = 半徑），以及 kernel 的輸出
+    struct Lanes {
+        std::vector<float> ax, ay, aw, ah;
+        std::vector<float> bx, by, bw, bh;
+        std::vector<float> ac, as, bc, bs;       // 旋轉的 cos / sin：只有 rotated 的桶有
+        bool rotated = false;
+        std::vector<std::uint32_t> pair;
+        std::vector<std::uint8_t> flip;
+        std::vector<float> nx, ny, depth, hit;   // hit：1.0f / 0.0f
+
+        void clear();
+        size_t size() const { return pair.size(); }
+        void resize(size_t count);
+        void resizeOutputs();
+    };
+
+private:
+    enum class Shape { CircleCircle, AabbAabb, CircleAabb, CircleObb, ObbObb };
+
+    Lanes& lanes(Shape shape);
+    void runLanes(Shape shape, Lanes& lanes, size_t begin, size_t end);
+    void scatter(const Lanes& lanes, size_t begin, size_t end);
+
+    SimdLevel m_level;
+    Lanes m_circleCircle;
+    Lanes m_aabbAabb;
+    Lanes m_circleAabb;
+    Lanes m_circleObb;
+    Lanes m_obbObb;
+    std::vector<Result> m_results;
+};
+
+} // namespace duck
@@ -0,0 +1,257 @@
+#include "physics/ProjectileManager.h"
+#include "ecs/Registry.h"
+#include "physics/CollisionWorld.h"
+#include "systems/CollisionSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define DUCK_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace duck {
+
+// ------------------------------------------------------------
+// integrate kernel：x += vx * dt、y += vy * dt、lifetime -= dt
+// 向量版一次 4 / 8 顆，回傳處理到哪裡，尾端交給純量版；
+// 先乘再加、不用 FMA，三種等級的結果逐位元相同
+// ------------------------------------------------------------
+static void scalarIntegrate(float* x, float* y, const float* vx, const float* vy, float* life,
+                            size_t begin, size_t end, float dt) {
+    for (size_t i = begin; i < end; ++i) {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        life[i] -= dt;
+    }
+}
+
+#ifdef DUCK_SIMD_X86
+
+static size_t sse2Integrate(float* x, float* y, const float* vx, const float* vy, float* life,
+                            size_t count, float dt) {
+    const __m128 step = _mm_set1_ps(dt);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(vx + i), step)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(vy + i), step)));
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), step));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t avx2Integrate(float* x, float* y, const float* vx, const float* vy, float* life,
+                            size_t count, float dt) {
+    const __m256 step = _mm256_set1_ps(dt);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), step)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(vy + i), step)));
+        _mm256_storeu_ps(life + i, _mm256_sub_ps(_mm256_loadu_ps(life + i), step));
+    }
+    return i;
+}
+
+#endif
+
+ProjectileManager::ProjectileManager() : m_level(detectSimdLevel()) {}
+
+void ProjectileManager::setSimdLevel(SimdLevel level) {
+    SimdLevel supported = detectSimdLevel();
+    m_level = static_cast<int>(level) > static_cast<int>(supported) ? supported : level;
+}
+
+ProjectileManager::ProjectileID ProjectileManager::spawn(const ProjectileSpawn& spawn) {
+    ProjectileID id = m_nextID++;
+    m_x.push_back(spawn.x);
+    m_y.push_back(spawn.y);
+    m_vx.push_back(spawn.vx);
+    m_vy.push_back(spawn.vy);
+    m_lifetime.push_back(spawn.lifetime);
+    m_radius.push_back(spawn.radius);
+    m_damage.push_back(spawn.damage);
+    m_mask.push_back(spawn.mask);
+    m_textureID.push_back(spawn.textureID);
+    m_owner.push_back(spawn.owner);
+    m_id.push_back(id);
+    return id;
+}
+
+// Swap-and-Pop，和 ComponentPool::remove 同一招：每條陣列各搬一格
+void ProjectileManager::removeAt(size_t i) {
+    size_t last = m_x.size() - 1;
+    if (i != last) {
+        m_x[i] = m_x[last];
+        m_y[i] = m_y[last];
+        m_vx[i] = m_vx[last];
+        m_vy[i] = m_vy[last];
+        m_lifetime[i] = m_lifetime[last];
+        m_radius[i] = m_radius[last];
+        m_damage[i] = m_damage[last];
+        m_mask[i] = m_mask[last];
+        m_textureID[i] = m_textureID[last];
+        m_owner[i] = m_owner[last];
+        m_id[i] = m_id[last];
+    }
+    m_x.pop_back();
+    m_y.pop_back();
+    m_vx.pop_back();
+    m_vy.pop_back();
+    m_lifetime.pop_back();
+    m_radius.pop_back();
+    m_damage.pop_back();
+    m_mask.pop_back();
+    m_textureID.pop_back();
+    m_owner.pop_back();
+    m_id.pop_back();
+}
+
+void ProjectileManager::clear() {
+    while (!m_x.empty()) removeAt(m_x.size() - 1);
+}
+
+bool ProjectileManager::contains(ProjectileID id) const {
+    return std::find(m_id.begin(), m_id.end(), id) != m_id.end();
+}
+
+void ProjectileManager::integrate(float dt) {
+    const size_t count = m_x.size();
+    size_t done = 0;
+#ifdef DUCK_SIMD_X86
+    if (m_level == SimdLevel::AVX2) {
+        done = avx2Integrate(m_x.data(), m_y.data(), m_vx.data(), m_vy.data(), m_lifetime.data(), count, dt);
+    } else if (m_level == SimdLevel::SSE2) {
+        done = sse2Integrate(m_x.data(), m_y.data(), m_vx.data(), m_vy.data(), m_lifetime.data(), count, dt);
+    }
+#endif
+    scalarIntegrate(m_x.data(), m_y.data(), m_vx.data(), m_vy.data(), m_lifetime.data(), done, count, dt);
+
+    // 由後往前移除：換過來的是最後一顆，它已經檢查過了
+    for (size_t i = count; i-- > 0;) {
+        if (m_lifetime[i] <= 0.0f) removeAt(i);
+    }
+}
+
+void ProjectileManager::sweep(Registry& registry, CollisionWorld& world, float dt,
+                              std::vector<ProjectileHit>& outHits) {
+    const size_t count = m_x.size();
+    m_lastBatches = 0;
+    m_lastCandidates = 0;
+    if (count == 0) return;
+
+    // 1. 依終點所在的格子排序（列優先，相鄰的格子在記憶體裡也相鄰）
+    //    key 只取格子座標的低 16 bits：相隔 65536 格的兩群子彈偶爾會排在同一批，
+    //    只是那一批的查詢範圍變大，結果不受影響
+    const float invCell = 1.0f / SWEEP_CELL_SIZE;
+    m_order.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto cx = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::floor(m_x[i] * invCell)));
+        auto cy = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::floor(m_y[i] * invCell)));
+        std::uint64_t key = ((cy & 0xFFFFu) << 16) | (cx & 0xFFFFu);
+        m_order[i] = (key << 32) | static_cast<std::uint64_t>(i);
+    }
+    std::sort(m_order.begin(), m_order.end());
+
+    m_hitTarget.assign(count, INVALID_ENTITY);
+    m_hitT.assign(count, 2.0f);
+
+    // 2. 同一格的子彈（最多 m_sweepBatch 顆）合成一批：
+    //    以整批掃掠範圍的聯集查一次 CollisionWorld，候選的形狀讀進 m_targets，
+    //    再逐顆子彈對這份小清單做掃掠測試
+    size_t begin = 0;
+    while (begin < count) {
+        std::uint64_t key = m_order[begin] >> 32;
+        size_t end = begin + 1;
+        while (end < count && end - begin < m_sweepBatch && (m_order[end] >> 32) == key) ++end;
+
+        Aabb area;
+        std::uint32_t masks = 0;
+        for (size_t k = begin; k < end; ++k) {
+            auto i = static_cast<size_t>(m_order[k] & 0xFFFFFFFFu);
+            float r = m_radius[i];
+            Aabb swept = aabbUnion(makeAabb(m_x[i] - m_vx[i] * dt, m_y[i] - m_vy[i] * dt, r, r),
+                                   makeAabb(m_x[i], m_y[i], r, r));
+            area = k == begin ? swept : aabbUnion(area, swept);
+            masks |= m_mask[i];
+        }
+
+        m_candidates.clear();
+        world.query(area, CollisionFilter{CollisionLayer::Projectile, masks}, m_candidates);
+        m_targets.clear();
+        for (EntityID entity : m_candidates) {
+            if (!registry.isEnabled(entity)) continue;
+            const auto& tf = registry.getComponent<Transform>(entity);
+            const auto& col = registry.getComponent<Collider>(entity);
+            Target target;
+            world.orientation(entity, target.cosR, target.sinR);
+            target.bounds = colliderBounds(tf, col, target.cosR, target.sinR);
+            target.x = tf.x;
+            target.y = tf.y;
+            target.halfW = col.halfW;
+            target.halfH = col.halfH;
+            target.radius = col.radius;
+            target.layer = col.layer;
+            target.mask = col.mask;
+            target.entity = entity;
+            target.type = col.type;
+            m_targets.push_back(target);
+        }
+        m_lastCandidates += m_targets.size();
+
+        for (size_t k = begin; k < end && !m_targets.empty(); ++k) {
+            auto i = static_cast<size_t>(m_order[k] & 0xFFFFFFFFu);
+            float r = m_radius[i];
+            float moveX = m_vx[i] * dt;
+            float moveY = m_vy[i] * dt;
+            float startX = m_x[i] - moveX;
+            float startY = m_y[i] - moveY;
+            Aabb swept = aabbUnion(makeAabb(startX, startY, r, r), makeAabb(m_x[i], m_y[i], r, r));
+            CollisionFilter filter{CollisionLayer::Projectile, m_mask[i]};
+
+            // 線段可能同時穿過好幾個候選：只算第一個碰到的（t 最小）
+            for (const Target& target : m_targets) {
+                if (!aabbOverlap(swept, target.bounds)) continue;
+                if (!filtersAccept(filter, CollisionFilter{target.layer, target.mask})) continue;
+                float t = 0.0f;
+                bool hit = false;
+                if (target.type == Collider::Type::AABB) {
+                    hit = sweptCircleVsAabb(startX, startY, moveX, moveY, r,
+                                            target.x, target.y, target.halfW, target.halfH, t);
+                } else if (target.type == Collider::Type::OBB) {
+                    hit = sweptCircleVsObb(startX, startY, moveX, moveY, r, target.x, target.y,
+                                           target.halfW, target.halfH, target.cosR, target.sinR, t);
+                } else {
+                    hit = sweptCircleVsCircle(startX, startY, moveX, moveY, r,
+                                              target.x, target.y, target.radius, t);
+                }
+                if (hit && t < m_hitT[i]) {
+                    m_hitT[i] = t;
+                    m_hitTarget[i] = target.entity;
+                }
+            }
+        }
+
+        ++m_lastBatches;
+        begin = end;
+    }
+
+    // 3. 依子彈順序輸出命中事件（和排序、分批方式無關），再由後往前移除撞到的子彈
+    for (size_t i = 0; i < count; ++i) {
+        if (m_hitTarget[i] == INVALID_ENTITY) continue;
+        float t = m_hitT[i];
+        ProjectileHit hit;
+        hit.projectile = m_id[i];
+        hit.target = m_hitTarget[i];
+        hit.owner = m_owner[i];
+        hit.damage = m_damage[i];
+        hit.x = m_x[i] - m_vx[i] * dt * (1.0f - t);
+        hit.y = m_y[i] - m_vy[i] * dt * (1.0f - t);
+        outHits.push_back(hit);
+    }
+    for (size_t i = count; i-- > 0;) {
+        if (m_hitTarget[i] != INVALID_ENTITY) removeAt(i);
+    }
+}
+
+} // namespace duck
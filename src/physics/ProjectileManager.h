@@ -0,0 +1,135 @@
+#pragma once
+#include "ecs/Components.h"
+#include "ecs/Entity.h"
+#include "physics/Aabb.h"
+#include "physics/NarrowPhaseBatch.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+class Registry;
+class CollisionWorld;
+
+// 生成一顆子彈需要的資料（WeaponSystem 從 Weapon 元件填好）
+struct ProjectileSpawn {
+    float x = 0.0f;
+    float y = 0.0f;
+    float vx = 0.0f;
+    float vy = 0.0f;
+    float lifetime = 2.0f;   // 剩餘存活時間（秒）
+    float radius = 5.0f;     // 碰撞半徑，也是畫面上的半邊長
+    float damage = 1.0f;
+    // 子彈屬於 Projectile 層；預設不打玩家自己（玩家的 Collider 在 Player 層）
+    std::uint32_t mask = CollisionLayer::All & ~CollisionLayer::Player;
+    std::uint32_t textureID = 0;
+    EntityID owner = INVALID_ENTITY;
+};
+
+// 子彈撞到固體：target 是被打中的 ECS entity，玩法邏輯（扣血、刪除）看這個
+struct ProjectileHit {
+    std::uint32_t projectile = 0;     // ProjectileManager::ProjectileID
+    EntityID target = INVALID_ENTITY;
+    EntityID owner = INVALID_ENTITY;
+    float damage = 0.0f;
+    float x = 0.0f;                   // 撞擊點（子彈中心）
+    float y = 0.0f;
+};
+
+// ============================================================
+// ProjectileManager — 子彈專用的 SoA 儲存（存在 Registry::context）
+// ============================================================
+// 原本每顆子彈都是完整的 entity（Transform + Sprite + Bullet）：
+// 生成要 create + 三次 addComponent，移動、碰撞、繪製各走一次 view，
+// 刪除又要每個 pool swap-and-pop。幾萬顆子彈時這些成本比子彈本身的運算還貴。
+//
+// 子彈沒有其他系統會看的元件，所以整個搬出 ECS：
+//   - 每個欄位一條陣列（x[]、y[]、vx[]、...），刪除用 swap-and-pop，陣列永遠是緊密的
+//   - integrate：一次 4（SSE2）/ 8（AVX2）顆的等速移動 + 壽命倒數，過期的一起移除
+//   - sweep：依所在格子排序後分批，同一格的一批子彈（最多 SWEEP_BATCH 顆）共用一次 CollisionWorld 查詢，
+//     候選的形狀只讀一次，再逐顆做掃掠測試（CollisionSystem.h 的 swept 函式）
+//   - 繪製：RenderSystem 直接走這幾條陣列送 sprite，不經過 Registry
+// 被打中的東西仍然是 entity：sweep 輸出 ProjectileHit，CollisionSystem 照原本的規則扣血。
+class ProjectileManager {
+public:
+    using ProjectileID = std::uint32_t;
+    // sweep 時的格子大小（像素）與預設每批最多幾顆
+    static constexpr float SWEEP_CELL_SIZE = 128.0f;
+    static constexpr size_t SWEEP_BATCH = 64;
+
+    ProjectileManager();
+
+    ProjectileID spawn(const ProjectileSpawn& spawn);
+
+    // 等速移動 dt，壽命歸零的子彈移除
+    void integrate(float dt);
+
+    // 每顆子彈這個 tick 的位移線段（終點是目前位置，起點往回推 v * dt）
+    // 對 world 裡的固體做掃掠測試，取最早撞到的那個寫進 outHits（依子彈順序，不清空），
+    // 撞到的子彈移除。呼叫前 world 必須已經 sync() 過。
+    void sweep(Registry& registry, CollisionWorld& world, float dt, std::vector<ProjectileHit>& outHits);
+
+    void clear();
+    size_t size() const { return m_x.size(); }
+    // 線性搜尋：只給測試 / 除錯用
+    bool contains(ProjectileID id) const;
+
+    // 繪製與除錯用的唯讀存取（index 在下一次 integrate / sweep 後就會變）
+    float x(size_t i) const { return m_x[i]; }
+    float y(size_t i) const { return m_y[i]; }
+    float radius(size_t i) const { return m_radius[i]; }
+    std::uint32_t textureID(size_t i) const { return m_textureID[i]; }
+
+    // 每批最多幾顆（1 = 每顆子彈各查一次，和舊的逐顆查詢相同；基準測試用來比較）
+    void setSweepBatchSize(size_t size) { m_sweepBatch = size > 0 ? size : 1; }
+    // 上一次 sweep 分成幾批（profiler 用）
+    size_t lastBatchCount() const { return m_lastBatches; }
+    // 上一次 sweep 各批查詢回傳的候選固體總數（除以批數 = 每次查詢的平均候選數）
+    size_t lastCandidateCount() const { return m_lastCandidates; }
+
+    // 預設是 detectSimdLevel()；設得比 CPU 支援的還高會被壓回去（測試用來比對各等級）
+    void setSimdLevel(SimdLevel level);
+    SimdLevel simdLevel() const { return m_level; }
+
+private:
+    void removeAt(size_t i);
+
+    // 候選固體的形狀，每批讀一次元件
+    struct Target {
+        Aabb bounds;
+        float x = 0.0f;
+        float y = 0.0f;
+        float halfW = 0.0f;
+        float halfH = 0.0f;
+        float radius = 0.0f;
+        float cosR = 1.0f;                // OBB 的 rotation（CollisionWorld::orientation）
+        float sinR = 0.0f;
+        std::uint32_t layer = 0;
+        std::uint32_t mask = 0;
+        EntityID entity = INVALID_ENTITY;
+        Collider::Type type = Collider::Type::Circle;
+    };
+
+    SimdLevel m_level;
+    ProjectileID m_nextID = 0;
+
+    std::vector<float> m_x, m_y, m_vx, m_vy;
+    std::vector<float> m_lifetime, m_radius, m_damage;
+    std::vector<std::uint32_t> m_mask;
+    std::vector<std::uint32_t> m_textureID;
+    std::vector<EntityID> m_owner;
+    std::vector<ProjectileID> m_id;
+
+    // sweep 的暫存
+    std::vector<std::uint64_t> m_order;   // 格子 key << 32 | index
+    std::vector<EntityID> m_candidates;
+    std::vector<Target> m_targets;
+    std::vector<EntityID> m_hitTarget;
+    std::vector<float> m_hitT;
+    size_t m_sweepBatch = SWEEP_BATCH;
+    size_t m_lastBatches = 0;
+    size_t m_lastCandidates = 0;
+};
+
+} // namespace duck
@@ -0,0 +1,270 @@
+#include "physics/SpatialHashGrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace duck {
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+    : m_cellSize(std::max(cellSize, 1.0f)), m_invCellSize(1.0f / std::max(cellSize, 1.0f)) {}
+
+bool SpatialHashGrid::isLarge(const Aabb& bounds) const {
+    float half = m_cellSize * 0.5f;
+    return (bounds.maxX - bounds.minX) * 0.5f > half || (bounds.maxY - bounds.minY) * 0.5f > half;
+}
+
+std::int32_t SpatialHashGrid::cellCoord(float v) const {
+    return static_cast<std::int32_t>(std::floor(v * m_invCellSize));
+}
+
+// 常見的 2D 空間雜湊（兩個大質數相乘後 XOR），相鄰格子會分散到不同 bucket
+std::uint32_t SpatialHashGrid::bucketOf(const CellTable& table, std::int32_t cx, std::int32_t cy) const {
+    std::uint32_t h = static_cast<std::uint32_t>(cx) * 73856093u
+                    ^ static_cast<std::uint32_t>(cy) * 19349663u;
+    return h & table.mask;
+}
+
+SpatialHashGrid::ProxyID SpatialHashGrid::insert(EntityID entity, const Aabb& bounds, bool isStatic,
+                                                 CollisionFilter filter) {
+    ProxyID id;
+    if (m_freeProxy != NULL_PROXY) {
+        id = m_freeProxy;
+        m_freeProxy = m_proxies[static_cast<size_t>(id)].index;
+    } else {
+        id = static_cast<ProxyID>(m_proxies.size());
+        m_proxies.emplace_back();
+    }
+
+    auto& ids = isStatic ? m_staticIds : m_dynamicIds;
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    p.bounds = bounds;
+    p.entity = entity;
+    p.isStatic = isStatic;
+    p.filter = filter;
+    p.index = static_cast<std::int32_t>(ids.size());
+    ids.push_back(id);
+    ++m_proxyCount;
+
+    (isStatic ? m_staticDirty : m_dynamicDirty) = true;
+    return id;
+}
+
+// Swap-and-Pop：清單最後一個搬進空位
+void SpatialHashGrid::remove(ProxyID id) {
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    auto& ids = p.isStatic ? m_staticIds : m_dynamicIds;
+    if (static_cast<size_t>(p.index) != ids.size() - 1) {
+        ids[static_cast<size_t>(p.index)] = ids.back();
+        m_proxies[static_cast<size_t>(ids.back())].index = p.index;
+    }
+    ids.pop_back();
+    (p.isStatic ? m_staticDirty : m_dynamicDirty) = true;
+
+    p.entity = INVALID_ENTITY;
+    p.index = m_freeProxy;
+    m_freeProxy = id;
+    --m_proxyCount;
+}
+
+bool SpatialHashGrid::update(ProxyID id, const Aabb& bounds) {
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    bool moved = cellCoord((p.bounds.minX + p.bounds.maxX) * 0.5f) != cellCoord((bounds.minX + bounds.maxX) * 0.5f)
+              || cellCoord((p.bounds.minY + p.bounds.maxY) * 0.5f) != cellCoord((bounds.minY + bounds.maxY) * 0.5f);
+    p.bounds = bounds;
+    m_dynamicDirty = true;
+    return moved;
+}
+
+// counting sort：數 bucket → prefix sum → 依序填入
+// bucket 數取 ≥ 2 倍物件數的 2 的冪次，平均每個 bucket 不到一格
+void SpatialHashGrid::rebuild(CellTable& table, const std::vector<ProxyID>& ids, std::vector<ProxyID>& large) {
+    large.clear();
+    std::uint32_t bucketCount = 16;
+    while (bucketCount < ids.size() * 2) bucketCount <<= 1;
+    table.mask = bucketCount - 1;
+    table.start.assign(bucketCount + 1, 0);
+
+    m_hashes.resize(ids.size());
+    size_t smallCount = 0;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        const Proxy& p = m_proxies[static_cast<size_t>(ids[i])];
+        if (isLarge(p.bounds)) {
+            large.push_back(ids[i]);
+            m_hashes[i] = bucketCount;  // 標記：不進表
+            continue;
+        }
+        std::uint32_t bucket = bucketOf(table, cellCoord((p.bounds.minX + p.bounds.maxX) * 0.5f),
+                                        cellCoord((p.bounds.minY + p.bounds.maxY) * 0.5f));
+        m_hashes[i] = bucket;
+        ++table.start[bucket + 1];
+        ++smallCount;
+    }
+    for (std::uint32_t b = 0; b < bucketCount; ++b) table.start[b + 1] += table.start[b];
+
+    // 填入時借用 m_buckets 當每個 bucket 的寫入游標
+    m_buckets.assign(table.start.begin(), table.start.end() - 1);
+    table.entries.resize(smallCount);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        std::uint32_t bucket = m_hashes[i];
+        if (bucket == bucketCount) continue;
+        const Proxy& p = m_proxies[static_cast<size_t>(ids[i])];
+        table.entries[m_buckets[bucket]++] = {p.bounds, p.entity, p.filter};
+    }
+}
+
+void SpatialHashGrid::refresh() {
+    if (m_staticDirty) {
+        rebuild(m_staticTable, m_staticIds, m_largeStatic);
+        m_staticDirty = false;
+    }
+    if (m_dynamicDirty) {
+        rebuild(m_dynamicTable, m_dynamicIds, m_largeDynamic);
+        m_dynamicDirty = false;
+    }
+}
+
+void SpatialHashGrid::collectBuckets(const CellTable& table, std::int32_t x0, std::int32_t y0,
+                                     std::int32_t x1, std::int32_t y1) {
+    m_buckets.clear();
+    std::int64_t cells = (static_cast<std::int64_t>(x1) - x0 + 1) * (static_cast<std::int64_t>(y1) - y0 + 1);
+    if (cells >= static_cast<std::int64_t>(table.mask) + 1) {
+        // 範圍比整張表還大：直接掃所有 bucket
+        for (std::uint32_t b = 0; b <= table.mask; ++b) m_buckets.push_back(b);
+        return;
+    }
+    for (std::int32_t cy = y0; cy <= y1; ++cy) {
+        for (std::int32_t cx = x0; cx <= x1; ++cx) m_buckets.push_back(bucketOf(table, cx, cy));
+    }
+    std::sort(m_buckets.begin(), m_buckets.end());
+    m_buckets.erase(std::unique(m_buckets.begin(), m_buckets.end()), m_buckets.end());
+}
+
+void SpatialHashGrid::findPairs(std::vector<BodyPair>& outPairs) {
+    refresh();
+    m_stats = BroadPhaseStats{};
+    // 直方圖看動態表：每個 bucket 一格（含空的），bucket 太擠代表格子太大或雜湊表太小
+    if (!m_dynamicTable.entries.empty()) {
+        for (std::uint32_t b = 0; b <= m_dynamicTable.mask; ++b) {
+            m_stats.addNode(m_dynamicTable.start[b + 1] - m_dynamicTable.start[b]);
+        }
+    }
+
+    // 1. 小動態 vs 小物件：依動態表的順序走（同一格的物體相鄰），各掃 3x3 格
+    //    3x3 的 9 個 bucket 用固定陣列線性去重，比 sort 便宜
+    if (!m_dynamicTable.entries.empty()) {
+        const bool hasStatic = !m_staticTable.entries.empty();
+        for (const Entry& self : m_dynamicTable.entries) {
+            std::int32_t cx = cellCoord((self.bounds.minX + self.bounds.maxX) * 0.5f);
+            std::int32_t cy = cellCoord((self.bounds.minY + self.bounds.maxY) * 0.5f);
+
+            std::uint32_t dyn[9];
+            std::uint32_t sta[9];
+            int dynCount = 0;
+            int staCount = 0;
+            for (std::int32_t dy = -1; dy <= 1; ++dy) {
+                for (std::int32_t dx = -1; dx <= 1; ++dx) {
+                    std::uint32_t b = bucketOf(m_dynamicTable, cx + dx, cy + dy);
+                    if (std::find(dyn, dyn + dynCount, b) == dyn + dynCount) dyn[dynCount++] = b;
+                    if (!hasStatic) continue;
+                    b = bucketOf(m_staticTable, cx + dx, cy + dy);
+                    if (std::find(sta, sta + staCount, b) == sta + staCount) sta[staCount++] = b;
+                }
+            }
+
+            m_stats.nodesVisited += static_cast<size_t>(dynCount + staCount);
+            for (int i = 0; i < dynCount; ++i) {
+                std::uint32_t end = m_dynamicTable.start[dyn[i] + 1];
+                m_stats.aabbTests += end - m_dynamicTable.start[dyn[i]];
+                for (std::uint32_t k = m_dynamicTable.start[dyn[i]]; k < end; ++k) {
+                    const Entry& other = m_dynamicTable.entries[k];
+                    if (other.entity <= self.entity) continue;
+                    if (!aabbOverlap(self.bounds, other.bounds)) continue;
+                    emitPair(outPairs, self.entity, other.entity, self.filter, other.filter);
+                }
+            }
+            for (int i = 0; i < staCount; ++i) {
+                std::uint32_t end = m_staticTable.start[sta[i] + 1];
+                m_stats.aabbTests += end - m_staticTable.start[sta[i]];
+                for (std::uint32_t k = m_staticTable.start[sta[i]]; k < end; ++k) {
+                    const Entry& other = m_staticTable.entries[k];
+                    if (!aabbOverlap(self.bounds, other.bounds)) continue;
+                    emitPair(outPairs, self.entity, other.entity, self.filter, other.filter);
+                }
+            }
+        }
+    }
+
+    // 2. 大物件 vs 小物件：小物件的半寬 ≤ cellSize / 2，
+    //    所以掃描範圍是大物件邊界外擴半格後覆蓋的格子
+    auto scanLarge = [&](ProxyID largeID, const CellTable& table, bool tableIsStatic) {
+        const Proxy& big = m_proxies[static_cast<size_t>(largeID)];
+        if (table.entries.empty()) return;
+        Aabb reach = aabbInflate(big.bounds, m_cellSize * 0.5f);
+        collectBuckets(table, cellCoord(reach.minX), cellCoord(reach.minY),
+                       cellCoord(reach.maxX), cellCoord(reach.maxY));
+        m_stats.nodesVisited += m_buckets.size();
+        for (std::uint32_t b : m_buckets) {
+            m_stats.aabbTests += table.start[b + 1] - table.start[b];
+            for (std::uint32_t k = table.start[b]; k < table.start[b + 1]; ++k) {
+                const Entry& other = table.entries[k];
+                if (!aabbOverlap(big.bounds, other.bounds)) continue;
+                if (tableIsStatic) {
+                    emitPair(outPairs, big.entity, other.entity, big.filter, other.filter);
+                } else if (big.isStatic || other.entity < big.entity) {
+                    emitPair(outPairs, other.entity, big.entity, other.filter, big.filter);
+                } else {
+                    emitPair(outPairs, big.entity, other.entity, big.filter, other.filter);
+                }
+            }
+        }
+    };
+    for (ProxyID id : m_largeDynamic) {
+        scanLarge(id, m_dynamicTable, false);
+        scanLarge(id, m_staticTable, true);
+    }
+    for (ProxyID id : m_largeStatic) scanLarge(id, m_dynamicTable, false);
+
+    // 3. 大物件 vs 大物件：數量很少，直接兩兩比
+    for (size_t i = 0; i < m_largeDynamic.size(); ++i) {
+        const Proxy& a = m_proxies[static_cast<size_t>(m_largeDynamic[i])];
+        for (size_t j = i + 1; j < m_largeDynamic.size(); ++j) {
+            const Proxy& b = m_proxies[static_cast<size_t>(m_largeDynamic[j])];
+            ++m_stats.aabbTests;
+            if (!aabbOverlap(a.bounds, b.bounds)) continue;
+            if (a.entity < b.entity) {
+                emitPair(outPairs, a.entity, b.entity, a.filter, b.filter);
+            } else {
+                emitPair(outPairs, b.entity, a.entity, b.filter, a.filter);
+            }
+        }
+        for (ProxyID staticID : m_largeStatic) {
+            const Proxy& b = m_proxies[static_cast<size_t>(staticID)];
+            ++m_stats.aabbTests;
+            if (aabbOverlap(a.bounds, b.bounds)) emitPair(outPairs, a.entity, b.entity, a.filter, b.filter);
+        }
+    }
+}
+
+void SpatialHashGrid::query(const Aabb& area, std::vector<EntityID>& outEntities) {
+    refresh();
+
+    Aabb reach = aabbInflate(area, m_cellSize * 0.5f);
+    for (const CellTable* table : {&m_staticTable, &m_dynamicTable}) {
+        if (table->entries.empty()) continue;
+        collectBuckets(*table, cellCoord(reach.minX), cellCoord(reach.minY),
+                       cellCoord(reach.maxX), cellCoord(reach.maxY));
+        for (std::uint32_t b : m_buckets) {
+            for (std::uint32_t k = table->start[b]; k < table->start[b + 1]; ++k) {
+                const Entry& e = table->entries[k];
+                if (aabbOverlap(area, e.bounds)) outEntities.push_back(e.entity);
+            }
+        }
+    }
+    for (const auto* large : {&m_largeStatic, &m_largeDynamic}) {
+        for (ProxyID id : *large) {
+            const Proxy& p = m_proxies[static_cast<size_t>(id)];
+            if (aabbOverlap(area, p.bounds)) outEntities.push_back(p.entity);
+        }
+    }
+}
+
+} // namespace duck
@@ -0,0 +1,110 @@
+#pragma once
+#include "ecs/Entity.h"
+#include "physics/Aabb.h"
+#include "physics/BroadPhase.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+// ============================================================
+// SpatialHashGrid — 均勻雜湊網格 broad phase
+// ============================================================
+// 競技場裡絕大多數是大小相近的圓（敵人半徑 19~24、子彈半徑 5），
+// 四叉樹的階層在這種場景幫不上忙：每次查詢都要從根往下走好幾層節點。
+// 均勻網格只需要「中心落在哪一格」+ 掃描周圍 3x3 格。
+//
+// 做法：
+//   1. 小物件（半寬/半高 ≤ cellSize / 2）只放進中心所在的那一格。
+//      兩個小物件重疊 → 中心在每個軸上相差 ≤ cellSize → 格子座標相差 ≤ 1，
+//      所以掃描 3x3 格就一定找得到，不需要把物件塞進它覆蓋的每一格
+//   2. 格子不存成 2D 陣列（世界邊界未知、可能很大），而是雜湊到 2 的冪次個 bucket，
+//      每次重建用 counting sort 排進一條連續的 entries 陣列：
+//        數每個 bucket 幾筆 → prefix sum 得到起點 → 依序填入
+//      沒有任何 per-cell 的 vector，也沒有 per-tick 的 heap 配置（陣列重複使用）
+//   3. 靜態物體和動態物體各一張表：靜態表只在靜態物體增減時重建，
+//      動態表每個 tick 重建一次（O(n)，比逐一 remove/insert 便宜）
+//   4. 大物件（超過 cellSize / 2）另外放一條清單，用覆蓋範圍掃格子；
+//      場景裡這種物件很少，不值得為它們把格子開大
+//
+// 不同格子可能雜湊到同一個 bucket：bucket 裡多出來的 entry 會被 AABB 測試剔除，
+// 同一次掃描碰到重複的 bucket 則跳過，避免同一對輸出兩次。
+class SpatialHashGrid : public BroadPhase {
+public:
+    // 預設格子大小：最大的常見 collider（敵人半徑 24 → 直徑 48）再留一點餘裕
+    static constexpr float DEFAULT_CELL_SIZE = 64.0f;
+
+    explicit SpatialHashGrid(float cellSize = DEFAULT_CELL_SIZE);
+
+    ProxyID insert(EntityID entity, const Aabb& bounds, bool isStatic, CollisionFilter filter) override;
+    void remove(ProxyID id) override;
+
+    // 只記下新邊界，動態表在下一次 findPairs / query 時整張重建
+    // 回傳 true 代表中心換了格子（統計用）
+    bool update(ProxyID id, const Aabb& bounds) override;
+
+    void findPairs(std::vector<BodyPair>& outPairs) override;
+    void query(const Aabb& area, std::vector<EntityID>& outEntities) override;
+    Aabb bounds(ProxyID id) const override { return m_proxies[static_cast<size_t>(id)].bounds; }
+    BroadPhaseType type() const override { return BroadPhaseType::HashGrid; }
+
+    float cellSize() const { return m_cellSize; }
+    size_t proxyCount() const { return m_proxyCount; }
+    size_t largeCount() const { return m_largeStatic.size() + m_largeDynamic.size(); }
+
+private:
+    struct Proxy {
+        Aabb bounds;
+        EntityID entity = INVALID_ENTITY;
+        std::int32_t index = -1;          // 在 m_staticIds / m_dynamicIds 的位置；空的 proxy 拿來串 free list
+        bool isStatic = false;
+        CollisionFilter filter;
+    };
+
+    // 表裡的一筆資料：掃描只需要邊界和 entity，放在一起讓 bucket 內保持連續
+    struct Entry {
+        Aabb bounds;
+        EntityID entity = INVALID_ENTITY;
+        CollisionFilter filter;
+    };
+
+    // counting sort 後的雜湊表：bucket i 的資料是 entries[start[i] .. start[i + 1])
+    struct CellTable {
+        std::vector<std::uint32_t> start;
+        std::vector<Entry> entries;
+        std::uint32_t mask = 0;
+    };
+
+    void rebuild(CellTable& table, const std::vector<ProxyID>& ids, std::vector<ProxyID>& large);
+    void refresh();
+    bool isLarge(const Aabb& bounds) const;
+    std::int32_t cellCoord(float v) const;
+    std::uint32_t bucketOf(const CellTable& table, std::int32_t cx, std::int32_t cy) const;
+
+    // 把格子範圍 [x0, x1] x [y0, y1] 對應的 bucket（去重後）寫進 m_buckets
+    void collectBuckets(const CellTable& table, std::int32_t x0, std::int32_t y0,
+                        std::int32_t x1, std::int32_t y1);
+
+    float m_cellSize;
+    float m_invCellSize;
+
+    std::vector<Proxy> m_proxies;
+    ProxyID m_freeProxy = NULL_PROXY;
+    size_t m_proxyCount = 0;
+    std::vector<ProxyID> m_staticIds;
+    std::vector<ProxyID> m_dynamicIds;
+
+    CellTable m_staticTable;
+    CellTable m_dynamicTable;
+    std::vector<ProxyID> m_largeStatic;
+    std::vector<ProxyID> m_largeDynamic;
+    bool m_staticDirty = false;
+    bool m_dynamicDirty = false;
+
+    // 重建與查詢的暫存，跨 tick 重複使用
+    std::vector<std::uint32_t> m_hashes;
+    std::vector<std::uint32_t> m_buckets;
+};
+
+} // namespace duck
@@ -0,0 +1,309 @@
+#include "physics/SpatialIndex.h"
+#include "ecs/Components.h"
+#include "ecs/Registry.h"
+#include "systems/CollisionSystem.h"
+#include <algorithm>
+#include <cmath>
+
+namespace duck {
+
+// 格子總數最多是 entry 數的幾倍（再多就把格子放大）
+static constexpr size_t MAX_CELLS_PER_ENTRY = 4;
+static constexpr size_t MIN_CELL_BUDGET = 64;
+
+// 圓 vs 圓 / 圓 vs 矩形；邊界相切也算重疊（和 aabbOverlap 一致）
+static bool circleTouchesCircle(float ax, float ay, float ar, float bx, float by, float br) {
+    float dx = ax - bx;
+    float dy = ay - by;
+    float r = ar + br;
+    return dx * dx + dy * dy <= r * r;
+}
+
+static bool circleTouchesBox(float cx, float cy, float r, const Aabb& box) {
+    float nearX = std::clamp(cx, box.minX, box.maxX);
+    float nearY = std::clamp(cy, box.minY, box.maxY);
+    float dx = cx - nearX;
+    float dy = cy - nearY;
+    return dx * dx + dy * dy <= r * r;
+}
+
+SpatialIndex::SpatialIndex(float cellSize)
+    : m_baseCellSize(cellSize > 0.0f ? cellSize : DEFAULT_CELL_SIZE), m_cellSize(m_baseCellSize) {}
+
+void SpatialIndex::clear() {
+    m_entries.clear();
+    m_cellStart.assign(1, 0);
+    m_cellEntries.clear();
+    m_columns = 0;
+    m_rows = 0;
+    m_built = false;
+}
+
+void SpatialIndex::addEntry(EntityID entity, float x, float y, float halfW, float halfH, bool isCircle,
+                            std::uint32_t layer) {
+    Entry entry;
+    entry.bounds = makeAabb(x, y, halfW, halfH);
+    entry.x = x;
+    entry.y = y;
+    entry.halfW = halfW;
+    entry.halfH = halfH;
+    entry.layer = layer;
+    entry.entity = entity;
+    entry.isCircle = isCircle;
+    m_entries.push_back(entry);
+}
+
+int SpatialIndex::cellX(float x) const {
+    float c = std::floor((x - m_originX) / m_cellSize);
+    return static_cast<int>(std::clamp(c, 0.0f, static_cast<float>(m_columns - 1)));
+}
+
+int SpatialIndex::cellY(float y) const {
+    float c = std::floor((y - m_originY) / m_cellSize);
+    return static_cast<int>(std::clamp(c, 0.0f, static_cast<float>(m_rows - 1)));
+}
+
+void SpatialIndex::rebuild(Registry& registry) {
+    clear();
+    m_built = true;
+
+    // 1. 快照：一個 entity 一筆，依 EnemyState、Collider pool 的順序（結果因此是決定性的）
+    //    只收 m_layers 裡的層：沒人查的層（例如掉落物）整個跳過，Collider 那一輪只多讀一次 layer
+    auto* transforms = registry.findPool<Transform>();
+    if (!transforms) return;
+    auto* colliders = registry.findPool<Collider>();
+    auto* enemies = registry.findPool<EnemyState>();
+
+    auto addShape = [&](EntityID entity, const Transform& tf, const Collider& col, std::uint32_t layer) {
+        if (col.type == Collider::Type::Circle) {
+            addEntry(entity, tf.x, tf.y, col.radius, col.radius, true, layer);
+        } else if (col.type == Collider::Type::OBB) {
+            // 旋轉矩形用外接的 AABB 代替：查詢會偏保守（角落外的小三角也算碰到）
+            Aabb box = makeRotatedAabb(tf.x, tf.y, col.halfW, col.halfH, std::cos(tf.rotation), std::sin(tf.rotation));
+            addEntry(entity, tf.x, tf.y, (box.maxX - box.minX) * 0.5f, (box.maxY - box.minY) * 0.5f, false, layer);
+        } else {
+            addEntry(entity, tf.x, tf.y, col.halfW, col.halfH, false, layer);
+        }
+    };
+
+    // 敵人不管 Collider 放在哪一層，都查得到 Enemy 層（EnemySystem 只查這層）；沒有 Collider 的是一個點
+    if (enemies && (m_layers & CollisionLayer::Enemy) != 0) {
+        for (EntityID entity : enemies->entities()) {
+            if (!registry.isEnabled(entity) || !transforms->has(entity)) continue;
+            const Transform& tf = transforms->get(entity);
+            if (colliders && colliders->has(entity)) {
+                const Collider& col = colliders->get(entity);
+                addShape(entity, tf, col, col.layer | CollisionLayer::Enemy);
+            } else {
+                addEntry(entity, tf.x, tf.y, 0.0f, 0.0f, true, CollisionLayer::Enemy);
+            }
+        }
+    }
+    if (colliders) {
+        const auto& entities = colliders->entities();
+        const auto& components = colliders->components();
+        for (size_t i = 0; i < entities.size(); ++i) {
+            const Collider& col = components[i];
+            if ((col.layer & m_layers) == 0) continue;
+            EntityID entity = entities[i];
+            if (!registry.isEnabled(entity) || !transforms->has(entity)) continue;
+            bool enemy = enemies && enemies->has(entity);
+            if (enemy && (m_layers & CollisionLayer::Enemy) != 0) continue;   // 上面已經收過
+            addShape(entity, transforms->get(entity), col, enemy ? col.layer | CollisionLayer::Enemy : col.layer);
+        }
+    }
+    if (m_entries.empty()) return;
+
+    // 2. 網格範圍 = 所有 entry 的聯集；格子太多就放大（稀疏的大地圖不會配出一大片空格）
+    Aabb all = m_entries[0].bounds;
+    for (const Entry& entry : m_entries) all = aabbUnion(all, entry.bounds);
+    m_originX = all.minX;
+    m_originY = all.minY;
+    size_t budget = std::max(MIN_CELL_BUDGET, m_entries.size() * MAX_CELLS_PER_ENTRY);
+    m_cellSize = m_baseCellSize;
+    for (;;) {
+        double columns = std::floor((all.maxX - all.minX) / m_cellSize) + 1.0;
+        double rows = std::floor((all.maxY - all.minY) / m_cellSize) + 1.0;
+        if (columns * rows <= static_cast<double>(budget)) {
+            m_columns = static_cast<int>(columns);
+            m_rows = static_cast<int>(rows);
+            break;
+        }
+        m_cellSize *= 2.0f;
+    }
+
+    // 3. CSR：先數每格幾筆，前綴和變成起點，再填一次
+    size_t cellCount = static_cast<size_t>(m_columns) * static_cast<size_t>(m_rows);
+    m_cellStart.assign(cellCount + 1, 0);
+    for (const Entry& entry : m_entries) {
+        int x0 = cellX(entry.bounds.minX), x1 = cellX(entry.bounds.maxX);
+        int y0 = cellY(entry.bounds.minY), y1 = cellY(entry.bounds.maxY);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) ++m_cellStart[cellIndex(cx, cy) + 1];
+        }
+    }
+    for (size_t c = 0; c < cellCount; ++c) m_cellStart[c + 1] += m_cellStart[c];
+    m_cellEntries.resize(m_cellStart[cellCount]);
+    std::vector<std::uint32_t> cursor(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        const Entry& entry = m_entries[i];
+        int x0 = cellX(entry.bounds.minX), x1 = cellX(entry.bounds.maxX);
+        int y0 = cellY(entry.bounds.minY), y1 = cellY(entry.bounds.maxY);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                m_cellEntries[cursor[cellIndex(cx, cy)]++] = static_cast<std::uint32_t>(i);
+            }
+        }
+    }
+}
+
+// 跨好幾格的 entry 只在「它和查詢範圍重疊的第一格」交出一次，
+// 不需要 visited 標記，查詢因此可以是 const 的
+template <typename Func>
+void SpatialIndex::visitArea(const Aabb& area, std::uint32_t layers, Func&& func) const {
+    if (m_columns == 0) return;
+    int qx0 = cellX(area.minX), qx1 = cellX(area.maxX);
+    int qy0 = cellY(area.minY), qy1 = cellY(area.maxY);
+    for (int cy = qy0; cy <= qy1; ++cy) {
+        for (int cx = qx0; cx <= qx1; ++cx) {
+            size_t cell = cellIndex(cx, cy);
+            for (std::uint32_t k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k) {
+                const Entry& entry = m_entries[m_cellEntries[k]];
+                if ((entry.layer & layers) == 0 || !aabbOverlap(entry.bounds, area)) continue;
+                if (std::max(cellX(entry.bounds.minX), qx0) != cx) continue;
+                if (std::max(cellY(entry.bounds.minY), qy0) != cy) continue;
+                func(entry);
+            }
+        }
+    }
+}
+
+void SpatialIndex::queryAabb(const Aabb& area, std::uint32_t layers, std::vector<EntityID>& out) const {
+    visitArea(area, layers, [&](const Entry& entry) {
+        if (entry.isCircle && !circleTouchesBox(entry.x, entry.y, entry.halfW, area)) return;
+        out.push_back(entry.entity);
+    });
+}
+
+void SpatialIndex::queryRadius(float x, float y, float radius, std::uint32_t layers,
+                               std::vector<EntityID>& out) const {
+    visitArea(makeAabb(x, y, radius, radius), layers, [&](const Entry& entry) {
+        bool hit = entry.isCircle ? circleTouchesCircle(x, y, radius, entry.x, entry.y, entry.halfW)
+                                  : circleTouchesBox(x, y, radius, entry.bounds);
+        if (hit) out.push_back(entry.entity);
+    });
+}
+
+// 由查詢點所在的格子一圈一圈往外走（Chebyshev 距離 d 的那一圈）。
+// 每個 entry 只在「中心所在的格子」被考慮，所以不會重複；
+// 走完第 d 圈後，還沒走的格子離查詢點至少 d 格，第 k 近的距離比這更近就可以停了。
+void SpatialIndex::queryNearest(float x, float y, size_t k, std::uint32_t layers,
+                                std::vector<SpatialNeighbor>& out) const {
+    if (k == 0 || m_columns == 0) return;
+    const size_t first = out.size();
+
+    // 查詢點可能在網格外：用沒有 clamp 的格子座標（再限制在 int 範圍內）
+    const float limit = 1.0e6f;
+    int qx = static_cast<int>(std::clamp(std::floor((x - m_originX) / m_cellSize), -limit, limit));
+    int qy = static_cast<int>(std::clamp(std::floor((y - m_originY) / m_cellSize), -limit, limit));
+    int startRing = std::max({0, -qx, qx - (m_columns - 1), -qy, qy - (m_rows - 1)});
+    int lastRing = std::max({qx, m_columns - 1 - qx, qy, m_rows - 1 - qy});
+
+    auto visitCell = [&](int cx, int cy) {
+        size_t cell = cellIndex(cx, cy);
+        for (std::uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+            const Entry& entry = m_entries[m_cellEntries[i]];
+            if ((entry.layer & layers) == 0) continue;
+            if (cellX(entry.x) != cx || cellY(entry.y) != cy) continue;
+            float dx = entry.x - x;
+            float dy = entry.y - y;
+            out.push_back(SpatialNeighbor{entry.entity, dx * dx + dy * dy});
+        }
+    };
+    auto closer = [](const SpatialNeighbor& a, const SpatialNeighbor& b) {
+        return a.distSq != b.distSq ? a.distSq < b.distSq : a.entity < b.entity;
+    };
+
+    for (int d = startRing; d <= lastRing; ++d) {
+        int y0 = std::max(qy - d, 0), y1 = std::min(qy + d, m_rows - 1);
+        for (int cy = y0; cy <= y1; ++cy) {
+            if (cy == qy - d || cy == qy + d) {
+                int x0 = std::max(qx - d, 0), x1 = std::min(qx + d, m_columns - 1);
+                for (int cx = x0; cx <= x1; ++cx) visitCell(cx, cy);
+            } else {
+                if (qx - d >= 0 && qx - d < m_columns) visitCell(qx - d, cy);
+                if (d > 0 && qx + d >= 0 && qx + d < m_columns) visitCell(qx + d, cy);
+            }
+        }
+
+        size_t found = out.size() - first;
+        if (found < k) continue;
+        auto kth = out.begin() + static_cast<std::ptrdiff_t>(first + k - 1);
+        std::nth_element(out.begin() + static_cast<std::ptrdiff_t>(first), kth, out.end(), closer);
+        float reach = static_cast<float>(d) * m_cellSize;
+        if (kth->distSq <= reach * reach) break;
+    }
+
+    std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), closer);
+    if (out.size() - first > k) out.resize(first + k);
+}
+
+// 逐列走：線段（外擴 radius）落在第 cy 列的那一段決定這一列要看哪幾格
+void SpatialIndex::querySegment(float x0, float y0, float x1, float y1, float radius, std::uint32_t layers,
+                                std::vector<SpatialSegmentHit>& out) const {
+    if (m_columns == 0) return;
+    const size_t first = out.size();
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+
+    Aabb swept = aabbInflate(Aabb{std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1)}, radius);
+    int rowBegin = cellY(swept.minY), rowEnd = cellY(swept.maxY);
+    for (int cy = rowBegin; cy <= rowEnd; ++cy) {
+        // 這一列（含 radius 外擴）對應的 t 範圍；第一列 / 最後一列延伸到無限遠，網格外的部分也算進來
+        float bandMin = cy == 0 ? -INFINITY : m_originY + static_cast<float>(cy) * m_cellSize - radius;
+        float bandMax = cy == m_rows - 1 ? INFINITY : m_originY + static_cast<float>(cy + 1) * m_cellSize + radius;
+        float tMin = 0.0f;
+        float tMax = 1.0f;
+        if (dy != 0.0f) {
+            float ta = (bandMin - y0) / dy;
+            float tb = (bandMax - y0) / dy;
+            if (ta > tb) std::swap(ta, tb);
+            tMin = std::max(tMin, ta);
+            tMax = std::min(tMax, tb);
+            if (tMin > tMax) continue;
+        } else if (y0 < bandMin || y0 > bandMax) {
+            continue;
+        }
+        float xa = x0 + dx * tMin;
+        float xb = x0 + dx * tMax;
+        int colBegin = cellX(std::min(xa, xb) - radius), colEnd = cellX(std::max(xa, xb) + radius);
+
+        for (int cx = colBegin; cx <= colEnd; ++cx) {
+            size_t cell = cellIndex(cx, cy);
+            for (std::uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+                const Entry& entry = m_entries[m_cellEntries[i]];
+                if ((entry.layer & layers) == 0 || !aabbOverlap(entry.bounds, swept)) continue;
+                float t = 0.0f;
+                bool hit = entry.isCircle
+                    ? sweptCircleVsCircle(x0, y0, dx, dy, radius, entry.x, entry.y, entry.halfW, t)
+                    : sweptCircleVsAabb(x0, y0, dx, dy, radius, entry.x, entry.y, entry.halfW, entry.halfH, t);
+                if (hit) out.push_back(SpatialSegmentHit{entry.entity, t});
+            }
+        }
+    }
+
+    // 跨格的 entry 可能被收到好幾次（t 都一樣）：依 entity 去重後再依 t 排序
+    auto begin = out.begin() + static_cast<std::ptrdiff_t>(first);
+    std::sort(begin, out.end(), [](const SpatialSegmentHit& a, const SpatialSegmentHit& b) {
+        return a.entity < b.entity;
+    });
+    out.erase(std::unique(begin, out.end(), [](const SpatialSegmentHit& a, const SpatialSegmentHit& b) {
+        return a.entity == b.entity;
+    }), out.end());
+    std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(),
+              [](const SpatialSegmentHit& a, const SpatialSegmentHit& b) {
+                  return a.t != b.t ? a.t < b.t : a.entity < b.entity;
+              });
+}
+
+} // namespace duck
@@ -0,0 +1,113 @@
+#pragma once
+#include "ecs/Entity.h"
+#include "physics/Aabb.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+class Registry;
+
+// k-nearest 的結果：distSq 是查詢點到 entity 中心的距離平方
+struct SpatialNeighbor {
+    EntityID entity = INVALID_ENTITY;
+    float distSq = 0.0f;
+};
+
+// 線段查詢的結果：t 是線段上第一次碰到的位置（0 = 起點、1 = 終點）
+struct SpatialSegmentHit {
+    EntityID entity = INVALID_ENTITY;
+    float t = 0.0f;
+};
+
+// ============================================================
+// SpatialIndex — 每個 fixed tick 建一次、所有系統共用的空間查詢（存在 Registry::context）
+// ============================================================
+// CollisionWorld 只收 Collider，查詢也只給 CollisionSystem 用（撿東西改走它的 trigger 事件）；
+// 敵人找玩家這類「某個點附近有誰」的問題原本各自掃一遍 view。
+// 這裡把場上的東西快照成一張均勻網格，大家查同一份：
+//   - 有 Collider：Collider 的形狀，層是 Collider::layer（solid 與否都收；有 EnemyState 的另外加上 Enemy）
+//   - 沒有 Collider 的 EnemyState：一個點，層是 CollisionLayer::Enemy
+// 只收 setLayers() 指定的層（預設全部）：Engine 只留有人查的層，掉落物這種大量、
+// 沒人查的東西（撿東西走 CollisionWorld 的 trigger）不進網格，重建成本不隨它們的數量長。
+//
+// 記憶體排列（CSR）：每格的 entry index 連續放在 m_cellEntries，
+// m_cellStart[c] .. m_cellStart[c + 1] 是第 c 格的範圍；跨好幾格的 entry 每格各記一次。
+// 格子範圍取所有 entry 的聯集，格子總數超過 entry 數的幾倍時自動把格子放大。
+//
+// 快照語意：rebuild() 之後移動 / 新增 / 刪除的 entity 要等下一次 rebuild() 才看得到。
+// Engine 在每個 fixed tick 開頭 rebuild 一次；查詢結果可能包含這個 tick 稍後被刪掉的
+// entity，需要時呼叫端自己檢查 alive。單獨跑系統（測試）時用 ensureBuilt() 在第一次用到時建。
+//
+// 所有查詢都寫進呼叫端提供的 buffer（不清空，接在後面）；查詢是 const 的，
+// 不碰任何內部暫存，可以從多條執行緒同時呼叫。
+class SpatialIndex {
+public:
+    static constexpr float DEFAULT_CELL_SIZE = 64.0f;
+
+    explicit SpatialIndex(float cellSize = DEFAULT_CELL_SIZE);
+
+    void rebuild(Registry& registry);
+    // 下一次 rebuild 起只收這些層（查別的層會查不到東西）
+    void setLayers(std::uint32_t layers) { m_layers = layers; }
+    std::uint32_t layers() const { return m_layers; }
+    // 還沒建過才建（給沒有 Engine 驅動的呼叫端）
+    void ensureBuilt(Registry& registry) {
+        if (!m_built) rebuild(registry);
+    }
+    bool built() const { return m_built; }
+    void clear();
+
+    // 形狀和 area 重疊、且 layer & layers != 0 的 entity
+    void queryAabb(const Aabb& area, std::uint32_t layers, std::vector<EntityID>& out) const;
+    // 形狀和圓 (x, y, radius) 重疊的 entity（radius = 0 就是「包含這個點」）
+    void queryRadius(float x, float y, float radius, std::uint32_t layers, std::vector<EntityID>& out) const;
+    // 中心離 (x, y) 最近的 k 個，依距離排序（同距離依 EntityID）
+    void queryNearest(float x, float y, size_t k, std::uint32_t layers, std::vector<SpatialNeighbor>& out) const;
+    // 半徑 radius 的圓沿線段 (x0, y0) → (x1, y1) 掃過會碰到的 entity，依 t 排序（同 t 依 EntityID）
+    void querySegment(float x0, float y0, float x1, float y1, float radius, std::uint32_t layers,
+                      std::vector<SpatialSegmentHit>& out) const;
+
+    size_t size() const { return m_entries.size(); }
+    size_t cellCount() const { return m_cellStart.empty() ? 0 : m_cellStart.size() - 1; }
+    float cellSize() const { return m_cellSize; }
+
+private:
+    struct Entry {
+        Aabb bounds;
+        float x = 0.0f;
+        float y = 0.0f;
+        float halfW = 0.0f;               // 圓：半徑；矩形：半寬
+        float halfH = 0.0f;
+        std::uint32_t layer = 0;
+        EntityID entity = INVALID_ENTITY;
+        bool isCircle = true;
+    };
+
+    void addEntry(EntityID entity, float x, float y, float halfW, float halfH, bool isCircle, std::uint32_t layer);
+    // area 範圍內、層相符的 entry 各交給 func(const Entry&) 一次（只在 SpatialIndex.cpp 裡用）
+    template <typename Func>
+    void visitArea(const Aabb& area, std::uint32_t layers, Func&& func) const;
+    // 世界座標 → 格子座標（clamp 在網格內）
+    int cellX(float x) const;
+    int cellY(float y) const;
+    size_t cellIndex(int cx, int cy) const {
+        return static_cast<size_t>(cy) * static_cast<size_t>(m_columns) + static_cast<size_t>(cx);
+    }
+
+    float m_baseCellSize;
+    float m_cellSize;
+    float m_originX = 0.0f;
+    float m_originY = 0.0f;
+    int m_columns = 0;
+    int m_rows = 0;
+    bool m_built = false;
+    std::uint32_t m_layers = ~0u;
+
+    std::vector<Entry> m_entries;
+    std::vector<std::uint32_t> m_cellStart;   // 長度 = 格子數 + 1
+    std::vector<std::uint32_t> m_cellEntries;
+};
+
+} // namespace duck
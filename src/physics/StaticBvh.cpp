@@ -0,0 +1,111 @@
+#include "physics/StaticBvh.h"
+#include <algorithm>
+
+namespace duck {
+
+StaticBvh::ItemID StaticBvh::insert(EntityID entity, const Aabb& bounds, CollisionFilter filter) {
+    ItemID id;
+    if (m_freeItem != NULL_ITEM) {
+        id = m_freeItem;
+        m_freeItem = m_items[id].packed;
+    } else {
+        id = static_cast<ItemID>(m_items.size());
+        m_items.emplace_back();
+    }
+    m_items[id] = {bounds, entity, -1, filter};
+    ++m_count;
+    m_dirty = true;
+    return id;
+}
+
+void StaticBvh::remove(ItemID id) {
+    Item& item = m_items[id];
+    // 已經在樹裡：葉節點那一格標成空的，樹的形狀不變
+    if (item.packed >= 0) {
+        m_packed[item.packed].entity = INVALID_ENTITY;
+        ++m_tombstones;
+        // 空格超過一半：下次 build() 時順便壓縮
+        if (m_tombstones * 2 > m_packed.size()) m_dirty = true;
+    }
+    item.entity = INVALID_ENTITY;
+    item.packed = m_freeItem;
+    m_freeItem = id;
+    --m_count;
+}
+
+void StaticBvh::build() {
+    if (!m_dirty) return;
+    m_dirty = false;
+    m_tombstones = 0;
+
+    m_packed.clear();
+    m_nodes.clear();
+    for (size_t i = 0; i < m_items.size(); ++i) {
+        if (m_items[i].entity == INVALID_ENTITY) continue;
+        m_packed.push_back({m_items[i].bounds, m_items[i].entity, static_cast<ItemID>(i), m_items[i].filter});
+    }
+    if (m_packed.empty()) return;
+
+    // 完全平衡的樹：節點數固定是 2 * 葉數 - 1
+    m_nodes.reserve(2 * (m_packed.size() / LEAF_SIZE + 1));
+    buildNode(0, static_cast<std::uint32_t>(m_packed.size()));
+
+    for (size_t i = 0; i < m_packed.size(); ++i) {
+        m_items[m_packed[i].item].packed = static_cast<std::int32_t>(i);
+    }
+}
+
+std::uint32_t StaticBvh::buildNode(std::uint32_t begin, std::uint32_t end) {
+    auto index = static_cast<std::uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    Aabb bounds = m_packed[begin].bounds;
+    for (std::uint32_t i = begin + 1; i < end; ++i) bounds = aabbUnion(bounds, m_packed[i].bounds);
+    m_nodes[index].bounds = bounds;
+
+    if (end - begin <= LEAF_SIZE) {
+        m_nodes[index].first = begin;
+        m_nodes[index].count = end - begin;
+        return index;
+    }
+
+    // 以物件中心的範圍選切割軸（比用節點邊界穩定：一面大牆不會把軸帶偏）
+    float minCx = m_packed[begin].bounds.minX + m_packed[begin].bounds.maxX;
+    float maxCx = minCx;
+    float minCy = m_packed[begin].bounds.minY + m_packed[begin].bounds.maxY;
+    float maxCy = minCy;
+    for (std::uint32_t i = begin + 1; i < end; ++i) {
+        float cx = m_packed[i].bounds.minX + m_packed[i].bounds.maxX;
+        float cy = m_packed[i].bounds.minY + m_packed[i].bounds.maxY;
+        minCx = std::min(minCx, cx);
+        maxCx = std::max(maxCx, cx);
+        minCy = std::min(minCy, cy);
+        maxCy = std::max(maxCy, cy);
+    }
+    bool splitX = (maxCx - minCx) >= (maxCy - minCy);
+
+    std::uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(m_packed.begin() + begin, m_packed.begin() + mid, m_packed.begin() + end,
+                     [splitX](const Packed& a, const Packed& b) {
+                         return splitX ? (a.bounds.minX + a.bounds.maxX) < (b.bounds.minX + b.bounds.maxX)
+                                       : (a.bounds.minY + a.bounds.maxY) < (b.bounds.minY + b.bounds.maxY);
+                     });
+
+    buildNode(begin, mid);                // 左子節點：index + 1
+    std::uint32_t right = buildNode(mid, end);
+    m_nodes[index].first = right;
+    m_nodes[index].count = 0;
+    return index;
+}
+
+void StaticBvh::query(const Aabb& area, std::vector<EntityID>& outEntities) const {
+    query(area, [&](EntityID entity) { outEntities.push_back(entity); });
+}
+
+bool StaticBvh::rootBounds(Aabb& out) const {
+    if (m_nodes.empty()) return false;
+    out = m_nodes[0].bounds;
+    return true;
+}
+
+} // namespace duck
@@ -0,0 +1,174 @@
+#pragma once
+#include "ecs/Entity.h"
+#include "physics/Aabb.h"
+#include "physics/BroadPhase.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+// ============================================================
+// StaticBvh — 靜態 collider 專用、一次建好的扁平 BVH
+// ============================================================
+// 地圖上的石頭（MapLoader::createObstacle、壓測的石頭格子）沒有 RigidBody，永遠不動。
+// 把它們和動態物體放在同一個 broad phase 裡，每個 tick 的配對掃描都要順便走過它們；
+// 分開之後：
+//   - 動態 vs 動態：留給可替換的 BroadPhase（四叉樹 / 網格 / sap）
+//   - 動態 vs 靜態：每個動態物體拿自己的邊界查這棵 BVH
+//   - 靜態 vs 靜態：這棵樹從來不拿自己查自己
+//
+// 記憶體排列：
+//   - 節點是一條 vector<Node>，深度優先排列：左子節點一定緊接在父節點後面，
+//     只需要存右子節點的 index，一個節點 24 bytes
+//   - 葉節點的物件（邊界 + entity）依樹的順序連續存放，走到葉節點時讀的是同一段記憶體
+//
+// 建樹：沿物件中心範圍最長的軸取中位數切開（nth_element），葉節點最多 LEAF_SIZE 個。
+// 地圖載入後建一次；之後新增靜態物體只標記 dirty，下一次 build() 整棵重建。
+// 移除（可破壞的牆被打爆）不重建：直接把葉節點裡那一格標成空的，查詢時跳過；
+// 空格超過一半才在下一次 build() 壓縮。
+class StaticBvh {
+public:
+    using ItemID = std::int32_t;
+    static constexpr ItemID NULL_ITEM = -1;
+    static constexpr std::uint32_t LEAF_SIZE = 4;
+
+    ItemID insert(EntityID entity, const Aabb& bounds, CollisionFilter filter = {});
+    void remove(ItemID id);
+
+    // dirty 時重建整棵樹（沒有變動就什麼都不做）
+    void build();
+    bool dirty() const { return m_dirty; }
+
+    // 邊界與 area 重疊的 entity 交給 func(EntityID)；呼叫前必須 build() 過
+    template <typename Func>
+    void query(const Aabb& area, Func&& func) const {
+        visit(area, [&](EntityID entity, const CollisionFilter&) { func(entity); });
+    }
+
+    // 同上，但只交出和 filter 相容的物件；被 layer / mask 濾掉的數量加進 pruned
+    template <typename Func>
+    void query(const Aabb& area, const CollisionFilter& filter, size_t& pruned, Func&& func) const {
+        visit(area, [&](EntityID entity, const CollisionFilter& other) {
+            if (filtersAccept(filter, other)) {
+                func(entity);
+            } else {
+                ++pruned;
+            }
+        });
+    }
+
+    // 寫進 out（不清空 out）
+    void query(const Aabb& area, std::vector<EntityID>& outEntities) const;
+
+    // 線段 (ox, oy) → (ox + dx, oy + dy)：邊界被線段碰到、且和 filter 相容的物件交給 func(EntityID)。
+    // 子節點依進入時間由近到遠走，進入時間超過 tLimit 的整棵子樹跳過；tLimit 以參照傳入，
+    // func 找到更近的命中時由呼叫端縮短它，後面的節點就剔除得更多（射線查詢用）
+    template <typename Func>
+    void raycast(float ox, float oy, float dx, float dy, const CollisionFilter& filter,
+                 const float& tLimit, Func&& func) const {
+        if (m_nodes.empty()) return;
+        const float invDx = rayInverse(dx);
+        const float invDy = rayInverse(dy);
+        if (segmentEnterAabb(ox, oy, invDx, invDy, m_nodes[0].bounds, tLimit) > tLimit) return;
+        // 堆疊裡同時記下進入時間：彈出時 tLimit 可能已經縮短，不必重算 slab 就能剔除
+        std::uint32_t stack[64];
+        float enter[64];
+        int top = 0;
+        stack[top] = 0;
+        enter[top++] = 0.0f;
+        while (top > 0) {
+            --top;
+            if (enter[top] > tLimit) continue;
+            const Node& node = m_nodes[stack[top]];
+            if (node.count > 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const Packed& item = m_packed[i];
+                    if (item.entity == INVALID_ENTITY || !filtersAccept(filter, item.filter)) continue;
+                    if (segmentOverlapsAabb(ox, oy, invDx, invDy, item.bounds, tLimit)) func(item.entity);
+                }
+                continue;
+            }
+            std::uint32_t left = static_cast<std::uint32_t>(&node - m_nodes.data()) + 1;
+            std::uint32_t right = node.first;
+            float tLeft = segmentEnterAabb(ox, oy, invDx, invDy, m_nodes[left].bounds, tLimit);
+            float tRight = segmentEnterAabb(ox, oy, invDx, invDy, m_nodes[right].bounds, tLimit);
+            // 遠的先壓、近的後壓（先彈出）
+            if (tLeft > tRight) {
+                std::swap(left, right);
+                std::swap(tLeft, tRight);
+            }
+            if (tRight <= tLimit) {
+                stack[top] = right;
+                enter[top++] = tRight;
+            }
+            if (tLeft <= tLimit) {
+                stack[top] = left;
+                enter[top++] = tLeft;
+            }
+        }
+    }
+
+    Aabb bounds(ItemID id) const { return m_items[id].bounds; }
+    // 上一次 build() 時所有靜態物體的範圍（空樹回傳 false）
+    bool rootBounds(Aabb& out) const;
+
+    size_t size() const { return m_count; }
+    size_t nodeCount() const { return m_nodes.size(); }
+
+private:
+    struct Node {
+        Aabb bounds;
+        std::uint32_t first = 0;          // 葉：m_packed 的起點；內部節點：右子節點 index
+        std::uint32_t count = 0;          // 葉：物件數；內部節點：0
+    };
+
+    struct Packed {
+        Aabb bounds;
+        EntityID entity = INVALID_ENTITY; // INVALID_ENTITY = 已移除，等下次重建才清掉
+        ItemID item = NULL_ITEM;
+        CollisionFilter filter;
+    };
+
+    struct Item {
+        Aabb bounds;
+        EntityID entity = INVALID_ENTITY; // INVALID_ENTITY = 空的（在 free list 上）
+        std::int32_t packed = -1;         // 在 m_packed 的位置；空的 item 拿來串 free list
+        CollisionFilter filter;
+    };
+
+    std::uint32_t buildNode(std::uint32_t begin, std::uint32_t end);
+
+    // 實際走訪：func(EntityID, const CollisionFilter&)
+    template <typename Func>
+    void visit(const Aabb& area, Func&& func) const {
+        if (m_nodes.empty()) return;
+        std::uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = m_nodes[stack[--top]];
+            if (!aabbOverlap(node.bounds, area)) continue;
+            if (node.count > 0) {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const Packed& item = m_packed[i];
+                    if (item.entity != INVALID_ENTITY && aabbOverlap(item.bounds, area)) func(item.entity, item.filter);
+                }
+                continue;
+            }
+            // 左子節點就在下一格，先處理（留在 cache 裡的機會最大）
+            stack[top++] = node.first;
+            stack[top++] = static_cast<std::uint32_t>(&node - m_nodes.data()) + 1;
+        }
+    }
+
+    std::vector<Item> m_items;
+    ItemID m_freeItem = NULL_ITEM;
+    size_t m_count = 0;
+    std::vector<Node> m_nodes;
+    std::vector<Packed> m_packed;
+    size_t m_tombstones = 0;
+    bool m_dirty = false;
+};
+
+} // namespace duck
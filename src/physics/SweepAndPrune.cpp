@@ -0,0 +1,175 @@
+#include "physics/SweepAndPrune.h"
+#include <algorithm>
+
+namespace duck {
+
+SweepAndPrune::ProxyID SweepAndPrune::insert(EntityID entity, const Aabb& bounds, bool isStatic,
+                                             CollisionFilter filter) {
+    ProxyID id;
+    if (m_freeProxy != NULL_PROXY) {
+        id = m_freeProxy;
+        m_freeProxy = m_proxies[static_cast<size_t>(id)].index;
+    } else {
+        id = static_cast<ProxyID>(m_proxies.size());
+        m_proxies.emplace_back();
+    }
+
+    SortedList& list = isStatic ? m_static : m_dynamic;
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    p.isStatic = isStatic;
+    p.index = static_cast<std::int32_t>(list.items.size());
+    list.items.push_back({bounds.minX, bounds.maxX, bounds.minY, bounds.maxY, entity, id, filter});
+    ++list.added;
+    list.dirty = true;
+    ++m_proxyCount;
+    return id;
+}
+
+void SweepAndPrune::remove(ProxyID id) {
+    Proxy& p = m_proxies[static_cast<size_t>(id)];
+    SortedList& list = p.isStatic ? m_static : m_dynamic;
+    Interval& item = list.items[static_cast<size_t>(p.index)];
+    item.entity = INVALID_ENTITY;
+    item.id = NULL_PROXY;
+    ++list.removed;
+    list.dirty = true;
+
+    p.index = m_freeProxy;
+    m_freeProxy = id;
+    --m_proxyCount;
+}
+
+bool SweepAndPrune::update(ProxyID id, const Aabb& bounds) {
+    const Proxy& p = m_proxies[static_cast<size_t>(id)];
+    SortedList& list = p.isStatic ? m_static : m_dynamic;
+    Interval& item = list.items[static_cast<size_t>(p.index)];
+    item.minX = bounds.minX;
+    item.maxX = bounds.maxX;
+    item.minY = bounds.minY;
+    item.maxY = bounds.maxY;
+    list.dirty = true;
+    return false;
+}
+
+Aabb SweepAndPrune::bounds(ProxyID id) const {
+    const Proxy& p = m_proxies[static_cast<size_t>(id)];
+    const SortedList& list = p.isStatic ? m_static : m_dynamic;
+    const Interval& item = list.items[static_cast<size_t>(p.index)];
+    return {item.minX, item.minY, item.maxX, item.maxY};
+}
+
+void SweepAndPrune::refresh(SortedList& list, bool countSwaps) {
+    if (!list.dirty) return;
+    auto& items = list.items;
+
+    if (list.removed > 0) {
+        // 穩定壓縮：保留既有順序，插入排序仍然只需要修正少量錯位
+        items.erase(std::remove_if(items.begin(), items.end(),
+                                   [](const Interval& item) { return item.id == NULL_PROXY; }),
+                    items.end());
+    }
+
+    size_t swaps = 0;
+    if (list.added * 16 > items.size()) {
+        // 新增的比例太高（地圖載入、第一次 sync），插入排序會退化，直接整體排序
+        std::sort(items.begin(), items.end(),
+                  [](const Interval& a, const Interval& b) { return a.minX < b.minX; });
+    } else {
+        for (size_t i = 1; i < items.size(); ++i) {
+            if (items[i - 1].minX <= items[i].minX) continue;
+            Interval moving = items[i];
+            size_t j = i;
+            while (j > 0 && items[j - 1].minX > moving.minX) {
+                items[j] = items[j - 1];
+                --j;
+            }
+            items[j] = moving;
+            swaps += i - j;
+        }
+    }
+    if (countSwaps) m_lastSwaps = swaps;
+
+    // 重新對應 proxy → 位置，順便算出最寬的區間
+    float maxWidth = 0.0f;
+    for (size_t i = 0; i < items.size(); ++i) {
+        m_proxies[static_cast<size_t>(items[i].id)].index = static_cast<std::int32_t>(i);
+        maxWidth = std::max(maxWidth, items[i].maxX - items[i].minX);
+    }
+    list.maxWidth = maxWidth;
+    list.added = 0;
+    list.removed = 0;
+    list.dirty = false;
+}
+
+void SweepAndPrune::refresh() {
+    refresh(m_static, false);
+    refresh(m_dynamic, true);
+}
+
+void SweepAndPrune::findPairs(std::vector<BodyPair>& outPairs) {
+    refresh();
+    m_stats = BroadPhaseStats{};
+    const auto& dyn = m_dynamic.items;
+    const auto& sta = m_static.items;
+
+    // 動態 vs 動態：往後看到 minX 超過自己的 maxX 為止
+    for (size_t i = 0; i < dyn.size(); ++i) {
+        const Interval& a = dyn[i];
+        for (size_t j = i + 1; j < dyn.size() && dyn[j].minX <= a.maxX; ++j) {
+            const Interval& b = dyn[j];
+            ++m_stats.aabbTests;
+            if (a.minY > b.maxY || b.minY > a.maxY) continue;
+            if (a.entity < b.entity) {
+                emitPair(outPairs, a.entity, b.entity, a.filter, b.filter);
+            } else {
+                emitPair(outPairs, b.entity, a.entity, b.filter, a.filter);
+            }
+        }
+    }
+
+    // 動態 vs 靜態：兩條陣列交錯前進，minX 較小（相同時動態優先）的那方往對方陣列掃
+    size_t d = 0;
+    size_t s = 0;
+    while (d < dyn.size() && s < sta.size()) {
+        if (dyn[d].minX <= sta[s].minX) {
+            const Interval& a = dyn[d];
+            for (size_t k = s; k < sta.size() && sta[k].minX <= a.maxX; ++k) {
+                const Interval& b = sta[k];
+                ++m_stats.aabbTests;
+                if (a.minY > b.maxY || b.minY > a.maxY) continue;
+                emitPair(outPairs, a.entity, b.entity, a.filter, b.filter);
+            }
+            ++d;
+        } else {
+            const Interval& b = sta[s];
+            for (size_t k = d; k < dyn.size() && dyn[k].minX <= b.maxX; ++k) {
+                const Interval& a = dyn[k];
+                ++m_stats.aabbTests;
+                if (a.minY > b.maxY || b.minY > a.maxY) continue;
+                emitPair(outPairs, a.entity, b.entity, a.filter, b.filter);
+            }
+            ++s;
+        }
+    }
+}
+
+// minX 有序但 maxX 沒有：從 area.minX - 最寬區間 開始二分搜尋，往後掃到 minX 超過 area.maxX
+void SweepAndPrune::queryList(const SortedList& list, const Aabb& area,
+                              std::vector<EntityID>& outEntities) const {
+    const auto& items = list.items;
+    float from = area.minX - list.maxWidth;
+    auto it = std::lower_bound(items.begin(), items.end(), from,
+                               [](const Interval& item, float x) { return item.minX < x; });
+    for (; it != items.end() && it->minX <= area.maxX; ++it) {
+        if (it->maxX < area.minX || it->minY > area.maxY || area.minY > it->maxY) continue;
+        outEntities.push_back(it->entity);
+    }
+}
+
+void SweepAndPrune::query(const Aabb& area, std::vector<EntityID>& outEntities) {
+    refresh();
+    queryList(m_static, area, outEntities);
+    queryList(m_dynamic, area, outEntities);
+}
+
+} // namespace duck
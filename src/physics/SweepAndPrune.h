@@ -0,0 +1,84 @@
+#pragma once
+#include "ecs/Entity.h"
+#include "physics/Aabb.h"
+#include "physics/BroadPhase.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace duck {
+
+// ============================================================
+// SweepAndPrune — 利用時間連貫性的排序掃描 broad phase
+// ============================================================
+// 物體每 tick 只移動幾個像素，沿 X 軸排好的順序在 tick 之間幾乎不變。
+// 做法：
+//   1. 每個 proxy 是一段 X 區間 [minX, maxX]（連同 Y 範圍一起存），
+//      依 minX 排序的陣列跨 tick 保留
+//   2. 每 tick 寫入新邊界後用插入排序修正順序：
+//      順序幾乎不變時插入排序接近 O(n)，只有真的交錯的物體才會搬動
+//   3. 掃描：對每個區間往後看，直到下一個的 minX 超過自己的 maxX；
+//      途中 Y 也重疊的就是候選配對。每一對只會從 minX 較小的那方被看到一次，
+//      不需要 per-entity 查詢，也不需要 hash set 去重
+//
+// 靜態和動態各一條陣列：靜態陣列只在增減時重排，掃描時動態 vs 靜態用兩條陣列
+// 交錯前進（誰的 minX 小誰負責往對方那條掃），靜態 vs 靜態完全不碰。
+//
+// 移除只先標記（entity = INVALID_ENTITY），下一次排序前整批壓縮；
+// 大量新增（例如地圖載入）時插入排序會退化成 O(n²)，改用 std::sort。
+class SweepAndPrune : public BroadPhase {
+public:
+    ProxyID insert(EntityID entity, const Aabb& bounds, bool isStatic, CollisionFilter filter) override;
+    void remove(ProxyID id) override;
+
+    // 只寫入新邊界，下一次 findPairs / query 時才插入排序
+    // 排序時才知道有沒有換位置，所以一律回傳 false（改看 lastSwapCount）
+    bool update(ProxyID id, const Aabb& bounds) override;
+
+    void findPairs(std::vector<BodyPair>& outPairs) override;
+    void query(const Aabb& area, std::vector<EntityID>& outEntities) override;
+    Aabb bounds(ProxyID id) const override;
+    BroadPhaseType type() const override { return BroadPhaseType::SweepAndPrune; }
+
+    size_t proxyCount() const { return m_proxyCount; }
+    // 上一次動態陣列插入排序搬動元素的次數（時間連貫性越好越接近 0）
+    size_t lastSwapCount() const { return m_lastSwaps; }
+
+private:
+    struct Proxy {
+        std::int32_t index = -1;          // 在所屬陣列的位置；空的 proxy 拿來串 free list
+        bool isStatic = false;
+    };
+
+    // 掃描時連續讀取的資料：X 區間放最前面，往後看的迴圈只碰得到 minX
+    struct Interval {
+        float minX = 0.0f;
+        float maxX = 0.0f;
+        float minY = 0.0f;
+        float maxY = 0.0f;
+        EntityID entity = INVALID_ENTITY;
+        ProxyID id = NULL_PROXY;
+        CollisionFilter filter;
+    };
+
+    struct SortedList {
+        std::vector<Interval> items;
+        size_t added = 0;                 // 上次排序後新增的數量
+        size_t removed = 0;               // 上次排序後標記移除的數量
+        bool dirty = false;
+        float maxWidth = 0.0f;            // 最寬的區間，範圍查詢往左多看這麼多
+    };
+
+    void refresh(SortedList& list, bool countSwaps);
+    void refresh();
+    void queryList(const SortedList& list, const Aabb& area, std::vector<EntityID>& outEntities) const;
+
+    std::vector<Proxy> m_proxies;
+    ProxyID m_freeProxy = NULL_PROXY;
+    size_t m_proxyCount = 0;
+    SortedList m_dynamic;
+    SortedList m_static;
+    size_t m_lastSwaps = 0;
+};
+
+} // namespace duck
@@ -72,7 +72,10 @@ void SpriteBatch::end() {
     m_currentTexture = 0;
 
     for (const auto& sprite : m_drawQueue) {
-        if (m_currentTexture != 0 && m_currentTexture != sprite.textureID) {
+        // 換紋理或 VBO 滿了（init 時配置 maxSprites 個）就先畫出去；
+        // 大量子彈時單一紋理的 sprite 會超過 VBO 容量
+        bool full = m_vertices.size() >= static_cast<size_t>(m_maxSprites) * 4;
+        if (m_currentTexture != 0 && (m_currentTexture != sprite.textureID || full)) {
             flush();
         }
         m_currentTexture = sprite.textureID;
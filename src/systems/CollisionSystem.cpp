@@ -1,364 +1,327 @@
 #include "systems/CollisionSystem.h"
 #include "ecs/Components.h"
-#include <algorithm>
-#include <array>
+#include "physics/CollisionValidator.h"
+#include "physics/CollisionWorld.h"
+#include "physics/ContactCache.h"
+#include "physics/ProjectileManager.h"
+#include <cmath>
 #include <cstdint>
-#include <memory>
-#include <unordered_set>
 #include <vector>
 
 namespace duck {
 
-namespace {
-
-struct Bounds {
-    float x = 0.0f;
-    float y = 0.0f;
-    float halfW = 0.0f;
-    float halfH = 0.0f;
-};
-
-struct SpatialEntry {
-    EntityID entity = INVALID_ENTITY;
-    Bounds bounds;
-};
-
-static Bounds computeBounds(const Transform& tf, const Collider& col) {
-    if (col.type == Collider::Type::Circle) {
-        return {tf.x, tf.y, col.radius, col.radius};
-    }
-    return {tf.x, tf.y, col.halfW, col.halfH};
-}
-
-static Bounds computeBulletBounds(const Transform& tf, const Bullet& bullet) {
-    return {tf.x, tf.y, bullet.radius, bullet.radius};
-}
-
-static bool boundsIntersect(const Bounds& a, const Bounds& b) {
-    return std::abs(a.x - b.x) <= (a.halfW + b.halfW)
-        && std::abs(a.y - b.y) <= (a.halfH + b.halfH);
-}
-
-static bool boundsContains(const Bounds& outer, const Bounds& inner) {
-    return (inner.x - inner.halfW) >= (outer.x - outer.halfW)
-        && (inner.x + inner.halfW) <= (outer.x + outer.halfW)
-        && (inner.y - inner.halfH) >= (outer.y - outer.halfH)
-        && (inner.y + inner.halfH) <= (outer.y + outer.halfH);
+static bool enemyCanDealTouchDamage(Registry& registry, EntityID entity) {
+    if (!registry.hasComponent<EnemyState>(entity)) return false;
+    const auto& enemy = registry.getComponent<EnemyState>(entity);
+    return enemy.state != EnemyState::State::Dead;
 }
 
-class Quadtree {
-public:
-    explicit Quadtree(const Bounds& worldBounds)
-        : m_root(std::make_unique<Node>(worldBounds, 0)) {}
-
-    void insert(const SpatialEntry& entry) {
-        insert(*m_root, entry);
-    }
-
-    void query(const Bounds& area, std::vector<EntityID>& outEntities) const {
-        query(*m_root, area, outEntities);
-    }
-
-private:
-    struct Node {
-        explicit Node(const Bounds& nodeBounds, int nodeDepth)
-            : bounds(nodeBounds), depth(nodeDepth) {}
-
-        Bounds bounds;
-        int depth = 0;
-        std::vector<SpatialEntry> entries;
-        std::array<std::unique_ptr<Node>, 4> children;
-    };
-
-    static constexpr int MAX_DEPTH = 5;
-    static constexpr int NODE_CAPACITY = 6;
-
-    static Bounds childBounds(const Bounds& parent, int index) {
-        float childHalfW = parent.halfW * 0.5f;
-        float childHalfH = parent.halfH * 0.5f;
-        float childX = parent.x + ((index % 2 == 0) ? -childHalfW : childHalfW);
-        float childY = parent.y + ((index < 2) ? -childHalfH : childHalfH);
-        return {childX, childY, childHalfW, childHalfH};
-    }
-
-    static int findContainingChild(const Node& node, const Bounds& bounds) {
-        for (int i = 0; i < 4; ++i) {
-            if (!node.children[i]) continue;
-            if (boundsContains(node.children[i]->bounds, bounds)) return i;
-        }
-        return -1;
-    }
-
-    static void subdivide(Node& node) {
-        for (int i = 0; i < 4; ++i) {
-            node.children[i] = std::make_unique<Node>(childBounds(node.bounds, i), node.depth + 1);
+// Enemy vs Player：冷卻結束就扣血，冷卻時間由 EnemySystem 遞減
+// 玩家只有一兩個：先把玩家挑出來，每個接觸事件只比對 entity id，
+// 不必對每一對（大多是敵人互擠）做 hasComponent 查詢
+static void applyTouchDamage(Registry& registry, const std::vector<EntityID>& players,
+                             const std::vector<ContactEvent>& contacts) {
+    const auto& archetypes = registry.context<EnemyArchetypeTable>();
+    for (const ContactEvent& contact : contacts) {
+        for (EntityID playerID : players) {
+            if (contact.a != playerID && contact.b != playerID) continue;
+            EntityID enemyID = contact.a == playerID ? contact.b : contact.a;
+            if (!enemyCanDealTouchDamage(registry, enemyID)) continue;
+
+            auto& enemy = registry.getComponent<EnemyState>(enemyID);
+            if (enemy.touchCooldown > 0.0f) continue;
+            const auto& arch = archetypes.get(enemy.archetype);
+            auto& playerHealth = registry.getComponent<Health>(playerID);
+            playerHealth.currentHP -= arch.touchDamage;
+            if (playerHealth.currentHP < 0.0f) playerHealth.currentHP = 0.0f;
+            enemy.touchCooldown = arch.touchInterval;
         }
     }
-
-    static void insert(Node& node, const SpatialEntry& entry) {
-        if (node.depth < MAX_DEPTH && node.entries.size() >= NODE_CAPACITY && !node.children[0]) {
-            subdivide(node);
-
-            std::vector<SpatialEntry> retained;
-            retained.reserve(node.entries.size());
-            for (const auto& existing : node.entries) {
-                int childIndex = findContainingChild(node, existing.bounds);
-                if (childIndex >= 0) {
-                    insert(*node.children[childIndex], existing);
-                } else {
-                    retained.push_back(existing);
-                }
-            }
-            node.entries = std::move(retained);
-        }
-
-        if (node.children[0]) {
-            int childIndex = findContainingChild(node, entry.bounds);
-            if (childIndex >= 0) {
-                insert(*node.children[childIndex], entry);
-                return;
-            }
-        }
-
-        node.entries.push_back(entry);
-    }
-
-    static void query(const Node& node, const Bounds& area, std::vector<EntityID>& outEntities) {
-        if (!boundsIntersect(node.bounds, area)) return;
-
-        for (const auto& entry : node.entries) {
-            if (boundsIntersect(entry.bounds, area)) {
-                outEntities.push_back(entry.entity);
-            }
-        }
-
-        for (const auto& child : node.children) {
-            if (child) query(*child, area, outEntities);
-        }
-    }
-
-    std::unique_ptr<Node> m_root;
-};
-
-static Bounds computeWorldBounds(const std::vector<SpatialEntry>& entries) {
-    if (entries.empty()) {
-        return {640.0f, 360.0f, 640.0f, 360.0f};
-    }
-
-    float minX = entries[0].bounds.x - entries[0].bounds.halfW;
-    float maxX = entries[0].bounds.x + entries[0].bounds.halfW;
-    float minY = entries[0].bounds.y - entries[0].bounds.halfH;
-    float maxY = entries[0].bounds.y + entries[0].bounds.halfH;
-
-    for (const auto& entry : entries) {
-        minX = std::min(minX, entry.bounds.x - entry.bounds.halfW);
-        maxX = std::max(maxX, entry.bounds.x + entry.bounds.halfW);
-        minY = std::min(minY, entry.bounds.y - entry.bounds.halfH);
-        maxY = std::max(maxY, entry.bounds.y + entry.bounds.halfH);
-    }
-
-    float padding = 32.0f;
-    float halfW = std::max(64.0f, (maxX - minX) * 0.5f + padding);
-    float halfH = std::max(64.0f, (maxY - minY) * 0.5f + padding);
-    return {(minX + maxX) * 0.5f, (minY + maxY) * 0.5f, halfW, halfH};
 }
 
-static std::uint64_t makePairKey(EntityID a, EntityID b) {
-    EntityID lo = std::min(a, b);
-    EntityID hi = std::max(a, b);
-    return (static_cast<std::uint64_t>(lo) << 32) | static_cast<std::uint64_t>(hi);
-}
-
-} // namespace
-
-static bool enemyCanDealTouchDamage(Registry& registry, EntityID entity) {
-    if (!registry.hasComponent<Enemy>(entity)) return false;
-    const auto& enemy = registry.getComponent<Enemy>(entity);
-    return enemy.state != Enemy::State::Dead;
-}
-
-void CollisionSystem::update(Registry& registry, float /*dt*/) {
+void CollisionSystem::update(Registry& registry, float dt) {
+    // -------------------------------------------------------
+    // 同步持久的 CollisionWorld：只處理新增的 Collider 和離開 fat bounds 的動態物體
+    // -------------------------------------------------------
+    auto& world = registry.context<CollisionWorld>();
+    world.sync(registry);
 
     // -------------------------------------------------------
-    // 收集所有有 Collider 的實體，並建立 Quadtree
+    // 1. Solid vs Solid：broad phase 直接給出不重複的候選配對，再做精確碰撞
     // -------------------------------------------------------
-    std::vector<SpatialEntry> solidEntries;
-    registry.view<Transform, Collider>([&](EntityID e) {
-        auto& col = registry.getComponent<Collider>(e);
-        if (col.isSolid) {
-            auto& tf = registry.getComponent<Transform>(e);
-            solidEntries.push_back({e, computeBounds(tf, col)});
+    m_pairs.clear();
+    world.findPairs(m_pairs);
+    if (m_validator) m_validator->processPairs(registry, world, m_pairs);
+    m_lastPruned = world.lastPrunedPairs();
+    m_stats = CollisionStats{};
+    m_stats.ticks = 1;
+    m_stats.broadPhase = world.lastBroadPhaseStats();
+    m_stats.staticPairs = world.lastStaticPairs();
+    m_stats.pairs = m_pairs.size();
+    m_stats.prunedPairs = m_lastPruned;
+
+    // 真的重疊的配對記進 ContactCache，tick 結束時得到 Begin / Stay / End 事件流
+    auto& contacts = registry.context<ContactCache>();
+    contacts.beginFrame();
+
+    // narrow phase 分成幾個階段，每個平行階段寫的資料都依配對 / 物體 index 分開，
+    // 循序階段只做依配對順序的計數 —— 結果和執行緒數量無關，逐位元相同
+    auto* transforms = registry.findPool<Transform>();
+    auto* colliders = registry.findPool<Collider>();
+    auto* rigidBodies = registry.findPool<RigidBody>();
+    const size_t pairCount = m_pairs.size();
+    m_bodies.resize(pairCount);
+
+    // (1) classify（平行）：每個 tick 只查一次 pool，之後每對只剩 SparseIndex 查表
+    m_workers.parallelFor(pairCount, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            EntityID A = m_pairs[i].a;
+            EntityID B = m_pairs[i].b;
+            PairBodies& bodies = m_bodies[i];
+            bodies.shape = PairShape::None;
+            // 停用的 entity 保留 proxy，但不參與碰撞（和 view 預設跳過停用一致）
+            if (!registry.isEnabled(A) || !registry.isEnabled(B)) continue;
+
+            bodies.tfA = &transforms->get(A);
+            bodies.tfB = &transforms->get(B);
+            bodies.colA = &colliders->get(A);
+            bodies.colB = &colliders->get(B);
+            bodies.bodyA = transforms->indexOf(A);
+            bodies.bodyB = transforms->indexOf(B);
+            bodies.aIsDynamic = rigidBodies && rigidBodies->has(A);
+            bodies.bIsDynamic = rigidBodies && rigidBodies->has(B);
+            bodies.aAsleep = world.isSleeping(A);
+            bodies.bAsleep = world.isSleeping(B);
+
+            world.orientation(A, bodies.cosA, bodies.sinA);
+            world.orientation(B, bodies.cosB, bodies.sinB);
+
+            bool aCircle = bodies.colA->type == Collider::Type::Circle;
+            bool bCircle = bodies.colB->type == Collider::Type::Circle;
+            bool aObb = bodies.colA->type == Collider::Type::OBB;
+            bool bObb = bodies.colB->type == Collider::Type::OBB;
+            if (aCircle && bCircle) bodies.shape = PairShape::CircleCircle;
+            else if (aCircle) bodies.shape = bObb ? PairShape::CircleObb : PairShape::CircleAabb;
+            else if (bCircle) bodies.shape = aObb ? PairShape::ObbCircle : PairShape::AabbCircle;
+            else bodies.shape = aObb || bObb ? PairShape::ObbObb : PairShape::AabbAabb;
         }
     });
 
-    Quadtree quadtree(computeWorldBounds(solidEntries));
-    for (const auto& entry : solidEntries) {
-        quadtree.insert(entry);
+    // (2) slot（循序）：依配對順序決定每一對在桶裡的位置
+    size_t circleCircle = 0, aabbAabb = 0, circleAabb = 0, circleObb = 0, obbObb = 0;
+    for (PairBodies& bodies : m_bodies) {
+        if (bodies.shape == PairShape::CircleCircle) bodies.slot = static_cast<std::uint32_t>(circleCircle++);
+        if (bodies.shape == PairShape::AabbAabb) bodies.slot = static_cast<std::uint32_t>(aabbAabb++);
+        if (bodies.shape == PairShape::CircleAabb || bodies.shape == PairShape::AabbCircle) {
+            bodies.slot = static_cast<std::uint32_t>(circleAabb++);
+        }
+        if (bodies.shape == PairShape::CircleObb || bodies.shape == PairShape::ObbCircle) {
+            bodies.slot = static_cast<std::uint32_t>(circleObb++);
+        }
+        if (bodies.shape == PairShape::ObbObb) bodies.slot = static_cast<std::uint32_t>(obbObb++);
     }
 
-    // -------------------------------------------------------
-    // 1. Solid vs Solid：先用 Quadtree 收斂候選，再做精確碰撞
-    // -------------------------------------------------------
-    std::unordered_set<std::uint64_t> testedPairs;
-    std::vector<EntityID> candidateEntities;
-
-    for (const auto& entryA : solidEntries) {
-        candidateEntities.clear();
-        quadtree.query(entryA.bounds, candidateEntities);
-
-        for (EntityID B : candidateEntities) {
-            EntityID A = entryA.entity;
-            if (A == B) continue;
-
-            auto pairKey = makePairKey(A, B);
-            if (!testedPairs.insert(pairKey).second) continue;
-
-            auto& tfA = registry.getComponent<Transform>(A);
-            auto& tfB = registry.getComponent<Transform>(B);
-            auto& colA = registry.getComponent<Collider>(A);
-            auto& colB = registry.getComponent<Collider>(B);
-
-            float nx = 0.0f, ny = 0.0f, depth = 0.0f;
-            bool hit = false;
-
-            // 分派到對應幾何函式
-            if (colA.type == Collider::Type::Circle && colB.type == Collider::Type::Circle) {
-                hit = circleVsCircle(tfA.x, tfA.y, colA.radius,
-                                     tfB.x, tfB.y, colB.radius,
-                                     nx, ny, depth);
-            }
-            else if (colA.type == Collider::Type::AABB && colB.type == Collider::Type::AABB) {
-                hit = aabbVsAabb(tfA.x, tfA.y, colA.halfW, colA.halfH,
-                                 tfB.x, tfB.y, colB.halfW, colB.halfH,
-                                 nx, ny, depth);
-            }
-            else {
-                // 混合：確保 Circle 在前，AABB 在後
-                if (colA.type == Collider::Type::AABB) {
-                    // A 是 AABB，B 是 Circle → 呼叫 circleVsAabb(B, A)，反轉方向
-                    hit = circleVsAabb(tfB.x, tfB.y, colB.radius,
-                                       tfA.x, tfA.y, colA.halfW, colA.halfH,
-                                       nx, ny, depth);
-                    nx = -nx;
-                    ny = -ny;
-                } else {
-                    // A 是 Circle，B 是 AABB
-                    hit = circleVsAabb(tfA.x, tfA.y, colA.radius,
-                                       tfB.x, tfB.y, colB.halfW, colB.halfH,
-                                       nx, ny, depth);
+    // 用距離場處理牆的圓形：停用的跳過（和配對的規則一樣）
+    const DistanceField& field = world.staticField();
+    m_fieldBodies.clear();
+    for (EntityID entity : world.fieldBodies()) {
+        if (!registry.isEnabled(entity)) continue;
+        m_fieldBodies.push_back({&transforms->get(entity), colliders->get(entity).radius});
+    }
+    m_fieldPushed.assign(m_fieldBodies.size(), 0);
+    m_stats.fieldBodies = m_fieldBodies.size();
+
+    // (3)–(7) 重複 m_iterations 次（relaxation）：每一輪都用上一輪推開後的位置重新 gather，
+    // 擠在一起的物體一個 tick 內就能大致分開，不必花好幾個 tick 慢慢抖開；
+    // 某一輪完全沒有重疊（也沒有物體被推出牆外）就提早結束。配對清單整個 tick 共用 broad phase 那一份。
+    m_toWake.clear();
+    const size_t bodyCount = transforms ? transforms->size() : 0;
+    for (int iteration = 0; iteration < m_iterations; ++iteration) {
+        m_batch.resize(pairCount, circleCircle, aabbAabb, circleAabb, circleObb, obbObb);
+        ++m_stats.iterations;
+        m_stats.narrowTests += circleCircle + aabbAabb + circleAabb + circleObb + obbObb;
+
+        // (3) gather（平行）：寫進 NarrowPhaseBatch 的 SoA 桶；沒進桶的配對 result 維持「沒撞到」
+        m_workers.parallelFor(pairCount, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const PairBodies& bodies = m_bodies[i];
+                if (bodies.shape == PairShape::None) continue;
+                const Transform& tfA = *bodies.tfA;
+                const Transform& tfB = *bodies.tfB;
+                auto index = static_cast<std::uint32_t>(i);
+
+                switch (bodies.shape) {
+                case PairShape::CircleCircle:
+                    m_batch.setCircleCircle(bodies.slot, index, tfA.x, tfA.y, bodies.colA->radius,
+                                            tfB.x, tfB.y, bodies.colB->radius);
+                    break;
+                case PairShape::AabbAabb:
+                    m_batch.setAabbAabb(bodies.slot, index, tfA.x, tfA.y, bodies.colA->halfW, bodies.colA->halfH,
+                                        tfB.x, tfB.y, bodies.colB->halfW, bodies.colB->halfH);
+                    break;
+                case PairShape::CircleAabb:
+                    m_batch.setCircleAabb(bodies.slot, index, tfA.x, tfA.y, bodies.colA->radius,
+                                          tfB.x, tfB.y, bodies.colB->halfW, bodies.colB->halfH, false);
+                    break;
+                case PairShape::AabbCircle:
+                    // 混合：圓一律放前面；A 是 AABB 時反轉法向量
+                    m_batch.setCircleAabb(bodies.slot, index, tfB.x, tfB.y, bodies.colB->radius,
+                                          tfA.x, tfA.y, bodies.colA->halfW, bodies.colA->halfH, true);
+                    break;
+                case PairShape::CircleObb:
+                    m_batch.setCircleObb(bodies.slot, index, tfA.x, tfA.y, bodies.colA->radius,
+                                         tfB.x, tfB.y, bodies.colB->halfW, bodies.colB->halfH,
+                                         bodies.cosB, bodies.sinB, false);
+                    break;
+                case PairShape::ObbCircle:
+                    m_batch.setCircleObb(bodies.slot, index, tfB.x, tfB.y, bodies.colB->radius,
+                                         tfA.x, tfA.y, bodies.colA->halfW, bodies.colA->halfH,
+                                         bodies.cosA, bodies.sinA, true);
+                    break;
+                case PairShape::ObbObb:
+                    m_batch.setObbObb(bodies.slot, index, tfA.x, tfA.y, bodies.colA->halfW, bodies.colA->halfH,
+                                      bodies.cosA, bodies.sinA, tfB.x, tfB.y, bodies.colB->halfW, bodies.colB->halfH,
+                                      bodies.cosB, bodies.sinB);
+                    break;
+                default:
+                    break;
                 }
             }
+        });
 
-            if (!hit) continue;
+        // (4) kernel（平行）：五個桶串成一條，每塊是 8 的倍數，向量 kernel 不會被切出尾端
+        m_workers.parallelFor(m_batch.laneCount(), PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+            m_batch.run(begin, end);
+        });
 
-            // 推生：判斷哪方是靜態（無 RigidBody）
-            bool aIsDynamic = registry.hasComponent<RigidBody>(A);
-            bool bIsDynamic = registry.hasComponent<RigidBody>(B);
-
-            if (aIsDynamic && bIsDynamic) {
-                // 雙方各推一半
-                tfA.x -= nx * depth * 0.5f;
-                tfA.y -= ny * depth * 0.5f;
-                tfB.x += nx * depth * 0.5f;
-                tfB.y += ny * depth * 0.5f;
-            } else if (aIsDynamic) {
-                // 只推 A（B 是靜態）
-                tfA.x -= nx * depth;
-                tfA.y -= ny * depth;
-            } else if (bIsDynamic) {
-                // 只推 B（A 是靜態）
-                tfB.x += nx * depth;
-                tfB.y += ny * depth;
-            }
-            // 兩者都靜態：不處理
-
-            // Enemy vs Player：接觸傷害
-            bool aIsEnemy = enemyCanDealTouchDamage(registry, A);
-            bool bIsEnemy = enemyCanDealTouchDamage(registry, B);
-            bool aIsPlayer = registry.hasComponent<InputControlled>(A);
-            bool bIsPlayer = registry.hasComponent<InputControlled>(B);
-
-            if (aIsEnemy && bIsPlayer && registry.hasComponent<Health>(B)) {
-                auto& enemy = registry.getComponent<Enemy>(A);
-                if (enemy.touchCooldown <= 0.0f) {
-                    auto& playerHealth = registry.getComponent<Health>(B);
-                    playerHealth.currentHP -= enemy.touchDamage;
-                    if (playerHealth.currentHP < 0.0f) playerHealth.currentHP = 0.0f;
-                    enemy.touchCooldown = enemy.touchInterval;
-                }
-            } else if (bIsEnemy && aIsPlayer && registry.hasComponent<Health>(A)) {
-                auto& enemy = registry.getComponent<Enemy>(B);
-                if (enemy.touchCooldown <= 0.0f) {
-                    auto& playerHealth = registry.getComponent<Health>(A);
-                    playerHealth.currentHP -= enemy.touchDamage;
-                    if (playerHealth.currentHP < 0.0f) playerHealth.currentHP = 0.0f;
-                    enemy.touchCooldown = enemy.touchInterval;
-                }
+        // 接觸事件只看第一輪（tick 開頭的位置），和沒有 relaxation 時一樣
+        if (iteration == 0) {
+            for (size_t i = 0; i < pairCount; ++i) {
+                if (m_batch.result(i).hit) contacts.touch(m_pairs[i].a, m_pairs[i].b);
             }
         }
-    }
-
-    // -------------------------------------------------------
-    // 2. Bullet vs Solid：先查 Quadtree 候選，再做精確判斷
-    // -------------------------------------------------------
-    std::vector<EntityID> bulletsToDestroy;
-    std::vector<EntityID> entitiesToDestroy;
-    std::vector<EntityID> bulletCandidates;
-
-    registry.view<Transform, Bullet>([&](EntityID bulletID) {
-        auto& btf = registry.getComponent<Transform>(bulletID);
-        auto& bullet = registry.getComponent<Bullet>(bulletID);
-        Bounds bulletBounds = computeBulletBounds(btf, bullet);
-
-        bulletCandidates.clear();
-        quadtree.query(bulletBounds, bulletCandidates);
-
-        for (EntityID solidID : bulletCandidates) {
-            // 跳過玩家（自己的子彈不消失在自己身上）
-            if (registry.hasComponent<InputControlled>(solidID)) continue;
-
-            auto& stf = registry.getComponent<Transform>(solidID);
-            auto& scol = registry.getComponent<Collider>(solidID);
 
-            float nx = 0.0f, ny = 0.0f, depth = 0.0f;
-            bool hit = false;
-
-            if (scol.type == Collider::Type::AABB) {
-                hit = circleVsAabb(btf.x, btf.y, bullet.radius,
-                                   stf.x, stf.y, scol.halfW, scol.halfH,
-                                   nx, ny, depth);
-            } else {
-                hit = circleVsCircle(btf.x, btf.y, bullet.radius,
-                                     stf.x, stf.y, scol.radius,
-                                     nx, ny, depth);
+        // (5) 依物體分組（循序）：每個動態物體收到的推開量依配對順序排成一段（CSR）
+        // 分組用 Transform 的 dense index，平行推開時每個物體只由一個執行緒寫。
+        // 睡著的物體被壓得很淺時當成靜態（不推它、也不叫醒），壓得深才叫醒並照常推開
+        m_correctionStart.assign(bodyCount + 1, 0);
+        size_t hits = 0;
+        for (size_t i = 0; i < pairCount; ++i) {
+            const NarrowPhaseBatch::Result& result = m_batch.result(i);
+            if (!result.hit) continue;
+            ++hits;
+            PairBodies& bodies = m_bodies[i];
+            bool deep = result.depth > CollisionWorld::WAKE_DEPTH;
+            bodies.pushA = bodies.aIsDynamic && (!bodies.aAsleep || deep);
+            bodies.pushB = bodies.bIsDynamic && (!bodies.bAsleep || deep);
+            if (deep && bodies.aAsleep) m_toWake.push_back(m_pairs[i].a);
+            if (deep && bodies.bAsleep) m_toWake.push_back(m_pairs[i].b);
+            if (bodies.pushA) ++m_correctionStart[bodies.bodyA + 1];
+            if (bodies.pushB) ++m_correctionStart[bodies.bodyB + 1];
+        }
+        if (iteration == 0) m_stats.hits = hits;
+        if (hits > 0) {
+            for (size_t body = 0; body < bodyCount; ++body) m_correctionStart[body + 1] += m_correctionStart[body];
+            m_corrections.resize(m_correctionStart[bodyCount]);
+            m_correctionCursor.assign(m_correctionStart.begin(), m_correctionStart.end() - 1);
+            for (size_t i = 0; i < pairCount; ++i) {
+                if (!m_batch.result(i).hit) continue;
+                const PairBodies& bodies = m_bodies[i];
+                auto entry = static_cast<std::uint32_t>(i) << 1;
+                if (bodies.pushA) m_corrections[m_correctionCursor[bodies.bodyA]++] = entry;
+                if (bodies.pushB) m_corrections[m_correctionCursor[bodies.bodyB]++] = entry | 1u;
             }
 
-            if (hit) {
-                bulletsToDestroy.push_back(bulletID);
-
-                if (registry.hasComponent<Health>(solidID)) {
-                    auto& health = registry.getComponent<Health>(solidID);
-                    health.currentHP -= bullet.damage;
-                    if (health.currentHP <= 0.0f && !registry.hasComponent<InputControlled>(solidID)
-                        && !registry.hasComponent<Enemy>(solidID)) {
-                        entitiesToDestroy.push_back(solidID);
-                    } else if (health.currentHP < 0.0f) {
-                        health.currentHP = 0.0f;
+            // (6) 推開（平行，依物體）：這一輪的幾何都以這一輪開頭的位置計算，
+            // 每個物體依配對順序累加自己的修正 —— 浮點運算順序和逐對推開的循序版完全一樣
+            m_workers.parallelFor(bodyCount, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+                for (size_t body = begin; body < end; ++body) {
+                    for (std::uint32_t k = m_correctionStart[body]; k < m_correctionStart[body + 1]; ++k) {
+                        std::uint32_t pair = m_corrections[k] >> 1;
+                        bool isB = (m_corrections[k] & 1u) != 0;
+                        const PairBodies& bodies = m_bodies[pair];
+                        const NarrowPhaseBatch::Result& result = m_batch.result(pair);
+                        // 雙方都會被推：各推一半；另一方是靜態（或睡著、壓得很淺）：只推這一方
+                        float share = (bodies.pushA && bodies.pushB) ? 0.5f : 1.0f;
+                        Transform& tf = isB ? *bodies.tfB : *bodies.tfA;
+                        if (isB) {
+                            tf.x += result.nx * result.depth * share;
+                            tf.y += result.ny * result.depth * share;
+                        } else {
+                            tf.x -= result.nx * result.depth * share;
+                            tf.y -= result.ny * result.depth * share;
+                        }
                     }
                 }
-                break;  // 一個子彈只需要刪一次
-            }
+            });
         }
-    });
 
-    // 在 view 迴圈外統一銷毀（避免邊刪邊遍歷的 UB）
-    for (EntityID e : bulletsToDestroy) {
-        if (registry.alive(e)) registry.destroy(e);
+        // (7) 推出牆外（平行，依物體）：取樣距離場一次，比半徑近就沿梯度推到剛好相切。
+        // 用的是 (6) 推開後的位置，每個物體只讀寫自己的 Transform
+        m_workers.parallelFor(m_fieldBodies.size(), PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Transform& tf = *m_fieldBodies[i].tf;
+                float gx = 0.0f, gy = 0.0f;
+                float depth = m_fieldBodies[i].radius - field.sample(tf.x, tf.y, gx, gy);
+                float len = std::sqrt(gx * gx + gy * gy);
+                m_fieldPushed[i] = depth > 0.0f && len > 0.0f;
+                if (!m_fieldPushed[i]) continue;
+                tf.x += gx / len * depth;
+                tf.y += gy / len * depth;
+            }
+        });
+        size_t fieldPushes = 0;
+        for (std::uint8_t pushed : m_fieldPushed) fieldPushes += pushed;
+        m_stats.fieldPushes += fieldPushes;
+        if (hits == 0 && fieldPushes == 0) break;
+    }
+    contacts.endFrame();
+
+    // 被壓醒的物體搬回 broad phase（下一個 tick 起照常參與配對）
+    for (EntityID entity : m_toWake) world.wake(entity);
+
+    // Trigger 用推開後的位置算重疊，Enter / Exit 事件留給 PickupSystem 等消費端
+    world.updateTriggers(registry);
+    m_stats.triggerCandidates = world.lastTriggerCandidates();
+    m_stats.triggerOverlaps = world.triggerOverlapCount();
+
+    // 接觸傷害只看這個 tick 仍在接觸的配對（Begin + Stay），整批處理
+    m_players.clear();
+    registry.view<Health, InputControlled>([&](EntityID entity) { m_players.push_back(entity); });
+    if (!m_players.empty()) {
+        applyTouchDamage(registry, m_players, contacts.begins());
+        applyTouchDamage(registry, m_players, contacts.stays());
     }
 
-    for (EntityID e : entitiesToDestroy) {
-        if (registry.alive(e)) registry.destroy(e);
+    // -------------------------------------------------------
+    // 2. 子彈 vs Solid：子彈這個 tick 的位移線段 vs 候選，取最早撞到的那個
+    // -------------------------------------------------------
+    // 子彈存在 registry.context<ProjectileManager>()（SoA，不是 entity），
+    // WeaponSystem 已經把它們移到 tick 結束的位置，sweep 往回推 v * dt 當起點。
+    // 只檢查結束位置的話，速度 900 px/s 一個 tick 就飛 15px，
+    // 更快的武器會直接穿過 20px 的障礙物；改用掃掠測試後不必為了子彈提高 tick rate。
+    // 固體用的是推開後的位置（固體一個 tick 只移動幾個像素，誤差可以忽略）。
+    m_hits.clear();
+    auto& projectiles = registry.context<ProjectileManager>();
+    projectiles.sweep(registry, world, dt, m_hits);
+    m_stats.bulletQueries = projectiles.lastBatchCount();
+    m_stats.bulletCandidates = projectiles.lastCandidateCount();
+    m_stats.bulletHits = m_hits.size();
+
+    // 命中事件依子彈順序處理；被打爆的物件收集起來，最後一次 destroyMany（每個 pool 只壓實一次）
+    std::vector<EntityID> entitiesToDestroy;
+    for (const ProjectileHit& hit : m_hits) {
+        if (!registry.hasComponent<Health>(hit.target)) continue;
+        auto& health = registry.getComponent<Health>(hit.target);
+        health.currentHP -= hit.damage;
+        if (health.currentHP <= 0.0f && !registry.hasComponent<InputControlled>(hit.target)
+            && !registry.hasComponent<EnemyState>(hit.target)) {
+            entitiesToDestroy.push_back(hit.target);
+        } else if (health.currentHP < 0.0f) {
+            health.currentHP = 0.0f;
+        }
     }
+    registry.destroyMany(entitiesToDestroy);
 }
 
 } // namespace duck
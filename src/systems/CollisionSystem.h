@@ -1,20 +1,40 @@
 #pragma once
+#include "core/WorkerPool.h"
 #include "ecs/Registry.h"
+#include "physics/CollisionWorld.h"
+#include "physics/NarrowPhaseBatch.h"
+#include "physics/ProjectileManager.h"
 #include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace duck {
 
 // ============================================================
-// CollisionSystem — Quadtree broad phase + 精確碰撞 narrow phase
+// CollisionSystem — CollisionWorld broad phase + 精確碰撞 narrow phase
 // ============================================================
+// broad phase 的結構跨 tick 保留在 registry.context<CollisionWorld>()，每個 tick 只同步有變動的部分，
+// 見 physics/CollisionWorld.h；動態物體用哪種結構由 BroadPhaseType 選（BroadPhase 介面後面的
+// 鬆散四叉樹 / 雜湊網格 / sweep and prune / 線性 BVH，見 physics/BroadPhase.h）。
+// narrow phase 依形狀組合分桶後批次計算（physics/NarrowPhaseBatch，AVX2 / SSE2），
+// 這個檔案裡的幾何函式是純量參考實作，批次版的結果和它們逐位元相同。
+// 分類、填桶、kernel、推開都在 WorkerPool 上平行跑；推開改成「依物體分組、
+// 每個物體依配對順序累加」，不同物體互不干擾，結果和執行緒數量無關。
+// 真的重疊的配對記進 registry.context<ContactCache>()，產生 Begin / Stay / End 事件流，
+// 接觸傷害等玩法邏輯整批消費事件，而不是在配對迴圈裡逐對判斷。
+//
 // Phase 2 範圍：
-//   1. Solid vs Solid：計算重疊量 → 互推開（推生）
-//   2. Bullet vs Solid：子彈進入固體範圍 → 刪除子彈
+//   1. Solid vs Solid：計算重疊量 → 互推開（推生），重複 solverIterations() 輪（relaxation）；
+//      靜止夠久的動態物體會睡著，不再參與 broad / narrow phase（見 CollisionWorld.h）
+//   2. 子彈 vs Solid：子彈這個 tick 掃過的線段碰到固體 → 刪除子彈
+//      （連續碰撞：高速子彈一個 tick 飛過的距離比薄牆還長也不會穿過去）
 //
-// 為什麼子彈不用 Collider 元件？
+// 為什麼子彈不用 Collider 元件（甚至不是 entity）？
 //   子彈生命週期極短（2 秒），數量多，若加 Collider 會讓
 //   Solid vs Solid 迴圈多跑很多不必要的比對。
-//   CollisionSystem 單獨用 Bullet.radius 做距離判斷，更清楚。
+//   子彈放在 physics/ProjectileManager 的 SoA 陣列裡，分批對固體做掃掠測試，
+//   這裡只消費它輸出的命中事件（被打中的是 entity）。
 //
 // 幾何函式全部是 inline（在 header），原因：
 //   1. 這些函式很短（5~15 行），inline 不會造成程式碼膨脹
@@ -126,12 +146,398 @@ inline bool circleVsAabb(
     return true;
 }
 
+// --------------------------------------------------
+// OBB（旋轉矩形）
+// --------------------------------------------------
+// OBB 以中心、旋轉前的半寬 / 半高和 rotation 的 cos / sin 定義；
+// 局部座標 (lx, ly) 到世界座標是 (lx·c − ly·s, lx·s + ly·c)。
+// cos / sin 由 CollisionWorld 算好（靜態物體只算一次），這裡不呼叫三角函式。
+// 把 AABB 當成 c = 1、s = 0 的 OBB 就能和 OBB 互撞。
+
+// 圓 vs OBB：圓心轉進盒子的局部座標，用 circleVsAabb，法向量再轉回世界座標
+inline bool circleVsObb(
+    float cx, float cy, float cr,
+    float bx, float by, float bhw, float bhh, float bc, float bs,
+    float& outDx, float& outDy, float& outDepth)
+{
+    float dx = cx - bx;
+    float dy = cy - by;
+    float lx = bc * dx + bs * dy;
+    float ly = bc * dy - bs * dx;
+    float lnx = 0.0f, lny = 0.0f;
+    if (!circleVsAabb(lx, ly, cr, 0.0f, 0.0f, bhw, bhh, lnx, lny, outDepth)) return false;
+    outDx = bc * lnx - bs * lny;
+    outDy = bs * lnx + bc * lny;
+    return true;
+}
+
+// OBB vs OBB：分離軸定理（SAT），候選軸是兩個盒子各自的兩個軸。
+// 兩組軸之間的 |cos|、|sin| 只有兩個值（uu、uv），投影半徑都由它們組合；
+// 每個軸的重疊量 = 兩邊投影半徑和 − 中心距離的投影，任何一軸 ≤ 0 就沒撞。
+// 推開方向取重疊最小的軸（同樣大取先出現的：A 的 x、A 的 y、B 的 x、B 的 y），方向從 A 指向 B
+inline bool obbVsObb(
+    float ax, float ay, float ahw, float ahh, float ac, float as,
+    float bx, float by, float bhw, float bhh, float bc, float bs,
+    float& outDx, float& outDy, float& outDepth)
+{
+    float dx = bx - ax;
+    float dy = by - ay;
+    float uu = std::abs(ac * bc + as * bs);
+    float uv = std::abs(as * bc - ac * bs);
+
+    // 中心距離在四個軸上的投影：A 的 x 軸 (ac, as)、y 軸 (-as, ac)，B 同理
+    float distA0 = dx * ac + dy * as;
+    float distA1 = dy * ac - dx * as;
+    float distB0 = dx * bc + dy * bs;
+    float distB1 = dy * bc - dx * bs;
+    float overlapA0 = (ahw + (bhw * uu + bhh * uv)) - std::abs(distA0);
+    float overlapA1 = (ahh + (bhw * uv + bhh * uu)) - std::abs(distA1);
+    float overlapB0 = ((ahw * uu + ahh * uv) + bhw) - std::abs(distB0);
+    float overlapB1 = ((ahw * uv + ahh * uu) + bhh) - std::abs(distB1);
+    if (overlapA0 <= 0.0f || overlapA1 <= 0.0f || overlapB0 <= 0.0f || overlapB1 <= 0.0f) return false;
+
+    float depth = overlapA0, axisX = ac, axisY = as, dist = distA0;
+    if (overlapA1 < depth) { depth = overlapA1; axisX = -as; axisY = ac; dist = distA1; }
+    if (overlapB0 < depth) { depth = overlapB0; axisX = bc;  axisY = bs; dist = distB0; }
+    if (overlapB1 < depth) { depth = overlapB1; axisX = -bs; axisY = bc; dist = distB1; }
+    float sign = dist > 0.0f ? 1.0f : -1.0f;
+    outDx = axisX * sign;
+    outDy = axisY * sign;
+    outDepth = depth;
+    return true;
+}
+
+// --------------------------------------------------
+// Swept Circle（連續碰撞）
+// --------------------------------------------------
+// 圓從 (sx, sy) 沿位移 (dx, dy) 走完一個 tick，求最早接觸的時間 t ∈ [0, 1]。
+// 把移動的圓縮成一個點、目標外擴圓的半徑（Minkowski 和），問題變成線段 vs 形狀：
+//   - 圓 vs 圓：目標變成半徑 r + cr 的圓，解一元二次方程
+//   - 圓 vs AABB：目標變成圓角矩形 = 兩個十字矩形（只往 X / 只往 Y 外擴）+ 四個角的圓，
+//     各自求進入時間取最小
+// 起點就重疊 → t = 0；相切、擦過都不算撞（和上面的離散版一致）
+
+// 點沿線段前進 vs 圓：起點在圓外才有意義
+inline bool segmentVsCircle(
+    float sx, float sy, float dx, float dy,
+    float cx, float cy, float r, float& outT)
+{
+    float mx = sx - cx;
+    float my = sy - cy;
+    float a = dx * dx + dy * dy;
+    float b = mx * dx + my * dy;
+    float c = mx * mx + my * my - r * r;
+
+    if (a <= 0.0f || b >= 0.0f) return false;  // 沒在動，或正在遠離
+    float disc = b * b - a * c;
+    if (disc <= 0.0f) return false;             // 錯過或剛好擦過
+
+    float t = (-b - std::sqrt(disc)) / a;
+    if (t > 1.0f) return false;                 // 這個 tick 還碰不到
+    outT = t < 0.0f ? 0.0f : t;
+    return true;
+}
+
+// 點沿線段前進 vs 矩形（slab 法：兩個軸的進入 / 離開時間取交集）
+inline bool segmentVsBox(
+    float sx, float sy, float dx, float dy,
+    float bx, float by, float hw, float hh, float& outT)
+{
+    float tEnter = 0.0f;
+    float tExit = 1.0f;
+    const float start[2] = {sx, sy};
+    const float delta[2] = {dx, dy};
+    const float center[2] = {bx, by};
+    const float half[2] = {hw, hh};
+
+    for (int axis = 0; axis < 2; ++axis) {
+        if (delta[axis] == 0.0f) {
+            // 這個軸不動：起點不在 slab 內就永遠碰不到
+            if (std::abs(start[axis] - center[axis]) >= half[axis]) return false;
+            continue;
+        }
+        float inv = 1.0f / delta[axis];
+        float t1 = (center[axis] - half[axis] - start[axis]) * inv;
+        float t2 = (center[axis] + half[axis] - start[axis]) * inv;
+        if (t1 > t2) std::swap(t1, t2);
+        if (t1 > tEnter) tEnter = t1;
+        if (t2 < tExit) tExit = t2;
+        if (tEnter >= tExit) return false;
+    }
+    outT = tEnter;
+    return true;
+}
+
+inline bool sweptCircleVsCircle(
+    float sx, float sy, float dx, float dy, float r,
+    float cx, float cy, float cr, float& outT)
+{
+    float mx = sx - cx;
+    float my = sy - cy;
+    float minDist = r + cr;
+    if (mx * mx + my * my < minDist * minDist) {
+        outT = 0.0f;
+        return true;
+    }
+    return segmentVsCircle(sx, sy, dx, dy, cx, cy, minDist, outT);
+}
+
+inline bool sweptCircleVsAabb(
+    float sx, float sy, float dx, float dy, float r,
+    float bx, float by, float bhw, float bhh, float& outT)
+{
+    float nx, ny, depth;
+    if (circleVsAabb(sx, sy, r, bx, by, bhw, bhh, nx, ny, depth)) {
+        outT = 0.0f;
+        return true;
+    }
+
+    float best = 2.0f;
+    float t = 0.0f;
+    if (segmentVsBox(sx, sy, dx, dy, bx, by, bhw + r, bhh, t) && t < best) best = t;
+    if (segmentVsBox(sx, sy, dx, dy, bx, by, bhw, bhh + r, t) && t < best) best = t;
+    for (float cornerX : {bx - bhw, bx + bhw}) {
+        for (float cornerY : {by - bhh, by + bhh}) {
+            if (segmentVsCircle(sx, sy, dx, dy, cornerX, cornerY, r, t) && t < best) best = t;
+        }
+    }
+    if (best > 1.0f) return false;
+    outT = best;
+    return true;
+}
+
+// 圓掃過 OBB：起點和位移轉進盒子的局部座標（旋轉不改變 t）
+inline bool sweptCircleVsObb(
+    float sx, float sy, float dx, float dy, float r,
+    float bx, float by, float bhw, float bhh, float bc, float bs, float& outT)
+{
+    float mx = sx - bx;
+    float my = sy - by;
+    return sweptCircleVsAabb(bc * mx + bs * my, bc * my - bs * mx, bc * dx + bs * dy, bc * dy - bs * dx, r,
+                             0.0f, 0.0f, bhw, bhh, outT);
+}
+
+// 一個 tick 的碰撞統計（CollisionSystem::lastStats）；Engine 的 profiler 與 benchmark
+// 用 add() 跨 tick 累加，再除以 ticks 得到每 tick 平均
+struct CollisionStats {
+    BroadPhaseStats broadPhase;       // 動態 vs 動態（CollisionWorld 的 broad phase）
+    size_t staticPairs = 0;           // 動態 vs 靜態 / 睡著（StaticBvh）輸出的配對
+    size_t pairs = 0;                 // 交給 narrow phase 的配對（上面兩者的和，不重複、已過濾）
+    size_t prunedPairs = 0;           // 因 layer / mask 被濾掉的配對（broad phase + StaticBvh）
+    size_t narrowTests = 0;           // narrow phase 的形狀測試次數（所有 relaxation 輪數加總）
+    size_t hits = 0;                  // 第一輪真的重疊的配對
+    size_t iterations = 0;            // 實際跑了幾輪 relaxation
+    size_t fieldBodies = 0;           // 改用靜態距離場處理牆的動態圓形
+    size_t fieldPushes = 0;           // 距離場把物體推出牆外的次數（所有 relaxation 輪數加總）
+    size_t bulletQueries = 0;         // 子彈 sweep 查 CollisionWorld 的次數（批數）
+    size_t bulletCandidates = 0;      // 這些查詢回傳的候選固體總數
+    size_t bulletHits = 0;
+    size_t triggerCandidates = 0;     // trigger 的形狀測試次數（見 CollisionWorld::updateTriggers）
+    size_t triggerOverlaps = 0;       // tick 結束時仍和 trigger 重疊的配對
+    size_t ticks = 0;                 // lastStats() 是 1；add() 累加過幾個 tick
+
+    void add(const CollisionStats& other) {
+        broadPhase.add(other.broadPhase);
+        staticPairs += other.staticPairs;
+        pairs += other.pairs;
+        prunedPairs += other.prunedPairs;
+        narrowTests += other.narrowTests;
+        hits += other.hits;
+        iterations += other.iterations;
+        fieldBodies += other.fieldBodies;
+        fieldPushes += other.fieldPushes;
+        bulletQueries += other.bulletQueries;
+        bulletCandidates += other.bulletCandidates;
+        bulletHits += other.bulletHits;
+        triggerCandidates += other.triggerCandidates;
+        triggerOverlaps += other.triggerOverlaps;
+        ticks += other.ticks;
+    }
+};
+
+// --------------------------------------------------
+// 射線（線段）查詢：點從 (sx, sy) 沿 (dx, dy) 前進，求第一次碰到形狀的 t ∈ [0, 1] 與命中面的法向量
+// --------------------------------------------------
+// 法向量是單位向量，指向射線來的那一側；起點就在形狀裡 → t = 0，法向量取 -d 的方向。
+// 和上面的 segmentVs* 不同，相切（擦過邊界）也算命中：視線貼著牆角掃過也算被擋住
+inline void rayBackNormal(float dx, float dy, float& outNx, float& outNy) {
+    float len = std::sqrt(dx * dx + dy * dy);
+    outNx = len > 0.0f ? -dx / len : 1.0f;
+    outNy = len > 0.0f ? -dy / len : 0.0f;
+}
+
+inline bool rayVsCircle(
+    float sx, float sy, float dx, float dy,
+    float cx, float cy, float r, float& outT, float& outNx, float& outNy)
+{
+    float mx = sx - cx;
+    float my = sy - cy;
+    float c = mx * mx + my * my - r * r;
+    if (c <= 0.0f) {
+        outT = 0.0f;
+        rayBackNormal(dx, dy, outNx, outNy);
+        return true;
+    }
+    float a = dx * dx + dy * dy;
+    float b = mx * dx + my * dy;
+    if (a <= 0.0f || b >= 0.0f) return false;  // 沒有位移，或正在遠離
+    float disc = b * b - a * c;
+    if (disc < 0.0f) return false;
+
+    float t = (-b - std::sqrt(disc)) / a;
+    if (t > 1.0f) return false;
+    outT = t;
+    outNx = (mx + dx * t) / r;
+    outNy = (my + dy * t) / r;
+    return true;
+}
+
+// slab 法；法向量是最後進入的那個軸
+inline bool rayVsBox(
+    float sx, float sy, float dx, float dy,
+    float bx, float by, float hw, float hh, float& outT, float& outNx, float& outNy)
+{
+    if (std::abs(sx - bx) < hw && std::abs(sy - by) < hh) {
+        outT = 0.0f;
+        rayBackNormal(dx, dy, outNx, outNy);
+        return true;
+    }
+
+    float tEnter = -1.0f;
+    float tExit = 1.0f;
+    int enterAxis = -1;
+    const float start[2] = {sx, sy};
+    const float delta[2] = {dx, dy};
+    const float center[2] = {bx, by};
+    const float half[2] = {hw, hh};
+    for (int axis = 0; axis < 2; ++axis) {
+        if (delta[axis] == 0.0f) {
+            if (std::abs(start[axis] - center[axis]) > half[axis]) return false;
+            continue;
+        }
+        float inv = 1.0f / delta[axis];
+        float t1 = (center[axis] - half[axis] - start[axis]) * inv;
+        float t2 = (center[axis] + half[axis] - start[axis]) * inv;
+        if (t1 > t2) std::swap(t1, t2);
+        if (t1 > tEnter) {
+            tEnter = t1;
+            enterAxis = axis;
+        }
+        if (t2 < tExit) tExit = t2;
+    }
+    if (enterAxis < 0 || tEnter < 0.0f || tEnter > tExit) return false;
+    outT = tEnter;
+    outNx = enterAxis == 0 ? (dx > 0.0f ? -1.0f : 1.0f) : 0.0f;
+    outNy = enterAxis == 1 ? (dy > 0.0f ? -1.0f : 1.0f) : 0.0f;
+    return true;
+}
+
+// OBB：射線轉進盒子的局部座標做 slab 測試，法向量再轉回來
+inline bool rayVsObb(
+    float sx, float sy, float dx, float dy,
+    float bx, float by, float hw, float hh, float bc, float bs, float& outT, float& outNx, float& outNy)
+{
+    float mx = sx - bx;
+    float my = sy - by;
+    float lnx = 0.0f, lny = 0.0f;
+    if (!rayVsBox(bc * mx + bs * my, bc * my - bs * mx, bc * dx + bs * dy, bc * dy - bs * dx,
+                  0.0f, 0.0f, hw, hh, outT, lnx, lny)) {
+        return false;
+    }
+    outNx = bc * lnx - bs * lny;
+    outNy = bs * lnx + bc * lny;
+    return true;
+}
+
+class CollisionValidator;
+
 // ============================================================
 // CollisionSystem
 // ============================================================
 class CollisionSystem {
 public:
     void update(Registry& registry, float dt);
+
+    // 上一次 update 的 broad phase 候選配對數（profiler 用）
+    size_t lastPairCount() const { return m_pairs.size(); }
+    // 上一次 update 因 layer / mask 在 broad phase 就被濾掉的配對數
+    size_t lastPrunedPairCount() const { return m_lastPruned; }
+    // 上一次 update 的完整統計（broad phase 結構、narrow phase、子彈查詢）
+    const CollisionStats& lastStats() const { return m_stats; }
+
+    // narrow phase 使用的 SIMD 等級（預設為 CPU 支援的最高等級）
+    void setSimdLevel(SimdLevel level) { m_batch.setSimdLevel(level); }
+    SimdLevel simdLevel() const { return m_batch.simdLevel(); }
+
+    // relaxation 的輪數：每輪用上一輪推開後的位置重新做 narrow phase（至少 1 輪）
+    static constexpr int DEFAULT_SOLVER_ITERATIONS = 4;
+    void setSolverIterations(int iterations) { m_iterations = iterations > 0 ? iterations : 1; }
+    int solverIterations() const { return m_iterations; }
+
+    // narrow phase 的執行緒數（含呼叫端，0 = 硬體執行緒數）；結果和執行緒數無關
+    void setThreadCount(unsigned threadCount) { m_workers.setThreadCount(threadCount); }
+    unsigned threadCount() const { return m_workers.threadCount(); }
+
+    // 掛上驗證器（nullptr = 不驗證）：每個 tick 的 findPairs 之後交給它比對 / 替換配對，
+    // 見 physics/CollisionValidator.h；O(n²)，只給 --validate-collision 和測試用
+    void setValidator(CollisionValidator* validator) { m_validator = validator; }
+
+private:
+    // 每個平行區塊處理的配對 / 物體數（8 的倍數，AVX2 kernel 不會被切出尾端）
+    static constexpr size_t PARALLEL_GRAIN = 2048;
+
+    // 有 OBB 參與的配對：圓 vs OBB 兩種方向；OBB vs OBB 也收 AABB vs OBB（AABB 當成 c = 1、s = 0）
+    enum class PairShape : std::uint8_t {
+        CircleCircle, AabbAabb, CircleAabb, AabbCircle, CircleObb, ObbCircle, ObbObb, None
+    };
+
+    // 每一對的元件指標、動態/靜態分類與在桶裡的位置（classify 時填好）
+    struct PairBodies {
+        Transform* tfA = nullptr;
+        Transform* tfB = nullptr;
+        const Collider* colA = nullptr;
+        const Collider* colB = nullptr;
+        std::uint32_t bodyA = 0;          // Transform 的 dense index（推開時依物體分組）
+        std::uint32_t bodyB = 0;
+        std::uint32_t slot = 0;           // 在 NarrowPhaseBatch 對應桶裡的位置
+        float cosA = 1.0f;                // CollisionWorld::orientation（只有 OBB 不是 1 / 0）
+        float sinA = 0.0f;
+        float cosB = 1.0f;
+        float sinB = 0.0f;
+        PairShape shape = PairShape::None;
+        bool aIsDynamic = false;
+        bool bIsDynamic = false;
+        bool aAsleep = false;             // CollisionWorld::isSleeping（classify 時讀一次）
+        bool bAsleep = false;
+        bool pushA = false;               // 這一輪要不要推開 A / B（每輪分組時決定）
+        bool pushB = false;
+    };
+
+    // 用距離場推出牆外的物體（CollisionWorld::fieldBodies，每 tick 讀一次元件）
+    struct FieldBody {
+        Transform* tf = nullptr;
+        float radius = 0.0f;
+    };
+
+    // 每 tick 重複使用的暫存，避免反覆配置
+    std::vector<BodyPair> m_pairs;
+    size_t m_lastPruned = 0;
+    CollisionStats m_stats;
+    std::vector<ProjectileHit> m_hits;
+    std::vector<EntityID> m_players;
+    NarrowPhaseBatch m_batch;
+    std::vector<PairBodies> m_bodies;
+    // 推開量依物體分組（CSR）：物體 b 的修正是 m_corrections[start[b] .. start[b + 1])，
+    // 每一格是「配對 index << 1 | 是不是 B 方」
+    std::vector<std::uint32_t> m_correctionStart;
+    std::vector<std::uint32_t> m_correctionCursor;
+    std::vector<std::uint32_t> m_corrections;
+    std::vector<EntityID> m_toWake;       // 這個 tick 被壓醒的睡著物體
+    std::vector<FieldBody> m_fieldBodies;
+    std::vector<std::uint8_t> m_fieldPushed;   // 這一輪有沒有被距離場推（平行寫、循序加總）
+    int m_iterations = DEFAULT_SOLVER_ITERATIONS;
+    WorkerPool m_workers;
+    CollisionValidator* m_validator = nullptr;
 };
 
 } // namespace duck
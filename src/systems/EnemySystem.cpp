@@ -1,5 +1,8 @@
 #include "systems/EnemySystem.h"
 #include "ecs/Components.h"
+#include "physics/CollisionWorld.h"
+#include "physics/SpatialIndex.h"
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -41,11 +44,63 @@ void EnemySystem::update(Registry& registry, float dt) {
     });
 
     std::vector<EntityID> toDestroy;
+    const auto& archetypes = registry.context<EnemyArchetypeTable>();
 
-    registry.view<Transform, RigidBody, Enemy>([&](EntityID entity) {
+    // 玩家附近的敵人用共用的 SpatialIndex 一次查出來並標記；
+    // 沒被標記的敵人離玩家超過所有 archetype 的偵測 / 攻擊距離，不必再算距離比較
+    m_nearby.clear();
+    if (player != INVALID_ENTITY) {
+        float reach = 0.0f;
+        for (const EnemyArchetype& arch : archetypes.archetypes) {
+            reach = std::max({reach, arch.detectRange, arch.attackRange});
+        }
+        auto& index = registry.context<SpatialIndex>();
+        index.ensureBuilt(registry);
+        index.queryRadius(playerX, playerY, reach, NEARBY_LAYERS, m_nearby);
+        for (EntityID entity : m_nearby) {
+            if (entity >= m_nearFlags.size()) m_nearFlags.resize(static_cast<size_t>(entity) + 1, 0);
+            m_nearFlags[entity] = NEAR_PLAYER;
+        }
+
+        // 視線：偵測範圍內、還活著的敵人各一條到玩家的線段，一次查完
+        m_rays.clear();
+        m_rayOwners.clear();
+        auto* transforms = registry.findPool<Transform>();
+        auto* enemies = registry.findPool<EnemyState>();
+        for (EntityID entity : m_nearby) {
+            if (!enemies || !enemies->has(entity) || !transforms->has(entity)) continue;
+            const EnemyState& enemy = enemies->get(entity);
+            if (enemy.state == EnemyState::State::Dead) continue;
+            const Transform& tf = transforms->get(entity);
+            float dx = playerX - tf.x;
+            float dy = playerY - tf.y;
+            if (dx * dx + dy * dy > sqr(archetypes.get(enemy.archetype).detectRange)) continue;
+
+            RayCast ray;
+            ray.x = tf.x;
+            ray.y = tf.y;
+            ray.dx = dx;
+            ray.dy = dy;
+            ray.filter = {CollisionLayer::Enemy, CollisionLayer::Obstacle};
+            ray.ignore = entity;
+            m_rays.push_back(ray);
+            m_rayOwners.push_back(entity);
+        }
+        if (!m_rays.empty()) {
+            auto& world = registry.context<CollisionWorld>();
+            world.ensureSynced(registry);
+            world.raycast(registry, m_rays, m_rayHits);
+            for (size_t i = 0; i < m_rays.size(); ++i) {
+                if (m_rayHits[i].hit()) m_nearFlags[m_rayOwners[i]] |= SIGHT_BLOCKED;
+            }
+        }
+    }
+
+    registry.view<Transform, RigidBody, EnemyState>([&](EntityID entity) {
         auto& tf = registry.getComponent<Transform>(entity);
         auto& rb = registry.getComponent<RigidBody>(entity);
-        auto& enemy = registry.getComponent<Enemy>(entity);
+        auto& enemy = registry.getComponent<EnemyState>(entity);
+        const EnemyArchetype& arch = archetypes.get(enemy.archetype);
 
         if (!enemy.homeInitialized) {
             enemy.homeX = tf.x;
@@ -65,14 +120,12 @@ void EnemySystem::update(Registry& registry, float dt) {
             ? &registry.getComponent<Health>(entity)
             : nullptr;
 
-        if (health && health->currentHP <= 0.0f && enemy.state != Enemy::State::Dead) {
-            enemy.state = Enemy::State::Dead;
-            enemy.deadTimer = enemy.deadLifetime;
+        if (health && health->currentHP <= 0.0f && enemy.state != EnemyState::State::Dead) {
+            enemy.state = EnemyState::State::Dead;
+            enemy.deadTimer = arch.deadLifetime;
             rb.vx = 0.0f;
             rb.vy = 0.0f;
-            if (registry.hasComponent<Collider>(entity)) {
-                registry.getComponent<Collider>(entity).isSolid = false;
-            }
+            registry.context<CollisionWorld>().setSolid(registry, entity, false);
             if (sprite) {
                 sprite->r = 0.35f;
                 sprite->g = 0.35f;
@@ -81,7 +134,7 @@ void EnemySystem::update(Registry& registry, float dt) {
             }
         }
 
-        if (enemy.state == Enemy::State::Dead) {
+        if (enemy.state == EnemyState::State::Dead) {
             enemy.deadTimer -= dt;
             rb.vx = 0.0f;
             rb.vy = 0.0f;
@@ -92,57 +145,60 @@ void EnemySystem::update(Registry& registry, float dt) {
         }
 
         if (player == INVALID_ENTITY) {
-            enemy.state = Enemy::State::Idle;
+            enemy.state = EnemyState::State::Idle;
             return;
         }
 
         float dx = playerX - tf.x;
         float dy = playerY - tf.y;
-        float distSq = dx * dx + dy * dy;
-        float detectSq = sqr(enemy.detectRange);
-        float attackSq = sqr(enemy.attackRange);
-        bool seesPlayer = distSq <= detectSq;
-        bool inAttackRange = distSq <= attackSq;
+        bool seesPlayer = false;
+        bool inAttackRange = false;
+        std::uint8_t flags = entity < m_nearFlags.size() ? m_nearFlags[entity] : 0;
+        if (flags & NEAR_PLAYER) {
+            float distSq = dx * dx + dy * dy;
+            seesPlayer = distSq <= sqr(arch.detectRange) && !(flags & SIGHT_BLOCKED);
+            inAttackRange = distSq <= sqr(arch.attackRange);
+        }
 
         switch (enemy.state) {
-            case Enemy::State::Idle: {
+            case EnemyState::State::Idle: {
                 rb.vx = 0.0f;
                 rb.vy = 0.0f;
                 if (sprite) {
                     sprite->r = 0.78f; sprite->g = 0.30f; sprite->b = 0.30f;
                 }
-                enemy.loseSightTimer = enemy.loseSightDelay;
+                enemy.loseSightTimer = arch.loseSightDelay;
                 if (seesPlayer) {
-                    enemy.state = inAttackRange ? Enemy::State::Attack : Enemy::State::Chase;
+                    enemy.state = inAttackRange ? EnemyState::State::Attack : EnemyState::State::Chase;
                 }
                 break;
             }
 
-            case Enemy::State::Chase: {
+            case EnemyState::State::Chase: {
                 if (sprite) {
                     sprite->r = 0.95f; sprite->g = 0.20f; sprite->b = 0.20f;
                 }
                 if (inAttackRange) {
-                    enemy.state = Enemy::State::Attack;
+                    enemy.state = EnemyState::State::Attack;
                     rb.vx = 0.0f;
                     rb.vy = 0.0f;
                     break;
                 }
 
                 if (seesPlayer) {
-                    enemy.loseSightTimer = enemy.loseSightDelay;
-                    accelerateTowards(rb, tf, playerX, playerY, enemy.moveAcceleration, dt);
+                    enemy.loseSightTimer = arch.loseSightDelay;
+                    accelerateTowards(rb, tf, playerX, playerY, arch.moveAcceleration, dt);
                 } else {
                     enemy.loseSightTimer -= dt;
                     if (enemy.loseSightTimer <= 0.0f) {
-                        enemy.state = Enemy::State::Patrol;
+                        enemy.state = EnemyState::State::Patrol;
                         enemy.patrolWaitTimer = 0.0f;
                     }
                 }
                 break;
             }
 
-            case Enemy::State::Attack: {
+            case EnemyState::State::Attack: {
                 if (sprite) {
                     sprite->r = 1.0f; sprite->g = 0.10f; sprite->b = 0.10f;
                 }
@@ -151,36 +207,36 @@ void EnemySystem::update(Registry& registry, float dt) {
                 rb.vy = 0.0f;
 
                 if (!inAttackRange) {
-                    enemy.state = seesPlayer ? Enemy::State::Chase : Enemy::State::Patrol;
-                    enemy.loseSightTimer = enemy.loseSightDelay;
+                    enemy.state = seesPlayer ? EnemyState::State::Chase : EnemyState::State::Patrol;
+                    enemy.loseSightTimer = arch.loseSightDelay;
                 }
                 break;
             }
 
-            case Enemy::State::Patrol: {
+            case EnemyState::State::Patrol: {
                 if (sprite) {
                     sprite->r = 0.88f; sprite->g = 0.42f; sprite->b = 0.22f;
                 }
                 if (seesPlayer) {
-                    enemy.state = inAttackRange ? Enemy::State::Attack : Enemy::State::Chase;
-                    enemy.loseSightTimer = enemy.loseSightDelay;
+                    enemy.state = inAttackRange ? EnemyState::State::Attack : EnemyState::State::Chase;
+                    enemy.loseSightTimer = arch.loseSightDelay;
                     break;
                 }
 
                 enemy.patrolWaitTimer -= dt;
-                float targetX = enemy.homeX + std::cos(enemy.patrolAngle) * enemy.patrolRadius;
-                float targetY = enemy.homeY + std::sin(enemy.patrolAngle) * enemy.patrolRadius;
+                float targetX = enemy.homeX + std::cos(enemy.patrolAngle) * arch.patrolRadius;
+                float targetY = enemy.homeY + std::sin(enemy.patrolAngle) * arch.patrolRadius;
                 float targetDx = targetX - tf.x;
                 float targetDy = targetY - tf.y;
                 float targetDistSq = targetDx * targetDx + targetDy * targetDy;
 
                 if (enemy.patrolWaitTimer <= 0.0f && targetDistSq < sqr(18.0f)) {
                     enemy.patrolAngle += 1.65f;
-                    enemy.patrolWaitTimer = enemy.patrolWaitDuration;
+                    enemy.patrolWaitTimer = arch.patrolWaitDuration;
                 }
 
                 if (enemy.patrolWaitTimer <= 0.0f) {
-                    accelerateTowards(rb, tf, targetX, targetY, enemy.moveAcceleration * 0.45f, dt);
+                    accelerateTowards(rb, tf, targetX, targetY, arch.moveAcceleration * 0.45f, dt);
                 } else {
                     rb.vx *= 0.75f;
                     rb.vy *= 0.75f;
@@ -188,14 +244,13 @@ void EnemySystem::update(Registry& registry, float dt) {
                 break;
             }
 
-            case Enemy::State::Dead:
+            case EnemyState::State::Dead:
                 break;
         }
     });
 
-    for (EntityID entity : toDestroy) {
-        if (registry.alive(entity)) registry.destroy(entity);
-    }
+    for (EntityID entity : m_nearby) m_nearFlags[entity] = 0;
+    registry.destroyMany(toDestroy);
 }
 
 } // namespace duck
@@ -1,5 +1,8 @@
 #pragma once
 #include "ecs/Registry.h"
+#include "physics/CollisionWorld.h"
+#include <cstdint>
+#include <vector>
 
 namespace duck {
 
@@ -12,9 +15,32 @@ namespace duck {
 // ATTACK: 進入近距離後停住並面向玩家，接觸傷害由 CollisionSystem 處理
 // PATROL: 失去目標後繞出生點附近巡邏
 // DEAD: 死亡殘留短時間後銷毀
+//
+// 每隻敵人的熱資料在 EnemyState，調校值從 Registry context 的
+// EnemyArchetypeTable 以 index 讀取（見 Components.h）
+//
+// 誰在玩家的偵測範圍附近由 registry.context<SpatialIndex>() 一次查出來，
+// 狀態機仍然每隻都跑（計時器要倒數），但遠處的敵人不必再和玩家比距離。
+// 偵測範圍內的敵人再各拉一條到玩家的視線，整批交給 CollisionWorld::raycast：
+// 被 Obstacle 層擋住就看不到（牆後的敵人不會被驚動、追丟了會照常轉巡邏）。
+// 只擋玩家、讓敵人穿過的障礙物（mask 不含 Enemy）不擋視線。
 class EnemySystem {
 public:
+    // 找玩家附近的敵人時查 SpatialIndex 的哪些層（掉落物、石頭等其他層用不到）
+    static constexpr std::uint32_t NEARBY_LAYERS = CollisionLayer::Enemy;
+
     void update(Registry& registry, float dt);
+
+private:
+    // m_nearFlags 的位元
+    static constexpr std::uint8_t NEAR_PLAYER = 1;
+    static constexpr std::uint8_t SIGHT_BLOCKED = 2;
+
+    std::vector<EntityID> m_nearby;          // 玩家附近的 entity（查詢結果，跨 tick 重用）
+    std::vector<std::uint8_t> m_nearFlags;   // 以 EntityID 索引：這個 tick 在玩家附近 / 視線被擋
+    std::vector<RayCast> m_rays;             // 視線（敵人 → 玩家），和 m_rayOwners 一一對應
+    std::vector<EntityID> m_rayOwners;
+    std::vector<RayHit> m_rayHits;
 };
 
 } // namespace duck
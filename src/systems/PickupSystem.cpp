@@ -1,36 +1,29 @@
 #include "systems/PickupSystem.h"
 #include "ecs/Components.h"
+#include "physics/CollisionWorld.h"
+#include <algorithm>
 #include <vector>
 
 namespace duck {
 
 void PickupSystem::update(Registry& registry) {
-    EntityID player = INVALID_ENTITY;
-    float playerX = 0.0f;
-    float playerY = 0.0f;
-
-    registry.view<Transform, Inventory, InputControlled>([&](EntityID entity) {
-        if (player != INVALID_ENTITY) return;
-        auto& tf = registry.getComponent<Transform>(entity);
-        player = entity;
-        playerX = tf.x;
-        playerY = tf.y;
-    });
-
-    if (player == INVALID_ENTITY) return;
-
-    auto& inventory = registry.getComponent<Inventory>(player);
-    std::vector<EntityID> toDestroy;
+    auto& world = registry.context<CollisionWorld>();
+    m_picked.clear();
+
+    // Enter 事件的 a 是 trigger（Item）、b 是碰到它的 solid；只有玩家（有背包）撿得走
+    for (const ContactEvent& event : world.triggerEnters()) {
+        EntityID entity = event.a;
+        EntityID collector = event.b;
+        if (!registry.alive(entity) || !registry.isEnabled(entity) || !registry.hasComponent<Item>(entity)) continue;
+        if (!registry.alive(collector) || !registry.hasComponent<Inventory>(collector)
+            || !registry.hasComponent<InputControlled>(collector)) {
+            continue;
+        }
+        // 同一個 tick 兩個玩家同時碰到：先到的事件撿走
+        if (std::find(m_picked.begin(), m_picked.end(), entity) != m_picked.end()) continue;
 
-    registry.view<Transform, Item>([&](EntityID entity) {
-        auto& tf = registry.getComponent<Transform>(entity);
         auto& item = registry.getComponent<Item>(entity);
-
-        float dx = tf.x - playerX;
-        float dy = tf.y - playerY;
-        float distSq = dx * dx + dy * dy;
-        if (distSq > item.pickupRadius * item.pickupRadius) return;
-
+        auto& inventory = registry.getComponent<Inventory>(collector);
         switch (item.type) {
             case Item::Type::DuckCoin:
                 inventory.duckCoins += item.amount;
@@ -43,12 +36,10 @@ void PickupSystem::update(Registry& registry) {
                 break;
         }
         inventory.totalPickups += item.amount;
-        toDestroy.push_back(entity);
-    });
-
-    for (EntityID entity : toDestroy) {
-        if (registry.alive(entity)) registry.destroy(entity);
+        m_picked.push_back(entity);
     }
+
+    registry.destroyMany(m_picked);
 }
 
 } // namespace duck
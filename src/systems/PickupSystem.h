@@ -1,14 +1,21 @@
 #pragma once
 #include "ecs/Registry.h"
+#include <vector>
 
 namespace duck {
 
 // ============================================================
-// PickupSystem — 玩家靠近時自動拾取掉落物
+// PickupSystem — 玩家碰到掉落物時自動拾取
 // ============================================================
+// 掉落物掛的是 isSolid = false 的 Collider（trigger，見 physics/CollisionWorld.h），
+// 這裡只消費 CollisionWorld 這個 tick 的 triggerEnters()，不掃描場上的 Item。
+// 事件由 CollisionSystem 產生，所以要排在它之後跑。
 class PickupSystem {
 public:
     void update(Registry& registry);
+
+private:
+    std::vector<EntityID> m_picked;   // 這個 tick 撿走的 Item，跨 tick 重用
 };
 
 } // namespace duck
@@ -1,6 +1,8 @@
 #include "systems/RenderSystem.h"
 #include "ecs/Components.h"
+#include "physics/ProjectileManager.h"
 #include "renderer/Texture.h"
+#include <cmath>
 
 namespace duck {
 
@@ -30,6 +32,26 @@ void RenderSystem::render(Registry& registry,
         );
     });
 
+    // 子彈直接從 ProjectileManager 的 SoA 陣列送出，不經過 Registry 的 view；
+    // 子彈幾乎都用同一張紋理，只在紋理 ID 換了才重新查表
+    const auto& projectiles = registry.context<ProjectileManager>();
+    const glm::vec4 bulletColor = {1.0f, 0.0f, 0.0f, 1.0f};   // 紅色
+    const int bulletZ = 5;                                    // 在角色(4)上方
+    std::uint32_t lastTextureID = 0;
+    const Texture* bulletTexture = nullptr;
+    for (size_t i = 0; i < projectiles.size(); ++i) {
+        std::uint32_t textureID = projectiles.textureID(i);
+        if (bulletTexture == nullptr || textureID != lastTextureID) {
+            auto it = textures.find(textureID);
+            bulletTexture = it != textures.end() ? it->second : nullptr;
+            lastTextureID = textureID;
+            if (bulletTexture == nullptr) continue;
+        }
+        float size = projectiles.radius(i) * 2.0f;
+        renderer.drawSprite(*bulletTexture, {projectiles.x(i), projectiles.y(i)}, {size, size},
+                            0.0f, bulletColor, bulletZ);
+    }
+
     // ── DebugDraw：繪製碰撞框輪廓 ──
     if (!m_debugMode) return;
 
@@ -41,7 +63,7 @@ void RenderSystem::render(Registry& registry,
         auto& tf  = registry.getComponent<Transform>(entity);
         auto& col = registry.getComponent<Collider>(entity);
 
-        // 計算碰撞形狀的外接矩形
+        // 計算碰撞形狀的外接矩形（OBB 是旋轉前的）
         float w, h;
         if (col.type == Collider::Type::Circle) {
             w = h = col.radius * 2.0f;
@@ -59,11 +81,18 @@ void RenderSystem::render(Registry& registry,
         const float L = 2.0f;  // 邊框線寬（像素）
         const int Z = 8;       // 最上層
 
-        // 四條邊線：上/下/左/右
-        renderer.drawSprite(debugTex, {tf.x, tf.y - h * 0.5f + L * 0.5f}, {w, L}, 0.0f, debugColor, Z);
-        renderer.drawSprite(debugTex, {tf.x, tf.y + h * 0.5f - L * 0.5f}, {w, L}, 0.0f, debugColor, Z);
-        renderer.drawSprite(debugTex, {tf.x - w * 0.5f + L * 0.5f, tf.y}, {L, h}, 0.0f, debugColor, Z);
-        renderer.drawSprite(debugTex, {tf.x + w * 0.5f - L * 0.5f, tf.y}, {L, h}, 0.0f, debugColor, Z);
+        // 四條邊線：上/下/左/右（OBB 的邊線跟著 rotation 轉：局部偏移轉到世界座標）
+        float angle = col.type == Collider::Type::OBB ? tf.rotation : 0.0f;
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+        auto edge = [&](float ox, float oy, float ew, float eh) {
+            renderer.drawSprite(debugTex, {tf.x + ox * c - oy * s, tf.y + ox * s + oy * c}, {ew, eh}, angle,
+                                debugColor, Z);
+        };
+        edge(0.0f, -h * 0.5f + L * 0.5f, w, L);
+        edge(0.0f, h * 0.5f - L * 0.5f, w, L);
+        edge(-w * 0.5f + L * 0.5f, 0.0f, L, h);
+        edge(w * 0.5f - L * 0.5f, 0.0f, L, h);
     });
 }
 
@@ -14,6 +14,7 @@ class Texture;
 // 職責：
 // 遍歷所有同時擁有 Transform 和 Sprite 的 entity，
 // 從紋理表取出對應 Texture，呼叫 Renderer::drawSprite()。
+// 子彈不是 entity：直接走 registry.context<ProjectileManager>() 的陣列送出。
 //
 // 為什麼用 textures map 而不是讓 Sprite 直接持有 Texture 指標？
 //
@@ -1,14 +1,16 @@
 #include "systems/WeaponSystem.h"
 #include "ecs/Components.h"
+#include "physics/ProjectileManager.h"
 #include <SDL2/SDL.h>
 #include <cmath>
 
 namespace duck {
 
 void WeaponSystem::update(Registry& registry, const Input& input, float dt) {
+    auto& projectiles = registry.context<ProjectileManager>();
 
     // -------------------------------------------------------
-    // View 1：射擊 — 只有 InputControlled entity 能開槍
+    // 射擊 — 只有 InputControlled entity 能開槍
     // -------------------------------------------------------
     registry.view<Transform, Weapon, InputControlled>([&](EntityID entity) {
         auto& tf = registry.getComponent<Transform>(entity);
@@ -30,20 +32,18 @@ void WeaponSystem::update(Registry& registry, const Input& input, float dt) {
             float len = std::sqrt(dx * dx + dy * dy);
             if (len > 0.0f) { dx /= len; dy /= len; }
 
-            // 在玩家位置生成子彈 entity
-            auto bullet = registry.create();
-            registry.addComponent<Transform>(bullet, tf.x, tf.y, 0.0f, 1.0f, 1.0f);
-            registry.addComponent<Sprite>(bullet,
-                wp.bulletTextureID,
-                wp.bulletSize, wp.bulletSize,
-                5,              // Z-Order 5：在角色(4)上方
-                1.0f, 0.0f, 0.0f, 1.0f);  // 紅色
-            registry.addComponent<Bullet>(bullet,
-                dx * wp.bulletSpeed,
-                dy * wp.bulletSpeed,
-                wp.bulletLifetime,
-                wp.bulletSize * 0.5f,
-                wp.damage);
+            // 在玩家位置生成子彈（存進 ProjectileManager，不是 entity）
+            ProjectileSpawn spawn;
+            spawn.x = tf.x;
+            spawn.y = tf.y;
+            spawn.vx = dx * wp.bulletSpeed;
+            spawn.vy = dy * wp.bulletSpeed;
+            spawn.lifetime = wp.bulletLifetime;
+            spawn.radius = wp.bulletSize * 0.5f;
+            spawn.damage = wp.damage;
+            spawn.textureID = wp.bulletTextureID;
+            spawn.owner = entity;
+            projectiles.spawn(spawn);
 
             // 重置冷卻，防止下幀立刻再射
             wp.cooldown = wp.fireRate;
@@ -51,24 +51,11 @@ void WeaponSystem::update(Registry& registry, const Input& input, float dt) {
     });
 
     // -------------------------------------------------------
-    // View 2：子彈移動 + 過期清除
+    // 子彈移動 + 過期清除
     // -------------------------------------------------------
     // 子彈等速直線飛行：不乘 friction，不會減速
-    // view() 在呼叫前複製 entity 列表，所以在 callback 裡 destroy() 是安全的
-    registry.view<Transform, Bullet>([&](EntityID entity) {
-        auto& tf = registry.getComponent<Transform>(entity);
-        auto& bl = registry.getComponent<Bullet>(entity);
-
-        // 等速位移
-        tf.x += bl.vx * dt;
-        tf.y += bl.vy * dt;
-
-        // 壽命倒數，歸零就清除
-        bl.lifetime -= dt;
-        if (bl.lifetime <= 0.0f) {
-            registry.destroy(entity);
-        }
-    });
+    // 整批 SIMD 位移 + 壽命倒數，過期的用 swap-and-pop 移除（見 ProjectileManager）
+    projectiles.integrate(dt);
 }
 
 } // namespace duck
@@ -7,20 +7,21 @@ namespace duck {
 // ============================================================
 // WeaponSystem — 射擊邏輯 + 子彈生命週期管理
 // ============================================================
-// 職責分兩個 view：
+// 職責分兩段：
 //
-// View 1：<Transform, Weapon, InputControlled>
-//   - 偵測左鍵按住 + 冷卻結束 → 生成 Bullet entity
+// View：<Transform, Weapon, InputControlled>
+//   - 偵測左鍵按住 + 冷卻結束 → 在 registry.context<ProjectileManager>() 生成一顆子彈
 //   - 子彈方向 = 從玩家位置指向滑鼠（normalized 向量）
 //   - 重置 cooldown = fireRate，下次才能再射
 //
-// View 2：<Transform, Bullet>
+// 子彈：ProjectileManager::integrate
 //   - 每幀移動子彈（等速直線，無摩擦力）
-//   - lifetime 倒數，歸零就 destroy()
+//   - lifetime 倒數，歸零的子彈直接 swap-and-pop
 //
-// 為什麼 Bullet 不用 RigidBody？
+// 為什麼子彈不用 RigidBody（也不是 entity）？
 // RigidBody 有 friction，子彈每幀都在減速 → 不符合物理
-// 用獨立 Bullet 元件，MovementSystem 的物理 view 完全不會碰到它
+// 子彈放在獨立的 SoA 陣列，MovementSystem 的物理 view 完全不會碰到它，
+// 大量子彈時也不必付 entity 建立 / 刪除與逐顆查元件的成本
 //
 class WeaponSystem {
 public:
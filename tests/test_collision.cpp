@@ -4,17 +4,38 @@
 
 #include "systems/CollisionSystem.h"
 #include "systems/EnemySystem.h"
+#include "core/WorkerPool.h"
 #include "ecs/Components.h"
 #include "ecs/Registry.h"
+#include "physics/CollisionWorld.h"
+#include "physics/ContactCache.h"
+#include "physics/DistanceField.h"
+#include "physics/LinearBvh.h"
+#include "physics/LooseQuadtree.h"
+#include "physics/NarrowPhaseBatch.h"
+#include "physics/ProjectileManager.h"
+#include "physics/SpatialIndex.h"
+#include "physics/StaticBvh.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <utility>
+#include <vector>
 
 // 輔助：兩個 float 是否近似相等（容差 0.001）
 static bool approx(float a, float b) {
     return std::abs(a - b) < 0.001f;
 }
 
+// 輔助：兩個 float 是否逐位元相同
+static bool sameBits(float a, float b) {
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
 // ─────────────────────────────────────────
 // Circle vs Circle
 // ─────────────────────────────────────────
@@ -131,6 +152,122 @@ void test_circle_inside_aabb_right_edge() {
     std::printf("  [PASS] test_circle_inside_aabb_right_edge\n");
 }
 
+// ─────────────────────────────────────────
+// Swept Circle（連續碰撞）
+// ─────────────────────────────────────────
+
+void test_swept_circle_vs_circle() {
+    float t = -1.0f;
+    // r=5 從 (0,0) 往 +X 走 100；目標 (50,0) r=10 → 距離 15 時接觸，x=35 → t=0.35
+    assert(duck::sweptCircleVsCircle(0, 0, 100, 0, 5, 50, 0, 10, t));
+    assert(approx(t, 0.35f));
+    // 側向偏移 20 > 15 → 錯過；剛好 15 是擦過，不算
+    assert(!duck::sweptCircleVsCircle(0, 20, 100, 0, 5, 50, 0, 10, t));
+    assert(!duck::sweptCircleVsCircle(0, 15, 100, 0, 5, 50, 0, 10, t));
+    // 這個 tick 還走不到（終點 x=30 < 35）
+    assert(!duck::sweptCircleVsCircle(0, 0, 30, 0, 5, 50, 0, 10, t));
+    // 往反方向走
+    assert(!duck::sweptCircleVsCircle(0, 0, -100, 0, 5, 50, 0, 10, t));
+    // 起點就重疊 → t = 0；不動時退化成離散判斷
+    assert(duck::sweptCircleVsCircle(45, 0, 100, 0, 5, 50, 0, 10, t));
+    assert(t == 0.0f);
+    assert(!duck::sweptCircleVsCircle(0, 0, 0, 0, 5, 50, 0, 10, t));
+    std::printf("  [PASS] test_swept_circle_vs_circle\n");
+}
+
+void test_swept_circle_vs_aabb() {
+    float t = -1.0f;
+    // 面：AABB 中心 (50,0) hw=2 hh=20（左邊 x=48），r=5 → x=43 接觸 → t=0.43
+    assert(duck::sweptCircleVsAabb(0, 0, 100, 0, 5, 50, 0, 2, 20, t));
+    assert(approx(t, 0.43f));
+    // 角：AABB (50,0) hw=10 hh=20，左上角 (40,-20)；沿 y=-24 前進，
+    // 和角的垂直距離 4 → x = 40 - sqrt(25 - 16) = 37 → t=0.37
+    assert(duck::sweptCircleVsAabb(0, -24, 100, 0, 5, 50, 0, 10, 20, t));
+    assert(approx(t, 0.37f));
+    // 斜著切過外擴矩形的角落，但離圓角還有 sqrt(32) > 5 → 沒撞
+    assert(!duck::sweptCircleVsAabb(26, -14, 20, -20, 5, 50, 0, 10, 20, t));
+    // 不動、起點在 AABB 外 → 沒撞；起點重疊 → t = 0
+    assert(!duck::sweptCircleVsAabb(0, 0, 0, 0, 5, 50, 0, 2, 20, t));
+    assert(duck::sweptCircleVsAabb(50, 0, 100, 0, 5, 50, 0, 2, 20, t));
+    assert(t == 0.0f);
+    std::printf("  [PASS] test_swept_circle_vs_aabb\n");
+}
+
+// 子彈已經被 WeaponSystem 移到 tick 結束的位置（和 Engine 的系統順序一致）
+static duck::ProjectileManager::ProjectileID spawnMovedBullet(duck::Registry& reg, float x, float y,
+                                                              float vx, float vy,
+                                                              std::uint32_t mask = duck::ProjectileSpawn{}.mask) {
+    duck::ProjectileSpawn spawn;
+    spawn.x = x;
+    spawn.y = y;
+    spawn.vx = vx;
+    spawn.vy = vy;
+    spawn.lifetime = 1.0f;
+    spawn.radius = 5.0f;
+    spawn.damage = 1.0f;
+    spawn.mask = mask;
+    return reg.context<duck::ProjectileManager>().spawn(spawn);
+}
+
+static bool bulletAlive(duck::Registry& reg, duck::ProjectileManager::ProjectileID id) {
+    return reg.context<duck::ProjectileManager>().contains(id);
+}
+
+static duck::EntityID spawnWall(duck::Registry& reg, float x, float y, float halfW, float halfH, float hp) {
+    auto wall = reg.create();
+    reg.addComponent<duck::Transform>(wall, x, y, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(wall, duck::Collider::Type::AABB, halfW, halfH, halfW, true);
+    reg.addComponent<duck::Health>(wall, hp, hp);
+    return wall;
+}
+
+void test_bullet_does_not_tunnel_through_thin_wall() {
+    const float dt = 1.0f / 60.0f;
+    duck::Registry reg;
+    // 4px 厚的牆在 x ∈ [98, 102]；子彈 900 px/s（每 tick 15px）從 x=95 飛到 x=110，
+    // 終點位置已經完全離開牆（110 - 5 > 102），只看終點會穿牆
+    auto wall = spawnWall(reg, 100.0f, 0.0f, 2.0f, 40.0f, 3.0f);
+    auto through = spawnMovedBullet(reg, 110.0f, 0.0f, 900.0f, 0.0f);
+    // 同一面牆、這個 tick 整段都在牆後面 → 不算
+    auto behind = spawnMovedBullet(reg, 135.0f, 10.0f, 900.0f, 0.0f);
+
+    duck::CollisionSystem system;
+    system.update(reg, dt);
+
+    assert(!bulletAlive(reg, through));
+    assert(bulletAlive(reg, behind));
+    assert(approx(reg.getComponent<duck::Health>(wall).currentHP, 2.0f));
+    std::printf("  [PASS] test_bullet_does_not_tunnel_through_thin_wall\n");
+}
+
+void test_high_speed_bullet_hits_earliest_target() {
+    const float dt = 1.0f / 60.0f;
+    duck::Registry reg;
+    // 6000 px/s：每 tick 100px，從 x=-10 飛到 x=90，途中有兩面牆和一個小敵人
+    auto far = spawnWall(reg, 70.0f, 0.0f, 3.0f, 30.0f, 5.0f);
+    auto nearWall = spawnWall(reg, 30.0f, 0.0f, 3.0f, 30.0f, 5.0f);
+    auto bullet = spawnMovedBullet(reg, 90.0f, 0.0f, 6000.0f, 0.0f);
+
+    // 另一條線上：半徑 8 的敵人，子彈兩端都離它 50px 以上
+    auto enemy = reg.create();
+    reg.addComponent<duck::Transform>(enemy, 40.0f, 200.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 8.0f, 8.0f, 8.0f, true);
+    reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
+    reg.addComponent<duck::Health>(enemy, 1.0f, 1.0f);
+    reg.addComponent<duck::EnemyState>(enemy, duck::EnemyState{});
+    auto sniper = spawnMovedBullet(reg, 90.0f, 200.0f, 6000.0f, 0.0f);
+
+    duck::CollisionSystem system;
+    system.update(reg, dt);
+
+    assert(!bulletAlive(reg, bullet));
+    assert(approx(reg.getComponent<duck::Health>(nearWall).currentHP, 4.0f));
+    assert(approx(reg.getComponent<duck::Health>(far).currentHP, 5.0f));
+    assert(!bulletAlive(reg, sniper));
+    assert(reg.getComponent<duck::Health>(enemy).currentHP <= 0.0f);
+    std::printf("  [PASS] test_high_speed_bullet_hits_earliest_target\n");
+}
+
 // ─────────────────────────────────────────
 // CollisionSystem 整合：Bullet damage
 // ─────────────────────────────────────────
@@ -148,23 +285,21 @@ void test_bullet_hits_enemy_and_kills() {
     reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 16.0f, 16.0f, 16.0f, true);
     reg.addComponent<duck::Health>(enemy, 1.0f, 1.0f);
     reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
-    reg.addComponent<duck::Enemy>(enemy, duck::Enemy{});
+    reg.addComponent<duck::EnemyState>(enemy, duck::EnemyState{});
 
-    auto bullet = reg.create();
-    reg.addComponent<duck::Transform>(bullet, 30.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-    reg.addComponent<duck::Bullet>(bullet, 0.0f, 0.0f, 1.0f, 5.0f, 1.0f);
+    auto bullet = spawnMovedBullet(reg, 30.0f, 0.0f, 0.0f, 0.0f);
 
     duck::CollisionSystem collisionSystem;
     collisionSystem.update(reg, 1.0f / 60.0f);
 
-    assert(!reg.alive(bullet));
+    assert(!bulletAlive(reg, bullet));
     assert(reg.alive(enemy));
     assert(reg.getComponent<duck::Health>(enemy).currentHP <= 0.0f);
-    assert(reg.getComponent<duck::Enemy>(enemy).state == duck::Enemy::State::Idle);
+    assert(reg.getComponent<duck::EnemyState>(enemy).state == duck::EnemyState::State::Idle);
 
     duck::EnemySystem enemySystem;
     enemySystem.update(reg, 1.0f / 60.0f);
-    assert(reg.getComponent<duck::Enemy>(enemy).state == duck::Enemy::State::Dead);
+    assert(reg.getComponent<duck::EnemyState>(enemy).state == duck::EnemyState::State::Dead);
     assert(reg.alive(player));
     std::printf("  [PASS] test_bullet_hits_enemy_and_kills\n");
 }
@@ -182,11 +317,13 @@ void test_enemy_touch_damages_player_once_per_cooldown() {
     auto enemy = reg.create();
     reg.addComponent<duck::Transform>(enemy, 10.0f, 0.0f, 0.0f, 1.0f, 1.0f);
     reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 16.0f, 16.0f, 16.0f, true);
-    duck::Enemy enemyData;
-    enemyData.touchDamage = 1.0f;
-    enemyData.touchInterval = 0.75f;
+    duck::EnemyArchetype archetype;
+    archetype.touchDamage = 1.0f;
+    archetype.touchInterval = 0.75f;
+    duck::EnemyState enemyData;
+    enemyData.archetype = reg.context<duck::EnemyArchetypeTable>().add(archetype);
     enemyData.touchCooldown = 0.0f;
-    reg.addComponent<duck::Enemy>(enemy, enemyData);
+    reg.addComponent<duck::EnemyState>(enemy, enemyData);
     reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
 
     duck::CollisionSystem system;
@@ -221,27 +358,2138 @@ void test_bullet_hits_target_with_many_spatial_entries() {
     reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 18.0f, 18.0f, 18.0f, true);
     reg.addComponent<duck::Health>(enemy, 1.0f, 1.0f);
     reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
-    reg.addComponent<duck::Enemy>(enemy, duck::Enemy{});
+    reg.addComponent<duck::EnemyState>(enemy, duck::EnemyState{});
 
-    auto bullet = reg.create();
-    reg.addComponent<duck::Transform>(bullet, 240.0f, 180.0f, 0.0f, 1.0f, 1.0f);
-    reg.addComponent<duck::Bullet>(bullet, 0.0f, 0.0f, 1.0f, 5.0f, 1.0f);
+    auto bullet = spawnMovedBullet(reg, 240.0f, 180.0f, 0.0f, 0.0f);
 
     duck::CollisionSystem collisionSystem;
     duck::EnemySystem enemySystem;
     collisionSystem.update(reg, 1.0f / 60.0f);
     enemySystem.update(reg, 1.0f / 60.0f);
 
-    assert(!reg.alive(bullet));
+    assert(!bulletAlive(reg, bullet));
     assert(reg.alive(enemy));
-    assert(reg.getComponent<duck::Enemy>(enemy).state == duck::Enemy::State::Dead);
+    assert(reg.getComponent<duck::EnemyState>(enemy).state == duck::EnemyState::State::Dead);
     std::printf("  [PASS] test_bullet_hits_target_with_many_spatial_entries\n");
 }
 
+// 敵人死掉時 EnemySystem 把 isSolid 改成 false：下一個 tick 屍體不再推開鄰居、也不再擋子彈
+void test_dead_enemy_stops_colliding() {
+    const float dt = 1.0f / 60.0f;
+    duck::Registry reg;
+
+    auto enemy = reg.create();
+    reg.addComponent<duck::Transform>(enemy, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 16.0f, 16.0f, 16.0f, true);
+    reg.addComponent<duck::Health>(enemy, 1.0f, 1.0f);
+    reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
+    reg.addComponent<duck::EnemyState>(enemy, duck::EnemyState{});
+
+    auto neighbour = reg.create();
+    reg.addComponent<duck::Transform>(neighbour, 60.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(neighbour, duck::Collider::Type::Circle, 8.0f, 8.0f, 8.0f, true);
+    reg.addComponent<duck::RigidBody>(neighbour, 0.0f, 0.0f, 1.0f, 0.9f);
+
+    duck::CollisionSystem collisionSystem;
+    duck::EnemySystem enemySystem;
+    collisionSystem.update(reg, dt);
+
+    reg.getComponent<duck::Health>(enemy).currentHP = 0.0f;
+    enemySystem.update(reg, dt);
+    assert(reg.getComponent<duck::EnemyState>(enemy).state == duck::EnemyState::State::Dead);
+    assert(!reg.getComponent<duck::Collider>(enemy).isSolid);
+
+    // 鄰居走進屍體裡、子彈打在屍體上（離鄰居夠遠）
+    reg.getComponent<duck::Transform>(neighbour).x = 20.0f;
+    auto bullet = spawnMovedBullet(reg, 0.0f, -12.0f, 0.0f, 0.0f);
+    collisionSystem.update(reg, dt);
+
+    assert(collisionSystem.lastStats().pairs == 0);
+    assert(approx(reg.getComponent<duck::Transform>(neighbour).x, 20.0f));
+    assert(approx(reg.getComponent<duck::Transform>(enemy).x, 0.0f));
+    assert(bulletAlive(reg, bullet));
+    assert(reg.getComponent<duck::Health>(enemy).currentHP == 0.0f);
+    std::printf("  [PASS] test_dead_enemy_stops_colliding\n");
+}
+
+// 跑到一半死一隻敵人：sync() 只重新分類那一隻（setSolid 排進來的），其他 Collider 一個都不看
+void test_enemy_death_reclassifies_only_that_body() {
+    const float dt = 1.0f / 60.0f;
+    duck::Registry reg;
+    for (int i = 0; i < 200; ++i) {
+        spawnWall(reg, 60.0f * static_cast<float>(i % 20), -200.0f - 60.0f * static_cast<float>(i / 20),
+                  10.0f, 10.0f, 5.0f);
+    }
+    for (int i = 0; i < 100; ++i) {
+        auto item = reg.create();
+        reg.addComponent<duck::Transform>(item, 60.0f * static_cast<float>(i), 400.0f, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(item, duck::Collider::Type::Circle, 10.0f, 10.0f, 10.0f, false,
+                                         duck::CollisionLayer::Pickup, duck::CollisionLayer::Player);
+    }
+    std::vector<duck::EntityID> enemies;
+    for (int i = 0; i < 50; ++i) {
+        auto enemy = reg.create();
+        reg.addComponent<duck::Transform>(enemy, 60.0f * static_cast<float>(i), 0.0f, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 16.0f, 16.0f, 16.0f, true);
+        reg.addComponent<duck::Health>(enemy, 1.0f, 1.0f);
+        reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
+        reg.addComponent<duck::EnemyState>(enemy, duck::EnemyState{});
+        enemies.push_back(enemy);
+    }
+
+    duck::CollisionSystem collisionSystem;
+    duck::EnemySystem enemySystem;
+    auto& world = reg.context<duck::CollisionWorld>();
+    for (int tick = 0; tick < 5; ++tick) {
+        enemySystem.update(reg, dt);
+        collisionSystem.update(reg, dt);
+        assert(world.lastReclassifiedCount() == 0);
+    }
+    assert(world.staticCount() == 200 && world.dynamicCount() == 50 && world.triggerCount() == 100);
+
+    reg.getComponent<duck::Health>(enemies[20]).currentHP = 0.0f;
+    enemySystem.update(reg, dt);
+    collisionSystem.update(reg, dt);
+    assert(world.lastReclassifiedCount() == 1);
+    assert(world.staticCount() == 200 && world.dynamicCount() == 49 && world.triggerCount() == 101);
+
+    // 之後的 tick 不再有人要重新分類；同一隻再設一次 false 也不會排進來
+    world.setSolid(reg, enemies[20], false);
+    enemySystem.update(reg, dt);
+    collisionSystem.update(reg, dt);
+    assert(world.lastReclassifiedCount() == 0);
+    std::printf("  [PASS] test_enemy_death_reclassifies_only_that_body\n");
+}
+
+// ─────────────────────────────────────────
+// CollisionWorld：持久 broad phase
+// ─────────────────────────────────────────
+
+// 靜態石頭只插入一次；動態物體離開 fat bounds 才重插；
+// destroy 的 entity 立刻從 broad phase 消失，不會再出現在配對裡
+void test_collision_world_persistent_broad_phase() {
+    duck::Registry reg;
+
+    auto rock = reg.create();
+    reg.addComponent<duck::Transform>(rock, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(rock, duck::Collider::Type::AABB, 20.0f, 20.0f, 20.0f, true);
+
+    auto mover = reg.create();
+    reg.addComponent<duck::Transform>(mover, 200.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(mover, duck::Collider::Type::Circle, 10.0f, 10.0f, 10.0f, true);
+    reg.addComponent<duck::RigidBody>(mover, 0.0f, 0.0f, 1.0f, 0.9f);
+
+    auto& world = reg.context<duck::CollisionWorld>();
+    std::vector<duck::BodyPair> pairs;
+    world.sync(reg);
+    assert(world.staticCount() == 1);
+    assert(world.dynamicCount() == 1);
+    world.findPairs(pairs);
+    assert(pairs.empty());
+
+    // 小幅移動：仍在 fat bounds 內，不重插
+    reg.getComponent<duck::Transform>(mover).x = 198.0f;
+    world.sync(reg);
+    assert(world.lastReinsertCount() == 0);
+
+    // 移到石頭旁邊：離開 fat bounds → 重插，配對出現（動態在前）
+    reg.getComponent<duck::Transform>(mover).x = 25.0f;
+    world.sync(reg);
+    assert(world.lastReinsertCount() == 1);
+    pairs.clear();
+    world.findPairs(pairs);
+    assert(pairs.size() == 1);
+    assert(pairs[0].a == mover && pairs[0].b == rock);
+
+    // 之後新增的 Collider 在下一次 sync 才加入
+    auto late = reg.create();
+    reg.addComponent<duck::Transform>(late, 30.0f, 5.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(late, duck::Collider::Type::Circle, 10.0f, 10.0f, 10.0f, true);
+    reg.addComponent<duck::RigidBody>(late, 0.0f, 0.0f, 1.0f, 0.9f);
+    world.sync(reg);
+    assert(world.dynamicCount() == 2);
+    pairs.clear();
+    world.findPairs(pairs);
+    assert(pairs.size() == 3);  // mover-rock, late-rock, mover-late（各一次）
+
+    // destroy 走 Registry 訊號：proxy 當下移除
+    reg.destroy(late);
+    assert(world.dynamicCount() == 1);
+    reg.destroyMany({rock});
+    assert(world.staticCount() == 0);
+    world.sync(reg);
+    pairs.clear();
+    world.findPairs(pairs);
+    assert(pairs.empty());
+
+    // 跑出世界邊界很遠的物體仍然查得到
+    reg.getComponent<duck::Transform>(mover).x = 50000.0f;
+    world.sync(reg);
+    std::vector<duck::EntityID> found;
+    world.query(duck::makeAabb(50000.0f, 0.0f, 5.0f, 5.0f), found);
+    assert(found.size() == 1 && found[0] == mover);
+
+    std::printf("  [PASS] test_collision_world_persistent_broad_phase\n");
+}
+
+// 暴力法的標準答案：緊密邊界重疊的配對（動態在前；動態 vs 動態 a < b）
+static std::set<std::pair<duck::EntityID, duck::EntityID>> bruteForcePairs(duck::Registry& reg) {
+    std::vector<duck::EntityID> bodies;
+    reg.view<duck::Transform, duck::Collider>([&](duck::EntityID e) { bodies.push_back(e); });
+
+    std::set<std::pair<duck::EntityID, duck::EntityID>> expected;
+    for (auto a : bodies) {
+        if (!reg.hasComponent<duck::RigidBody>(a)) continue;
+        auto boundsA = duck::colliderBounds(reg.getComponent<duck::Transform>(a), reg.getComponent<duck::Collider>(a));
+        for (auto b : bodies) {
+            if (a == b) continue;
+            bool bDynamic = reg.hasComponent<duck::RigidBody>(b);
+            if (bDynamic && b < a) continue;
+            auto boundsB = duck::colliderBounds(reg.getComponent<duck::Transform>(b), reg.getComponent<duck::Collider>(b));
+            if (duck::aabbOverlap(boundsA, boundsB)) expected.insert({a, b});
+        }
+    }
+    return expected;
+}
+
+// 400 個隨機分布的石頭 / 圓，外加比網格格子大的物體：一面靜態長牆、一個動態巨石
+struct MixedScene {
+    duck::EntityID wall = duck::INVALID_ENTITY;
+    duck::EntityID boulder = duck::INVALID_ENTITY;
+};
+
+static MixedScene buildMixedScene(duck::Registry& reg) {
+    std::uint32_t seed = 7u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+
+    for (int i = 0; i < 400; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, rnd(0.0f, 900.0f), rnd(0.0f, 900.0f), 0.0f, 1.0f, 1.0f);
+        if (i % 3 == 0) {
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::AABB, 22.0f, 22.0f, 22.0f, true);
+        } else {
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 19.0f, 19.0f, 19.0f, true);
+            reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        }
+    }
+    MixedScene scene;
+    scene.wall = reg.create();
+    reg.addComponent<duck::Transform>(scene.wall, 450.0f, 450.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(scene.wall, duck::Collider::Type::AABB, 300.0f, 10.0f, 10.0f, true);
+    scene.boulder = reg.create();
+    reg.addComponent<duck::Transform>(scene.boulder, 300.0f, 420.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(scene.boulder, duck::Collider::Type::Circle, 80.0f, 80.0f, 80.0f, true);
+    reg.addComponent<duck::RigidBody>(scene.boulder, 0.0f, 0.0f, 1.0f, 0.9f);
+    return scene;
+}
+
+// 跑一次 sync + findPairs，收集成 set；同一對出現兩次直接失敗
+static void collectPairs(duck::Registry& reg, std::set<std::pair<duck::EntityID, duck::EntityID>>& out) {
+    auto& world = reg.context<duck::CollisionWorld>();
+    std::vector<duck::BodyPair> pairs;
+    world.sync(reg);
+    world.findPairs(pairs);
+    out.clear();
+    for (const auto& pair : pairs) {
+        bool inserted = out.insert({pair.a, pair.b}).second;
+        assert(inserted);
+    }
+}
+
+// 兩種 broad phase 都要遵守同一組配對規則；網格用緊密邊界，結果應該和暴力法完全一樣，
+// 四叉樹用 fat bounds，會多出一些近距離的候選，但不能漏掉任何一對
+void test_hash_grid_matches_brute_force_and_quadtree() {
+    duck::Registry reg;
+    MixedScene scene = buildMixedScene(reg);
+
+    auto& world = reg.context<duck::CollisionWorld>();
+    world.setBroadPhase(duck::BroadPhaseType::HashGrid);
+    assert(world.broadPhaseType() == duck::BroadPhaseType::HashGrid);
+
+    std::set<std::pair<duck::EntityID, duck::EntityID>> gridPairs;
+    collectPairs(reg, gridPairs);
+    auto expected = bruteForcePairs(reg);
+    assert(!expected.empty());
+    assert(gridPairs == expected);
+    assert(gridPairs.count({scene.boulder, scene.wall}) == 1);
+
+    // 移動幾個物體後再比一次（動態表每 tick 重建）
+    reg.view<duck::Transform, duck::RigidBody>([&](duck::EntityID e) {
+        reg.getComponent<duck::Transform>(e).x += 7.0f;
+    });
+    collectPairs(reg, gridPairs);
+    expected = bruteForcePairs(reg);
+    assert(gridPairs == expected);
+
+    // 執行中切回四叉樹：既有的 proxy 全部搬過去，結果是暴力法的超集合
+    world.setBroadPhase(duck::BroadPhaseType::Quadtree);
+    std::set<std::pair<duck::EntityID, duck::EntityID>> treePairs;
+    collectPairs(reg, treePairs);
+    for (const auto& pair : expected) assert(treePairs.count(pair) == 1);
+
+    // 範圍查詢：網格和四叉樹都找得到牆
+    world.setBroadPhase(duck::BroadPhaseType::HashGrid);
+    std::vector<duck::EntityID> found;
+    world.query(duck::makeAabb(700.0f, 450.0f, 2.0f, 2.0f), found);
+    bool foundWall = false;
+    for (auto e : found) foundWall = foundWall || e == scene.wall;
+    assert(foundWall);
+
+    std::printf("  [PASS] test_hash_grid_matches_brute_force_and_quadtree\n");
+}
+
+// Sweep-and-prune 也用緊密邊界：每個 tick 的結果都要和暴力法一樣，
+// 包含插入排序修正順序、中途移除（標記後壓縮）、新增少量物體的情況
+void test_sweep_and_prune_matches_brute_force() {
+    duck::Registry reg;
+    MixedScene scene = buildMixedScene(reg);
+    auto& world = reg.context<duck::CollisionWorld>();
+    world.setBroadPhase(duck::BroadPhaseType::SweepAndPrune);
+
+    std::set<std::pair<duck::EntityID, duck::EntityID>> sapPairs;
+    collectPairs(reg, sapPairs);
+    assert(sapPairs == bruteForcePairs(reg));
+    assert(sapPairs.count({scene.boulder, scene.wall}) == 1);
+
+    std::uint32_t seed = 99u;
+    for (int tick = 0; tick < 10; ++tick) {
+        reg.view<duck::Transform, duck::RigidBody>([&](duck::EntityID e) {
+            seed = seed * 1664525u + 1013904223u;
+            auto& tf = reg.getComponent<duck::Transform>(e);
+            tf.x += static_cast<float>(static_cast<int>(seed >> 28) - 8);
+            tf.y += static_cast<float>(static_cast<int>((seed >> 24) & 15u) - 8);
+        });
+        if (tick == 3) reg.destroy(scene.boulder);
+        if (tick == 5) {
+            auto e = reg.create();
+            reg.addComponent<duck::Transform>(e, 450.0f, 440.0f, 0.0f, 1.0f, 1.0f);
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 19.0f, 19.0f, 19.0f, true);
+            reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        }
+        collectPairs(reg, sapPairs);
+        assert(sapPairs == bruteForcePairs(reg));
+    }
+
+    std::vector<duck::EntityID> found;
+    world.query(duck::makeAabb(700.0f, 450.0f, 2.0f, 2.0f), found);
+    bool foundWall = false;
+    for (auto e : found) foundWall = foundWall || e == scene.wall;
+    assert(foundWall);
+
+    std::printf("  [PASS] test_sweep_and_prune_matches_brute_force\n");
+}
+
+// LBVH 每次整棵重建，同樣用緊密邊界：在 CollisionWorld 裡跟 sap 一樣逐 tick 和暴力法比對；
+// 單獨拿來用時（含靜態 proxy、中途移除、6000 個 proxy 讓建樹真的切成好幾塊），
+// 配對和暴力法一樣、輸出順序和執行緒數無關，沒有變動時不會重建
+void test_linear_bvh_matches_brute_force() {
+    {
+        duck::Registry reg;
+        MixedScene scene = buildMixedScene(reg);
+        auto& world = reg.context<duck::CollisionWorld>();
+        world.setBroadPhaseThreadCount(4);
+        world.setBroadPhase(duck::BroadPhaseType::Lbvh);
+        assert(world.broadPhaseType() == duck::BroadPhaseType::Lbvh);
+
+        std::set<std::pair<duck::EntityID, duck::EntityID>> bvhPairs;
+        collectPairs(reg, bvhPairs);
+        assert(bvhPairs == bruteForcePairs(reg));
+        assert(bvhPairs.count({scene.boulder, scene.wall}) == 1);
+
+        // 每個 tick 所有動態物體都瞬移到隨機位置：LBVH 本來就整棵重建，不在乎移動多遠
+        std::uint32_t seed = 5u;
+        for (int tick = 0; tick < 6; ++tick) {
+            reg.view<duck::Transform, duck::RigidBody>([&](duck::EntityID e) {
+                seed = seed * 1664525u + 1013904223u;
+                auto& tf = reg.getComponent<duck::Transform>(e);
+                tf.x = static_cast<float>(seed >> 22);
+                tf.y = static_cast<float>((seed >> 12) & 1023u);
+            });
+            if (tick == 2) reg.destroy(scene.boulder);
+            collectPairs(reg, bvhPairs);
+            assert(bvhPairs == bruteForcePairs(reg));
+        }
+    }
+
+    std::uint32_t seed = 31u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    struct Item {
+        duck::Aabb bounds;
+        bool isStatic = false;
+        bool alive = true;
+        duck::CollisionFilter filter;
+    };
+    std::vector<Item> items;
+    for (int i = 0; i < 6000; ++i) {
+        Item item;
+        float half = (i % 97 == 0) ? rnd(40.0f, 120.0f) : rnd(2.0f, 9.0f);
+        item.bounds = duck::makeAabb(rnd(0.0f, 3000.0f), rnd(0.0f, 3000.0f), half, rnd(2.0f, 9.0f));
+        item.isStatic = (i % 5 == 0);
+        if (i % 7 == 0) item.filter = {2u, ~2u};   // 第 2 層彼此不碰
+        items.push_back(item);
+    }
+
+    auto bruteForce = [&](size_t& pruned) {
+        std::set<std::pair<duck::EntityID, duck::EntityID>> expected;
+        pruned = 0;
+        for (size_t a = 0; a < items.size(); ++a) {
+            if (!items[a].alive || items[a].isStatic) continue;
+            for (size_t b = 0; b < items.size(); ++b) {
+                if (a == b || !items[b].alive) continue;
+                if (!items[b].isStatic && b < a) continue;
+                if (!duck::aabbOverlap(items[a].bounds, items[b].bounds)) continue;
+                if (!duck::filtersAccept(items[a].filter, items[b].filter)) {
+                    ++pruned;
+                    continue;
+                }
+                expected.insert({static_cast<duck::EntityID>(a), static_cast<duck::EntityID>(b)});
+            }
+        }
+        return expected;
+    };
+
+    std::vector<std::vector<duck::BodyPair>> outputs;
+    for (unsigned threads : {1u, 4u}) {
+        duck::LinearBvh bvh;
+        bvh.setThreadCount(threads);
+        std::vector<duck::BroadPhase::ProxyID> proxies;
+        for (size_t i = 0; i < items.size(); ++i) {
+            items[i].alive = true;
+            proxies.push_back(bvh.insert(static_cast<duck::EntityID>(i), items[i].bounds, items[i].isStatic,
+                                         items[i].filter));
+        }
+        // 移除一些，空出來的 slot 留在 free list 上
+        for (size_t i = 3; i < items.size(); i += 11) {
+            bvh.remove(proxies[i]);
+            items[i].alive = false;
+        }
+        assert(bvh.proxyCount() == 6000 - 546);
+
+        std::vector<duck::BodyPair> pairs;
+        bvh.findPairs(pairs);
+        size_t pruned = 0;
+        auto expected = bruteForce(pruned);
+        std::set<std::pair<duck::EntityID, duck::EntityID>> got;
+        for (const auto& pair : pairs) assert(got.insert({pair.a, pair.b}).second);
+        assert(!expected.empty() && pruned > 0);
+        assert(got == expected);
+        assert(bvh.lastPrunedPairs() == pruned);
+        assert(bvh.lastStats().pairs == pairs.size());
+        assert(bvh.nodeCount() == bvh.proxyCount() - 1);
+        outputs.push_back(pairs);
+
+        // 沒有變動：查詢不會重建
+        size_t builds = bvh.buildCount();
+        for (int q = 0; q < 50; ++q) {
+            duck::Aabb area = duck::makeAabb(rnd(0.0f, 3000.0f), rnd(0.0f, 3000.0f), rnd(5.0f, 300.0f), rnd(5.0f, 300.0f));
+            std::vector<duck::EntityID> found;
+            bvh.query(area, found);
+            std::set<duck::EntityID> foundSet(found.begin(), found.end());
+            assert(foundSet.size() == found.size());
+            std::set<duck::EntityID> want;
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (items[i].alive && duck::aabbOverlap(area, items[i].bounds)) want.insert(static_cast<duck::EntityID>(i));
+            }
+            assert(foundSet == want);
+        }
+        assert(bvh.buildCount() == builds);
+
+        // 全部擠在同一點（Morton code 全部相同）：退化成依 proxy 編號排序的樹，結果照樣正確
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (items[i].alive) bvh.update(proxies[i], duck::makeAabb(500.0f, 500.0f, 1.0f, 1.0f));
+        }
+        pairs.clear();
+        bvh.findPairs(pairs);
+        assert(bvh.buildCount() == builds + 1);
+        size_t dynamicCount = 0, staticCount = 0;
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (!items[i].alive) continue;
+            (items[i].isStatic ? staticCount : dynamicCount)++;
+        }
+        assert(bvh.lastStats().candidatePairs ==
+               dynamicCount * (dynamicCount - 1) / 2 + dynamicCount * staticCount);
+    }
+    assert(outputs[0].size() == outputs[1].size());
+    for (size_t i = 0; i < outputs[0].size(); ++i) {
+        assert(outputs[0][i].a == outputs[1][i].a && outputs[0][i].b == outputs[1][i].b);
+    }
+
+    std::printf("  [PASS] test_linear_bvh_matches_brute_force\n");
+}
+
+// 四叉樹的雙樹走訪：和「每個動態物體各查一次 fat bounds」的結果完全一樣，每一對只出現一次，
+// 包含放在根節點的世界外物件、大物件（放在淺層節點）和靜態 proxy
+void test_quadtree_self_collision_matches_queries() {
+    std::uint32_t seed = 77u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    duck::LooseQuadtree tree;
+    tree.reset({0.0f, 0.0f, 1000.0f, 1000.0f});
+    for (int i = 0; i < 3000; ++i) {
+        float half = (i % 50 == 0) ? rnd(30.0f, 150.0f) : rnd(3.0f, 10.0f);
+        float x = rnd(0.0f, 1000.0f);
+        float y = rnd(0.0f, 1000.0f);
+        // 幾個落在世界外，擠在根節點
+        if (i % 600 == 1) x = rnd(-400.0f, -300.0f);
+        tree.insert(static_cast<duck::EntityID>(i), duck::makeAabb(x, y, half, half), i % 4 == 0, {});
+    }
+    assert(tree.outOfBoundsCount() == 5);
+
+    std::set<std::pair<duck::EntityID, duck::EntityID>> expected;
+    std::vector<duck::BroadPhase::ProxyID> found;
+    for (int i = 0; i < 3000; ++i) {
+        const auto& self = tree.proxy(i);
+        if (self.isStatic) continue;
+        found.clear();
+        tree.queryProxies(self.fat, found);
+        for (auto id : found) {
+            const auto& other = tree.proxy(id);
+            if (id == i || (!other.isStatic && other.entity < self.entity)) continue;
+            expected.insert({self.entity, other.entity});
+        }
+    }
+
+    std::vector<duck::BodyPair> pairs;
+    tree.findPairs(pairs);
+    std::set<std::pair<duck::EntityID, duck::EntityID>> got;
+    for (const auto& pair : pairs) assert(got.insert({pair.a, pair.b}).second);
+    assert(!expected.empty());
+    assert(got == expected);
+    const auto& stats = tree.lastStats();
+    assert(stats.pairs == pairs.size() && stats.aabbTests >= stats.candidatePairs);
+    std::printf("  [PASS] test_quadtree_self_collision_matches_queries\n");
+}
+
+// StaticBvh 單獨測：隨機查詢和暴力比對；移除不重建（墓碑）、新增後 build() 重建
+void test_static_bvh_matches_brute_force() {
+    duck::StaticBvh bvh;
+    std::vector<duck::Aabb> boxes;
+    std::vector<duck::StaticBvh::ItemID> ids;
+    std::vector<bool> live;
+
+    std::uint32_t seed = 7u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    auto addBox = [&](float x, float y, float hw, float hh) {
+        boxes.push_back(duck::makeAabb(x, y, hw, hh));
+        ids.push_back(bvh.insert(static_cast<duck::EntityID>(boxes.size() - 1), boxes.back()));
+        live.push_back(true);
+    };
+    for (int i = 0; i < 300; ++i) addBox(rnd(0, 2000), rnd(0, 2000), rnd(4, 30), rnd(4, 30));
+    addBox(1000.0f, 1000.0f, 900.0f, 10.0f);  // 一面橫跨大半個地圖的牆
+    bvh.build();
+    assert(!bvh.dirty());
+    assert(bvh.size() == 301);
+
+    auto check = [&]() {
+        for (int q = 0; q < 200; ++q) {
+            duck::Aabb area = duck::makeAabb(rnd(0, 2000), rnd(0, 2000), rnd(1, 120), rnd(1, 120));
+            std::vector<duck::EntityID> found;
+            bvh.query(area, found);
+            std::set<duck::EntityID> got(found.begin(), found.end());
+            assert(got.size() == found.size());  // 不重複
+            std::set<duck::EntityID> expected;
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                if (live[i] && duck::aabbOverlap(boxes[i], area)) expected.insert(static_cast<duck::EntityID>(i));
+            }
+            assert(got == expected);
+        }
+    };
+    check();
+
+    // 移除三分之一：不會觸發重建
+    size_t nodes = bvh.nodeCount();
+    for (size_t i = 0; i < boxes.size(); i += 3) {
+        bvh.remove(ids[i]);
+        live[i] = false;
+    }
+    assert(!bvh.dirty());
+    assert(bvh.nodeCount() == nodes);
+    check();
+
+    // 新增：標記 dirty，build() 後查得到
+    for (int i = 0; i < 50; ++i) addBox(rnd(0, 2000), rnd(0, 2000), rnd(4, 30), rnd(4, 30));
+    assert(bvh.dirty());
+    bvh.build();
+    check();
+    std::printf("  [PASS] test_static_bvh_matches_brute_force\n");
+}
+
+// 靜態物體不在 broad phase 裡：石頭之間永遠不產生配對，配對數只隨「動態 × 附近靜態」成長
+void test_collision_world_keeps_statics_out_of_broad_phase() {
+    duck::Registry reg;
+    for (int i = 0; i < 40; ++i) {
+        auto rock = reg.create();
+        // 石頭彼此重疊排成一列
+        reg.addComponent<duck::Transform>(rock, i * 30.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(rock, duck::Collider::Type::AABB, 20.0f, 20.0f, 20.0f, true);
+    }
+    auto mover = reg.create();
+    reg.addComponent<duck::Transform>(mover, 300.0f, 25.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(mover, duck::Collider::Type::Circle, 10.0f, 10.0f, 10.0f, true);
+    reg.addComponent<duck::RigidBody>(mover, 0.0f, 0.0f, 1.0f, 0.9f);
+
+    auto& world = reg.context<duck::CollisionWorld>();
+    for (auto type : {duck::BroadPhaseType::Quadtree, duck::BroadPhaseType::HashGrid,
+                      duck::BroadPhaseType::SweepAndPrune, duck::BroadPhaseType::Lbvh}) {
+        world.setBroadPhase(type);
+        world.sync(reg);
+        assert(world.staticCount() == 40);
+        assert(world.staticBvh().size() == 40);
+
+        std::vector<duck::BodyPair> pairs;
+        world.findPairs(pairs);
+        // 圓 [290, 310] × [15, 35] 只碰到 x = 270、300、330 三顆石頭（兩側是邊界相切，仍算候選）
+        assert(pairs.size() == 3);
+        for (const auto& pair : pairs) assert(pair.a == mover);
+    }
+    std::printf("  [PASS] test_collision_world_keeps_statics_out_of_broad_phase\n");
+}
+
+// layer / mask：把 MixedScene 分成玩家、敵人、兩種石頭
+//   敵人彼此不碰（mask 去掉 Enemy）；一半的石頭只擋玩家（敵人可以穿過）
+// 四種 broad phase + StaticBvh 都要在產生配對時就把不相容的濾掉，並回報被濾掉的數量
+void test_collision_layers_prune_pairs_in_broad_phase() {
+    using namespace duck;
+    Registry reg;
+    buildMixedScene(reg);
+    int index = 0;
+    reg.view<Transform, Collider>([&](EntityID e) {
+        auto& col = reg.getComponent<Collider>(e);
+        if (reg.hasComponent<RigidBody>(e)) {
+            bool enemy = (index++ % 4) != 0;
+            col.layer = enemy ? CollisionLayer::Enemy : CollisionLayer::Player;
+            col.mask = enemy ? (CollisionLayer::All & ~CollisionLayer::Enemy) : CollisionLayer::All;
+        } else {
+            col.layer = CollisionLayer::Obstacle;
+            col.mask = (index++ % 2) ? CollisionLayer::Player : CollisionLayer::All;
+        }
+    });
+
+    // 暴力法的配對依 filter 分成「要輸出」和「要濾掉」
+    std::set<std::pair<EntityID, EntityID>> accepted;
+    size_t prunedExpected = 0;
+    for (const auto& pair : bruteForcePairs(reg)) {
+        const auto& a = reg.getComponent<Collider>(pair.first);
+        const auto& b = reg.getComponent<Collider>(pair.second);
+        if (filtersAccept({a.layer, a.mask}, {b.layer, b.mask})) {
+            accepted.insert(pair);
+        } else {
+            ++prunedExpected;
+        }
+    }
+    assert(!accepted.empty());
+    assert(prunedExpected > 0);
+
+    auto& world = reg.context<CollisionWorld>();
+    std::set<std::pair<EntityID, EntityID>> pairs;
+    for (auto type : {BroadPhaseType::HashGrid, BroadPhaseType::SweepAndPrune, BroadPhaseType::Lbvh}) {
+        world.setBroadPhase(type);
+        collectPairs(reg, pairs);
+        assert(pairs == accepted);
+        assert(world.lastPrunedPairs() == prunedExpected);
+    }
+    // 四叉樹用 fat bounds：候選是超集合，濾掉的也只會更多
+    world.setBroadPhase(BroadPhaseType::Quadtree);
+    collectPairs(reg, pairs);
+    for (const auto& pair : accepted) assert(pairs.count(pair) == 1);
+    for (const auto& pair : pairs) {
+        const auto& a = reg.getComponent<Collider>(pair.first);
+        const auto& b = reg.getComponent<Collider>(pair.second);
+        assert(filtersAccept({a.layer, a.mask}, {b.layer, b.mask}));
+    }
+    assert(world.lastPrunedPairs() >= prunedExpected);
+
+    // CollisionSystem 把數字交給 profiler
+    CollisionSystem system;
+    system.update(reg, 1.0f / 60.0f);
+    assert(system.lastPrunedPairCount() == world.lastPrunedPairs());
+    std::printf("  [PASS] test_collision_layers_prune_pairs_in_broad_phase\n");
+}
+
+// 子彈預設不打 Player 層：擋在路上的玩家不會吃掉子彈，後面的敵人照樣被打中；
+// mask 含 Player 的子彈則停在玩家身上
+void test_bullet_mask_skips_player_layer() {
+    using namespace duck;
+    const float dt = 1.0f / 60.0f;
+    Registry reg;
+    auto spawnBody = [&](float x, float y, std::uint32_t layer) {
+        auto e = reg.create();
+        reg.addComponent<Transform>(e, x, y, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<Collider>(e, Collider::Type::Circle, 16.0f, 16.0f, 16.0f, true, layer, CollisionLayer::All);
+        reg.addComponent<RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        reg.addComponent<Health>(e, 5.0f, 5.0f);
+        return e;
+    };
+    // 子彈這個 tick 從 x=0 飛到 x=120：途中先經過玩家（x=50）再到敵人（x=100）
+    auto player = spawnBody(50.0f, 0.0f, CollisionLayer::Player);
+    auto enemy = spawnBody(100.0f, 0.0f, CollisionLayer::Enemy);
+    auto bullet = spawnMovedBullet(reg, 120.0f, 0.0f, 7200.0f, 0.0f);
+
+    auto shield = spawnBody(50.0f, 300.0f, CollisionLayer::Player);
+    auto friendly = spawnMovedBullet(reg, 120.0f, 300.0f, 7200.0f, 0.0f, CollisionLayer::All);
+
+    CollisionSystem system;
+    system.update(reg, dt);
+
+    assert(!bulletAlive(reg, bullet));
+    assert(approx(reg.getComponent<Health>(player).currentHP, 5.0f));
+    assert(approx(reg.getComponent<Health>(enemy).currentHP, 4.0f));
+    assert(!bulletAlive(reg, friendly));
+    assert(approx(reg.getComponent<Health>(shield).currentHP, 4.0f));
+    std::printf("  [PASS] test_bullet_mask_skips_player_layer\n");
+}
+
+// integrate：三種 SIMD 等級逐位元相同（37 顆，AVX2 / SSE2 都有尾端），過期的移除
+void test_projectile_manager_integrate_and_expire() {
+    const float dt = 1.0f / 60.0f;
+    std::vector<std::vector<float>> positions;
+    for (auto level : {duck::SimdLevel::Scalar, duck::SimdLevel::SSE2, duck::SimdLevel::AVX2}) {
+        duck::ProjectileManager projectiles;
+        projectiles.setSimdLevel(level);
+        std::vector<duck::ProjectileManager::ProjectileID> ids;
+        for (int i = 0; i < 37; ++i) {
+            duck::ProjectileSpawn spawn;
+            spawn.x = 3.1f * static_cast<float>(i);
+            spawn.y = -7.7f * static_cast<float>(i);
+            spawn.vx = 900.0f - 13.3f * static_cast<float>(i);
+            spawn.vy = 17.9f * static_cast<float>(i);
+            // 每 5 顆有一顆只活 2 個 tick
+            spawn.lifetime = (i % 5 == 0) ? dt * 1.5f : 1.0f;
+            ids.push_back(projectiles.spawn(spawn));
+        }
+        for (int tick = 0; tick < 3; ++tick) projectiles.integrate(dt);
+
+        assert(projectiles.size() == 37 - 8);
+        for (int i = 0; i < 37; ++i) assert(projectiles.contains(ids[static_cast<size_t>(i)]) == (i % 5 != 0));
+        std::vector<float> xy;
+        for (size_t i = 0; i < projectiles.size(); ++i) {
+            xy.push_back(projectiles.x(i));
+            xy.push_back(projectiles.y(i));
+        }
+        positions.push_back(xy);
+    }
+    for (const auto& xy : positions) {
+        assert(xy.size() == positions[0].size());
+        assert(std::memcmp(xy.data(), positions[0].data(), xy.size() * sizeof(float)) == 0);
+    }
+    std::printf("  [PASS] test_projectile_manager_integrate_and_expire\n");
+}
+
+// 依格子分批查詢的結果要和每顆子彈各查一次（batch = 1）完全一樣：
+// 同樣的命中事件（順序、子彈、目標），批次數遠少於子彈數
+void test_projectile_sweep_batches_match_single_queries() {
+    const float dt = 1.0f / 60.0f;
+    std::vector<duck::ProjectileHit> results[2];
+    size_t batchCounts[2] = {0, 0};
+    const size_t batchSizes[2] = {1, duck::ProjectileManager::SWEEP_BATCH};
+    for (int run = 0; run < 2; ++run) {
+        duck::Registry reg;
+        buildMixedScene(reg);
+        auto& world = reg.context<duck::CollisionWorld>();
+        world.setBroadPhase(duck::BroadPhaseType::HashGrid);
+        world.sync(reg);
+
+        std::uint32_t seed = 5u;
+        auto rnd = [&](float lo, float hi) {
+            seed = seed * 1664525u + 1013904223u;
+            return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+        };
+        auto& projectiles = reg.context<duck::ProjectileManager>();
+        projectiles.setSweepBatchSize(batchSizes[run]);
+        for (int i = 0; i < 3000; ++i) {
+            float x = rnd(0.0f, 900.0f);
+            float y = rnd(0.0f, 900.0f);
+            spawnMovedBullet(reg, x, y, rnd(-3000.0f, 3000.0f), rnd(-3000.0f, 3000.0f));
+        }
+        projectiles.sweep(reg, world, dt, results[run]);
+        batchCounts[run] = projectiles.lastBatchCount();
+        assert(projectiles.size() + results[run].size() == 3000);
+    }
+
+    assert(!results[0].empty());
+    assert(results[0].size() == results[1].size());
+    for (size_t i = 0; i < results[0].size(); ++i) {
+        assert(results[0][i].projectile == results[1][i].projectile);
+        assert(results[0][i].target == results[1][i].target);
+        assert(sameBits(results[0][i].x, results[1][i].x));
+        assert(sameBits(results[0][i].y, results[1][i].y));
+    }
+    assert(batchCounts[0] == 3000);
+    assert(batchCounts[1] < 3000 / 4);
+    std::printf("  [PASS] test_projectile_sweep_batches_match_single_queries\n");
+}
+
+void test_contact_cache_begin_stay_end() {
+    duck::ContactCache cache;
+    assert(duck::makePairKey(3, 9) == duck::makePairKey(9, 3));
+
+    cache.beginFrame();
+    cache.touch(1, 2);
+    cache.touch(5, 3);
+    cache.endFrame();
+    assert(cache.begins().size() == 2 && cache.stays().empty() && cache.ends().empty());
+    assert(cache.begins()[1].a == 5 && cache.begins()[1].b == 3);  // 保留第一次給出的順序
+
+    cache.beginFrame();
+    cache.touch(2, 1);  // 反向呼叫也是同一對
+    cache.endFrame();
+    assert(cache.begins().empty());
+    assert(cache.stays().size() == 1 && cache.stays()[0].a == 1 && cache.stays()[0].b == 2);
+    assert(cache.ends().size() == 1 && cache.ends()[0].a == 5);
+    assert(cache.touching(1, 2) && !cache.touching(3, 5));
+
+    // 分開一個 tick 再接觸：重新 Begin
+    cache.beginFrame();
+    cache.endFrame();
+    assert(cache.ends().size() == 1 && cache.contactCount() == 0);
+    cache.beginFrame();
+    cache.touch(1, 2);
+    cache.endFrame();
+    assert(cache.begins().size() == 1);
+
+    // 大量配對：表會長大，墓碑會被清掉，Begin / Stay 計數保持正確
+    for (int frame = 0; frame < 6; ++frame) {
+        cache.beginFrame();
+        int first = frame % 2 == 0 ? 0 : 500;  // 偶數 tick 和奇數 tick 的配對有一半重疊
+        for (int i = first; i < first + 1000; ++i) {
+            cache.touch(static_cast<duck::EntityID>(i), static_cast<duck::EntityID>(i + 100000));
+        }
+        cache.endFrame();
+        if (frame > 0) {
+            assert(cache.stays().size() == 500);
+            assert(cache.begins().size() == 500);
+            assert(cache.ends().size() == 500);
+        }
+        assert(cache.contactCount() == 1000);
+    }
+    assert(cache.capacity() >= 2000);
+
+    std::printf("  [PASS] test_contact_cache_begin_stay_end\n");
+}
+
+void test_collision_system_emits_contact_events() {
+    duck::Registry reg;
+    auto a = reg.create();
+    reg.addComponent<duck::Transform>(a, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(a, duck::Collider::Type::Circle, 10.0f, 10.0f, 10.0f, true);
+    reg.addComponent<duck::RigidBody>(a, 0.0f, 0.0f, 1.0f, 0.9f);
+    auto b = reg.create();
+    reg.addComponent<duck::Transform>(b, 15.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(b, duck::Collider::Type::Circle, 10.0f, 10.0f, 10.0f, true);
+    reg.addComponent<duck::RigidBody>(b, 0.0f, 0.0f, 1.0f, 0.9f);
+
+    duck::CollisionSystem system;
+    auto& contacts = reg.context<duck::ContactCache>();
+
+    system.update(reg, 1.0f / 60.0f);
+    assert(contacts.begins().size() == 1);
+    assert(contacts.begins()[0].a == a && contacts.begins()[0].b == b);
+
+    // 推開後又被擠回來（仍然重疊）→ Stay
+    reg.getComponent<duck::Transform>(a).x = 0.0f;
+    reg.getComponent<duck::Transform>(b).x = 15.0f;
+    system.update(reg, 1.0f / 60.0f);
+    assert(contacts.begins().empty() && contacts.stays().size() == 1);
+
+    reg.getComponent<duck::Transform>(b).x = 200.0f;
+    system.update(reg, 1.0f / 60.0f);
+    assert(contacts.stays().empty() && contacts.ends().size() == 1);
+    assert(contacts.contactCount() == 0);
+
+    std::printf("  [PASS] test_collision_system_emits_contact_events\n");
+}
+
+// 批次 narrow phase 的每個 SIMD 等級都要和純量函式逐位元相同
+// 座標範圍刻意取小，讓大部分配對都有撞到；數量不是 8 的倍數，尾端會走純量
+void test_narrow_phase_batch_matches_scalar() {
+    std::uint32_t seed = 2024u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+
+    // kind 3 / 4 是圓 vs OBB、OBB vs OBB：(ca, sa) / (cb, sb) 是兩邊的 rotation
+    struct Input { int kind; float v[8]; bool flip; float ca = 1.0f, sa = 0.0f, cb = 1.0f, sb = 0.0f; };
+    std::vector<Input> inputs;
+    for (int i = 0; i < 1503; ++i) {
+        Input in{i % 5, {}, (i % 7) == 0};
+        for (float& v : in.v) v = rnd(-30.0f, 30.0f);
+        for (int k : {2, 3, 6, 7}) in.v[k] = std::abs(in.v[k]) + 1.0f;  // 尺寸取正
+        if (i % 50 == 0) { in.v[0] = in.v[4]; in.v[1] = in.v[5]; }      // 中心完全重合
+        float angleA = i % 11 == 0 ? 0.0f : rnd(-3.2f, 3.2f);
+        float angleB = i % 13 == 0 ? 0.0f : rnd(-3.2f, 3.2f);
+        in.ca = std::cos(angleA); in.sa = std::sin(angleA);
+        in.cb = std::cos(angleB); in.sb = std::sin(angleB);
+        inputs.push_back(in);
+    }
+    // 剛好相切、圓心落在 AABB 內部的固定案例
+    inputs.push_back({0, {0, 0, 10, 10, 20, 0, 10, 10}, false});
+    inputs.push_back({2, {3, 1, 5, 5, 0, 0, 10, 8}, false});
+    inputs.push_back({2, {-9, 0, 5, 5, 0, 0, 10, 8}, true});
+
+    for (auto level : {duck::SimdLevel::Scalar, duck::SimdLevel::SSE2, duck::SimdLevel::AVX2}) {
+        duck::NarrowPhaseBatch batch;
+        batch.setSimdLevel(level);
+        batch.reset(inputs.size());
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const float* v = inputs[i].v;
+            auto pair = static_cast<std::uint32_t>(i);
+            if (inputs[i].kind == 0) batch.addCircleCircle(pair, v[0], v[1], v[2], v[4], v[5], v[6]);
+            if (inputs[i].kind == 1) batch.addAabbAabb(pair, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+            if (inputs[i].kind == 2) batch.addCircleAabb(pair, v[0], v[1], v[2], v[4], v[5], v[6], v[7], inputs[i].flip);
+            if (inputs[i].kind == 3) {
+                batch.addCircleObb(pair, v[0], v[1], v[2], v[4], v[5], v[6], v[7], inputs[i].cb, inputs[i].sb,
+                                   inputs[i].flip);
+            }
+            if (inputs[i].kind == 4) {
+                batch.addObbObb(pair, v[0], v[1], v[2], v[3], inputs[i].ca, inputs[i].sa,
+                                v[4], v[5], v[6], v[7], inputs[i].cb, inputs[i].sb);
+            }
+        }
+        batch.run();
+
+        int hits = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const float* v = inputs[i].v;
+            float nx = 0.0f, ny = 0.0f, depth = 0.0f;
+            bool hit = false;
+            if (inputs[i].kind == 0) hit = duck::circleVsCircle(v[0], v[1], v[2], v[4], v[5], v[6], nx, ny, depth);
+            if (inputs[i].kind == 1) hit = duck::aabbVsAabb(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], nx, ny, depth);
+            if (inputs[i].kind == 2) {
+                hit = duck::circleVsAabb(v[0], v[1], v[2], v[4], v[5], v[6], v[7], nx, ny, depth);
+                if (inputs[i].flip) { nx = -nx; ny = -ny; }
+            }
+            if (inputs[i].kind == 3) {
+                hit = duck::circleVsObb(v[0], v[1], v[2], v[4], v[5], v[6], v[7], inputs[i].cb, inputs[i].sb,
+                                        nx, ny, depth);
+                if (inputs[i].flip) { nx = -nx; ny = -ny; }
+            }
+            if (inputs[i].kind == 4) {
+                hit = duck::obbVsObb(v[0], v[1], v[2], v[3], inputs[i].ca, inputs[i].sa,
+                                     v[4], v[5], v[6], v[7], inputs[i].cb, inputs[i].sb, nx, ny, depth);
+            }
+
+            const auto& r = batch.result(i);
+            assert(r.hit == hit);
+            if (!hit) continue;
+            ++hits;
+            assert(sameBits(r.nx, nx) && sameBits(r.ny, ny) && sameBits(r.depth, depth));
+        }
+        assert(hits > 450);
+        std::printf("  [PASS] test_narrow_phase_batch_matches_scalar (%s, %d hits)\n",
+                    duck::simdLevelName(batch.simdLevel()), hits);
+    }
+}
+
+// ─────────────────────────────────────────
+// 平行 narrow phase：結果和執行緒數量無關
+// ─────────────────────────────────────────
+
+void test_worker_pool_parallel_for_covers_range() {
+    for (unsigned threads : {1u, 2u, 5u}) {
+        duck::WorkerPool pool(threads);
+        assert(pool.threadCount() == threads);
+        for (size_t count : {size_t{0}, size_t{1}, size_t{999}, size_t{10000}}) {
+            std::vector<int> visits(count, 0);
+            pool.parallelFor(count, 64, [&](size_t begin, size_t end) {
+                assert(begin < end && end - begin <= 64);
+                for (size_t i = begin; i < end; ++i) ++visits[i];
+            });
+            for (int v : visits) assert(v == 1);
+        }
+    }
+    std::printf("  [PASS] test_worker_pool_parallel_for_covers_range\n");
+}
+
+// 擠成一團的場景：大量互相重疊的圓 + 動態/靜態 AABB，其中幾個停用
+static void buildCrowdScene(duck::Registry& reg) {
+    std::uint32_t seed = 31u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    for (int i = 0; i < 3000; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, rnd(0, 700), rnd(0, 700), 0.0f, 1.0f, 1.0f);
+        if (i % 10 == 0) {
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::AABB, rnd(5, 20), rnd(5, 20), 0.0f, true);
+        } else {
+            float r = rnd(6, 14);
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, r, r, r, true);
+        }
+        if (i % 7 != 0) reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        if (i % 101 == 0) reg.setEnabled(e, false);
+    }
+}
+
+// 舊版逐對推開的循序參考：同樣的 broad phase 配對、純量 narrow phase、依配對順序直接寫 Transform；
+// 每一輪 relaxation 都用上一輪推開後的位置重新測試全部配對（場景裡沒有睡著的物體）
+static void referenceNarrowPhase(duck::Registry& reg, int iterations) {
+    auto& world = reg.context<duck::CollisionWorld>();
+    world.sync(reg);
+    std::vector<duck::BodyPair> pairs;
+    world.findPairs(pairs);
+
+    struct Hit { size_t pair; float nx, ny, depth; };
+    std::vector<Hit> hits;
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        hits.clear();
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            duck::EntityID A = pairs[i].a, B = pairs[i].b;
+            if (!reg.isEnabled(A) || !reg.isEnabled(B)) continue;
+            const auto& tfA = reg.getComponent<duck::Transform>(A);
+            const auto& tfB = reg.getComponent<duck::Transform>(B);
+            const auto& colA = reg.getComponent<duck::Collider>(A);
+            const auto& colB = reg.getComponent<duck::Collider>(B);
+            float nx = 0, ny = 0, depth = 0;
+            bool hit;
+            if (colA.type == duck::Collider::Type::Circle && colB.type == duck::Collider::Type::Circle) {
+                hit = duck::circleVsCircle(tfA.x, tfA.y, colA.radius, tfB.x, tfB.y, colB.radius, nx, ny, depth);
+            } else if (colA.type == duck::Collider::Type::AABB && colB.type == duck::Collider::Type::AABB) {
+                hit = duck::aabbVsAabb(tfA.x, tfA.y, colA.halfW, colA.halfH, tfB.x, tfB.y, colB.halfW, colB.halfH,
+                                       nx, ny, depth);
+            } else if (colA.type == duck::Collider::Type::AABB) {
+                hit = duck::circleVsAabb(tfB.x, tfB.y, colB.radius, tfA.x, tfA.y, colA.halfW, colA.halfH,
+                                         nx, ny, depth);
+                nx = -nx; ny = -ny;
+            } else {
+                hit = duck::circleVsAabb(tfA.x, tfA.y, colA.radius, tfB.x, tfB.y, colB.halfW, colB.halfH,
+                                         nx, ny, depth);
+            }
+            if (hit) hits.push_back({i, nx, ny, depth});
+        }
+        // 這一輪的配對都用這一輪開頭的位置，算完才依配對順序推開
+        for (const Hit& h : hits) {
+            auto& tfA = reg.getComponent<duck::Transform>(pairs[h.pair].a);
+            auto& tfB = reg.getComponent<duck::Transform>(pairs[h.pair].b);
+            bool aDyn = reg.hasComponent<duck::RigidBody>(pairs[h.pair].a);
+            bool bDyn = reg.hasComponent<duck::RigidBody>(pairs[h.pair].b);
+            if (aDyn && bDyn) {
+                tfA.x -= h.nx * h.depth * 0.5f; tfA.y -= h.ny * h.depth * 0.5f;
+                tfB.x += h.nx * h.depth * 0.5f; tfB.y += h.ny * h.depth * 0.5f;
+            } else if (aDyn) {
+                tfA.x -= h.nx * h.depth; tfA.y -= h.ny * h.depth;
+            } else if (bDyn) {
+                tfB.x += h.nx * h.depth; tfB.y += h.ny * h.depth;
+            }
+        }
+    }
+}
+
+static std::vector<float> snapshotPositions(duck::Registry& reg) {
+    std::vector<float> out;
+    reg.view<duck::Transform>([&](duck::EntityID e) {
+        const auto& tf = reg.getComponent<duck::Transform>(e);
+        out.push_back(tf.x);
+        out.push_back(tf.y);
+    }, duck::ViewFilter::IncludeDisabled);
+    return out;
+}
+
+void test_parallel_narrow_phase_is_deterministic() {
+    for (int iterations : {1, duck::CollisionSystem::DEFAULT_SOLVER_ITERATIONS}) {
+        duck::Registry reference;
+        buildCrowdScene(reference);
+        for (int tick = 0; tick < 4; ++tick) referenceNarrowPhase(reference, iterations);
+        std::vector<float> expected = snapshotPositions(reference);
+
+        for (unsigned threads : {1u, 2u, 3u, 8u}) {
+            duck::Registry reg;
+            buildCrowdScene(reg);
+            duck::CollisionSystem system;
+            system.setThreadCount(threads);
+            system.setSolverIterations(iterations);
+            size_t contacts = 0;
+            for (int tick = 0; tick < 4; ++tick) {
+                system.update(reg, 1.0f / 60.0f);
+                contacts += reg.context<duck::ContactCache>().contactCount();
+            }
+            std::vector<float> got = snapshotPositions(reg);
+            assert(got.size() == expected.size());
+            assert(std::memcmp(got.data(), expected.data(), got.size() * sizeof(float)) == 0);
+            assert(contacts > 1000);
+        }
+    }
+    std::printf("  [PASS] test_parallel_narrow_phase_is_deterministic\n");
+}
+
+// 一個 tick 之後還剩多少重疊：動態圓兩兩之間的最大穿透深度
+static float maxCrowdPenetration(duck::Registry& reg) {
+    std::vector<duck::EntityID> circles;
+    reg.view<duck::Transform, duck::Collider, duck::RigidBody>([&](duck::EntityID e) {
+        if (reg.getComponent<duck::Collider>(e).type == duck::Collider::Type::Circle) circles.push_back(e);
+    });
+    float worst = 0.0f;
+    for (size_t i = 0; i < circles.size(); ++i) {
+        const auto& a = reg.getComponent<duck::Transform>(circles[i]);
+        float ra = reg.getComponent<duck::Collider>(circles[i]).radius;
+        for (size_t j = i + 1; j < circles.size(); ++j) {
+            const auto& b = reg.getComponent<duck::Transform>(circles[j]);
+            float rb = reg.getComponent<duck::Collider>(circles[j]).radius;
+            float depth = ra + rb - std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+            if (depth > worst) worst = depth;
+        }
+    }
+    return worst;
+}
+
+static void test_relaxation_iterations_settle_crowd() {
+    // 60 隻敵人擠在同一點附近：一輪推開之後還疊在一起，多輪之後幾乎分開
+    auto buildPile = [](duck::Registry& reg) {
+        std::uint32_t seed = 9u;
+        auto rnd = [&](float lo, float hi) {
+            seed = seed * 1664525u + 1013904223u;
+            return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+        };
+        for (int i = 0; i < 60; ++i) {
+            auto e = reg.create();
+            reg.addComponent<duck::Transform>(e, rnd(190.0f, 210.0f), rnd(190.0f, 210.0f), 0.0f, 1.0f, 1.0f);
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 12.0f, 12.0f, 12.0f, true);
+            reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        }
+    };
+
+    float residual[2] = {};
+    int index = 0;
+    for (int iterations : {1, 8}) {
+        duck::Registry reg;
+        buildPile(reg);
+        duck::CollisionSystem system;
+        system.setSolverIterations(iterations);
+        for (int tick = 0; tick < 3; ++tick) system.update(reg, 1.0f / 60.0f);
+        residual[index++] = maxCrowdPenetration(reg);
+    }
+    assert(residual[1] < residual[0] * 0.5f);
+    std::printf("  [PASS] test_relaxation_iterations_settle_crowd\n");
+}
+
+static void test_idle_bodies_sleep_and_wake() {
+    duck::Registry reg;
+    // 8x8 隻靜止的敵人排成格子（互不重疊），旁邊一顆石頭貼著第一隻
+    std::vector<duck::EntityID> idle;
+    for (int i = 0; i < 64; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, 100.0f + 30.0f * static_cast<float>(i % 8),
+                                          100.0f + 30.0f * static_cast<float>(i / 8), 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 14.0f, 14.0f, 14.0f, true);
+        reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        reg.addComponent<duck::Health>(e, 5.0f, 5.0f);
+        idle.push_back(e);
+    }
+    auto rock = reg.create();
+    reg.addComponent<duck::Transform>(rock, 70.0f, 100.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(rock, duck::Collider::Type::AABB, 16.0f, 16.0f, 0.0f, true);
+    // 玩家靜止也不會睡（接觸傷害要靠玩家那一方產生配對）
+    auto player = reg.create();
+    reg.addComponent<duck::Transform>(player, 600.0f, 600.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(player, duck::Collider::Type::Circle, 14.0f, 14.0f, 14.0f, true);
+    reg.addComponent<duck::RigidBody>(player, 0.0f, 0.0f, 1.0f, 0.9f);
+    reg.addComponent<duck::InputControlled>(player);
+
+    duck::CollisionSystem system;
+    auto& world = reg.context<duck::CollisionWorld>();
+    const float dt = 1.0f / 60.0f;
+    for (int tick = 1; tick < duck::CollisionWorld::SLEEP_TICKS; ++tick) system.update(reg, dt);
+    assert(world.sleepingCount() == 0);
+    system.update(reg, dt);
+    assert(world.sleepingCount() == idle.size());
+    assert(!world.isSleeping(player));
+
+    // 全部睡著：睡著的彼此、睡著 vs 石頭都不產生配對
+    system.update(reg, dt);
+    assert(system.lastPairCount() == 0);
+    assert(world.sleepingCount() == idle.size());
+
+    // 子彈照樣打得到睡著的物體，但打中不會叫醒它（沒有推開）
+    auto bullet = spawnMovedBullet(reg, 100.0f, 130.0f, 600.0f, 0.0f);
+    system.update(reg, dt);
+    assert(!bulletAlive(reg, bullet));
+    assert(reg.getComponent<duck::Health>(idle[8]).currentHP < 5.0f);
+    assert(world.isSleeping(idle[8]));
+
+    // 有了速度（被 MovementSystem 移動）→ 下一次 sync 叫醒
+    reg.getComponent<duck::RigidBody>(idle[63]).vx = 50.0f;
+    reg.getComponent<duck::Transform>(idle[63]).x += 50.0f * dt;
+    system.update(reg, dt);
+    assert(!world.isSleeping(idle[63]));
+
+    // 醒著的玩家撞進睡著的那一隻 → 被壓醒、兩邊各推一半
+    auto& playerTf = reg.getComponent<duck::Transform>(player);
+    playerTf.x = 100.0f;
+    playerTf.y = 80.0f;
+    float before = reg.getComponent<duck::Transform>(idle[0]).y;
+    system.update(reg, dt);
+    assert(!world.isSleeping(idle[0]));
+    assert(reg.getComponent<duck::Transform>(idle[0]).y > before);
+    assert(world.sleepingCount() == idle.size() - 2);
+
+    // 關掉休眠：全部叫醒
+    world.setSleepingEnabled(false);
+    assert(world.sleepingCount() == 0);
+    for (auto e : idle) assert(!world.isSleeping(e));
+    std::printf("  [PASS] test_idle_bodies_sleep_and_wake\n");
+}
+
+// CollisionStats：四種 broad phase 下各計數之間的關係都要成立，並且和實際輸出對得上
+//   broad phase 的配對 + StaticBvh 的配對 = 交給 narrow phase 的配對
+//   候選 = 輸出 + 被 layer / mask 濾掉；子彈的查詢數 / 候選數 / 命中數來自 ProjectileManager
+void test_collision_stats_are_consistent() {
+    using namespace duck;
+    for (auto type : {BroadPhaseType::Quadtree, BroadPhaseType::HashGrid, BroadPhaseType::SweepAndPrune,
+                      BroadPhaseType::Lbvh}) {
+        Registry reg;
+        buildMixedScene(reg);
+        int index = 0;
+        reg.view<Transform, Collider, RigidBody>([&](EntityID e) {
+            auto& col = reg.getComponent<Collider>(e);
+            col.layer = CollisionLayer::Enemy;
+            if (index++ % 2) col.mask = CollisionLayer::All & ~CollisionLayer::Enemy;
+        });
+        reg.context<CollisionWorld>().setBroadPhase(type);
+
+        // 30 顆子彈排在牆（y = 450，x 150 ~ 750）裡面，一開始就撞到
+        auto& projectiles = reg.context<ProjectileManager>();
+        for (int i = 0; i < 30; ++i) {
+            ProjectileSpawn spawn;
+            spawn.x = 160.0f + 19.0f * static_cast<float>(i);
+            spawn.y = 450.0f;
+            spawn.vx = 600.0f;
+            projectiles.spawn(spawn);
+        }
+
+        CollisionSystem system;
+        system.update(reg, 1.0f / 60.0f);
+        const CollisionStats& stats = system.lastStats();
+        const BroadPhaseStats& broad = stats.broadPhase;
+
+        assert(stats.ticks == 1);
+        assert(stats.pairs == system.lastPairCount());
+        assert(stats.prunedPairs == system.lastPrunedPairCount());
+        assert(broad.pairs + stats.staticPairs == stats.pairs);
+        assert(broad.candidatePairs == broad.pairs + broad.prunedPairs);
+        assert(broad.prunedPairs > 0);
+        assert(broad.aabbTests >= broad.candidatePairs);
+        assert(stats.staticPairs > 0);
+        assert(stats.hits > 0 && stats.hits <= stats.pairs);
+        assert(stats.iterations >= 1 && stats.iterations <= static_cast<size_t>(system.solverIterations()));
+        assert(stats.narrowTests >= stats.pairs && stats.narrowTests <= stats.pairs * stats.iterations);
+
+        size_t histogramNodes = 0;
+        for (size_t count : broad.entriesHistogram) histogramNodes += count;
+        if (type == BroadPhaseType::SweepAndPrune) {
+            assert(broad.nodesVisited == 0 && histogramNodes == 0);
+        } else if (type == BroadPhaseType::Lbvh) {
+            assert(broad.nodesVisited > 0 && histogramNodes == 0);
+        } else {
+            assert(broad.nodesVisited > 0 && histogramNodes > 0);
+        }
+        if (type == BroadPhaseType::Quadtree) assert(broad.maxDepth > 0);
+
+        assert(stats.bulletQueries == projectiles.lastBatchCount() && stats.bulletQueries > 0);
+        assert(stats.bulletCandidates == projectiles.lastCandidateCount());
+        // 同一批的子彈共用候選：候選數可能比命中數少
+        assert(stats.bulletHits == 30 && stats.bulletCandidates > 0);
+        assert(projectiles.size() == 0);
+
+        // add()：計數相加、maxDepth 取最大
+        CollisionStats total;
+        total.add(stats);
+        total.add(stats);
+        assert(total.ticks == 2 && total.pairs == stats.pairs * 2);
+        assert(total.broadPhase.aabbTests == broad.aabbTests * 2);
+        assert(total.broadPhase.maxDepth == broad.maxDepth);
+        assert(total.broadPhase.entriesHistogram[0] == broad.entriesHistogram[0] * 2);
+    }
+    std::printf("  [PASS] test_collision_stats_are_consistent\n");
+}
+
+// 射線的形狀測試：t、法向量，以及起點在形狀裡、相切、沒有位移這些邊界情況
+void test_ray_shape_tests() {
+    using namespace duck;
+    float t = 0.0f, nx = 0.0f, ny = 0.0f;
+    // 往右打中圓 (100, 0) r = 10：在 x = 90 碰到，法向量朝左
+    assert(rayVsCircle(0.0f, 0.0f, 200.0f, 0.0f, 100.0f, 0.0f, 10.0f, t, nx, ny));
+    assert(approx(t, 0.45f) && approx(nx, -1.0f) && approx(ny, 0.0f));
+    // 太短、方向相反、擦過（相切算命中）、完全錯過
+    assert(!rayVsCircle(0.0f, 0.0f, 50.0f, 0.0f, 100.0f, 0.0f, 10.0f, t, nx, ny));
+    assert(!rayVsCircle(0.0f, 0.0f, -200.0f, 0.0f, 100.0f, 0.0f, 10.0f, t, nx, ny));
+    assert(rayVsCircle(0.0f, 10.0f, 200.0f, 0.0f, 100.0f, 0.0f, 10.0f, t, nx, ny) && approx(ny, 1.0f));
+    assert(!rayVsCircle(0.0f, 11.0f, 200.0f, 0.0f, 100.0f, 0.0f, 10.0f, t, nx, ny));
+    // 起點在圓裡：t = 0，法向量和位移相反
+    assert(rayVsCircle(100.0f, 0.0f, 0.0f, 50.0f, 100.0f, 0.0f, 10.0f, t, nx, ny));
+    assert(t == 0.0f && approx(nx, 0.0f) && approx(ny, -1.0f));
+
+    // 矩形 (100, 50) 半寬 20、半高 10：從左上方斜著打進頂邊
+    assert(rayVsBox(60.0f, 0.0f, 80.0f, 80.0f, 100.0f, 50.0f, 20.0f, 10.0f, t, nx, ny));
+    assert(approx(t, 0.5f) && approx(nx, 0.0f) && approx(ny, -1.0f));
+    // 從右邊水平打進右邊
+    assert(rayVsBox(200.0f, 50.0f, -200.0f, 0.0f, 100.0f, 50.0f, 20.0f, 10.0f, t, nx, ny));
+    assert(approx(t, 0.4f) && approx(nx, 1.0f) && approx(ny, 0.0f));
+    // 沿著頂邊擦過也算；在 slab 外平行移動、太短都不算
+    assert(rayVsBox(0.0f, 40.0f, 200.0f, 0.0f, 100.0f, 50.0f, 20.0f, 10.0f, t, nx, ny));
+    assert(!rayVsBox(0.0f, 39.0f, 200.0f, 0.0f, 100.0f, 50.0f, 20.0f, 10.0f, t, nx, ny));
+    assert(!rayVsBox(0.0f, 50.0f, 70.0f, 0.0f, 100.0f, 50.0f, 20.0f, 10.0f, t, nx, ny));
+    // 起點在矩形裡
+    assert(rayVsBox(100.0f, 50.0f, -30.0f, 0.0f, 100.0f, 50.0f, 20.0f, 10.0f, t, nx, ny));
+    assert(t == 0.0f && approx(nx, 1.0f) && approx(ny, 0.0f));
+    std::printf("  [PASS] test_ray_shape_tests\n");
+}
+
+// 暴力法：每個 solid collider 都測一次，取最小的 t（同 t 取 EntityID 小的）
+static duck::RayHit bruteForceRaycast(duck::Registry& reg, const duck::RayCast& ray) {
+    using namespace duck;
+    RayHit best;
+    reg.view<Transform, Collider>([&](EntityID e) {
+        const auto& tf = reg.getComponent<Transform>(e);
+        const auto& col = reg.getComponent<Collider>(e);
+        if (e == ray.ignore || !col.isSolid || !filtersAccept(ray.filter, {col.layer, col.mask})) return;
+        float t = 0.0f, nx = 0.0f, ny = 0.0f;
+        bool hit = col.type == Collider::Type::Circle
+            ? rayVsCircle(ray.x, ray.y, ray.dx, ray.dy, tf.x, tf.y, col.radius, t, nx, ny)
+            : rayVsBox(ray.x, ray.y, ray.dx, ray.dy, tf.x, tf.y, col.halfW, col.halfH, t, nx, ny);
+        if (!hit || t > best.t || (t == best.t && e >= best.entity)) return;
+        best.entity = e;
+        best.t = t;
+        best.nx = nx;
+        best.ny = ny;
+    });
+    return best;
+}
+
+// CollisionWorld::raycast 和暴力法逐條相同：四種 broad phase、有睡著的物體、
+// 只看 Obstacle 的視線（不查 broad phase）和什麼都打的射線混在同一批
+void test_raycast_matches_brute_force() {
+    using namespace duck;
+    for (auto type : {BroadPhaseType::Quadtree, BroadPhaseType::HashGrid, BroadPhaseType::SweepAndPrune,
+                      BroadPhaseType::Lbvh}) {
+        Registry reg;
+        buildMixedScene(reg);
+        std::vector<EntityID> dynamics;
+        reg.view<Transform, Collider>([&](EntityID e) {
+            auto& col = reg.getComponent<Collider>(e);
+            bool dynamic = reg.hasComponent<RigidBody>(e);
+            col.layer = dynamic ? CollisionLayer::Enemy : CollisionLayer::Obstacle;
+            if (dynamic) dynamics.push_back(e);
+        });
+        auto& world = reg.context<CollisionWorld>();
+        world.setBroadPhase(type);
+
+        // 重疊的推開、其他的靜止下來睡著；再讓一部分醒著動一下
+        CollisionSystem system;
+        for (int tick = 0; tick < CollisionWorld::SLEEP_TICKS + 10; ++tick) system.update(reg, 1.0f / 60.0f);
+        for (size_t i = 0; i < dynamics.size(); i += 3) reg.getComponent<RigidBody>(dynamics[i]).vx = 30.0f;
+        system.update(reg, 1.0f / 60.0f);
+        assert(world.sleepingCount() > 0 && world.sleepingCount() < world.dynamicCount());
+
+        std::uint32_t seed = 11u;
+        auto rnd = [&](float lo, float hi) {
+            seed = seed * 1664525u + 1013904223u;
+            return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+        };
+        std::vector<RayCast> rays;
+        for (int i = 0; i < 400; ++i) {
+            RayCast ray;
+            ray.x = rnd(-50.0f, 950.0f);
+            ray.y = rnd(-50.0f, 950.0f);
+            ray.dx = rnd(-600.0f, 600.0f);
+            ray.dy = i % 7 == 0 ? 0.0f : rnd(-600.0f, 600.0f);
+            if (i % 2) ray.filter = {CollisionLayer::Enemy, CollisionLayer::Obstacle};
+            if (i % 5 == 0) ray.ignore = dynamics[static_cast<size_t>(i) % dynamics.size()];
+            rays.push_back(ray);
+        }
+        std::vector<RayHit> hits;
+        world.raycast(reg, rays, hits);
+        assert(hits.size() == rays.size());
+
+        int hitCount = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            RayHit expected = bruteForceRaycast(reg, rays[i]);
+            assert(hits[i].entity == expected.entity);
+            if (!expected.hit()) continue;
+            ++hitCount;
+            assert(hits[i].t == expected.t && hits[i].nx == expected.nx && hits[i].ny == expected.ny);
+            assert(approx(hits[i].x, rays[i].x + rays[i].dx * expected.t));
+            float length = std::sqrt(rays[i].dx * rays[i].dx + rays[i].dy * rays[i].dy);
+            assert(approx(hits[i].distance, length * expected.t));
+        }
+        assert(hitCount > 100 && hitCount < 400);
+    }
+    std::printf("  [PASS] test_raycast_matches_brute_force\n");
+}
+
+// ─────────────────────────────────────────
+// OBB（旋轉矩形）
+// ─────────────────────────────────────────
+
+static const float QUARTER_TURN_HALF = 0.78539816f;   // 45°
+
+// 沒有旋轉（c = 1、s = 0）時和 AABB 版的結果相同（兩軸重疊量剛好相等時兩邊挑的軸不同，略過）
+void test_obb_matches_aabb_when_unrotated() {
+    std::uint32_t seed = 77u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    int hits = 0;
+    for (int i = 0; i < 2000; ++i) {
+        float ax = rnd(-30, 30), ay = rnd(-30, 30), ahw = rnd(1, 20), ahh = rnd(1, 20);
+        float bx = rnd(-30, 30), by = rnd(-30, 30), bhw = rnd(1, 20), bhh = rnd(1, 20);
+        float nx = 0, ny = 0, depth = 0, ex = 0, ey = 0, expected = 0;
+        bool hit = duck::obbVsObb(ax, ay, ahw, ahh, 1.0f, 0.0f, bx, by, bhw, bhh, 1.0f, 0.0f, nx, ny, depth);
+        bool aabbHit = duck::aabbVsAabb(ax, ay, ahw, ahh, bx, by, bhw, bhh, ex, ey, expected);
+        assert(hit == aabbHit);
+        if (hit && (ahw + bhw) - std::abs(bx - ax) != (ahh + bhh) - std::abs(by - ay)) {
+            ++hits;
+            assert(nx == ex && ny == ey && depth == expected);
+        }
+
+        float r = rnd(1, 20);
+        hit = duck::circleVsObb(ax, ay, r, bx, by, bhw, bhh, 1.0f, 0.0f, nx, ny, depth);
+        aabbHit = duck::circleVsAabb(ax, ay, r, bx, by, bhw, bhh, ex, ey, expected);
+        if (std::abs(expected) > 0.001f) assert(hit == aabbHit);
+        if (hit && aabbHit) assert(approx(nx, ex) && approx(ny, ey) && approx(depth, expected));
+    }
+    assert(hits > 500);
+    std::printf("  [PASS] test_obb_matches_aabb_when_unrotated\n");
+}
+
+void test_circle_vs_rotated_obb() {
+    float c = std::cos(QUARTER_TURN_HALF), s = std::sin(QUARTER_TURN_HALF);
+    float nx = 0, ny = 0, depth = 0;
+    // 半寬 10 的正方形轉 45°：角落伸到 x = 14.14；r = 6 的圓在 (20, 0) 只碰到角落
+    assert(!duck::circleVsAabb(20, 0, 6, 0, 0, 10, 10, nx, ny, depth));
+    assert(duck::circleVsObb(20, 0, 6, 0, 0, 10, 10, c, s, nx, ny, depth));
+    assert(approx(depth, 6.0f - (20.0f - 14.1421f)) && approx(nx, -1.0f) && approx(ny, 0.0f));
+    // 斜對角方向上離邊 11：AABB 版會撞（外接框的角落），OBB 不會
+    assert(!duck::circleVsObb(21, 21, 6, 0, 0, 10, 10, c, s, nx, ny, depth));
+    // 圓心在盒子裡：沿最近的那一面推出去，法向量是那一面轉過的方向
+    assert(duck::circleVsObb(0, -8, 2, 0, 0, 10, 10, c, s, nx, ny, depth));
+    assert(approx(std::abs(nx), 0.70711f) && approx(std::abs(ny), 0.70711f) && ny > 0.0f);
+    std::printf("  [PASS] test_circle_vs_rotated_obb\n");
+}
+
+void test_obb_vs_obb_sat() {
+    float c = std::cos(QUARTER_TURN_HALF), s = std::sin(QUARTER_TURN_HALF);
+    float nx = 0, ny = 0, depth = 0;
+    // 正放的 A 和轉 45° 的 B：B 的角落戳進 A 的右邊 0.14
+    assert(duck::obbVsObb(0, 0, 10, 10, 1, 0, 24, 0, 10, 10, c, s, nx, ny, depth));
+    assert(approx(depth, 10.0f - (24.0f - 14.1421f)) && approx(nx, 1.0f) && approx(ny, 0.0f));
+    assert(!duck::obbVsObb(0, 0, 10, 10, 1, 0, 25, 0, 10, 10, c, s, nx, ny, depth));
+    // 兩個都轉 45°、沿對角線錯開：外接框重疊，但 A 的軸把它們分開
+    assert(!duck::obbVsObb(0, 0, 10, 10, c, s, 15, 15, 5, 5, c, s, nx, ny, depth));
+    assert(duck::obbVsObb(0, 0, 10, 10, c, s, 10, 10, 5, 5, c, s, nx, ny, depth));
+    assert(approx(depth, 15.0f - 14.1421f) && approx(nx, c) && approx(ny, s));
+    // 交換 A、B 法向量反過來
+    float rx = 0, ry = 0, rdepth = 0;
+    assert(duck::obbVsObb(10, 10, 5, 5, c, s, 0, 0, 10, 10, c, s, rx, ry, rdepth));
+    assert(approx(rx, -nx) && approx(ry, -ny) && approx(rdepth, depth));
+
+    // 距離場：45° 正方形的角落在 x = 14.14，(20, 0) 離它 5.86
+    duck::DistanceFieldShape shape{0, 0, 10, 10, false, c, s};
+    assert(approx(duck::exactSignedDistance(shape, 20, 0), 20.0f - 14.1421f));
+    assert(approx(duck::exactSignedDistance(shape, 0, 0), -10.0f));
+    std::printf("  [PASS] test_obb_vs_obb_sat\n");
+}
+
+// 轉 45° 的石頭：推開、子彈、射線都照旋轉後的形狀，而不是外接框
+void test_rotated_rock_collides_as_oriented_box() {
+    const float dt = 1.0f / 60.0f;
+    const float c = std::cos(QUARTER_TURN_HALF), s = std::sin(QUARTER_TURN_HALF);
+    duck::Registry reg;
+    auto rock = reg.create();
+    reg.addComponent<duck::Transform>(rock, 100.0f, 100.0f, QUARTER_TURN_HALF, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(rock, duck::Collider::Type::OBB, 20.0f, 20.0f, 20.0f, true);
+    reg.addComponent<duck::Health>(rock, 5.0f, 5.0f);
+
+    // 壓進石頭右邊角落的圓，和只在外接框左上角裡（離斜邊 11）的圓
+    auto pressed = reg.create();
+    reg.addComponent<duck::Transform>(pressed, 124.0f, 100.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(pressed, duck::Collider::Type::Circle, 5.0f, 5.0f, 5.0f, true);
+    reg.addComponent<duck::RigidBody>(pressed, 0.0f, 0.0f, 1.0f, 0.9f);
+    auto outside = reg.create();
+    reg.addComponent<duck::Transform>(outside, 78.0f, 78.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(outside, duck::Collider::Type::Circle, 3.0f, 3.0f, 3.0f, true);
+    reg.addComponent<duck::RigidBody>(outside, 0.0f, 0.0f, 1.0f, 0.9f);
+
+    // 從左邊打進石頭的子彈，和擦過外接框左下角、離斜邊 12 的子彈
+    auto hitter = spawnMovedBullet(reg, 70.0f, 100.0f, 1800.0f, 0.0f);
+    auto grazer = spawnMovedBullet(reg, 87.4f, 132.6f, 1200.0f, 1200.0f);
+
+    duck::CollisionSystem system;
+    system.update(reg, dt);
+
+    const auto& tf = reg.getComponent<duck::Transform>(pressed);
+    float nx = 0, ny = 0, depth = 0;
+    assert(tf.x != 124.0f || tf.y != 100.0f);
+    assert(!duck::circleVsObb(tf.x, tf.y, 5.0f, 100.0f, 100.0f, 20.0f, 20.0f, c, s, nx, ny, depth) || depth < 0.01f);
+    assert(reg.getComponent<duck::Transform>(outside).x == 78.0f && reg.getComponent<duck::Transform>(outside).y == 78.0f);
+    assert(!bulletAlive(reg, hitter) && bulletAlive(reg, grazer));
+    assert(approx(reg.getComponent<duck::Health>(rock).currentHP, 4.0f));
+
+    // 水平射線在石頭中心上方 24：外接框在 x = 71.7 就會擋住，斜邊要到 x = 95.7
+    auto& world = reg.context<duck::CollisionWorld>();
+    std::vector<duck::RayCast> rays(1);
+    rays[0].x = 40.0f;
+    rays[0].y = 76.0f;
+    rays[0].dx = 120.0f;
+    rays[0].ignore = outside;
+    std::vector<duck::RayHit> hits;
+    world.raycast(reg, rays, hits);
+    assert(hits[0].entity == rock);
+    assert(approx(hits[0].x, 100.0f - (28.2843f - 24.0f)) && approx(hits[0].nx, -c) && approx(hits[0].ny, -s));
+    std::printf("  [PASS] test_rotated_rock_collides_as_oriented_box\n");
+}
+
+// ─────────────────────────────────────────
+// DistanceField
+// ─────────────────────────────────────────
+
+// 牆（矩形，四分之一有旋轉）和柱子（圓）隨機散在 800 × 600 裡
+static std::vector<duck::DistanceFieldShape> buildFieldShapes() {
+    std::uint32_t seed = 5u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    std::vector<duck::DistanceFieldShape> shapes;
+    for (int i = 0; i < 40; ++i) {
+        duck::DistanceFieldShape shape;
+        shape.x = rnd(0.0f, 800.0f);
+        shape.y = rnd(0.0f, 600.0f);
+        shape.isCircle = i % 4 == 0;
+        shape.halfW = rnd(8.0f, 40.0f);
+        shape.halfH = shape.isCircle ? shape.halfW : rnd(8.0f, 40.0f);
+        if (i % 4 == 2) {
+            float angle = rnd(-1.5f, 1.5f);
+            shape.cosR = std::cos(angle);
+            shape.sinR = std::sin(angle);
+        }
+        shapes.push_back(shape);
+    }
+    return shapes;
+}
+
+static float exactUnionDistance(const std::vector<duck::DistanceFieldShape>& shapes, float x, float y) {
+    float best = 1e30f;
+    for (const auto& shape : shapes) best = std::min(best, duck::exactSignedDistance(shape, x, y));
+    return best;
+}
+
+void test_distance_field_matches_exact() {
+    using namespace duck;
+    std::vector<DistanceFieldShape> shapes = buildFieldShapes();
+
+    // 精確函式本身：矩形外 / 裡、圓外 / 裡
+    DistanceFieldShape box{0.0f, 0.0f, 10.0f, 5.0f, false};
+    assert(approx(exactSignedDistance(box, 13.0f, 9.0f), 5.0f));
+    assert(approx(exactSignedDistance(box, 8.0f, 1.0f), -2.0f));
+    DistanceFieldShape circle{0.0f, 0.0f, 10.0f, 10.0f, true};
+    assert(approx(exactSignedDistance(circle, 0.0f, 25.0f), 15.0f));
+    assert(approx(exactSignedDistance(circle, 3.0f, 4.0f), -5.0f));
+
+    float previousError = 1e30f;
+    for (float cell : {8.0f, 4.0f, 2.0f}) {
+        DistanceField field;
+        field.build(shapes, cell);
+        assert(field.cellSize() == cell && !field.empty());
+
+        std::uint32_t seed = 17u;
+        auto rnd = [&](float lo, float hi) {
+            seed = seed * 1664525u + 1013904223u;
+            return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+        };
+        float maxError = 0.0f;
+        int gradientTests = 0, gradientAgree = 0;
+        for (int i = 0; i < 20000; ++i) {
+            float x = rnd(-100.0f, 900.0f);
+            float y = rnd(-100.0f, 700.0f);
+            float exact = exactUnionDistance(shapes, x, y);
+            float gx = 0.0f, gy = 0.0f;
+            float d = field.sample(x, y, gx, gy);
+            // 網格外只保證是下界
+            if (x < field.bounds().minX || x > field.bounds().maxX
+                || y < field.bounds().minY || y > field.bounds().maxY) {
+                assert(d <= exact + 0.001f && d >= DistanceField::DEFAULT_MARGIN);
+                continue;
+            }
+            maxError = std::max(maxError, std::abs(d - exact));
+            // 離表面夠遠的地方梯度大致是單位長、方向和精確的一致；
+            // 跨在兩個形狀分界（中軸）上的格子內插出來的方向會偏，只要求絕大多數一致
+            if (exact > 2.0f * cell) {
+                float step = 0.01f;
+                float ex = (exactUnionDistance(shapes, x + step, y) - exactUnionDistance(shapes, x - step, y)) / (2.0f * step);
+                float ey = (exactUnionDistance(shapes, x, y + step) - exactUnionDistance(shapes, x, y - step)) / (2.0f * step);
+                float len = std::sqrt(gx * gx + gy * gy);
+                if (std::sqrt(ex * ex + ey * ey) < 0.99f) continue;   // 剛好在兩個形狀的分界上
+                ++gradientTests;
+                if (len > 0.5f && (gx * ex + gy * ey) / len > 0.5f) ++gradientAgree;
+            }
+        }
+        // 誤差和格子大小成正比，格子越小越準：
+        // 節點值是精確的，1-Lipschitz 函式雙線性內插的誤差不超過半條對角線（≈ 0.71 格）
+        assert(maxError <= 0.75f * cell);
+        assert(maxError < previousError);
+        assert(gradientTests > 10000 && gradientAgree * 100 >= gradientTests * 95);
+        previousError = maxError;
+    }
+
+    // 沒有形狀：空場，任何地方都很遠
+    DistanceField empty;
+    empty.build({}, 4.0f);
+    assert(empty.empty() && empty.distance(0.0f, 0.0f) > 1e20f);
+    std::printf("  [PASS] test_distance_field_matches_exact\n");
+}
+
+// 牆和圓形一一對應擺好（每個圓各壓進一面牆，圓彼此不重疊），
+// 用距離場推開和逐對推開的結果要差不多；mask 挑過的牆不進場，照樣走配對
+void test_distance_field_pushes_like_pairs() {
+    using namespace duck;
+    struct Placed {
+        std::vector<EntityID> circles;
+        EntityID filteredWall = INVALID_ENTITY;
+        EntityID filteredCircle = INVALID_ENTITY;
+        std::vector<float> startX, startY, wallX, wallY;
+    };
+    auto build = [](Registry& reg) {
+        Placed placed;
+        for (int i = 0; i < 60; ++i) {
+            float x = 100.0f + static_cast<float>(i % 10) * 120.0f;
+            float y = 100.0f + static_cast<float>(i / 10) * 120.0f;
+            auto wall = reg.create();
+            reg.addComponent<Transform>(wall, x, y, 0.0f, 1.0f, 1.0f);
+            reg.addComponent<Collider>(wall, Collider::Type::AABB, 30.0f, 20.0f, 20.0f, true,
+                                       CollisionLayer::Obstacle, CollisionLayer::All);
+            // 從不同方向壓進牆邊 / 牆角
+            auto e = reg.create();
+            float angle = static_cast<float>(i) * 0.7f;
+            placed.startX.push_back(x + std::cos(angle) * 40.0f);
+            placed.startY.push_back(y + std::sin(angle) * 32.0f);
+            placed.wallX.push_back(x);
+            placed.wallY.push_back(y);
+            reg.addComponent<Transform>(e, placed.startX.back(), placed.startY.back(), 0.0f, 1.0f, 1.0f);
+            reg.addComponent<Collider>(e, Collider::Type::Circle, 15.0f, 15.0f, 15.0f, true,
+                                       CollisionLayer::Enemy, CollisionLayer::All);
+            reg.addComponent<RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+            placed.circles.push_back(e);
+        }
+        placed.filteredWall = reg.create();
+        reg.addComponent<Transform>(placed.filteredWall, 100.0f, 900.0f, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<Collider>(placed.filteredWall, Collider::Type::AABB, 30.0f, 20.0f, 20.0f, true,
+                                   CollisionLayer::Obstacle, CollisionLayer::Enemy);
+        placed.filteredCircle = reg.create();
+        reg.addComponent<Transform>(placed.filteredCircle, 100.0f, 930.0f, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<Collider>(placed.filteredCircle, Collider::Type::Circle, 15.0f, 15.0f, 15.0f, true,
+                                   CollisionLayer::Enemy, CollisionLayer::All);
+        reg.addComponent<RigidBody>(placed.filteredCircle, 0.0f, 0.0f, 1.0f, 0.9f);
+        placed.circles.push_back(placed.filteredCircle);
+        placed.startX.push_back(100.0f);
+        placed.startY.push_back(930.0f);
+        placed.wallX.push_back(100.0f);
+        placed.wallY.push_back(900.0f);
+        return placed;
+    };
+
+    Registry pairReg, fieldReg;
+    Placed pairScene = build(pairReg);
+    Placed fieldScene = build(fieldReg);
+    fieldReg.context<CollisionWorld>().setStaticFieldCellSize(2.0f);
+
+    CollisionSystem pairSystem, fieldSystem;
+    pairSystem.update(pairReg, 1.0f / 60.0f);
+    fieldSystem.update(fieldReg, 1.0f / 60.0f);
+
+    auto& world = fieldReg.context<CollisionWorld>();
+    assert(!world.staticField().empty() && world.staticFieldExcluded() == 1);
+    const CollisionStats& stats = fieldSystem.lastStats();
+    assert(stats.fieldBodies == 61 && stats.fieldPushes >= 60);
+    // 只剩被挑過的那面牆還是配對
+    assert(stats.staticPairs == 1 && pairSystem.lastStats().staticPairs >= 61);
+
+    for (size_t i = 0; i < pairScene.circles.size(); ++i) {
+        const auto& expected = pairReg.getComponent<Transform>(pairScene.circles[i]);
+        const auto& actual = fieldReg.getComponent<Transform>(fieldScene.circles[i]);
+        float startX = fieldScene.startX[i];
+        float startY = fieldScene.startY[i];
+        // 推開的距離一樣（都推到剛好相切）
+        float pairMove = std::hypot(expected.x - startX, expected.y - startY);
+        float fieldMove = std::hypot(actual.x - startX, actual.y - startY);
+        assert(std::abs(pairMove - fieldMove) < 0.5f);
+        // 正對牆面時方向也一樣；牆角那一格的梯度是內插出來的，方向可以有點偏
+        float wallX = fieldScene.wallX[i];
+        float wallY = fieldScene.wallY[i];
+        bool facing = std::abs(startX - wallX) < 30.0f - 2.0f || std::abs(startY - wallY) < 20.0f - 2.0f;
+        if (facing) assert(std::hypot(actual.x - expected.x, actual.y - expected.y) < 0.05f);
+    }
+    // 推開後不再壓在任何牆裡
+    for (EntityID e : fieldScene.circles) {
+        const auto& tf = fieldReg.getComponent<Transform>(e);
+        assert(world.staticField().distance(tf.x, tf.y) > 15.0f - 0.05f);
+    }
+
+    // 靜態物體變了：下一次 sync 重烘
+    fieldReg.destroy(fieldScene.filteredWall);
+    world.sync(fieldReg);
+    assert(world.staticFieldExcluded() == 0);
+    // 關掉距離場：全部回到配對
+    world.setStaticFieldCellSize(0.0f);
+    fieldSystem.update(fieldReg, 1.0f / 60.0f);
+    assert(world.staticField().empty() && fieldSystem.lastStats().fieldBodies == 0);
+    std::printf("  [PASS] test_distance_field_pushes_like_pairs\n");
+}
+
+// march（距離場）和 raycast（精確形狀）互相驗證：
+// raycast 打到的 march 也打到、而且不會晚超過一格（只擦過角落的例外）；
+// march 打到的點一定離牆不到一格
+void test_distance_field_march_matches_raycast() {
+    using namespace duck;
+    Registry reg;
+    std::vector<DistanceFieldShape> shapes = buildFieldShapes();
+    for (const auto& shape : shapes) {
+        auto e = reg.create();
+        bool rotated = shape.sinR != 0.0f;
+        reg.addComponent<Transform>(e, shape.x, shape.y, std::atan2(shape.sinR, shape.cosR), 1.0f, 1.0f);
+        reg.addComponent<Collider>(e, shape.isCircle ? Collider::Type::Circle
+                                      : rotated ? Collider::Type::OBB : Collider::Type::AABB,
+                                   shape.halfW, shape.halfH, shape.halfW, true,
+                                   CollisionLayer::Obstacle, CollisionLayer::All);
+    }
+    const float cell = 4.0f;
+    auto& world = reg.context<CollisionWorld>();
+    world.setStaticFieldCellSize(cell);
+    world.sync(reg);
+    const DistanceField& field = world.staticField();
+
+    std::uint32_t seed = 23u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    std::vector<RayCast> rays;
+    while (rays.size() < 500) {
+        RayCast ray;
+        ray.x = rnd(-50.0f, 850.0f);
+        ray.y = rnd(-50.0f, 650.0f);
+        if (exactUnionDistance(shapes, ray.x, ray.y) < cell) continue;
+        ray.dx = rnd(-400.0f, 400.0f);
+        ray.dy = rnd(-400.0f, 400.0f);
+        rays.push_back(ray);
+    }
+    std::vector<RayHit> hits;
+    world.raycast(reg, rays, hits);
+
+    int hitCount = 0, grazes = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        const RayCast& ray = rays[i];
+        float length = std::sqrt(ray.dx * ray.dx + ray.dy * ray.dy);
+        float t = 0.0f;
+        bool marched = field.march(ray.x, ray.y, ray.dx, ray.dy, 0.0f, t);
+        if (hits[i].hit()) {
+            ++hitCount;
+            if (!marched || (t - hits[i].t) * length >= cell) {
+                // 只擦過角落的線段距離場可能看不到（或穿過去、撞到後面的牆）：
+                // 沿線取樣到 march 停下的地方，確認最多只切進牆裡不到半格
+                float end = marched ? t : 1.0f;
+                float deepest = 1e30f;
+                for (int k = 0; k <= 1000; ++k) {
+                    float s = end * static_cast<float>(k) / 1000.0f;
+                    deepest = std::min(deepest, exactUnionDistance(shapes, ray.x + ray.dx * s, ray.y + ray.dy * s));
+                }
+                assert(deepest > -0.5f * cell);
+                ++grazes;
+            }
+        }
+        if (marched) {
+            assert(exactUnionDistance(shapes, ray.x + ray.dx * t, ray.y + ray.dy * t) < cell);
+        }
+    }
+    assert(hitCount > 100 && hitCount < 450 && grazes * 20 < hitCount);
+    std::printf("  [PASS] test_distance_field_march_matches_raycast\n");
+}
+
+// SpatialIndex 的標準答案：直接比對每個 entity 的形狀（和 SpatialIndex 的收錄規則相同）
+struct IndexedShape {
+    duck::EntityID entity = duck::INVALID_ENTITY;
+    float x = 0.0f, y = 0.0f, halfW = 0.0f, halfH = 0.0f;
+    bool isCircle = true;
+    std::uint32_t layer = 0;
+};
+
+static std::vector<IndexedShape> buildIndexScene(duck::Registry& reg) {
+    std::uint32_t seed = 11u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+
+    std::vector<IndexedShape> shapes;
+    for (int i = 0; i < 600; ++i) {
+        auto e = reg.create();
+        IndexedShape s;
+        s.entity = e;
+        s.x = rnd(0.0f, 1200.0f);
+        s.y = rnd(0.0f, 800.0f);
+        reg.addComponent<duck::Transform>(e, s.x, s.y, 0.0f, 1.0f, 1.0f);
+        if (i % 4 == 0) {
+            s.halfW = s.halfH = rnd(20.0f, 50.0f);
+            s.layer = duck::CollisionLayer::Pickup;
+            reg.addComponent<duck::Item>(e, duck::Item{duck::Item::Type::DuckCoin, 1, s.halfW});
+            reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, s.halfW, s.halfW, s.halfW, false,
+                                             duck::CollisionLayer::Pickup, duck::CollisionLayer::Player);
+        } else if (i % 4 == 1) {
+            s.halfW = rnd(4.0f, 90.0f);
+            s.halfH = rnd(4.0f, 30.0f);
+            s.isCircle = false;
+            s.layer = duck::CollisionLayer::Obstacle;
+            duck::Collider col{duck::Collider::Type::AABB, s.halfW, s.halfH, 0.0f, true};
+            col.layer = s.layer;
+            reg.addComponent<duck::Collider>(e, col);
+        } else if (i % 4 == 2) {
+            s.halfW = s.halfH = rnd(6.0f, 24.0f);
+            s.layer = duck::CollisionLayer::Enemy;
+            duck::Collider col{duck::Collider::Type::Circle, s.halfW, s.halfW, s.halfW, i % 8 == 2};
+            col.layer = s.layer;
+            reg.addComponent<duck::Collider>(e, col);
+            reg.addComponent<duck::EnemyState>(e);
+        } else {
+            // 沒有 Collider 的敵人：一個點
+            s.layer = duck::CollisionLayer::Enemy;
+            reg.addComponent<duck::EnemyState>(e);
+        }
+        if (i % 97 == 5) {
+            reg.setEnabled(e, false);
+            continue;
+        }
+        shapes.push_back(s);
+    }
+    // 離群很遠的一個：網格範圍被撐大，格子會自動放大
+    auto far = reg.create();
+    reg.addComponent<duck::Transform>(far, 90000.0f, -40000.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::EnemyState>(far);
+    shapes.push_back(IndexedShape{far, 90000.0f, -40000.0f, 0.0f, 0.0f, true, duck::CollisionLayer::Enemy});
+    return shapes;
+}
+
+static bool shapeTouchesCircle(const IndexedShape& s, float x, float y, float r) {
+    float nearX = s.isCircle ? s.x : std::fmax(s.x - s.halfW, std::fmin(x, s.x + s.halfW));
+    float nearY = s.isCircle ? s.y : std::fmax(s.y - s.halfH, std::fmin(y, s.y + s.halfH));
+    float reach = s.isCircle ? r + s.halfW : r;
+    return (x - nearX) * (x - nearX) + (y - nearY) * (y - nearY) <= reach * reach;
+}
+
+static bool shapeTouchesBox(const IndexedShape& s, const duck::Aabb& box) {
+    if (!s.isCircle) return duck::aabbOverlap(duck::makeAabb(s.x, s.y, s.halfW, s.halfH), box);
+    float nearX = std::fmax(box.minX, std::fmin(s.x, box.maxX));
+    float nearY = std::fmax(box.minY, std::fmin(s.y, box.maxY));
+    return (s.x - nearX) * (s.x - nearX) + (s.y - nearY) * (s.y - nearY) <= s.halfW * s.halfW;
+}
+
+static void test_spatial_index_queries_match_brute_force() {
+    duck::Registry reg;
+    std::vector<IndexedShape> shapes = buildIndexScene(reg);
+    auto& index = reg.context<duck::SpatialIndex>();
+    index.rebuild(reg);
+    assert(index.size() == shapes.size());
+    assert(index.cellCount() <= 4 * shapes.size());
+    assert(index.cellSize() > duck::SpatialIndex::DEFAULT_CELL_SIZE);
+
+    // 同樣的場景用小網格（不被離群點撐大）再驗一次
+    duck::Registry dense;
+    std::vector<IndexedShape> denseShapes = buildIndexScene(dense);
+    dense.destroy(denseShapes.back().entity);
+    denseShapes.pop_back();
+    duck::SpatialIndex denseIndex(32.0f);
+    denseIndex.rebuild(dense);
+    assert(denseIndex.cellSize() == 32.0f);
+
+    std::uint32_t seed = 5u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    const std::uint32_t layerChoices[] = {
+        duck::CollisionLayer::All, duck::CollisionLayer::Enemy,
+        duck::CollisionLayer::Pickup | duck::CollisionLayer::Obstacle, duck::CollisionLayer::Projectile,
+    };
+
+    for (const duck::SpatialIndex* idx : {&index, &denseIndex}) {
+        const std::vector<IndexedShape>& scene = idx == &index ? shapes : denseShapes;
+        for (int q = 0; q < 200; ++q) {
+            float x = rnd(-100.0f, 1300.0f);
+            float y = rnd(-100.0f, 900.0f);
+            std::uint32_t layers = layerChoices[q % 4];
+
+            // AABB / 半徑：集合相同，而且不重複
+            duck::Aabb area = duck::makeAabb(x, y, rnd(0.0f, 150.0f), rnd(0.0f, 150.0f));
+            float r = q % 10 == 0 ? 0.0f : rnd(0.0f, 200.0f);
+            std::vector<duck::EntityID> got;
+            std::vector<duck::EntityID> gotRadius;
+            idx->queryAabb(area, layers, got);
+            idx->queryRadius(x, y, r, layers, gotRadius);
+            std::set<duck::EntityID> expectBox, expectRadius;
+            for (const IndexedShape& s : scene) {
+                if ((s.layer & layers) == 0) continue;
+                if (shapeTouchesBox(s, area)) expectBox.insert(s.entity);
+                if (shapeTouchesCircle(s, x, y, r)) expectRadius.insert(s.entity);
+            }
+            assert(got.size() == expectBox.size());
+            assert(std::set<duck::EntityID>(got.begin(), got.end()) == expectBox);
+            assert(gotRadius.size() == expectRadius.size());
+            assert(std::set<duck::EntityID>(gotRadius.begin(), gotRadius.end()) == expectRadius);
+
+            // k-nearest：依 (距離, entity) 排序後的前 k 個
+            size_t k = static_cast<size_t>(1 + q % 25);
+            std::vector<duck::SpatialNeighbor> nearest;
+            idx->queryNearest(x, y, k, layers, nearest);
+            std::vector<std::pair<float, duck::EntityID>> expectNearest;
+            for (const IndexedShape& s : scene) {
+                if ((s.layer & layers) == 0) continue;
+                expectNearest.push_back({(s.x - x) * (s.x - x) + (s.y - y) * (s.y - y), s.entity});
+            }
+            std::sort(expectNearest.begin(), expectNearest.end());
+            if (expectNearest.size() > k) expectNearest.resize(k);
+            assert(nearest.size() == expectNearest.size());
+            for (size_t i = 0; i < nearest.size(); ++i) {
+                assert(nearest[i].entity == expectNearest[i].second);
+                assert(sameBits(nearest[i].distSq, expectNearest[i].first));
+            }
+
+            // 線段：和 swept 參考函式相同的集合，依 t 排序
+            float x1 = rnd(-100.0f, 1300.0f);
+            float y1 = rnd(-100.0f, 900.0f);
+            float thickness = q % 3 == 0 ? 0.0f : rnd(0.0f, 20.0f);
+            std::vector<duck::SpatialSegmentHit> hits;
+            idx->querySegment(x, y, x1, y1, thickness, layers, hits);
+            std::vector<std::pair<float, duck::EntityID>> expectHits;
+            for (const IndexedShape& s : scene) {
+                if ((s.layer & layers) == 0) continue;
+                float t = 0.0f;
+                bool hit = s.isCircle
+                    ? duck::sweptCircleVsCircle(x, y, x1 - x, y1 - y, thickness, s.x, s.y, s.halfW, t)
+                    : duck::sweptCircleVsAabb(x, y, x1 - x, y1 - y, thickness, s.x, s.y, s.halfW, s.halfH, t);
+                if (hit) expectHits.push_back({t, s.entity});
+            }
+            std::sort(expectHits.begin(), expectHits.end());
+            assert(hits.size() == expectHits.size());
+            for (size_t i = 0; i < hits.size(); ++i) {
+                assert(hits[i].entity == expectHits[i].second);
+                assert(sameBits(hits[i].t, expectHits[i].first));
+            }
+        }
+    }
+
+    // 查詢接在 out 後面、不清空
+    std::vector<duck::EntityID> out{duck::INVALID_ENTITY};
+    index.queryRadius(600.0f, 400.0f, 300.0f, duck::CollisionLayer::All, out);
+    assert(out.size() > 1 && out[0] == duck::INVALID_ENTITY);
+    std::printf("  [PASS] test_spatial_index_queries_match_brute_force\n");
+}
+
+static void test_spatial_index_is_a_snapshot() {
+    duck::Registry reg;
+    auto& index = reg.context<duck::SpatialIndex>();
+    index.ensureBuilt(reg);
+    assert(index.built() && index.size() == 0);
+    std::vector<duck::SpatialNeighbor> nearest;
+    index.queryNearest(0.0f, 0.0f, 3, duck::CollisionLayer::All, nearest);
+    assert(nearest.empty());
+
+    auto item = reg.create();
+    reg.addComponent<duck::Transform>(item, 100.0f, 100.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Item>(item);
+    reg.addComponent<duck::Collider>(item, duck::Collider::Type::Circle, 20.0f, 20.0f, 20.0f, false,
+                                     duck::CollisionLayer::Pickup, duck::CollisionLayer::Player);
+    index.ensureBuilt(reg);
+    std::vector<duck::EntityID> found;
+    index.queryRadius(100.0f, 100.0f, 0.0f, duck::CollisionLayer::Pickup, found);
+    assert(found.empty());   // 建好之後新增的要等下一次 rebuild
+
+    index.rebuild(reg);
+    index.queryRadius(100.0f, 100.0f, 0.0f, duck::CollisionLayer::Pickup, found);
+    assert(found.size() == 1 && found[0] == item);
+    std::printf("  [PASS] test_spatial_index_is_a_snapshot\n");
+}
+
+// setLayers：只收有人查的層；收進來的層查起來和全收時一模一樣
+static void test_spatial_index_skips_unused_layers() {
+    duck::Registry reg;
+    std::vector<IndexedShape> shapes = buildIndexScene(reg);
+    duck::SpatialIndex full;
+    full.rebuild(reg);
+    duck::SpatialIndex enemiesOnly;
+    enemiesOnly.setLayers(duck::CollisionLayer::Enemy);
+    enemiesOnly.rebuild(reg);
+
+    size_t enemyShapes = 0;
+    for (const IndexedShape& s : shapes) enemyShapes += (s.layer & duck::CollisionLayer::Enemy) != 0 ? 1 : 0;
+    assert(enemiesOnly.size() == enemyShapes && enemyShapes < full.size());
+
+    for (int q = 0; q < 50; ++q) {
+        float x = 25.0f * static_cast<float>(q);
+        float y = 16.0f * static_cast<float>(q);
+        std::vector<duck::EntityID> a, b;
+        full.queryRadius(x, y, 180.0f, duck::CollisionLayer::Enemy, a);
+        enemiesOnly.queryRadius(x, y, 180.0f, duck::CollisionLayer::Enemy, b);
+        assert(std::set<duck::EntityID>(a.begin(), a.end()) == std::set<duck::EntityID>(b.begin(), b.end()));
+        b.clear();
+        enemiesOnly.queryRadius(x, y, 180.0f, duck::CollisionLayer::Pickup | duck::CollisionLayer::Obstacle, b);
+        assert(b.empty());
+    }
+    std::printf("  [PASS] test_spatial_index_skips_unused_layers\n");
+}
+
 // ─────────────────────────────────────────
 // main
 // ─────────────────────────────────────────
 
+// Trigger：不推開、只產生 Enter / Stay / Exit；成本跟著重疊數走，和掉落物數量無關
+static void test_trigger_volumes_emit_enter_exit() {
+    duck::Registry reg;
+    const float dt = 1.0f / 60.0f;
+    // 50x40 個掉落物 trigger（只收 Player 層），間隔 40px、半徑 10
+    std::vector<duck::EntityID> items;
+    for (int i = 0; i < 2000; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, 40.0f * static_cast<float>(i % 50),
+                                          40.0f * static_cast<float>(i / 50), 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 10.0f, 10.0f, 10.0f, false,
+                                         duck::CollisionLayer::Pickup, duck::CollisionLayer::Player);
+        items.push_back(e);
+    }
+    auto player = reg.create();
+    reg.addComponent<duck::Transform>(player, 400.0f, 400.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(player, duck::Collider::Type::Circle, 12.0f, 12.0f, 12.0f, true,
+                                     duck::CollisionLayer::Player, duck::CollisionLayer::All);
+    reg.addComponent<duck::RigidBody>(player, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::InputControlled>(player);
+    // 敵人站在掉落物上：layer 不在 trigger 的 mask 裡，不產生事件也不做形狀測試
+    auto enemy = reg.create();
+    reg.addComponent<duck::Transform>(enemy, 200.0f, 200.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 12.0f, 12.0f, 12.0f, true,
+                                     duck::CollisionLayer::Enemy, duck::CollisionLayer::All);
+    reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 1.0f);
+
+    duck::CollisionSystem system;
+    auto& world = reg.context<duck::CollisionWorld>();
+    system.update(reg, dt);
+    assert(world.triggerCount() == 2000);
+    assert(world.dynamicCount() == 2 && world.staticCount() == 0);
+    assert(system.lastPairCount() == 0);
+    // 玩家在 (400, 400) 正中一個掉落物上（items[10 * 50 + 10]）
+    const duck::EntityID under = items[510];
+    assert(world.triggerEnters().size() == 1);
+    assert(world.triggerEnters()[0].a == under && world.triggerEnters()[0].b == player);
+    assert(world.lastTriggerCandidates() <= 4);
+    assert(system.lastStats().triggerOverlaps == 1);
+    assert(reg.getComponent<duck::Transform>(player).x == 400.0f);
+
+    // 站著不動：Stay；往右走 20px 仍碰得到（12 + 10 > 20），走到兩個之間（離兩邊都 20px）也一樣
+    system.update(reg, dt);
+    assert(world.triggerEnters().empty() && world.triggerStays().size() == 1);
+    reg.getComponent<duck::Transform>(player).x = 420.0f;
+    system.update(reg, dt);
+    assert(world.triggerEnters().size() == 1 && world.triggerEnters()[0].a == items[511]);
+    assert(world.triggerStays().size() == 1 && world.triggerExits().empty());
+    reg.getComponent<duck::Transform>(player).x = 445.0f;
+    system.update(reg, dt);
+    assert(world.triggerExits().size() == 1 && world.triggerExits()[0].a == under);
+    assert(world.inTrigger(items[511], player) && !world.inTrigger(under, player));
+
+    // 停用的 trigger 不算重疊；destroy 掉的 trigger 下一個 tick 變成 Exit
+    reg.setEnabled(items[511], false);
+    system.update(reg, dt);
+    assert(world.triggerExits().size() == 1 && world.triggerExits()[0].a == items[511]);
+    reg.setEnabled(items[511], true);
+    system.update(reg, dt);
+    assert(world.triggerEnters().size() == 1);
+    reg.destroy(items[511]);
+    system.update(reg, dt);
+    assert(world.triggerCount() == 1999);
+    assert(world.triggerExits().size() == 1 && world.triggerExits()[0].b == player);
+    assert(world.triggerOverlapCount() == 0);
+
+    // kinematic trigger（有 RigidBody）：跟著 Transform 移動，自己查 solid（這裡只收 Enemy 層）
+    auto zone = reg.create();
+    reg.addComponent<duck::Transform>(zone, 100.0f, 200.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(zone, duck::Collider::Type::AABB, 30.0f, 30.0f, 0.0f, false,
+                                     duck::CollisionLayer::Default, duck::CollisionLayer::Enemy);
+    reg.addComponent<duck::RigidBody>(zone, 0.0f, 0.0f, 1.0f, 1.0f);
+    system.update(reg, dt);
+    assert(world.triggerCount() == 2000 && world.dynamicCount() == 2);
+    assert(world.triggerEnters().empty());
+    reg.getComponent<duck::Transform>(zone).x = 180.0f;
+    system.update(reg, dt);
+    assert(world.triggerEnters().size() == 1);
+    assert(world.triggerEnters()[0].a == zone && world.triggerEnters()[0].b == enemy);
+    assert(reg.getComponent<duck::Transform>(enemy).x == 200.0f);
+    reg.getComponent<duck::Transform>(zone).x = 100.0f;
+    system.update(reg, dt);
+    assert(world.triggerExits().size() == 1 && world.triggerExits()[0].a == zone);
+    std::printf("  [PASS] test_trigger_volumes_emit_enter_exit\n");
+}
+
+// isSolid 在遊戲中途切換：solid 和 trigger 之間搬家，兩邊的事件都接得上
+static void test_trigger_follows_is_solid_flips() {
+    duck::Registry reg;
+    const float dt = 1.0f / 60.0f;
+    auto zone = reg.create();
+    reg.addComponent<duck::Transform>(zone, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(zone, duck::Collider::Type::AABB, 40.0f, 40.0f, 0.0f, false);
+    auto body = reg.create();
+    reg.addComponent<duck::Transform>(body, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(body, duck::Collider::Type::Circle, 12.0f, 12.0f, 12.0f, true);
+    reg.addComponent<duck::RigidBody>(body, 0.0f, 0.0f, 1.0f, 1.0f);
+    auto other = reg.create();
+    reg.addComponent<duck::Transform>(other, 200.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(other, duck::Collider::Type::Circle, 6.0f, 6.0f, 6.0f, true);
+    reg.addComponent<duck::RigidBody>(other, 0.0f, 0.0f, 1.0f, 1.0f);
+
+    auto has = [](const std::vector<duck::ContactEvent>& events, duck::EntityID a, duck::EntityID b) {
+        for (const auto& event : events) {
+            if (event.a == a && event.b == b) return true;
+        }
+        return false;
+    };
+
+    duck::CollisionSystem system;
+    auto& world = reg.context<duck::CollisionWorld>();
+    system.update(reg, dt);
+    assert(world.triggerEnters().size() == 1 && has(world.triggerEnters(), zone, body));
+
+    // solid → trigger：離開 zone，自己變成 kinematic trigger
+    world.setSolid(reg, body, false);
+    system.update(reg, dt);
+    assert(world.triggerCount() == 2 && world.dynamicCount() == 1);
+    assert(world.triggerExits().size() == 1 && has(world.triggerExits(), zone, body));
+    assert(world.triggerEnters().empty());
+
+    // 另一個 solid 走進來：兩個 trigger 都收到 Enter，而且沒被推開
+    reg.getComponent<duck::Transform>(other).x = 10.0f;
+    system.update(reg, dt);
+    assert(world.triggerEnters().size() == 2);
+    assert(has(world.triggerEnters(), zone, other) && has(world.triggerEnters(), body, other));
+    assert(reg.getComponent<duck::Transform>(other).x == 10.0f);
+
+    // trigger → solid：自己的 trigger 事件結束，重新進入 zone
+    world.setSolid(reg, body, true);
+    system.update(reg, dt);
+    assert(world.triggerCount() == 1 && world.dynamicCount() == 2);
+    assert(world.triggerExits().size() == 1 && has(world.triggerExits(), body, other));
+    assert(world.triggerEnters().size() == 1 && has(world.triggerEnters(), zone, body));
+    assert(has(world.triggerStays(), zone, other));
+    std::printf("  [PASS] test_trigger_follows_is_solid_flips\n");
+}
+
 int main() {
     std::printf("=== Collision Geometry Tests ===\n");
 
@@ -262,10 +2510,63 @@ int main() {
     test_circle_inside_aabb_left_edge();
     test_circle_inside_aabb_right_edge();
 
+    std::printf("--- Swept Circle ---\n");
+    test_swept_circle_vs_circle();
+    test_swept_circle_vs_aabb();
+
     std::printf("--- Bullet Damage ---\n");
     test_bullet_hits_enemy_and_kills();
     test_enemy_touch_damages_player_once_per_cooldown();
     test_bullet_hits_target_with_many_spatial_entries();
+    test_dead_enemy_stops_colliding();
+    test_enemy_death_reclassifies_only_that_body();
+    test_bullet_does_not_tunnel_through_thin_wall();
+    test_high_speed_bullet_hits_earliest_target();
+    test_bullet_mask_skips_player_layer();
+    test_projectile_manager_integrate_and_expire();
+    test_projectile_sweep_batches_match_single_queries();
+
+    std::printf("--- CollisionWorld ---\n");
+    test_collision_world_persistent_broad_phase();
+    test_hash_grid_matches_brute_force_and_quadtree();
+    test_sweep_and_prune_matches_brute_force();
+    test_linear_bvh_matches_brute_force();
+    test_quadtree_self_collision_matches_queries();
+    test_static_bvh_matches_brute_force();
+    test_collision_world_keeps_statics_out_of_broad_phase();
+    test_collision_layers_prune_pairs_in_broad_phase();
+
+    std::printf("--- NarrowPhaseBatch ---\n");
+    test_narrow_phase_batch_matches_scalar();
+    test_worker_pool_parallel_for_covers_range();
+    test_parallel_narrow_phase_is_deterministic();
+    test_relaxation_iterations_settle_crowd();
+    test_idle_bodies_sleep_and_wake();
+    test_collision_stats_are_consistent();
+    test_ray_shape_tests();
+    test_raycast_matches_brute_force();
+
+    std::printf("--- OBB ---\n");
+    test_obb_matches_aabb_when_unrotated();
+    test_circle_vs_rotated_obb();
+    test_obb_vs_obb_sat();
+    test_rotated_rock_collides_as_oriented_box();
+
+    std::printf("--- DistanceField ---\n");
+    test_distance_field_matches_exact();
+    test_distance_field_pushes_like_pairs();
+    test_distance_field_march_matches_raycast();
+
+    std::printf("--- ContactCache ---\n");
+    test_contact_cache_begin_stay_end();
+    test_collision_system_emits_contact_events();
+    test_trigger_volumes_emit_enter_exit();
+    test_trigger_follows_is_solid_flips();
+
+    std::printf("--- SpatialIndex ---\n");
+    test_spatial_index_queries_match_brute_force();
+    test_spatial_index_is_a_snapshot();
+    test_spatial_index_skips_unused_layers();
 
     std::printf("\n=== All tests passed! ===\n");
     return 0;
@@ -0,0 +1,291 @@
+// 碰撞驗證：每種 broad phase 和 O(n²) 暴力法 oracle 並排跑，比對配對與推開後的位置
+// 用法：./test_collision_validation [錄下來的場景檔 ...]
+//   不帶參數：跑隨機場景（最多 10k 個 body）；帶參數：另外重播這些場景（--validate-collision 寫出的 repro）
+#include "ecs/Components.h"
+#include "ecs/Registry.h"
+#include "physics/CollisionValidator.h"
+#include "physics/CollisionWorld.h"
+#include "systems/CollisionSystem.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const duck::BroadPhaseType ALL_TYPES[] = {duck::BroadPhaseType::Quadtree, duck::BroadPhaseType::HashGrid,
+                                          duck::BroadPhaseType::SweepAndPrune, duck::BroadPhaseType::Lbvh};
+
+// 固定種子的 LCG：同一個種子永遠產生同一個場景
+struct Lcg {
+    std::uint32_t state = 12345u;
+    std::uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+    float uniform(float lo, float hi) {
+        return lo + (hi - lo) * static_cast<float>(next() >> 8) / 16777216.0f;
+    }
+    bool chance(int percent) { return static_cast<int>((next() >> 8) % 100u) < percent; }
+};
+
+// 平均每 3600 px² 一個 body：約 30% 靜態（AABB / OBB / 圓，偶爾很大），其餘動態（兩成靜止、會睡著），
+// layer / mask 混著用，少數停用或是 trigger，另外一個玩家
+duck::ValidationScene randomScene(std::uint32_t seed, int count, duck::BroadPhaseType type, float fieldCell) {
+    using duck::CollisionLayer::All;
+    Lcg rng;
+    rng.state = seed;
+    duck::ValidationScene scene;
+    scene.broadPhase = type;
+    scene.fieldCellSize = fieldCell;
+    const float worldSize = std::sqrt(static_cast<float>(count) * 3600.0f);
+    const std::uint32_t layers[] = {duck::CollisionLayer::Default, duck::CollisionLayer::Enemy,
+                                    duck::CollisionLayer::Obstacle, duck::CollisionLayer::Projectile};
+
+    for (int i = 0; i < count; ++i) {
+        duck::SceneBody body;
+        body.x = rng.uniform(0.0f, worldSize);
+        body.y = rng.uniform(0.0f, worldSize);
+        body.kind = i == 0 ? duck::SceneBody::Kind::Player
+                  : rng.chance(30) ? duck::SceneBody::Kind::Static : duck::SceneBody::Kind::Dynamic;
+        bool isStatic = body.kind == duck::SceneBody::Kind::Static;
+        int shape = static_cast<int>(rng.next() >> 8) % 10;
+        body.shape = shape < 6 ? duck::Collider::Type::Circle
+                   : shape < 8 ? duck::Collider::Type::AABB : duck::Collider::Type::OBB;
+        body.radius = rng.uniform(6.0f, 30.0f);
+        body.halfW = rng.uniform(6.0f, 30.0f);
+        body.halfH = rng.uniform(6.0f, 30.0f);
+        if (rng.chance(1)) {
+            body.radius *= 8.0f;
+            body.halfW *= 8.0f;
+        }
+        body.rotation = body.shape == duck::Collider::Type::OBB ? rng.uniform(-3.14159f, 3.14159f) : 0.0f;
+        if (!isStatic && !rng.chance(20)) {
+            body.vx = rng.uniform(-150.0f, 150.0f);
+            body.vy = rng.uniform(-150.0f, 150.0f);
+        }
+        body.layer = i == 0 ? duck::CollisionLayer::Player
+                   : isStatic ? duck::CollisionLayer::Obstacle : layers[(rng.next() >> 8) % 4];
+        body.mask = rng.chance(80) ? All : (layers[(rng.next() >> 8) % 4] | duck::CollisionLayer::Player);
+        body.solid = !rng.chance(2);
+        body.enabled = !rng.chance(3);
+        scene.bodies.push_back(body);
+    }
+    return scene;
+}
+
+void printResult(const char* label, const duck::SideBySideResult& result) {
+    std::printf("    %s: %zu ticks, expected %zu / reported %zu / extra %zu pairs, mismatch ticks %zu",
+                label, result.pairs.ticks, result.pairs.expectedPairs, result.pairs.reportedPairs,
+                result.pairs.extraPairs, result.pairs.mismatchTicks);
+    if (result.firstPositionTick != duck::ValidationReport::NO_TICK) {
+        std::printf(", positions differ from tick %zu (entity %u, max %g px)", result.firstPositionTick,
+                    result.firstPositionEntity, static_cast<double>(result.maxPositionError));
+    }
+    std::printf("\n");
+    for (const duck::PairMismatch& mismatch : result.firstMismatches) {
+        std::printf("      %s (%u, %u)\n", duck::pairMismatchName(mismatch.kind), mismatch.a, mismatch.b);
+    }
+}
+
+} // namespace
+
+// 每種 broad phase × 三種規模：配對集合和 oracle 一致，推開後的位置逐位元相同
+static void test_every_broad_phase_matches_oracle() {
+    struct Case {
+        int count;
+        int ticks;
+        float fieldCell;
+    };
+    const Case cases[] = {{300, 60, 0.0f}, {2000, 10, 8.0f}, {10000, 2, 0.0f}};
+    for (auto type : ALL_TYPES) {
+        for (const Case& c : cases) {
+            auto scene = randomScene(1000u + static_cast<std::uint32_t>(c.count), c.count, type, c.fieldCell);
+            auto result = duck::runSideBySide(scene, c.ticks, 1.0f / 60.0f);
+            if (!result.ok()) printResult(duck::broadPhaseName(type), result);
+            assert(result.ok());
+            assert(result.pairs.ticks == static_cast<size_t>(c.ticks));
+            assert(result.pairs.expectedPairs > 0);
+        }
+    }
+    std::printf("  [PASS] test_every_broad_phase_matches_oracle\n");
+}
+
+// 故意弄壞 findPairs 的輸出：漏一對、重複、靜態 vs 靜態、順序反了、已經不是 solid，各自被抓到
+static void test_validator_flags_broken_pair_lists() {
+    auto scene = randomScene(7u, 600, duck::BroadPhaseType::HashGrid, 0.0f);
+    duck::Registry reg;
+    duck::buildValidationScene(scene, reg);
+    auto& world = reg.context<duck::CollisionWorld>();
+    world.sync(reg);
+    std::vector<duck::BodyPair> pairs;
+    world.findPairs(pairs);
+
+    duck::CollisionValidator validator;
+    std::vector<duck::BodyPair> expected;
+    validator.bruteForcePairs(reg, world, expected);
+    assert(!expected.empty());
+
+    auto check = [&](std::vector<duck::BodyPair> list) {
+        validator.processPairs(reg, world, list);
+        return validator.lastMismatches();
+    };
+    assert(check(pairs).empty());
+    assert(check(expected).empty());
+
+    // 漏掉一對
+    auto broken = expected;
+    duck::BodyPair dropped = broken[broken.size() / 2];
+    broken.erase(broken.begin() + static_cast<std::ptrdiff_t>(broken.size() / 2));
+    auto mismatches = check(broken);
+    assert(mismatches.size() == 1 && mismatches[0].kind == duck::PairMismatch::Kind::Missing);
+    assert(mismatches[0].a == dropped.a && mismatches[0].b == dropped.b);
+
+    // 同一對兩次
+    broken = expected;
+    broken.push_back(expected[0]);
+    mismatches = check(broken);
+    assert(mismatches.size() == 1 && mismatches[0].kind == duck::PairMismatch::Kind::Duplicate);
+
+    // 兩個靜態物體（就算邊界重疊也不該輸出）
+    std::vector<duck::EntityID> statics;
+    reg.view<duck::Transform, duck::Collider>([&](duck::EntityID e) {
+        if (world.isStaticBody(e)) statics.push_back(e);
+    });
+    assert(statics.size() >= 2);
+    broken = expected;
+    broken.push_back({statics[0], statics[1]});
+    mismatches = check(broken);
+    assert(mismatches.size() == 1 && mismatches[0].kind == duck::PairMismatch::Kind::Invalid);
+
+    // 動態 vs 靜態卻把靜態放前面
+    broken = expected;
+    size_t flipped = 0;
+    for (auto& pair : broken) {
+        if (!world.isStaticBody(pair.b)) continue;
+        std::swap(pair.a, pair.b);
+        flipped = 1;
+        break;
+    }
+    assert(flipped == 1);
+    mismatches = check(broken);
+    assert(mismatches.size() == 1 && mismatches[0].kind == duck::PairMismatch::Kind::Invalid);
+
+    // 已經不是 solid 的 body 還在配對裡（直接改欄位、沒走 CollisionWorld::setSolid）：oracle 要抓得到
+    duck::EntityID corpse = expected[0].a;
+    size_t corpsePairs = 0;
+    for (const auto& pair : expected) corpsePairs += pair.a == corpse || pair.b == corpse ? 1 : 0;
+    reg.getComponent<duck::Collider>(corpse).isSolid = false;
+    mismatches = check(expected);
+    assert(mismatches.size() == std::min(corpsePairs, duck::CollisionValidator::MAX_RECORDED));
+    for (const auto& mismatch : mismatches) assert(mismatch.kind == duck::PairMismatch::Kind::Invalid);
+    reg.getComponent<duck::Collider>(corpse).isSolid = true;
+
+    assert(validator.report().ticks == 7);
+    assert(validator.report().mismatchTicks == 5);
+    assert(validator.report().firstMismatchTick == 2);
+    std::printf("  [PASS] test_validator_flags_broken_pair_lists\n");
+}
+
+// 縮小 repro：只有某三個 body 同時存在才「失敗」時，一千個 body 縮到剛好那三個
+static void test_shrink_finds_minimal_repro() {
+    auto scene = randomScene(99u, 1000, duck::BroadPhaseType::Quadtree, 0.0f);
+    const float markers[] = {scene.bodies[3].x, scene.bodies[500].x, scene.bodies[999].x};
+    int calls = 0;
+    auto fails = [&](const duck::ValidationScene& candidate) {
+        ++calls;
+        int found = 0;
+        for (const auto& body : candidate.bodies) {
+            for (float marker : markers) found += body.x == marker ? 1 : 0;
+        }
+        return found == 3;
+    };
+    auto shrunk = duck::CollisionValidator::shrinkScene(scene, fails);
+    assert(shrunk.bodies.size() == 3);
+    assert(shrunk.bodies[0].x == markers[0] && shrunk.bodies[1].x == markers[1] && shrunk.bodies[2].x == markers[2]);
+    assert(calls < 200);
+    std::printf("  [PASS] test_shrink_finds_minimal_repro\n");
+}
+
+// 錄下跑到一半的場景（有睡著的、有被推開過的）、存檔再讀回：逐位元相同，重播也和 oracle 一致；
+// 沒有差異時 writeRepro 存下整個場景
+static void test_recorded_scene_round_trip() {
+    auto scene = randomScene(2024u, 800, duck::BroadPhaseType::SweepAndPrune, 0.0f);
+    duck::Registry reg;
+    duck::buildValidationScene(scene, reg);
+    duck::CollisionSystem system;
+    for (int tick = 0; tick < 40; ++tick) {
+        duck::stepValidationScene(reg, 1.0f / 60.0f);
+        system.update(reg, 1.0f / 60.0f);
+    }
+    auto& world = reg.context<duck::CollisionWorld>();
+    assert(world.sleepingCount() > 0);
+
+    duck::ValidationScene recorded;
+    duck::recordValidationScene(reg, world, recorded);
+    assert(recorded.bodies.size() == scene.bodies.size());
+    assert(recorded.broadPhase == duck::BroadPhaseType::SweepAndPrune);
+    const char* path = "/tmp/duck_engine_validation.scene";
+    assert(duck::saveValidationScene(recorded, path));
+    duck::ValidationScene loaded;
+    assert(duck::loadValidationScene(path, loaded));
+    assert(loaded.broadPhase == recorded.broadPhase && loaded.sleeping == recorded.sleeping);
+    assert(loaded.bodies.size() == recorded.bodies.size());
+    for (size_t i = 0; i < loaded.bodies.size(); ++i) {
+        const auto& a = loaded.bodies[i];
+        const auto& b = recorded.bodies[i];
+        assert(a.kind == b.kind && a.shape == b.shape && a.solid == b.solid && a.enabled == b.enabled);
+        assert(a.layer == b.layer && a.mask == b.mask);
+        assert(std::memcmp(&a.x, &b.x, sizeof(float)) == 0 && std::memcmp(&a.y, &b.y, sizeof(float)) == 0);
+        assert(a.rotation == b.rotation && a.vx == b.vx && a.vy == b.vy);
+        assert(a.radius == b.radius && a.halfW == b.halfW && a.halfH == b.halfH);
+    }
+
+    auto result = duck::runSideBySide(loaded, 30, 1.0f / 60.0f);
+    if (!result.ok()) printResult("recorded", result);
+    assert(result.ok());
+    assert(!duck::CollisionValidator::sceneFails(loaded));
+
+    size_t written = 0;
+    assert(!duck::CollisionValidator::writeRepro(reg, world, path, written));
+    assert(written == scene.bodies.size());
+    assert(!duck::loadValidationScene("/tmp/duck_engine_no_such.scene", loaded));
+    std::printf("  [PASS] test_recorded_scene_round_trip\n");
+}
+
+int main(int argc, char* argv[]) {
+    std::printf("=== Collision Validation Tests ===\n");
+
+    std::printf("--- Oracle ---\n");
+    test_every_broad_phase_matches_oracle();
+    test_validator_flags_broken_pair_lists();
+
+    std::printf("--- Repro ---\n");
+    test_shrink_finds_minimal_repro();
+    test_recorded_scene_round_trip();
+
+    if (argc > 1) std::printf("--- Recorded scenes ---\n");
+    int failed = 0;
+    for (int i = 1; i < argc; ++i) {
+        duck::ValidationScene scene;
+        if (!duck::loadValidationScene(argv[i], scene)) {
+            std::printf("  [FAIL] %s: 讀不到場景\n", argv[i]);
+            ++failed;
+            continue;
+        }
+        auto result = duck::runSideBySide(scene, 60, 1.0f / 60.0f);
+        std::printf("  [%s] %s（%zu bodies, %s）\n", result.ok() ? "PASS" : "FAIL", argv[i], scene.bodies.size(),
+                    duck::broadPhaseName(scene.broadPhase));
+        if (!result.ok()) {
+            printResult(duck::broadPhaseName(scene.broadPhase), result);
+            ++failed;
+        }
+    }
+    if (failed > 0) return 1;
+
+    std::printf("\n=== All tests passed! ===\n");
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "core/MapLoader.h"
 #include "ecs/Components.h"
 #include "ecs/Registry.h"
+#include "physics/CollisionWorld.h"
+#include "systems/CollisionSystem.h"
 #include "systems/PickupSystem.h"
 #include <cassert>
 #include <cstdio>
@@ -42,11 +44,17 @@ R"({
     int players = 0, grounds = 0, obstacles = 0, enemies = 0, items = 0, inventories = 0;
     reg.view<duck::InputControlled>([&](duck::EntityID) { ++players; });
     reg.view<duck::Inventory>([&](duck::EntityID) { ++inventories; });
-    reg.view<duck::Enemy>([&](duck::EntityID) { ++enemies; });
+    reg.view<duck::EnemyState>([&](duck::EntityID entity) {
+        ++enemies;
+        const auto& state = reg.getComponent<duck::EnemyState>(entity);
+        const auto& archetype = reg.context<duck::EnemyArchetypeTable>().get(state.archetype);
+        assert(archetype.detectRange == 280.0f);
+        assert(archetype.attackRange == 48.0f);
+    });
     reg.view<duck::Item>([&](duck::EntityID) { ++items; });
     reg.view<duck::Collider>([&](duck::EntityID entity) {
         auto& col = reg.getComponent<duck::Collider>(entity);
-        if (reg.hasComponent<duck::Enemy>(entity)) return;
+        if (reg.hasComponent<duck::EnemyState>(entity)) return;
         if (reg.hasComponent<duck::InputControlled>(entity)) return;
         if (col.type == duck::Collider::Type::AABB) ++obstacles;
     });
@@ -66,37 +74,103 @@ R"({
     std::printf("  [PASS] test_map_loader_populates_registry\n");
 }
 
+// 沒寫 layer 的物件用各自的預設層；"layer" / "mask" 可以是名稱或名稱陣列
+static void test_map_loader_reads_collision_layers() {
+    const char* path = "/tmp/duck_engine_test_layers.json";
+    std::ofstream out(path);
+    out <<
+R"({
+  "player": { "x": 100.0, "y": 120.0 },
+  "obstacles": [
+    { "x": 200.0, "y": 180.0 },
+    { "x": 300.0, "y": 180.0, "mask": ["player", "projectile"] }
+  ],
+  "enemies": [
+    { "x": 400.0, "y": 220.0, "layer": "enemy", "mask": ["player", "obstacle", "projectile"] }
+  ]
+})";
+    out.close();
+
+    duck::Registry reg;
+    duck::MapLoader loader;
+    assert(loader.loadFromFile(path, reg, duck::MapSceneAssets{}));
+
+    int checked = 0;
+    reg.view<duck::Transform, duck::Collider>([&](duck::EntityID entity) {
+        const auto& tf = reg.getComponent<duck::Transform>(entity);
+        const auto& col = reg.getComponent<duck::Collider>(entity);
+        if (reg.hasComponent<duck::InputControlled>(entity)) {
+            assert(col.layer == duck::CollisionLayer::Player);
+            assert(col.mask == duck::CollisionLayer::All);
+        } else if (reg.hasComponent<duck::EnemyState>(entity)) {
+            assert(col.layer == duck::CollisionLayer::Enemy);
+            assert(col.mask == (duck::CollisionLayer::Player | duck::CollisionLayer::Obstacle
+                                | duck::CollisionLayer::Projectile));
+        } else {
+            assert(col.layer == duck::CollisionLayer::Obstacle);
+            assert(col.mask == (tf.x < 250.0f ? duck::CollisionLayer::All
+                                              : (duck::CollisionLayer::Player | duck::CollisionLayer::Projectile)));
+        }
+        ++checked;
+    });
+    assert(checked == 4);
+    std::printf("  [PASS] test_map_loader_reads_collision_layers\n");
+}
+
+// 掉落物是 trigger：CollisionSystem 產生 Enter 事件，PickupSystem 只消費事件
 static void test_pickup_system_collects_items() {
     duck::Registry reg;
 
     auto player = reg.create();
     reg.addComponent<duck::Transform>(player, 100.0f, 100.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::RigidBody>(player, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Collider>(player, duck::Collider::Type::Circle, 12.0f, 12.0f, 12.0f, true,
+                                     duck::CollisionLayer::Player, duck::CollisionLayer::All);
     reg.addComponent<duck::InputControlled>(player);
     reg.addComponent<duck::Inventory>(player);
 
-    auto coin = reg.create();
-    reg.addComponent<duck::Transform>(coin, 110.0f, 100.0f, 0.0f, 1.0f, 1.0f);
-    reg.addComponent<duck::Item>(coin, duck::Item::Type::DuckCoin, 5, 20.0f);
-
-    auto ammo = reg.create();
-    reg.addComponent<duck::Transform>(ammo, 118.0f, 100.0f, 0.0f, 1.0f, 1.0f);
-    reg.addComponent<duck::Item>(ammo, duck::Item::Type::Ammo, 12, 20.0f);
+    auto addItem = [&](float x, duck::Item::Type type, int amount) {
+        auto entity = reg.create();
+        reg.addComponent<duck::Transform>(entity, x, 100.0f, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Item>(entity, type, amount, 20.0f);
+        reg.addComponent<duck::Collider>(entity, duck::Collider::Type::Circle, 20.0f, 20.0f, 20.0f, false,
+                                         duck::CollisionLayer::Pickup, duck::CollisionLayer::Player);
+        return entity;
+    };
+    auto coin = addItem(110.0f, duck::Item::Type::DuckCoin, 5);
+    auto ammo = addItem(118.0f, duck::Item::Type::Ammo, 12);
+    auto medkit = addItem(160.0f, duck::Item::Type::Medkit, 1);   // 20 + 12 < 60：碰不到
 
+    duck::CollisionSystem collision;
     duck::PickupSystem system;
+    collision.update(reg, 1.0f / 60.0f);
     system.update(reg);
 
     auto& inventory = reg.getComponent<duck::Inventory>(player);
     assert(inventory.duckCoins == 5);
     assert(inventory.ammo == 12);
+    assert(inventory.medkits == 0);
     assert(inventory.totalPickups == 17);
     assert(!reg.alive(coin));
     assert(!reg.alive(ammo));
+    assert(reg.alive(medkit));
+    // trigger 不是 solid：玩家沒有被掉落物推開
+    assert(reg.getComponent<duck::Transform>(player).x == 100.0f);
+
+    // 走過去：下一個 tick 才有 Enter 事件
+    reg.getComponent<duck::Transform>(player).x = 140.0f;
+    collision.update(reg, 1.0f / 60.0f);
+    system.update(reg);
+    assert(inventory.medkits == 1);
+    assert(!reg.alive(medkit));
+    assert(reg.context<duck::CollisionWorld>().triggerCount() == 0);
     std::printf("  [PASS] test_pickup_system_collects_items\n");
 }
 
 int main() {
     std::printf("=== Content Tests ===\n");
     test_map_loader_populates_registry();
+    test_map_loader_reads_collision_layers();
     test_pickup_system_collects_items();
     std::printf("\n=== All tests passed! ===\n");
     return 0;
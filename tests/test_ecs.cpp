@@ -13,6 +13,7 @@
 #include "ecs/ComponentPool.h"
 #include "ecs/Components.h"
 #include "ecs/Registry.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <vector>
@@ -193,17 +194,363 @@ void test_registry_destroy_removes_from_view() {
     std::printf("  [PASS] test_registry_destroy_removes_from_view\n");
 }
 
+// --------------------------------------------------
+// 測試 8：停用的 entity 預設被 view 跳過，但元件原封不動
+// --------------------------------------------------
+// 確認：
+// - setEnabled(false) 後 view 不會遍歷到它
+// - ViewFilter::IncludeDisabled 仍然看得到
+// - 停用/啟用不改變 pool 大小，元件資料也不會被搬走
+void test_registry_disable_skips_view() {
+    duck::Registry reg;
+    auto e1 = reg.create();
+    auto e2 = reg.create();
+
+    reg.addComponent<duck::Transform>(e1, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Transform>(e2, 2.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    auto* tfBefore = &reg.getComponent<duck::Transform>(e1);
+
+    assert(reg.isEnabled(e1));
+    reg.setEnabled(e1, false);
+    assert(!reg.isEnabled(e1));
+    assert(reg.alive(e1));
+    assert(reg.hasComponent<duck::Transform>(e1));
+
+    std::vector<duck::EntityID> result;
+    reg.view<duck::Transform>([&](duck::EntityID e) {
+        result.push_back(e);
+    });
+    assert(result.size() == 1);
+    assert(result[0] == e2);
+
+    result.clear();
+    reg.view<duck::Transform>([&](duck::EntityID e) {
+        result.push_back(e);
+    }, duck::ViewFilter::IncludeDisabled);
+    assert(result.size() == 2);
+
+    // 停用不搬動記憶體：同一個元件位址、同樣的資料
+    assert(&reg.getComponent<duck::Transform>(e1) == tfBefore);
+    assert(reg.getComponent<duck::Transform>(e1).x == 1.0f);
+
+    reg.setEnabled(e1, true);
+    result.clear();
+    reg.view<duck::Transform>([&](duck::EntityID e) {
+        result.push_back(e);
+    });
+    assert(result.size() == 2);
+
+    std::printf("  [PASS] test_registry_disable_skips_view\n");
+}
+
+// --------------------------------------------------
+// 測試 9：destroyMany 批次銷毀
+// --------------------------------------------------
+// 場景：200 個 entity，部分有 RigidBody；一次銷毀其中 1/3
+// 受害者列表故意包含重複 ID 與已經死亡的 ID
+// 確認：
+// - 受害者全部死亡、元件全部消失
+// - 倖存者的元件資料沒有被搬錯（x 仍等於自己的 ID）
+// - pool 大小正確
+void test_registry_destroy_many() {
+    duck::Registry reg;
+    std::vector<duck::EntityID> all;
+    for (int i = 0; i < 200; ++i) {
+        auto e = reg.create();
+        all.push_back(e);
+        reg.addComponent<duck::Transform>(e, static_cast<float>(e), 0.0f, 0.0f, 1.0f, 1.0f);
+        if (i % 2 == 0) {
+            reg.addComponent<duck::RigidBody>(e, static_cast<float>(e), 0.0f, 1.0f, 0.9f);
+        }
+    }
+
+    auto alreadyDead = all[199];
+    reg.destroy(alreadyDead);
+
+    std::vector<duck::EntityID> victims;
+    for (auto e : all) {
+        if (e % 3 == 0) victims.push_back(e);
+    }
+    victims.push_back(victims[0]);     // 重複
+    victims.push_back(alreadyDead);    // 已死亡
+    reg.destroyMany(victims);
+
+    int transforms = 0, bodies = 0;
+    for (auto e : all) {
+        bool shouldLive = (e % 3 != 0) && e != alreadyDead;
+        assert(reg.alive(e) == shouldLive);
+        assert(reg.hasComponent<duck::Transform>(e) == shouldLive);
+        if (!shouldLive) {
+            assert(!reg.hasComponent<duck::RigidBody>(e));
+            continue;
+        }
+        assert(reg.getComponent<duck::Transform>(e).x == static_cast<float>(e));
+        if (reg.hasComponent<duck::RigidBody>(e)) {
+            assert(reg.getComponent<duck::RigidBody>(e).vx == static_cast<float>(e));
+        }
+    }
+    reg.view<duck::Transform>([&](duck::EntityID) { ++transforms; });
+    reg.view<duck::RigidBody>([&](duck::EntityID) { ++bodies; });
+    assert(transforms == 132);  // 200 - 67（%3==0）- 1（alreadyDead）
+    assert(bodies == 66);       // 偶數 100 個 - 其中 %3==0 的 34 個
+
+    // 受害者超過 3/4：走整池壓實的路徑，只留下 %10==0 的 entity
+    victims.clear();
+    for (auto e : all) {
+        if (e % 10 != 0) victims.push_back(e);
+    }
+    reg.destroyMany(victims);
+
+    transforms = 0;
+    reg.view<duck::Transform>([&](duck::EntityID e) {
+        assert(e % 10 == 0 && e % 3 != 0);
+        assert(reg.getComponent<duck::Transform>(e).x == static_cast<float>(e));
+        ++transforms;
+    });
+    assert(transforms == 13);   // 0..190 中 %10==0 的 20 個 - 其中 %30==0 的 7 個
+
+    std::printf("  [PASS] test_registry_destroy_many\n");
+}
+
+// --------------------------------------------------
+// 測試 10：快取查詢隨元件增減、destroy、停用增量更新
+// --------------------------------------------------
+// 確認：
+// - 註冊後 view 走快取（hits 增加），結果和未快取時一致
+// - addComponent / removeComponent / destroy / destroyMany / setEnabled 都會更新快取
+// - callback 中 destroy 尚未遍歷到的 entity，不會再被遍歷到
+void test_registry_cached_query() {
+    duck::Registry reg;
+    auto e1 = reg.create();
+    auto e2 = reg.create();
+    auto e3 = reg.create();
+    reg.addComponent<duck::Transform>(e1);
+    reg.addComponent<duck::RigidBody>(e1);
+    reg.addComponent<duck::Transform>(e2);
+
+    reg.registerQuery<duck::Transform, duck::RigidBody>();
+    assert(reg.queryStats().rebuilds == 1);
+
+    auto collect = [&]() {
+        std::vector<duck::EntityID> result;
+        reg.view<duck::Transform, duck::RigidBody>([&](duck::EntityID e) {
+            result.push_back(e);
+        });
+        return result;
+    };
+
+    auto result = collect();
+    assert(result.size() == 1 && result[0] == e1);
+    assert(reg.queryStats().hits == 1);
+
+    // 新增元件後自動加入
+    reg.addComponent<duck::RigidBody>(e2);
+    reg.addComponent<duck::RigidBody>(e3);  // e3 沒有 Transform，不應加入
+    assert(collect().size() == 2);
+
+    reg.addComponent<duck::Transform>(e3);
+    assert(collect().size() == 3);
+
+    // 移除元件、停用、銷毀後自動退出
+    reg.removeComponent<duck::RigidBody>(e1);
+    assert(collect().size() == 2);
+    reg.setEnabled(e2, false);
+    result = collect();
+    assert(result.size() == 1 && result[0] == e3);
+    reg.setEnabled(e2, true);
+    assert(collect().size() == 2);
+    reg.destroy(e3);
+    result = collect();
+    assert(result.size() == 1 && result[0] == e2);
+
+    // 遍歷中銷毀其他 entity：被刪的不應再被呼叫
+    auto e4 = reg.create();
+    reg.addComponent<duck::Transform>(e4);
+    reg.addComponent<duck::RigidBody>(e4);
+    int visited = 0;
+    reg.view<duck::Transform, duck::RigidBody>([&](duck::EntityID e) {
+        ++visited;
+        reg.destroyMany({e == e2 ? e4 : e2});
+    });
+    assert(visited == 1);
+    assert(collect().size() == 1);
+
+    // 沒註冊的簽名走未快取路徑
+    auto missesBefore = reg.queryStats().misses;
+    reg.view<duck::Transform>([](duck::EntityID) {});
+    assert(reg.queryStats().misses == missesBefore + 1);
+    assert(reg.queryStats().rebuilds == 1);
+
+    std::printf("  [PASS] test_registry_cached_query\n");
+}
+
+// --------------------------------------------------
+// 測試：快取查詢就地遍歷時，callback 改動清單
+// --------------------------------------------------
+// 刪自己、刪還沒走到的、停用、新增符合條件的、巢狀 view 同一個查詢：
+// 每個還活著的 entity 剛好走到一次，新加入的下一次才出現，之後清單和 slot 都正確。
+void test_registry_cached_query_mutation_during_view() {
+    duck::Registry reg;
+    reg.registerQuery<duck::Transform, duck::RigidBody>();
+    std::vector<duck::EntityID> entities;
+    for (int i = 0; i < 8; ++i) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e);
+        reg.addComponent<duck::RigidBody>(e);
+        entities.push_back(e);
+    }
+
+    auto collect = [&]() {
+        std::vector<duck::EntityID> result;
+        reg.view<duck::Transform, duck::RigidBody>([&](duck::EntityID e) { result.push_back(e); });
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+
+    std::vector<duck::EntityID> visited;
+    std::vector<duck::EntityID> spawned;
+    int nestedVisits = 0;
+    reg.view<duck::Transform, duck::RigidBody>([&](duck::EntityID e) {
+        visited.push_back(e);
+        if (e == entities[0]) {
+            reg.destroy(e);                                     // 刪自己
+            reg.destroy(entities[7]);                           // 刪還沒走到的
+        } else if (e == entities[1]) {
+            reg.setEnabled(entities[6], false);
+            reg.removeComponent<duck::RigidBody>(entities[5]);
+        } else if (e == entities[2]) {
+            auto fresh = reg.create();                          // 新加入：這次走不到
+            reg.addComponent<duck::Transform>(fresh);
+            reg.addComponent<duck::RigidBody>(fresh);
+            spawned.push_back(fresh);
+            reg.view<duck::Transform, duck::RigidBody>([&](duck::EntityID) { ++nestedVisits; });
+        }
+    });
+    assert((visited == std::vector<duck::EntityID>{entities[0], entities[1], entities[2], entities[3], entities[4]}));
+    // 巢狀遍歷看到的是當時的清單：1..4 和剛加入的那個
+    assert(nestedVisits == 5);
+
+    auto after = collect();
+    assert((after == std::vector<duck::EntityID>{entities[1], entities[2], entities[3], entities[4], spawned[0]}));
+    // 壓實後 slot 仍然正確：再移除 / 加回都正常
+    reg.removeComponent<duck::RigidBody>(entities[3]);
+    reg.setEnabled(entities[6], true);
+    after = collect();
+    assert((after == std::vector<duck::EntityID>{entities[1], entities[2], entities[4], entities[6], spawned[0]}));
+    std::printf("  [PASS] test_registry_cached_query_mutation_during_view\n");
+}
+
+// --------------------------------------------------
+// 測試：分頁儲存的參照穩定性
+// --------------------------------------------------
+// Transform 用 PagedVector 儲存：先拿到 entity 0 的參照，
+// 再新增幾千個 Transform（跨過很多頁），參照必須仍指向同一份資料。
+// 之後 remove / removeMany 的 Swap-and-Pop 語意要和 vector 版一致。
+void test_paged_storage_stable_references() {
+    static_assert(duck::ComponentStorage<duck::Transform>::pageSize > 0,
+                  "Transform should use paged storage");
+
+    duck::ComponentPool<duck::Transform> pool;
+    duck::Transform& first = pool.add(0, {7.0f, 8.0f, 0.0f, 1.0f, 1.0f});
+    const duck::Transform* firstAddress = &first;
+
+    const duck::EntityID count = 5000;
+    for (duck::EntityID e = 1; e < count; ++e) {
+        pool.add(e, {static_cast<float>(e), 0.0f, 0.0f, 1.0f, 1.0f});
+    }
+    assert(&pool.get(0) == firstAddress);
+    assert(first.x == 7.0f && first.y == 8.0f);
+    first.x = 9.0f;
+    assert(pool.get(0).x == 9.0f);
+
+    // 逐頁遍歷看到的元素數量 = size
+    size_t visited = 0;
+    pool.components().forEachPage([&](duck::Transform*, size_t n) { visited += n; });
+    assert(visited == count);
+
+    // Swap-and-Pop：最後一個被搬到 entity 1 的位置
+    pool.remove(1);
+    assert(!pool.has(1));
+    assert(pool.get(count - 1).x == static_cast<float>(count - 1));
+
+    // 整池壓實路徑（受害者 >= 3/4）
+    std::vector<duck::EntityID> victims;
+    std::vector<std::uint8_t> marked(count, 0);
+    for (duck::EntityID e = 2; e < count; ++e) {
+        if (e % 10 != 0) { victims.push_back(e); marked[e] = 1; }
+    }
+    pool.removeMany(victims, marked);
+    assert(pool.size() == count - 1 - victims.size());
+    for (duck::EntityID e = 2; e < count; ++e) {
+        assert(pool.has(e) == (e % 10 == 0));
+        if (e % 10 == 0) assert(pool.get(e).x == static_cast<float>(e));
+    }
+    assert(pool.get(0).x == 9.0f);
+
+    // 刪光後再加回來：頁面重用，不重新配置
+    size_t capacityBefore = pool.components().capacity();
+    pool.add(1, {1.0f, 1.0f, 0.0f, 1.0f, 1.0f});
+    assert(pool.components().capacity() == capacityBefore);
+
+    std::printf("  [PASS] test_paged_storage_stable_references\n");
+}
+
+// --------------------------------------------------
+// 測試：元件訊號（onAdd / onRemove）
+// --------------------------------------------------
+// removeComponent、destroy、destroyMany 都要在元件被移除「之前」通知，
+// 而且只通知真的擁有該元件的 entity
+void test_registry_component_signals() {
+    duck::Registry reg;
+    std::vector<duck::EntityID> added;
+    std::vector<duck::EntityID> removed;
+    float lastSeenX = 0.0f;
+
+    reg.onAdd<duck::Transform>([&](duck::EntityID e) { added.push_back(e); });
+    reg.onRemove<duck::Transform>([&](duck::EntityID e) {
+        removed.push_back(e);
+        lastSeenX = reg.getComponent<duck::Transform>(e).x;  // 移除前仍讀得到
+    });
+
+    auto a = reg.create();
+    auto b = reg.create();
+    auto c = reg.create();
+    auto tagOnly = reg.create();
+    reg.addComponent<duck::Transform>(a, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Transform>(b, 2.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::Transform>(c, 3.0f, 0.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::InputControlled>(tagOnly);
+    assert(added.size() == 3);
+
+    reg.removeComponent<duck::Transform>(a);
+    assert(removed.size() == 1 && removed[0] == a && lastSeenX == 1.0f);
+
+    reg.destroy(b);
+    assert(removed.size() == 2 && removed[1] == b && lastSeenX == 2.0f);
+
+    reg.destroyMany({c, tagOnly, c});
+    assert(removed.size() == 3 && removed[2] == c);
+
+    std::printf("  [PASS] test_registry_component_signals\n");
+}
+
 int main() {
     std::printf("=== ComponentPool 測試 ===\n");
     test_add_get();
     test_remove();
     test_tag_component();
+    test_paged_storage_stable_references();
 
     std::printf("\n=== Registry 測試 ===\n");
     test_registry_create_destroy();
     test_registry_components();
     test_registry_view();
     test_registry_destroy_removes_from_view();
+    test_registry_disable_skips_view();
+    test_registry_destroy_many();
+    test_registry_cached_query();
+    test_registry_cached_query_mutation_during_view();
+    test_registry_component_signals();
 
     std::printf("\n=== 全部通過 ===\n");
     return 0;
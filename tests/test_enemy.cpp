@@ -2,7 +2,9 @@
 #include "ecs/Components.h"
 #include "ecs/Registry.h"
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
+#include <vector>
 
 static void test_enemy_idle_to_chase() {
     duck::Registry reg;
@@ -14,14 +16,16 @@ static void test_enemy_idle_to_chase() {
     auto enemy = reg.create();
     reg.addComponent<duck::Transform>(enemy, 220.0f, 100.0f, 0.0f, 1.0f, 1.0f);
     reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
-    duck::Enemy enemyData;
-    enemyData.detectRange = 160.0f;
-    reg.addComponent<duck::Enemy>(enemy, enemyData);
+    duck::EnemyArchetype archetype;
+    archetype.detectRange = 160.0f;
+    duck::EnemyState enemyData;
+    enemyData.archetype = reg.context<duck::EnemyArchetypeTable>().add(archetype);
+    reg.addComponent<duck::EnemyState>(enemy, enemyData);
 
     duck::EnemySystem system;
     system.update(reg, 1.0f / 60.0f);
 
-    assert(reg.getComponent<duck::Enemy>(enemy).state == duck::Enemy::State::Chase);
+    assert(reg.getComponent<duck::EnemyState>(enemy).state == duck::EnemyState::State::Chase);
     std::printf("  [PASS] test_enemy_idle_to_chase\n");
 }
 
@@ -35,16 +39,18 @@ static void test_enemy_chase_to_attack() {
     auto enemy = reg.create();
     reg.addComponent<duck::Transform>(enemy, 130.0f, 100.0f, 0.0f, 1.0f, 1.0f);
     reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
-    duck::Enemy enemyData;
-    enemyData.state = duck::Enemy::State::Chase;
-    enemyData.detectRange = 200.0f;
-    enemyData.attackRange = 48.0f;
-    reg.addComponent<duck::Enemy>(enemy, enemyData);
+    duck::EnemyArchetype archetype;
+    archetype.detectRange = 200.0f;
+    archetype.attackRange = 48.0f;
+    duck::EnemyState enemyData;
+    enemyData.state = duck::EnemyState::State::Chase;
+    enemyData.archetype = reg.context<duck::EnemyArchetypeTable>().add(archetype);
+    reg.addComponent<duck::EnemyState>(enemy, enemyData);
 
     duck::EnemySystem system;
     system.update(reg, 1.0f / 60.0f);
 
-    assert(reg.getComponent<duck::Enemy>(enemy).state == duck::Enemy::State::Attack);
+    assert(reg.getComponent<duck::EnemyState>(enemy).state == duck::EnemyState::State::Attack);
     std::printf("  [PASS] test_enemy_chase_to_attack\n");
 }
 
@@ -58,12 +64,14 @@ static void test_enemy_lost_player_to_patrol() {
     auto enemy = reg.create();
     reg.addComponent<duck::Transform>(enemy, 100.0f, 100.0f, 0.0f, 1.0f, 1.0f);
     reg.addComponent<duck::RigidBody>(enemy, 0.0f, 0.0f, 1.0f, 0.9f);
-    duck::Enemy enemyData;
-    enemyData.state = duck::Enemy::State::Chase;
-    enemyData.detectRange = 120.0f;
-    enemyData.loseSightDelay = 0.1f;
+    duck::EnemyArchetype archetype;
+    archetype.detectRange = 120.0f;
+    archetype.loseSightDelay = 0.1f;
+    duck::EnemyState enemyData;
+    enemyData.state = duck::EnemyState::State::Chase;
+    enemyData.archetype = reg.context<duck::EnemyArchetypeTable>().add(archetype);
     enemyData.loseSightTimer = 0.05f;
-    reg.addComponent<duck::Enemy>(enemy, enemyData);
+    reg.addComponent<duck::EnemyState>(enemy, enemyData);
 
     duck::EnemySystem system;
     system.update(reg, 1.0f / 60.0f);
@@ -71,7 +79,7 @@ static void test_enemy_lost_player_to_patrol() {
     system.update(reg, 1.0f / 60.0f);
     system.update(reg, 1.0f / 60.0f);
 
-    assert(reg.getComponent<duck::Enemy>(enemy).state == duck::Enemy::State::Patrol);
+    assert(reg.getComponent<duck::EnemyState>(enemy).state == duck::EnemyState::State::Patrol);
     std::printf("  [PASS] test_enemy_lost_player_to_patrol\n");
 }
 
@@ -88,15 +96,17 @@ static void test_enemy_dead_state_destroys_entity() {
     reg.addComponent<duck::Health>(enemy, 0.0f, 3.0f);
     reg.addComponent<duck::Collider>(enemy, duck::Collider::Type::Circle, 16.0f, 16.0f, 16.0f, true);
     reg.addComponent<duck::Sprite>(enemy, 1u, 32.0f, 32.0f, 4, 1.0f, 1.0f, 1.0f, 1.0f);
-    duck::Enemy enemyData;
-    enemyData.deadLifetime = 0.03f;
+    duck::EnemyArchetype archetype;
+    archetype.deadLifetime = 0.03f;
+    duck::EnemyState enemyData;
+    enemyData.archetype = reg.context<duck::EnemyArchetypeTable>().add(archetype);
     enemyData.deadTimer = 0.03f;
-    reg.addComponent<duck::Enemy>(enemy, enemyData);
+    reg.addComponent<duck::EnemyState>(enemy, enemyData);
 
     duck::EnemySystem system;
     system.update(reg, 1.0f / 60.0f);
     assert(reg.alive(enemy));
-    assert(reg.getComponent<duck::Enemy>(enemy).state == duck::Enemy::State::Dead);
+    assert(reg.getComponent<duck::EnemyState>(enemy).state == duck::EnemyState::State::Dead);
 
     system.update(reg, 1.0f / 60.0f);
     system.update(reg, 1.0f / 60.0f);
@@ -104,12 +114,147 @@ static void test_enemy_dead_state_destroys_entity() {
     std::printf("  [PASS] test_enemy_dead_state_destroys_entity\n");
 }
 
+static void test_enemy_archetypes_are_shared() {
+    duck::Registry reg;
+    auto& table = reg.context<duck::EnemyArchetypeTable>();
+
+    duck::EnemyArchetype fast;
+    fast.moveAcceleration = 2000.0f;
+    duck::EnemyArchetype alsoFast = fast;
+    duck::EnemyArchetype slow;
+    slow.moveAcceleration = 400.0f;
+
+    auto a = table.add(fast);
+    auto b = table.add(alsoFast);
+    auto c = table.add(slow);
+    assert(a == b);             // 相同調校共用同一筆
+    assert(a != c);
+    assert(a != 0 && c != 0);   // 0 保留給預設 archetype
+    assert(table.get(c).moveAcceleration == 400.0f);
+    assert(table.get(0).moveAcceleration == duck::EnemyArchetype{}.moveAcceleration);
+    assert(sizeof(duck::EnemyState) <= 32);
+    std::printf("  [PASS] test_enemy_archetypes_are_shared\n");
+}
+
+// 一大群敵人、兩種偵測距離，一部分有 Collider：
+// 經過 SpatialIndex 篩選後，誰進 Chase / Attack 要和逐隻比距離的結果一樣
+static void test_enemy_range_checks_match_brute_force() {
+    duck::Registry reg;
+    const float playerX = 500.0f;
+    const float playerY = 400.0f;
+
+    auto player = reg.create();
+    reg.addComponent<duck::Transform>(player, playerX, playerY, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::InputControlled>(player);
+
+    auto& table = reg.context<duck::EnemyArchetypeTable>();
+    duck::EnemyArchetype nearSighted;
+    nearSighted.detectRange = 90.0f;
+    nearSighted.attackRange = 40.0f;
+    duck::EnemyArchetype farSighted;
+    farSighted.detectRange = 260.0f;
+    farSighted.attackRange = 60.0f;
+    std::uint16_t archetypes[] = {table.add(nearSighted), table.add(farSighted)};
+
+    std::uint32_t seed = 3u;
+    auto rnd = [&](float lo, float hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + (hi - lo) * static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+    std::vector<duck::EntityID> enemies;
+    std::vector<duck::EnemyState::State> expected;
+    for (int i = 0; i < 500; ++i) {
+        auto e = reg.create();
+        float x = rnd(0.0f, 1000.0f);
+        float y = rnd(0.0f, 800.0f);
+        reg.addComponent<duck::Transform>(e, x, y, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        // 一半掛 Default 層的 Collider：EnemySystem 只查 Enemy 層，SpatialIndex 仍要把它們收進 Enemy 層
+        if (i % 2 == 0) reg.addComponent<duck::Collider>(e, duck::Collider::Type::Circle, 14.0f, 14.0f, 14.0f, true);
+        duck::EnemyState state;
+        state.archetype = archetypes[i % 2];
+        reg.addComponent<duck::EnemyState>(e, state);
+
+        const duck::EnemyArchetype& arch = table.get(state.archetype);
+        float distSq = (x - playerX) * (x - playerX) + (y - playerY) * (y - playerY);
+        expected.push_back(distSq <= arch.attackRange * arch.attackRange ? duck::EnemyState::State::Attack
+                           : distSq <= arch.detectRange * arch.detectRange ? duck::EnemyState::State::Chase
+                           : duck::EnemyState::State::Idle);
+        enemies.push_back(e);
+    }
+
+    duck::EnemySystem system;
+    system.update(reg, 1.0f / 60.0f);
+
+    int chasing = 0;
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        assert(reg.getComponent<duck::EnemyState>(enemies[i]).state == expected[i]);
+        if (expected[i] != duck::EnemyState::State::Idle) ++chasing;
+    }
+    assert(chasing > 10 && chasing < 400);
+    std::printf("  [PASS] test_enemy_range_checks_match_brute_force\n");
+}
+
+// 視線：偵測範圍內但被石頭（Obstacle 層）擋住的敵人不會被驚動；
+// 只擋玩家的障礙物（mask 不含 Enemy）不擋視線
+static void test_enemy_walls_block_line_of_sight() {
+    duck::Registry reg;
+
+    auto player = reg.create();
+    reg.addComponent<duck::Transform>(player, 100.0f, 100.0f, 0.0f, 1.0f, 1.0f);
+    reg.addComponent<duck::InputControlled>(player);
+
+    duck::EnemyArchetype archetype;
+    archetype.detectRange = 200.0f;
+    archetype.attackRange = 30.0f;
+    std::uint16_t arch = reg.context<duck::EnemyArchetypeTable>().add(archetype);
+    auto spawnEnemy = [&](float x, float y) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, x, y, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::RigidBody>(e, 0.0f, 0.0f, 1.0f, 0.9f);
+        reg.addComponent<duck::Collider>(e, duck::Collider{duck::Collider::Type::Circle, 14.0f, 14.0f, 14.0f, true,
+                                                           duck::CollisionLayer::Enemy, duck::CollisionLayer::All});
+        duck::EnemyState state;
+        state.archetype = arch;
+        reg.addComponent<duck::EnemyState>(e, state);
+        return e;
+    };
+    auto spawnWall = [&](float x, float y, float halfW, float halfH, std::uint32_t mask) {
+        auto e = reg.create();
+        reg.addComponent<duck::Transform>(e, x, y, 0.0f, 1.0f, 1.0f);
+        reg.addComponent<duck::Collider>(e, duck::Collider{duck::Collider::Type::AABB, halfW, halfH, halfW, true,
+                                                           duck::CollisionLayer::Obstacle, mask});
+    };
+
+    auto behindWall = spawnEnemy(250.0f, 100.0f);     // 右邊，中間有一面牆
+    auto inTheOpen = spawnEnemy(100.0f, 250.0f);      // 下面，視線暢通
+    auto behindHedge = spawnEnemy(100.0f, -50.0f);    // 上面，中間的障礙物只擋玩家
+    spawnWall(170.0f, 100.0f, 10.0f, 60.0f, duck::CollisionLayer::All);
+    spawnWall(100.0f, 30.0f, 60.0f, 10.0f, duck::CollisionLayer::Player);
+
+    duck::EnemySystem system;
+    system.update(reg, 1.0f / 60.0f);
+    assert(reg.getComponent<duck::EnemyState>(behindWall).state == duck::EnemyState::State::Idle);
+    assert(reg.getComponent<duck::EnemyState>(inTheOpen).state == duck::EnemyState::State::Chase);
+    assert(reg.getComponent<duck::EnemyState>(behindHedge).state == duck::EnemyState::State::Chase);
+
+    // 玩家繞過牆角：視線不再被擋
+    reg.getComponent<duck::Transform>(player).x = 120.0f;
+    reg.getComponent<duck::Transform>(player).y = 240.0f;
+    system.update(reg, 1.0f / 60.0f);
+    assert(reg.getComponent<duck::EnemyState>(behindWall).state == duck::EnemyState::State::Chase);
+    std::printf("  [PASS] test_enemy_walls_block_line_of_sight\n");
+}
+
 int main() {
     std::printf("=== Enemy AI Tests ===\n");
     test_enemy_idle_to_chase();
     test_enemy_chase_to_attack();
     test_enemy_lost_player_to_patrol();
     test_enemy_dead_state_destroys_entity();
+    test_enemy_archetypes_are_shared();
+    test_enemy_range_checks_match_brute_force();
+    test_enemy_walls_block_line_of_sight();
     std::printf("\n=== All tests passed! ===\n");
     return 0;
 }